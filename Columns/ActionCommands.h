@@ -36,7 +36,7 @@ namespace geng
 		friend class ActionCommandStream;
 	};
 
-	class ActionCommandStream : public ICommandStream
+	class ActionCommandStream : public ICommandStream, public PooledObject
 	{
 	public:
 		bool UpdateOnFrame(unsigned long frameIndex) override
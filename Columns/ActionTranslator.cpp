@@ -1,6 +1,8 @@
 #include "ActionTranslator.h"
 #include "KeyDebug.h"
 
+#include <algorithm>
+
 geng::ActionTranslator::KeyIndex geng::ActionTranslator::GetOrCreateKeyIndex(KeyCode key)
 {
 	auto itKey = m_subKeyMap.find(key);
@@ -41,21 +43,28 @@ void geng::ActionTranslator::OnMapping(ActionID actionId, const ActionMapping& m
 	{
 		ActionInfo_& rInfo = itAction->second;
 
-		rInfo.keyRefs.clear();
+		rInfo.keyGroups.clear();
 		for (const auto& keyGroup : mapping.keyGroups)
 		{
 		//	fprintf(stderr, "keygroup:\n");
-			std::vector<KeyIndex>  transKeyGroup;
+			KeyGroup_ transKeyGroup;
+			// Like the on-key count it's compared to, this counts a key listed twice twice
+			transKeyGroup.keyCount = keyGroup.size();
 			for (KeyCode key : keyGroup)
 			{
 				KeyIndex kidx = GetOrCreateKeyIndex(key);
 	//			fprintf(stderr, "\tkey %u\n", key);
-				transKeyGroup.emplace_back(kidx);
+				size_t wordIndex = kidx / KEY_MASK_WORD_BITS;
+				if (transKeyGroup.mask.size() <= wordIndex)
+				{
+					transKeyGroup.mask.resize(wordIndex + 1, 0);
+				}
+				transKeyGroup.mask[wordIndex] |= KeyMaskWord(1) << (kidx % KEY_MASK_WORD_BITS);
 			}
 	//		fprintf(stderr, "/keygroup\n");
 
 			++groupCount;
-			rInfo.keyRefs.emplace_back(std::move(transKeyGroup));
+			rInfo.keyGroups.emplace_back(std::move(transKeyGroup));
 		}
 	}
 	//fprintf(stderr, "Group count %u\n", groupCount);
@@ -73,13 +82,27 @@ void geng::ActionTranslator::UpdateOnFrame(unsigned long frameId)
 
 	m_pInput->QueryInput(&mouseState, &kbState, m_keyStateRefs.data(), m_keyStateRefs.size());
 
+	m_onKeys.assign((m_keyStateVector.size() + KEY_MASK_WORD_BITS - 1) / KEY_MASK_WORD_BITS, 0);
 	unsigned int nOnKeys{ 0 };
-	for (KeyInfo_& rKey : m_keyStateVector)
+	// A group matches exactly the keys that are on, so whatever action comes on
+	// came on when the last of them changed
+	bool keysChanged{ false };
+	unsigned long lastChangeTime{ 0 };
+	for (KeyIndex index = 0; index < m_keyStateVector.size(); ++index)
 	{
 		//fprintf(stderr, "key state: ")
+		const KeyInfo_& rKey = m_keyStateVector[index];
 		if (IsOnAction(rKey))
 		{
+			m_onKeys[index / KEY_MASK_WORD_BITS] |= KeyMaskWord(1) << (index % KEY_MASK_WORD_BITS);
 			++nOnKeys;
+
+			if (rKey.m_pkeyState->numChanges > 0)
+			{
+				lastChangeTime = keysChanged ? std::max(lastChangeTime, rKey.m_pkeyState->changeTime)
+					: rKey.m_pkeyState->changeTime;
+				keysChanged = true;
+			}
 		}
 	}
 
@@ -90,14 +113,14 @@ void geng::ActionTranslator::UpdateOnFrame(unsigned long frameId)
 	for (auto& rActionState : m_actionMap)
 	{
 		bool actionOn{ false };
-		for (const auto& keyGroup : rActionState.second.keyRefs)
+		for (const KeyGroup_& keyGroup : rActionState.second.keyGroups)
 		{
-			if (keyGroup.size() == nOnKeys)
+			if (keyGroup.keyCount == nOnKeys)
 			{
 				bool keysOn{ true };
-				for (KeyIndex index : keyGroup)
+				for (size_t wordIndex = 0; wordIndex < keyGroup.mask.size(); ++wordIndex)
 				{
-					if (!IsOnAction(m_keyStateVector[index]))
+					if ((m_onKeys[wordIndex] & keyGroup.mask[wordIndex]) != keyGroup.mask[wordIndex])
 					{
 						keysOn = false;
 						break;
@@ -121,6 +144,9 @@ void geng::ActionTranslator::UpdateOnFrame(unsigned long frameId)
 		}
 		*/
 	
+		rActionState.second.turnedOn = keysChanged && nextState == ActionState::On
+			&& rActionState.second.actState != ActionState::On;
+		rActionState.second.onTime = lastChangeTime;
 		rActionState.second.actState = nextState;
 	}
 }
\ No newline at end of file
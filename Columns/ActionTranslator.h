@@ -21,10 +21,25 @@ namespace geng
 	{
 	private:
 		using KeyIndex = size_t;
+		using KeyMaskWord = uint64_t;
+		static constexpr size_t KEY_MASK_WORD_BITS = 64;
+
+		// A group is on when exactly its keys are on:  every bit of the mask is set among the
+		// keys that are on, and as many keys are on as the group has
+		struct KeyGroup_
+		{
+			size_t keyCount{ 0 };
+			// Covers the keys subscribed when the group was compiled; keys added later are never in it
+			std::vector<KeyMaskWord> mask;
+		};
+
 		struct ActionInfo_
 		{
-			std::vector<std::vector<KeyIndex> > keyRefs;
+			std::vector<KeyGroup_> keyGroups;
 			ActionState actState;
+			// The action came on in the last update, when its last key changed
+			bool turnedOn{ false };
+			unsigned long onTime{ 0 };
 		};
 
 		struct KeyInfo_
@@ -76,6 +91,19 @@ namespace geng
 			return ActionState::Invalid;
 		}
 
+		// True if the action came on in the last update because a key changed during the frame,
+		// and when, on the input's clock
+		bool GetActionOnTime(ActionID actionId, unsigned long& rOnTime) const
+		{
+			auto itAction = m_actionMap.find(actionId);
+			if (itAction != m_actionMap.end() && itAction->second.turnedOn)
+			{
+				rOnTime = itAction->second.onTime;
+				return true;
+			}
+			return false;
+		}
+
 	private:
 		bool IsOnAction(const KeyInfo_& key)
 		{
@@ -97,5 +125,8 @@ namespace geng
 		std::vector<KeyInfo_> m_keyStateVector;
 
 		std::vector<KeyState*>  m_keyStateRefs;
+
+		// One bit per subscribed key, by key index; refreshed every frame
+		std::vector<KeyMaskWord> m_onKeys;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "SerializedCommands.h"
 #include "Packet.h"
+#include "BlockPool.h"
 #include <string>
 #include <vector>
 
@@ -51,7 +52,8 @@ namespace geng
 			}
 		};
 
-		class Delta_ : public serial::ICommandDelta
+		// Recording, playback and the spectator feed each allocate one per command, per session
+		class Delta_ : public serial::ICommandDelta, public PooledObject
 		{
 		public:
 			void OnCommand(const ICommand& nextCommand) override
@@ -86,6 +88,7 @@ namespace geng
 				TypedCommand& typedCommand = static_cast<TypedCommand&>(curCommand);
 				ApplyCommandDiff(typedCommand.m_commandState,
 					m_stateDelta);
+				typedCommand.MarkChanged();
 			}
 		private:
 			bool m_hasDelta{ false };
@@ -132,6 +135,20 @@ namespace geng
 			}
 		}
 
+		void BindChangeList(CommandChangeList* pChangeList, uint32_t commandIndex) override
+		{
+			m_pChangeList = pChangeList;
+			m_changeIndex = commandIndex;
+		}
+
+		void UnbindChangeList(const CommandChangeList* pChangeList) override
+		{
+			if (m_pChangeList == pChangeList)
+			{
+				m_pChangeList = nullptr;
+			}
+		}
+
 		void Reset() override
 		{
 			m_commandState = State{};
@@ -150,6 +167,7 @@ namespace geng
 			if (!(newState == m_commandState))
 			{
 				m_commandState = newState;
+				MarkChanged();
 
 				for (const auto& commandListener : m_vCommandListeners)
 				{
@@ -159,9 +177,19 @@ namespace geng
 		}
 
 	private:
+		void MarkChanged()
+		{
+			if (m_pChangeList)
+			{
+				m_pChangeList->MarkChanged(m_changeIndex);
+			}
+		}
+
 		std::string  m_key;
 		State m_commandState{};
 		std::vector<Subscriber_>
 			m_vCommandListeners;
+		CommandChangeList* m_pChangeList{ nullptr };
+		uint32_t m_changeIndex{ 0 };
 	};
 }
\ No newline at end of file
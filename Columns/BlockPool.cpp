@@ -0,0 +1,98 @@
+#include "BlockPool.h"
+
+#include <array>
+
+namespace
+{
+	constexpr size_t SIZE_CLASS_COUNT = geng::BlockPool::MAX_POOLED_SIZE / geng::BlockPool::BLOCK_GRANULARITY + 1;
+
+	struct FreeBlock
+	{
+		FreeBlock* pNext;
+	};
+
+	// Plain data, so it's still there for blocks freed after the thread's destructors have run
+	struct ThreadLists
+	{
+		std::array<FreeBlock*, SIZE_CLASS_COUNT> freeLists;
+		geng::BlockPool::Stats stats;
+		bool released;
+	};
+
+	thread_local ThreadLists t_lists{};
+
+	// Gives the free blocks back to the system when the thread ends
+	struct ThreadListsReleaser
+	{
+		bool armed{ false };
+
+		~ThreadListsReleaser()
+		{
+			for (FreeBlock*& pFreeList : t_lists.freeLists)
+			{
+				while (pFreeList)
+				{
+					FreeBlock* pBlock = pFreeList;
+					pFreeList = pBlock->pNext;
+					::operator delete(pBlock);
+				}
+			}
+			t_lists.stats.freeBlocks = 0;
+			t_lists.released = true;
+		}
+	};
+
+	thread_local ThreadListsReleaser t_releaser;
+}
+
+void* geng::BlockPool::Allocate(size_t size)
+{
+	size_t sizeClass = GetSizeClass(size);
+	if (sizeClass >= SIZE_CLASS_COUNT || t_lists.released)
+	{
+		return ::operator new(size);
+	}
+
+	// Touching the releaser makes sure it's constructed, and so destroyed, on this thread
+	t_releaser.armed = true;
+
+	FreeBlock*& pFreeList = t_lists.freeLists[sizeClass];
+	if (pFreeList)
+	{
+		FreeBlock* pBlock = pFreeList;
+		pFreeList = pBlock->pNext;
+		++t_lists.stats.reusedAllocations;
+		--t_lists.stats.freeBlocks;
+		return pBlock;
+	}
+
+	++t_lists.stats.systemAllocations;
+	return ::operator new(sizeClass * BLOCK_GRANULARITY);
+}
+
+void geng::BlockPool::Free(void* pBlock, size_t size)
+{
+	if (!pBlock)
+	{
+		return;
+	}
+
+	size_t sizeClass = GetSizeClass(size);
+	if (sizeClass >= SIZE_CLASS_COUNT || t_lists.released)
+	{
+		::operator delete(pBlock);
+		return;
+	}
+
+	t_releaser.armed = true;
+
+	FreeBlock* pFreeBlock = static_cast<FreeBlock*>(pBlock);
+	pFreeBlock->pNext = t_lists.freeLists[sizeClass];
+	t_lists.freeLists[sizeClass] = pFreeBlock;
+	++t_lists.stats.freeBlocks;
+}
+
+geng::BlockPool::Stats geng::BlockPool::GetStats()
+{
+	return t_lists.stats;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace geng
+{
+	// Per-thread free lists of small blocks, one list for every 16-byte size class up to
+	// MAX_POOLED_SIZE.  A freed block is kept for the next object of its size, so the objects
+	// a game session tears down at its end are the ones the next session is built from, and
+	// restarting sessions doesn't churn the system heap.
+	// Blocks go back to the system only when their thread ends.  A block freed on another thread
+	// than the one it came from simply joins that thread's lists
+	class BlockPool
+	{
+	public:
+		static constexpr size_t BLOCK_GRANULARITY = alignof(std::max_align_t);
+		static constexpr size_t MAX_POOLED_SIZE = 512;
+
+		// Sizes over MAX_POOLED_SIZE go straight to the system
+		static void* Allocate(size_t size);
+		// The size must be the one the block was allocated with
+		static void Free(void* pBlock, size_t size);
+
+		// For the calling thread
+		struct Stats
+		{
+			// Blocks taken from the system
+			size_t systemAllocations{ 0 };
+			// Blocks handed out again from the free lists
+			size_t reusedAllocations{ 0 };
+			// Blocks waiting in the free lists
+			size_t freeBlocks{ 0 };
+		};
+		static Stats GetStats();
+
+	private:
+		static size_t GetSizeClass(size_t size)
+		{
+			// Every block must hold a free list link
+			return size > 0 ? (size + BLOCK_GRANULARITY - 1) / BLOCK_GRANULARITY : 1;
+		}
+	};
+
+	// Derive a class from this to allocate its objects from the block pool.  The class must be
+	// deleted through itself or a base with a virtual destructor, like any other.
+	// Only one class in a hierarchy should derive from this
+	class PooledObject
+	{
+	public:
+		static void* operator new(size_t size)
+		{
+			return BlockPool::Allocate(size);
+		}
+
+		static void operator delete(void* pObject, size_t size)
+		{
+			BlockPool::Free(pObject, size);
+		}
+	};
+
+	// A standard allocator on the block pool; mainly for shared_ptr control blocks
+	template<typename T>
+	class PoolAllocator
+	{
+	public:
+		using value_type = T;
+
+		PoolAllocator() = default;
+
+		template<typename U>
+		PoolAllocator(const PoolAllocator<U>&) { }
+
+		T* allocate(size_t count)
+		{
+			return static_cast<T*>(BlockPool::Allocate(count * sizeof(T)));
+		}
+
+		void deallocate(T* pObjects, size_t count)
+		{
+			BlockPool::Free(pObjects, count * sizeof(T));
+		}
+
+		template<typename U>
+		bool operator==(const PoolAllocator<U>&) const { return true; }
+		template<typename U>
+		bool operator!=(const PoolAllocator<U>&) const { return false; }
+	};
+
+	// Share an object, with the control block from the pool as well
+	template<typename T>
+	std::shared_ptr<T> SharePooled(T* pObject)
+	{
+		return std::shared_ptr<T>(pObject, std::default_delete<T>(), PoolAllocator<T>());
+	}
+}
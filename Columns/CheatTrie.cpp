@@ -1,5 +1,25 @@
 #include "CheatTrie.h"
 
+#include <deque>
+#include <algorithm>
+
+const std::array<uint8_t, 256> geng::CheatTrie::s_symbols = geng::CheatTrie::MakeSymbolTable();
+
+std::array<uint8_t, 256> geng::CheatTrie::MakeSymbolTable()
+{
+	std::array<uint8_t, 256> symbols;
+	symbols.fill(NO_SYMBOL);
+	for (char c = 'a'; c <= 'z'; ++c)
+	{
+		symbols[(unsigned char)c] = (uint8_t)(c - 'a');
+	}
+	for (char c = '0'; c <= '9'; ++c)
+	{
+		symbols[(unsigned char)c] = (uint8_t)(26 + c - '0');
+	}
+	return symbols;
+}
+
 geng::CheatTrie::CheatTrie()
 {
 	m_nodes.emplace_back();
@@ -7,50 +27,83 @@ geng::CheatTrie::CheatTrie()
 
 geng::TrieIndex geng::CheatTrie::AddEntry(const char* pEntry, geng::CheatKey cheatKey)
 {
-	const char* pC = pEntry;
-
-	TrieIndex curNodeIndex = 0;
-	while (*pC != '\0')
+	// Check the whole entry first, so a bad one leaves nothing behind
+	for (const char* pC = pEntry; *pC != '\0'; ++pC)
 	{
-		char curChar = *pC;
-		if (curNodeIndex >= m_nodes.size())
+		if (GetSymbol(*pC) == NO_SYMBOL)
 		{
 			return CHEAT_TRIE_ROOT;
 		}
+	}
 
+	CompiledIndex curNodeIndex = 0;
+	for (const char* pC = pEntry; *pC != '\0'; ++pC)
+	{
+		uint8_t symbol = GetSymbol(*pC);
 		TrieNode& curNode = m_nodes[curNodeIndex];
 
-		auto itNext = curNode.m_nextNodes.find(curChar);
+		auto itNext = curNode.m_nextNodes.begin();
+		while (itNext != curNode.m_nextNodes.end() && itNext->first != symbol)
+		{
+			++itNext;
+		}
+
 		if (itNext != curNode.m_nextNodes.end())
 		{
 			curNodeIndex = itNext->second;
 		}
 		else
 		{
-			TrieIndex nextNodeIndex = m_nodes.size();
+			CompiledIndex nextNodeIndex = (CompiledIndex)m_nodes.size();
 			m_nodes.emplace_back();
 			// Need to use the full call as the vector may grow
-			m_nodes[curNodeIndex].m_nextNodes.emplace(curChar, nextNodeIndex);
+			m_nodes[curNodeIndex].m_nextNodes.emplace_back(symbol, nextNodeIndex);
 			curNodeIndex = nextNodeIndex;
 		}
-
-		++pC;
 	}
 
 	m_nodes[curNodeIndex].key.emplace(cheatKey);
+	m_compiled = false;
 	return curNodeIndex;
 }
 
-geng::TrieIndex geng::CheatTrie::GetNext(TrieIndex curNodeIndex, char cNext) const
+void geng::CheatTrie::Compile()
 {
-	if (curNodeIndex >= m_nodes.size())
+	m_transitions.assign(m_nodes.size() * ALPHABET_SIZE, (CompiledIndex)CHEAT_TRIE_ROOT);
+	m_matches.assign(m_nodes.size(), std::nullopt);
+
+	// Breadth first, so a node's failure link (to a shorter string) is done before the node.
+	// A node's missing edges are its failure link's edges, and the root's go back to the root
+	std::vector<CompiledIndex> failLinks(m_nodes.size(), (CompiledIndex)CHEAT_TRIE_ROOT);
+	std::deque<CompiledIndex> pending;
+
+	m_matches[CHEAT_TRIE_ROOT] = m_nodes[CHEAT_TRIE_ROOT].key;
+	for (const auto& edge : m_nodes[CHEAT_TRIE_ROOT].m_nextNodes)
 	{
-		return CHEAT_TRIE_ROOT;
+		m_transitions[edge.first] = edge.second;
+		pending.push_back(edge.second);
 	}
 
-	auto itNext = m_nodes[curNodeIndex].m_nextNodes.find(cNext);
+	while (!pending.empty())
+	{
+		CompiledIndex nodeIndex = pending.front();
+		pending.pop_front();
+
+		const TrieNode& node = m_nodes[nodeIndex];
+		CompiledIndex failIndex = failLinks[nodeIndex];
+		m_matches[nodeIndex] = node.key.has_value() ? node.key : m_matches[failIndex];
 
-	return itNext != m_nodes[curNodeIndex].m_nextNodes.end() 
-		? itNext->second : 
-		CHEAT_TRIE_ROOT;
-}
\ No newline at end of file
+		CompiledIndex* pRow = &m_transitions[nodeIndex * ALPHABET_SIZE];
+		const CompiledIndex* pFailRow = &m_transitions[failIndex * ALPHABET_SIZE];
+		std::copy(pFailRow, pFailRow + ALPHABET_SIZE, pRow);
+
+		for (const auto& edge : node.m_nextNodes)
+		{
+			failLinks[edge.second] = pFailRow[edge.first];
+			pRow[edge.first] = edge.second;
+			pending.push_back(edge.second);
+		}
+	}
+
+	m_compiled = true;
+}
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <cinttypes>
-#include <unordered_map>
 #include <vector>
+#include <array>
 #include <optional>
+#include <utility>
 
 namespace geng
 {
 
-	// A trie that tracks cheats as sequences of inputs, stored in an indexed vector
-	// The index "0" always corresponds to the root.  It may succeed no one and when
-	// it is hit, the trace has failed
+	// A trie of cheats as sequences of inputs, stored in an indexed vector, and compiled into
+	// an Aho-Corasick automaton:  a dense table of next states with the failure links folded in.
+	// Every input is one table lookup, and on a mismatch the trace carries on from the longest
+	// cheat prefix it still ends in, so cheats that overlap (or start inside one another) are found.
+	// The index "0" always corresponds to the root, i.e. no cheat is in progress.
+	// The alphabet is what the text keys type:  'a' to 'z' and '0' to '9'
 
 	using CheatKey = uint32_t;
 	using TrieIndex = size_t;
@@ -19,33 +23,72 @@ namespace geng
 
 	class CheatTrie
 	{
+	public:
+		static constexpr size_t ALPHABET_SIZE = 26 + 10;
+
 	private:
+		using CompiledIndex = uint32_t;
+		static constexpr uint8_t NO_SYMBOL = 0xff;
+
 		struct TrieNode
 		{
 			std::optional<CheatKey> key{};
-			// One could of course use an array.  But that's a lot of useless bloat
-			// An unordered_map from chars is a good compromise
-			std::unordered_map<char,TrieIndex> m_nextNodes;
+			// The trie's own edges, as (symbol, node); only the compiler reads them
+			std::vector<std::pair<uint8_t, CompiledIndex> > m_nextNodes;
 		};
+
 	public:
 		CheatTrie();
 
+		// Returns the entry's node, or the root if the entry has a character outside the alphabet
 		TrieIndex AddEntry(const char* pEntry, CheatKey key);
+
+		// Build the automaton.  Entries may be added afterwards, but must be compiled again
+		void Compile();
+		bool IsCompiled() const { return m_compiled; }
+
+		// A node has a key if a cheat ends there -- its own, or failing that the longest
+		// one it ends with.  Only valid when compiled
 		bool HasKey(TrieIndex idx) const
 		{
-			return idx < m_nodes.size() && m_nodes[idx].key.has_value();
+			return idx < m_matches.size() && m_matches[idx].has_value();
 		}
 
 		CheatKey GetKey(TrieIndex idx) const
 		{
-			return *(m_nodes[idx].key);
+			return *(m_matches[idx]);
+		}
+
+		// Only valid when compiled.  A character outside the alphabet goes back to the root
+		TrieIndex GetNext(TrieIndex cur, char cNext) const
+		{
+			uint8_t symbol = GetSymbol(cNext);
+			if (symbol == NO_SYMBOL || cur >= m_matches.size())
+			{
+				return CHEAT_TRIE_ROOT;
+			}
+
+			return m_transitions[cur * ALPHABET_SIZE + symbol];
 		}
 
-		TrieIndex GetNext(TrieIndex cur, char cNext) const;
+		size_t GetNodeCount() const { return m_nodes.size(); }
 
 	private:
+		static uint8_t GetSymbol(char c)
+		{
+			return s_symbols[(unsigned char)c];
+		}
+
+		static std::array<uint8_t, 256> MakeSymbolTable();
+		static const std::array<uint8_t, 256> s_symbols;
+
 		std::vector<TrieNode>   m_nodes;
+
+		// The automaton:  ALPHABET_SIZE next states per node, and the cheat matched at each
+		bool m_compiled{ false };
+		std::vector<CompiledIndex> m_transitions;
+		std::vector<std::optional<CheatKey> > m_matches;
 	};
 
-	
-}
\ No newline at end of file
+
+}
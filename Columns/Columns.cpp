@@ -6,10 +6,19 @@
 #include <SDL.h>
 #include <SDL_ttf.h>
 #include <unordered_map>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+#include <filesystem>
 
 #include "DefaultGame.h"
 #include "ColumnsExecutive.h"
 #include "CommandLine.h"
+#include "ReplayVerifier.h"
+#include "FrameExporter.h"
+#include "SpectatorFeed.h"
+#include "ActionCommands.h"
+#include "DataPacket.h"
 
 #include "DTSimple.h"
 #include "DTJsonSerializer.h"
@@ -21,6 +30,28 @@ namespace
 {
 	const char* RecordArgumentName() { return "record"; };
 	const char* PlaybackArgumentName() { return "playback"; }
+	const char* CompressArgumentName() { return "compress"; }
+	const char* VerifyArgumentName() { return "verify"; }
+	const char* ThreadsArgumentName() { return "threads"; }
+	const char* ExportArgumentName() { return "export"; }
+	const char* OutArgumentName() { return "out"; }
+	const char* CsvArgumentName() { return "csv"; }
+	const char* FeedArgumentName() { return "feed"; }
+	const char* WatchArgumentName() { return "watch"; }
+	const char* BlackboxArgumentName() { return "blackbox"; }
+	const char* LoopbackArgumentName() { return "loopback"; }
+	const char* LateLatchArgumentName() { return "latch"; }
+	const char* InputThreadArgumentName() { return "inputthread"; }
+	const char* ScriptArgumentName() { return "script"; }
+	const char* RandomArgumentName() { return "random"; }
+	const char* SeedArgumentName() { return "seed"; }
+	const char* GamesArgumentName() { return "games"; }
+
+	// The flight recorder is always on in play; this is how much of the game it keeps
+	constexpr unsigned int DEFAULT_FLIGHT_RECORDER_MINUTES = 5;
+	const char* DefaultFlightRecorderFile() { return "blackbox.dem"; }
+	// Under the demo directory, unless --out says otherwise
+	const char* DefaultExportDirectory() { return "frames"; }
 }
 
 bool InitSDL()
@@ -53,7 +84,8 @@ void DeinitSDL()
 }
 
 bool InitializeGameComponents(const std::shared_ptr<geng::IGame>& pGame,
-	const std::unordered_map<std::string,geng::cmdline::ArgValues>& cmdLineMap)
+	const std::unordered_map<std::string,geng::cmdline::ArgValues>& cmdLineMap,
+	std::shared_ptr<geng::columns::ColumnsExecutive>& pExecutiveOut)
 {
 	// Recording/playback
 	geng::columns::ExecutiveSettings execSettings;
@@ -70,6 +102,7 @@ bool InitializeGameComponents(const std::shared_ptr<geng::IGame>& pGame,
 		execSettings.pbMode = geng::PlaybackMode::Record;
 		const auto& recordFileEntry = cmdLineMap.at(RecordArgumentName());
 		execSettings.pbFileName = recordFileEntry.vals.at(0);
+		execSettings.compressDemo = cmdLineMap.count(CompressArgumentName()) > 0;
 	}
 	else if (cmdLineMap.count(PlaybackArgumentName()) > 0)
 	{
@@ -78,6 +111,59 @@ bool InitializeGameComponents(const std::shared_ptr<geng::IGame>& pGame,
 		execSettings.pbFileName = playbackFileEntry.vals.at(0);
 	}
 
+	if (cmdLineMap.count(FeedArgumentName()) > 0)
+	{
+		execSettings.spectatorFeed = cmdLineMap.at(FeedArgumentName()).vals.at(0);
+	}
+
+	// F12 or a crash dumps the flight recorder; --blackbox names the file, and dumps on quit too
+	execSettings.flightRecorderMinutes = DEFAULT_FLIGHT_RECORDER_MINUTES;
+	execSettings.flightRecorderFile = DefaultFlightRecorderFile();
+	auto itBlackbox = cmdLineMap.find(BlackboxArgumentName());
+	if (itBlackbox != cmdLineMap.end())
+	{
+		execSettings.flightRecorderFile = itBlackbox->second.vals.at(0);
+		if (itBlackbox->second.vals.size() > 1)
+		{
+			execSettings.flightRecorderMinutes = (unsigned int)std::strtoul(itBlackbox->second.vals.at(1).c_str(), nullptr, 10);
+		}
+	}
+
+	// Play through a loopback peer:  --loopback <delay ms> [jitter ms]
+	auto itLoopback = cmdLineMap.find(LoopbackArgumentName());
+	if (itLoopback != cmdLineMap.end())
+	{
+		execSettings.loopbackPeer = true;
+		execSettings.loopbackDelayMs = (unsigned int)std::strtoul(itLoopback->second.vals.at(0).c_str(), nullptr, 10);
+		if (itLoopback->second.vals.size() > 1)
+		{
+			execSettings.loopbackJitterMs = (unsigned int)std::strtoul(itLoopback->second.vals.at(1).c_str(), nullptr, 10);
+		}
+	}
+
+	// Take in input again right before the sim, rather than only at the start of the frame
+	execSettings.lateLatchInput = cmdLineMap.count(LateLatchArgumentName()) > 0;
+	// Read the keyboard at 1kHz on a thread of its own
+	execSettings.inputThread = cmdLineMap.count(InputThreadArgumentName()) > 0;
+
+	// Let a script or random presses play the game; either way, --seed fixes the game's seed
+	auto itSeed = cmdLineMap.find(SeedArgumentName());
+	if (itSeed != cmdLineMap.end())
+	{
+		execSettings.fixedSeed = true;
+		execSettings.randomSeed = std::strtoull(itSeed->second.vals.at(0).c_str(), nullptr, 10);
+	}
+
+	if (cmdLineMap.count(ScriptArgumentName()) > 0)
+	{
+		execSettings.inputSource = geng::columns::InputSource::Script;
+		execSettings.inputScript = cmdLineMap.at(ScriptArgumentName()).vals.at(0);
+	}
+	else if (cmdLineMap.count(RandomArgumentName()) > 0)
+	{
+		execSettings.inputSource = geng::columns::InputSource::Random;
+	}
+
 	// The executive initializes all other components
 	auto pExecutive = std::make_shared<geng::columns::ColumnsExecutive>(execSettings);
 
@@ -88,18 +174,185 @@ bool InitializeGameComponents(const std::shared_ptr<geng::IGame>& pGame,
 	}
 
 	pGame->AddComponent(pExecutive);
+	pExecutiveOut = pExecutive;
 
 	return true;
 }
 
 
-int main(int argc, char** argv)
+geng::columns::ReplayArgs GetReplayArgs(const std::unordered_map<std::string, geng::cmdline::ArgValues>& cmdLineMap,
+	unsigned long msTimePerFrame)
 {
-	if (!InitSDL())
+	geng::columns::ReplayArgs replayArgs;
+	replayArgs.msTimePerFrame = msTimePerFrame;
+
+	auto itThreads = cmdLineMap.find(ThreadsArgumentName());
+	if (itThreads != cmdLineMap.end())
 	{
+		replayArgs.threadCount = (unsigned int)std::strtoul(itThreads->second.vals.at(0).c_str(), nullptr, 10);
+	}
+
+	return replayArgs;
+}
+
+int VerifyReplays(const std::unordered_map<std::string, geng::cmdline::ArgValues>& cmdLineMap,
+	unsigned long msTimePerFrame)
+{
+	// Play back every demo in the directory headlessly -- no SDL required
+	geng::columns::ReplayArgs replayArgs = GetReplayArgs(cmdLineMap, msTimePerFrame);
+
+	std::vector<std::string> demoFiles;
+	std::string listError;
+	if (!geng::columns::ListDemoFiles(cmdLineMap.at(VerifyArgumentName()).vals.at(0).c_str(), 
+		demoFiles, 
+		listError))
+	{
+		std::cerr << listError << '\n';
+		return -1;
+	}
+
+	std::vector<geng::columns::ReplayReport> reports;
+	geng::columns::ReplayDemoFiles(demoFiles, replayArgs, reports);
+
+	return geng::columns::PrintReplayReports(std::cout, reports) == 0 ? 0 : 1;
+}
+
+int ExportReplays(const std::unordered_map<std::string, geng::cmdline::ArgValues>& cmdLineMap,
+	unsigned long msTimePerFrame)
+{
+	// Replay every demo in the directory headlessly and write out a per-frame table for each
+	geng::columns::ReplayArgs replayArgs = GetReplayArgs(cmdLineMap, msTimePerFrame);
+
+	const std::string& demoDirectory = cmdLineMap.at(ExportArgumentName()).vals.at(0);
+	auto itOut = cmdLineMap.find(OutArgumentName());
+	std::filesystem::path outDirectory = itOut != cmdLineMap.end() ? std::filesystem::path(itOut->second.vals.at(0))
+		: std::filesystem::path(demoDirectory) / DefaultExportDirectory();
+
+	// Tables in the demo directory would be read as demos the next time round
+	std::error_code errCode;
+	std::filesystem::create_directories(outDirectory, errCode);
+	if (errCode)
+	{
+		std::cerr << "Could not create directory " << outDirectory.string() << ": " << errCode.message() << '\n';
+		return -1;
+	}
+	if (std::filesystem::equivalent(outDirectory, demoDirectory, errCode))
+	{
+		std::cerr << "The frame tables can't go in the demo directory; give --out another one\n";
+		return -1;
+	}
+
+	auto format = cmdLineMap.count(CsvArgumentName()) > 0 ? geng::columns::FrameTableFormat::CSV
+		: geng::columns::FrameTableFormat::Binary;
+
+	std::vector<std::string> demoFiles;
+	std::string listError;
+	if (!geng::columns::ListDemoFiles(demoDirectory.c_str(), demoFiles, listError))
+	{
+		std::cerr << listError << '\n';
 		return -1;
 	}
 
+	std::vector<geng::columns::ReplayReport> reports;
+	geng::columns::ExportDemoFiles(demoFiles, outDirectory.string().c_str(), format, replayArgs, reports);
+
+	return geng::columns::PrintReplayReports(std::cout, reports) == 0 ? 0 : 1;
+}
+
+int PlayGames(const std::unordered_map<std::string, geng::cmdline::ArgValues>& cmdLineMap,
+	unsigned long msTimePerFrame)
+{
+	// Play a run of games headlessly, with a script or random presses at the controls
+	geng::columns::ReplayArgs replayArgs = GetReplayArgs(cmdLineMap, msTimePerFrame);
+
+	geng::columns::SyntheticGameArgs gameArgs;
+	auto itScript = cmdLineMap.find(ScriptArgumentName());
+	if (itScript != cmdLineMap.end())
+	{
+		gameArgs.inputSource = geng::columns::InputSource::Script;
+		gameArgs.scriptFile = itScript->second.vals.at(0);
+	}
+
+	auto itSeed = cmdLineMap.find(SeedArgumentName());
+	if (itSeed != cmdLineMap.end())
+	{
+		gameArgs.firstSeed = std::strtoull(itSeed->second.vals.at(0).c_str(), nullptr, 10);
+	}
+
+	size_t gameCount = std::strtoul(cmdLineMap.at(GamesArgumentName()).vals.at(0).c_str(), nullptr, 10);
+
+	std::vector<geng::columns::ReplayReport> reports;
+	geng::columns::PlaySyntheticGames(gameArgs, gameCount, replayArgs, reports);
+
+	return geng::columns::PrintGameReports(std::cout, reports) == 0 ? 0 : 1;
+}
+
+int WatchFeed(const char* pFeedName)
+{
+	// Follow a live game's spectator feed and print the player's actions as they change
+	geng::serial::SpectatorFeedReader feedReader(pFeedName);
+	if (!feedReader.IsValid())
+	{
+		std::cerr << feedReader.GetError() << '\n';
+		return -1;
+	}
+
+	std::vector<std::shared_ptr<geng::serial::ISerializableCommand> > commandList;
+	std::vector<std::shared_ptr<geng::ActionCommand> > actionCommands;
+	for (const std::string& cmdKey : feedReader.GetCommandKeys())
+	{
+		actionCommands.emplace_back(std::make_shared<geng::ActionCommand>(cmdKey.c_str()));
+		commandList.emplace_back(actionCommands.back());
+	}
+
+	auto pSimArgsPacket = std::make_shared<geng::serial::DataPacket<geng::columns::SimArgs> >();
+	if (!feedReader.BindCommands(pSimArgsPacket, commandList))
+	{
+		std::cerr << feedReader.GetError() << '\n';
+		return -1;
+	}
+	std::cout << "Watching " << pFeedName << ", random seed " << pSimArgsPacket->Get().randomSeed << '\n';
+
+	std::vector<bool> prevStates(actionCommands.size(), false);
+	while (true)
+	{
+		auto pollResult = feedReader.Poll();
+		if (pollResult == geng::serial::SpectatorPollResult::NoFrame)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if (pollResult == geng::serial::SpectatorPollResult::Ended)
+		{
+			std::cout << "Game over at frame " << feedReader.GetFrame() << '\n';
+			return 0;
+		}
+		if (pollResult == geng::serial::SpectatorPollResult::Error)
+		{
+			std::cerr << feedReader.GetError() << '\n';
+			return -1;
+		}
+		if (pollResult == geng::serial::SpectatorPollResult::Resynced)
+		{
+			std::cout << "Synced at frame " << feedReader.GetFrame() << ", "
+				<< feedReader.GetSimState().size() << " bytes of game state\n";
+		}
+
+		for (size_t cmdIdx = 0; cmdIdx < actionCommands.size(); ++cmdIdx)
+		{
+			bool curState = actionCommands[cmdIdx]->GetState();
+			if (curState != prevStates[cmdIdx])
+			{
+				std::cout << feedReader.GetFrame() << ' ' << actionCommands[cmdIdx]->GetKey()
+					<< (curState ? " down" : " up") << '\n';
+				prevStates[cmdIdx] = curState;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
 	geng::DefaultGameArgs gameArgs;
 	gameArgs.msBreather = 1;
 	gameArgs.msTimePerFrame = 20;
@@ -107,7 +360,23 @@ int main(int argc, char** argv)
 
 	std::vector<geng::cmdline::ArgDesc>
 		cmdArgDescs{ geng::cmdline::ArgDesc(RecordArgumentName(), "r", true, 1,1),
-				geng::cmdline::ArgDesc(PlaybackArgumentName(), "p", true, 1, 1) };
+				geng::cmdline::ArgDesc(PlaybackArgumentName(), "p", true, 1, 1),
+				geng::cmdline::ArgDesc(CompressArgumentName(), "z", true, 0, 0),
+				geng::cmdline::ArgDesc(VerifyArgumentName(), "v", true, 1, 1),
+				geng::cmdline::ArgDesc(ThreadsArgumentName(), "j", true, 1, 1),
+				geng::cmdline::ArgDesc(ExportArgumentName(), "x", true, 1, 1),
+				geng::cmdline::ArgDesc(OutArgumentName(), "o", true, 1, 1),
+				geng::cmdline::ArgDesc(CsvArgumentName(), "c", true, 0, 0),
+				geng::cmdline::ArgDesc(FeedArgumentName(), "f", true, 1, 1),
+				geng::cmdline::ArgDesc(WatchArgumentName(), "w", true, 1, 1),
+				geng::cmdline::ArgDesc(BlackboxArgumentName(), "b", true, 1, 2),
+				geng::cmdline::ArgDesc(LoopbackArgumentName(), "l", true, 1, 2),
+				geng::cmdline::ArgDesc(LateLatchArgumentName(), "a", true, 0, 0),
+				geng::cmdline::ArgDesc(InputThreadArgumentName(), "i", true, 0, 0),
+				geng::cmdline::ArgDesc(ScriptArgumentName(), "s", true, 1, 1),
+				geng::cmdline::ArgDesc(RandomArgumentName(), "n", true, 0, 0),
+				geng::cmdline::ArgDesc(SeedArgumentName(), "e", true, 1, 1),
+				geng::cmdline::ArgDesc(GamesArgumentName(), "g", true, 1, 1) };
 	std::unordered_map<std::string, geng::cmdline::ArgValues> argMap;
 	std::string cmdLineError;
 	if (!geng::cmdline::ProcessArgs(cmdArgDescs,
@@ -123,14 +392,48 @@ int main(int argc, char** argv)
 		return -1;
 	}
 
-	if (!InitializeGameComponents(pGame,argMap))
+	if (argMap.count(VerifyArgumentName()) > 0)
+	{
+		return VerifyReplays(argMap, gameArgs.msTimePerFrame);
+	}
+
+	if (argMap.count(ExportArgumentName()) > 0)
+	{
+		return ExportReplays(argMap, gameArgs.msTimePerFrame);
+	}
+
+	if (argMap.count(GamesArgumentName()) > 0)
+	{
+		return PlayGames(argMap, gameArgs.msTimePerFrame);
+	}
+
+	if (argMap.count(WatchArgumentName()) > 0)
+	{
+		return WatchFeed(argMap.at(WatchArgumentName()).vals.at(0).c_str());
+	}
+
+	if (!InitSDL())
+	{
+		return -1;
+	}
+
+	std::shared_ptr<geng::columns::ColumnsExecutive> pExecutive;
+	if (!InitializeGameComponents(pGame, argMap, pExecutive))
 	{
 		std::cerr << "Could not initialize the game.\n";
 		return -1;
 	}
 
 	// Run!
-	if (!pGame->Run())
+	bool runOK = pGame->Run();
+
+	if (argMap.count(BlackboxArgumentName()) > 0)
+	{
+		pExecutive->DumpFlightRecorder();
+	}
+	pExecutive.reset();
+
+	if (!runOK)
 	{
 		std::cerr << "Exited abnormally\n";
 		pGame.reset();
@@ -38,11 +38,41 @@ namespace geng
 			RandomSeedType randomSeed;
 		};
 
+		// Where a player's actions come from when the game isn't played back
+		enum class InputSource
+		{
+			Keyboard,
+			Script,
+			Random,
+			Bot
+		};
+
 		struct InputArgs
 		{
 			PlaybackMode pbMode;
 			std::string fileName;
 			unsigned int userPlayer;
+			bool compressDemo{ false };
+			bool allowUnsafePlayback{ false };
+			// Name of the shared-memory spectator feed to publish, if any
+			std::string spectatorFeed;
+			// How much of the game the flight recorder keeps in memory; 0 turns it off
+			unsigned int flightRecorderMinutes{ 0 };
+			// Where the flight recorder is dumped on demand or on a crash
+			std::string flightRecorderFile;
+			// Send the user's input through a loopback with this delay and jitter, and let it drive
+			// the board as a remote player's would, rolling back when it arrives late
+			bool loopbackPeer{ false };
+			unsigned int loopbackDelayMs{ 0 };
+			unsigned int loopbackJitterMs{ 0 };
+			// Take in input again right before the sim runs, for presses that came in during the frame
+			bool lateLatch{ false };
+			// Anything but the keyboard plays the game by itself.  The script and the bot are
+			// handed to ColumnsInput directly
+			InputSource inputSource{ InputSource::Keyboard };
+			// Play with this random seed rather than a fresh one; the random input source draws from it too
+			bool fixedSeed{ false };
+			RandomSeedType randomSeed{ 0 };
 		};
 
 		struct ColumnsArgs
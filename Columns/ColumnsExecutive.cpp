@@ -12,6 +12,11 @@
 #include <array>
 
 #include "InputBridge.h"
+#include "LoopbackTransport.h"
+#include "SDLKeySampler.h"
+
+#include <random>
+#include <iostream>
 
 geng::columns::ColumnsExecutive::ColumnsExecutive(const ExecutiveSettings& settings)
 	:BaseGameComponent(GetExecutiveName()),
@@ -22,23 +27,69 @@ geng::columns::ColumnsExecutive::ColumnsExecutive(const ExecutiveSettings& setti
 	m_columnsArgs.inputArgs.pbMode = settings.pbMode;
 	m_columnsArgs.inputArgs.fileName = settings.pbFileName;
 	m_columnsArgs.inputArgs.userPlayer = 0;
+	m_columnsArgs.inputArgs.compressDemo = settings.compressDemo;
+	m_columnsArgs.inputArgs.allowUnsafePlayback = settings.allowUnsafePlayback;
+	m_columnsArgs.inputArgs.spectatorFeed = settings.spectatorFeed;
+	m_columnsArgs.inputArgs.flightRecorderMinutes = settings.flightRecorderMinutes;
+	m_columnsArgs.inputArgs.flightRecorderFile = settings.flightRecorderFile;
+	m_columnsArgs.inputArgs.loopbackPeer = settings.loopbackPeer;
+	m_columnsArgs.inputArgs.loopbackDelayMs = settings.loopbackDelayMs;
+	m_columnsArgs.inputArgs.loopbackJitterMs = settings.loopbackJitterMs;
+	m_columnsArgs.inputArgs.lateLatch = settings.lateLatchInput;
+	m_columnsArgs.inputArgs.inputSource = settings.inputSource;
+	m_columnsArgs.inputArgs.fixedSeed = settings.fixedSeed;
+	m_columnsArgs.inputArgs.randomSeed = settings.randomSeed;
+	m_inputScript = settings.inputScript;
+	m_botPolicy = settings.botPolicy;
+
+	m_headless = settings.headless;
+	m_inputThread = settings.inputThread;
+	if (m_headless)
+	{
+		m_cheatsEnabled = false;
+	}
 }
 
 bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pGame)
 {
 	// Precreate certain components
-	setup::InitializeSDLRendering(pGame.get(), "Columns", 640 + 320, 480 + 240);
-	auto pResLoader =  std::static_pointer_cast<geng::ResourceLoader>
-		(setup::InitializeResourceLoader(pGame.get()));
+	std::shared_ptr<sdl::EventPoller> pPoller;
+	std::shared_ptr<sdl::Input> pSDLInput;
+	if (!m_headless)
+	{
+		setup::InitializeSDLRendering(pGame.get(), "Columns", 640 + 320, 480 + 240);
+		auto pResLoader = std::static_pointer_cast<geng::ResourceLoader>
+			(setup::InitializeResourceLoader(pGame.get()));
+
+		std::vector<std::string> fontSearchPaths{ "c:\\windows\\fonts", "." };
+		auto pTTFFactory = std::make_shared<geng::sdl::TTFFactory>(fontSearchPaths);
+		pResLoader->AddFactory(pTTFFactory);
+
+		pPoller = std::static_pointer_cast<sdl::EventPoller>
+			(setup::InitializeSDLPoller(pGame.get()));
+		m_pEventPoller = pPoller;
 
-	std::vector<std::string> fontSearchPaths{"c:\\windows\\fonts", "."};
-	auto pTTFFactory = std::make_shared<geng::sdl::TTFFactory>(fontSearchPaths);
-	pResLoader->AddFactory(pTTFFactory);
+		if (m_inputThread)
+		{
+			std::unique_ptr<IInputEventSource> pKeySampler = sdl::CreateKeySampler();
+			if (pKeySampler)
+			{
+				pPoller->StartInputThread(std::unique_ptr<InputThread>(new InputThread(std::move(pKeySampler))));
+			}
+			else
+			{
+				pGame->LogError("Columns: no input thread on this platform; keys come through SDL");
+			}
+		}
 
-	auto pPoller = std::static_pointer_cast<sdl::EventPoller>
-		(setup::InitializeSDLPoller(pGame.get()));
+		pSDLInput = std::static_pointer_cast<sdl::Input>(setup::InitializeSDLInput(pGame.get()));
+		m_pInput = pSDLInput;
+	}
+	else
+	{
+		m_pInput = std::static_pointer_cast<IInput>(setup::InitializeNullInput(pGame.get()));
+	}
 
-	m_pInput = std::static_pointer_cast<sdl::Input>(setup::InitializeSDLInput(pGame.get()));
 	m_spaceKey.keyCode = SDLK_SPACE;
 	AddKeySub(&m_spaceKey);
 
@@ -47,6 +98,9 @@ bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pG
 
 	m_escKey.keyCode = SDLK_ESCAPE;
 	AddKeySub(&m_escKey);
+
+	m_dumpKey.keyCode = SDLK_F12;
+	AddKeySub(&m_dumpKey);
 	
 	ThrottleSettings throttleSettings;
 	throttleSettings.dropThrottlePeriod = 100;
@@ -58,15 +112,15 @@ bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pG
 
 	// Add the event poller and the overall input as executive listeners to execute before the executive itself
 	// This means they will run first in any frame, regardless of context
-	if (!pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT,
+	if (pPoller && !pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT,
 		pPoller))
 	{
 		pGame->LogError("Columns: unable to add SDL event poller as listener");
 		return false;
 	}
 
-	if (!pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT,
-		m_pInput))
+	if (pSDLInput && !pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT,
+		pSDLInput))
 	{
 		pGame->LogError("Columns: unable to add SDL input handler as listener");
 		return false;
@@ -92,6 +146,32 @@ bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pG
 														pGame->GetGameArgs().msTimePerFrame);
 	pGame->AddComponent(m_pColumnsInput);
 
+	// Something other than the keyboard may play the game
+	if (m_columnsArgs.inputArgs.inputSource == InputSource::Script)
+	{
+		auto pScript = std::make_shared<ActionScript>();
+		std::string scriptError;
+		if (!pScript->Load(m_inputScript.c_str()))
+		{
+			pGame->LogError(pScript->GetError().c_str());
+			return false;
+		}
+		if (!m_pColumnsInput->SetActionScript(pScript, scriptError))
+		{
+			pGame->LogError(scriptError.c_str());
+			return false;
+		}
+	}
+	else if (m_columnsArgs.inputArgs.inputSource == InputSource::Bot)
+	{
+		if (!m_botPolicy)
+		{
+			pGame->LogError("Columns: the bot input source needs a bot");
+			return false;
+		}
+		m_pColumnsInput->SetActionBot(m_botPolicy);
+	}
+
 	// Preinitialize, but do not yet use, the columns sim arguments
 
 	m_columnsArgs.simArgs.boardSize.x = 9;
@@ -105,12 +185,27 @@ bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pG
 	m_pSim = std::make_shared<geng::columns::ColumnsSim>();
 	pGame->AddComponent(m_pSim);
 
+	// The user's input goes round the loopback and comes back as the remote player's
+	const InputArgs& inputArgs = m_columnsArgs.inputArgs;
+	if (inputArgs.loopbackPeer)
+	{
+		std::random_device randomDevice;
+		std::unique_ptr<IInputTransport> pTransport{ new LoopbackTransport(inputArgs.loopbackDelayMs,
+			inputArgs.loopbackJitterMs,
+			randomDevice()) };
+		m_pRollback = std::make_shared<RollbackController>(std::move(pTransport),
+			pGame->GetGameArgs().msTimePerFrame);
+		pGame->AddComponent(m_pRollback);
+	}
+
 	// Create the columns SDL renderer
-	geng::columns::ColumnsRenderArgs renderArgs;
-	renderArgs.renderShadow = 4;
-	auto pRenderer = std::make_shared<geng::columns::ColumnsSDLRenderer>(renderArgs);
-	pGame->AddComponent(pRenderer);
-	m_pSDLRenderer = pRenderer;
+	if (!m_headless)
+	{
+		geng::columns::ColumnsRenderArgs renderArgs;
+		renderArgs.renderShadow = 4;
+		m_pSDLRenderer = std::make_shared<geng::columns::ColumnsSDLRenderer>(renderArgs);
+		pGame->AddComponent(m_pSDLRenderer);
+	}
 	
 	// Add the three components (input, sim, renderer) to the context as listeners
 	if (!pGame->AddListener(ListenerType::Input, m_simContextId, pInputBridge))
@@ -125,13 +220,20 @@ bool geng::columns::ColumnsExecutive::AddToGame(const std::shared_ptr<IGame>& pG
 		return false;
 	}
 
+	// Between the user's commands and the sim
+	if (m_pRollback && !pGame->AddListener(ListenerType::Input, m_simContextId, m_pRollback))
+	{
+		pGame->LogError("Columns: unable to add rollback controller as listener");
+		return false;
+	}
+
 	if (!pGame->AddListener(ListenerType::Simulation, m_simContextId, m_pSim))
 	{
 		pGame->LogError("Columns: unable to add simulation as listener");
 		return false;
 	}
 
-	if (!pGame->AddListener(ListenerType::Rendering, m_simContextId, pRenderer))
+	if (m_pSDLRenderer && !pGame->AddListener(ListenerType::Rendering, m_simContextId, m_pSDLRenderer))
 	{
 		pGame->LogError("Columns: unable to add renderer as listener");
 		return false;
@@ -189,16 +291,46 @@ void geng::columns::ColumnsExecutive::OnEnterState(NoGameState& ngs)
 
 	if (IsInGameState(m_prevContextState))
 	{
-		m_pSDLRenderer->OnEndGame();
+		if (m_pSDLRenderer)
+		{
+			m_pSDLRenderer->OnEndGame();
+		}
 		m_pSim->OnEndGame();
+		if (m_pRollback)
+		{
+			m_pRollback->OnEndGame();
+		}
 		m_pColumnsInput->OnEndGame();
 
+		const InputLatencyStats& latency = m_pColumnsInput->GetInputLatency();
+		if (latency.presses > 0)
+		{
+			std::cout << "Input to sim latency over " << latency.presses << " presses: average "
+				<< latency.totalMs / latency.presses << "ms, worst " << latency.worstMs << "ms\n";
+		}
+
+		// Presses the game never saw
+		if (m_pEventPoller)
+		{
+			unsigned long droppedEvents = m_pEventPoller->GetDroppedInputEvents() - m_droppedInputEvents;
+			if (droppedEvents > 0)
+			{
+				std::cout << "The input thread's queue was full; " << droppedEvents << " key transitions were lost\n";
+			}
+		}
+
 		// Suspend execution
 		auto pGame = m_pGame.lock();
 
 		if (pGame)
 		{
 			pGame->SetRunState(m_simContextId, false);
+
+			// A headless run plays exactly one game
+			if (m_headless)
+			{
+				pGame->Quit();
+			}
 		}
 	}
 }
@@ -220,8 +352,26 @@ void geng::columns::ColumnsExecutive::OnEnterState(ActiveGameState& ags)
 		}
 
 		m_pColumnsInput->OnStartGame(m_columnsArgs);
+		if (m_pEventPoller)
+		{
+			m_droppedInputEvents = m_pEventPoller->GetDroppedInputEvents();
+		}
 		m_pSim->OnStartGame();
-		m_pSDLRenderer->OnStartGame();
+		if (m_pRollback)
+		{
+			m_pRollback->OnStartGame();
+		}
+		if (m_pSDLRenderer)
+		{
+			m_pSDLRenderer->OnStartGame();
+		}
+
+		// A recording of a game in progress goes on from its own frame
+		const serial::CommandStartState* pStartState = m_pColumnsInput->GetStartState();
+		if (pGame && pStartState)
+		{
+			pGame->SetFrameIndex(m_simContextId, pStartState->frame);
+		}
 
 		if (!m_startGameError)
 		{
@@ -243,7 +393,10 @@ void geng::columns::ColumnsExecutive::OnEnterState(ActiveGameState& ags)
 
 		m_pColumnsInput->OnPauseGame(false);
 		m_pSim->OnPauseGame(false);
-		m_pSDLRenderer->OnPauseGame(false);
+		if (m_pSDLRenderer)
+		{
+			m_pSDLRenderer->OnPauseGame(false);
+		}
 	}
 	
 }
@@ -263,13 +416,27 @@ void geng::columns::ColumnsExecutive::OnEnterState(PausedGameState& pgs)
 	// Notify
 	m_pColumnsInput->OnPauseGame(true);
 	m_pSim->OnPauseGame(true);
-	m_pSDLRenderer->OnPauseGame(true);
+	if (m_pSDLRenderer)
+	{
+		m_pSDLRenderer->OnPauseGame(true);
+	}
 }
 
 void geng::columns::ColumnsExecutive::OnExitState(PausedGameState& pgs) {}
 
 void geng::columns::ColumnsExecutive::OnFrame(NoGameState&, const SimState& rSimState)
 {
+	if (m_headless)
+	{
+		// Nobody is there to press the key
+		if (!m_headlessGameStarted)
+		{
+			m_headlessGameStarted = true;
+			StartGame();
+		}
+		return;
+	}
+
 	if (IsKeyPressedOnce(m_spaceKey))
 	{
 		ResetKey(&m_spaceKey);
@@ -337,12 +504,41 @@ void geng::columns::ColumnsExecutive::OnFrame(const SimState& rSimState,
 	// Key states
 	m_pInput->QueryInput(nullptr, nullptr, m_keySubs.data(), m_keySubs.size());
 
+	// The flight recorder can be dumped at any time, including after the game is over
+	if (IsKeyPressedOnce(m_dumpKey))
+	{
+		ResetKey(&m_dumpKey);
+		DumpFlightRecorder();
+	}
+
 	InvokeHelper<OnFrameSelector, ColumnsExecutive>
 		invokeHelperOnFrame(*this);
 
 	DispatchInvoke(invokeHelperOnFrame, rSimState);
 }
 
+bool geng::columns::ColumnsExecutive::DumpFlightRecorder()
+{
+	FlightRecorder* pRecorder = m_pColumnsInput->GetFlightRecorder();
+	if (!pRecorder)
+	{
+		return false;
+	}
+
+	const InputArgs& inputArgs = m_columnsArgs.inputArgs;
+	if (!pRecorder->Dump(inputArgs.flightRecorderFile.c_str(), inputArgs.compressDemo))
+	{
+		auto pGame = m_pGame.lock();
+		if (pGame)
+		{
+			pGame->LogError(pRecorder->GetError().c_str());
+		}
+		return false;
+	}
+
+	return true;
+}
+
 void geng::columns::ColumnsExecutive::UpdateCheatState(unsigned long execTime)
 {
 	if (m_cheatKey.has_value())
@@ -363,31 +559,34 @@ void geng::columns::ColumnsExecutive::UpdateCheatState(unsigned long execTime)
 	// Find the first active key
 	char curC;
 	bool hasChar{ false };
-	for (KeyState& state : m_alphaKeyStates)
+	for (size_t i = 0; i < m_alphaKeyStates.size(); ++i)
 	{
-		if (IsKeyPressedOnce(state))
+		if (IsKeyPressedOnce(m_alphaKeyStates[i]))
 		{
 			hasChar = true;
-			curC = sdl::GetTextFromKeyCode(state.keyCode);
+			curC = m_alphaKeyChars[i];
 			break;
 		}
 	}
 
 	if (hasChar)
 	{
-//		fprintf(stderr, "got char %c\n", curC);
-		TrieIndex nextNode = m_cheatTrie.GetNext(m_cheatState, curC);
-		if (nextNode != CHEAT_TRIE_ROOT)
+		// Cheats are added as the components initialize; the first keystroke after that compiles them
+		if (!m_cheatTrie.IsCompiled())
+		{
+			m_cheatTrie.Compile();
+		}
+
+		// A mismatch falls back to the longest cheat prefix still typed, rather than the root
+		m_cheatState = m_cheatTrie.GetNext(m_cheatState, curC);
+		if (m_cheatState != CHEAT_TRIE_ROOT)
 		{
-			// Advance
 			m_lastCheatInputTime = execTime;
-			m_cheatState = nextNode;
-			// Cheat?
+			// Cheat?  The trace stays where it is, since this may be a cheat inside a longer one
+			// ("bc" in "abcd") that still has to be finished
 			if (m_cheatTrie.HasKey(m_cheatState))
 			{
-//				fprintf(stderr, "Has key!!\n");
 				m_cheatKey.emplace(m_cheatTrie.GetKey(m_cheatState));
-				m_cheatState = CHEAT_TRIE_ROOT;
 			}
 		}
 	}
@@ -411,6 +610,7 @@ void geng::columns::ColumnsExecutive::SetupCheats(IInput* pInput)
 			m_alphaKeyStates[i].numChanges = 0;
 			m_alphaKeyStates[i].finalState = KeySignal::KeyUp;
 			m_alphaKeyRefs.emplace_back(&m_alphaKeyStates[i]);
+			m_alphaKeyChars.emplace_back(sdl::GetTextFromKeyCode(alphaKeys[i]));
 		}
 	}
 
@@ -5,10 +5,16 @@
 #include "SDLInput.h"
 #include "ColumnsSim.h"
 #include "ColumnsInput.h"
+#include "RollbackController.h"
 #include "CheatTrie.h"
 #include "SimStateDispatcher.h"
 #include <memory>
 
+namespace geng::sdl
+{
+	class EventPoller;
+}
+
 namespace geng::columns
 {
 	class ColumnsSDLRenderer;
@@ -31,6 +37,28 @@ namespace geng::columns
 	{
 		PlaybackMode pbMode;
 		std::string pbFileName;
+		bool compressDemo{ false };
+		bool allowUnsafePlayback{ false };
+		std::string spectatorFeed;
+		unsigned int flightRecorderMinutes{ 0 };
+		std::string flightRecorderFile;
+		bool loopbackPeer{ false };
+		unsigned int loopbackDelayMs{ 0 };
+		unsigned int loopbackJitterMs{ 0 };
+		bool lateLatchInput{ false };
+		// Sample the keyboard on a thread of its own, where the platform allows
+		bool inputThread{ false };
+		// Where the user's actions come from.  The script is a file of ActionScript steps; the bot
+		// is asked for the actions every frame
+		InputSource inputSource{ InputSource::Keyboard };
+		std::string inputScript;
+		ActionBotPolicy botPolicy;
+		// Play every game with this random seed, for runs that come out the same every time
+		bool fixedSeed{ false };
+		RandomSeedType randomSeed{ 0 };
+		// No window, no devices, no cheats.  The game starts right away, and the
+		// executive quits once it's over
+		bool headless{ false };
 	};
 
 
@@ -127,6 +155,9 @@ namespace geng::columns
 		}
 
 		void StartGameError(const char* pError);
+
+		// Write what the flight recorder holds to its file.  False if it's off or the write failed
+		bool DumpFlightRecorder();
 	private:
 		static void MapActions(ActionMapper& rMapper,
 							std::vector<ActionDesc>& columnsActions,
@@ -146,13 +177,24 @@ namespace geng::columns
 
 		bool m_initialized{ false };
 		bool m_startGameError{ false };
+		bool m_headless{ false };
+		bool m_headlessGameStarted{ false };
+		bool m_inputThread{ false };
+		std::string m_inputScript;
+		ActionBotPolicy m_botPolicy;
 
 		std::weak_ptr<IGame> m_pGame;
-		std::shared_ptr<sdl::Input>  m_pInput;
+		std::shared_ptr<IInput>  m_pInput;
 		std::shared_ptr<ColumnsInput>  m_pColumnsInput;
 		std::shared_ptr<ColumnsSim> m_pSim;
+		// Only with a loopback peer
+		std::shared_ptr<RollbackController> m_pRollback;
 		// TODO:  Generalize the game start/end interfaces!
 		std::shared_ptr<ColumnsSDLRenderer> m_pSDLRenderer;
+		// Not in headless runs
+		std::shared_ptr<sdl::EventPoller> m_pEventPoller;
+		// The input thread's count of dropped key transitions when the game started
+		unsigned long m_droppedInputEvents{ 0 };
 		
 		/*
 		geng::columns::InputArgs m_inputArgs;
@@ -170,6 +212,8 @@ namespace geng::columns
 		bool m_cheatsEnabled{ true };
 		std::vector<KeyState> m_alphaKeyStates;
 		std::vector<KeyState*> m_alphaKeyRefs;
+		// What each of the keys types
+		std::vector<char> m_alphaKeyChars;
  
 		// Cheat state
 		CheatTrie m_cheatTrie;
@@ -177,11 +221,12 @@ namespace geng::columns
 		unsigned long m_lastCheatInputTime;
 		std::optional<CheatKey> m_cheatKey;
 
-		// Keys: start, pause, escape
+		// Keys: start, pause, escape, dump the flight recorder
 		// NOTE:  The "escape" key will someday designate "open the menu"
 		KeyState m_spaceKey;
 		KeyState m_pauseKey;
 		KeyState m_escKey;
+		KeyState m_dumpKey;
 	};
 
 	// Helper function for getting cheats
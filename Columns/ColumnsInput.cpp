@@ -4,11 +4,13 @@
 
 #include <unordered_set>
 #include <sstream>
+#include <algorithm>
 
 geng::columns::ColumnsInput::ColumnsInput(const std::vector<ActionDesc>& vActions, unsigned int playerCount,
 	unsigned long msPerFrame)
 	:BaseGameComponent(ColumnsExecutive::GetColumnsInputComponentName()),
 	m_actionTranslator(new ActionTranslator()),
+	m_playerCount(playerCount),
 	m_msPerFrame(msPerFrame),
 	m_pSimArgsPacket(new serial::DataPacket<SimArgs>())
 {
@@ -77,6 +79,11 @@ bool geng::columns::ColumnsInput::Initialize(const std::shared_ptr<IGame>& pGame
 		return false;
 	}
 
+	for (ActionCommand_& actionCommand : m_actionCommands)
+	{
+		actionCommand.actionId = m_actionMapper->GetAction(actionCommand.actionName.c_str());
+	}
+
 	m_actionTranslator->SetInput(m_pInput);
 	m_actionMapper->GetAllMappings(m_actionTranslator);
 	m_actionMapper->AddMappingListener(m_actionTranslator);
@@ -87,40 +94,116 @@ bool geng::columns::ColumnsInput::Initialize(const std::shared_ptr<IGame>& pGame
 	return true;
 }
 
-void geng::columns::ColumnsInput::OnStartGame(const ColumnsArgs& args)
+bool geng::columns::ColumnsInput::SetActionScript(const std::shared_ptr<const ActionScript>& pScript, std::string& rErr)
 {
-	std::vector<CommandDesc>  commandDescriptions;
-
-	// Iterate through all the stored actions, and specify "throttled command streams" for the current player's
-	// actions.
-	for (const ActionCommand_& actionCommand : m_actionCommands)
+	for (const std::string& actionName : pScript->GetActionNames())
 	{
-		if (actionCommand.playerId == args.inputArgs.userPlayer)
+		if (std::find(m_actionNames.begin(), m_actionNames.end(), actionName) == m_actionNames.end())
 		{
-			ActionCommandStreamArgs actionStreamArgs(actionCommand.pCommand,
-				m_actionTranslator,
-				m_msPerFrame,
-				m_actionMapper->GetAction(actionCommand.actionName.c_str()));
-			FactorySharedPtr<ICommandStream> pActionFactory
-			{ CreateFactoryWithArgs<ThrottledActionCommandStream, ICommandStream>(actionStreamArgs, actionCommand.throttlePeriod)
-			};
-
-			commandDescriptions.emplace_back(actionCommand.pCommand, pActionFactory);
+			rErr = "ColumnsInput: the script names an unknown action: ";
+			rErr += actionName;
+			return false;
 		}
 	}
 
+	m_pActionScript = pScript;
+	return true;
+}
+
+geng::FactorySharedPtr<geng::ICommandStream> geng::columns::ColumnsInput::CreateStreamFactory(const ActionCommand_& actionCommand,
+	unsigned int actionIndex,
+	const InputArgs& inputArgs,
+	const std::shared_ptr<ActionBot>& pBot) const
+{
+	switch (inputArgs.inputSource)
+	{
+	case InputSource::Script:
+		return SharePooled(CreateFactoryWithArgs<ScriptedActionCommandStream, ICommandStream>(actionCommand.pCommand,
+			m_pActionScript,
+			actionCommand.actionName));
+	case InputSource::Random:
+	{
+		RandomActionArgs randomArgs;
+		randomArgs.seed = m_pSimArgsPacket->Get().randomSeed;
+		return SharePooled(CreateFactoryWithArgs<RandomActionCommandStream, ICommandStream>(actionCommand.pCommand,
+			randomArgs,
+			actionIndex));
+	}
+	case InputSource::Bot:
+		return SharePooled(CreateFactoryWithArgs<BotActionCommandStream, ICommandStream>(actionCommand.pCommand,
+			pBot,
+			actionIndex));
+	default:
+	{
+		ActionCommandStreamArgs actionStreamArgs(actionCommand.pCommand,
+			m_actionTranslator,
+			m_msPerFrame,
+			actionCommand.actionId);
+		return SharePooled(CreateFactoryWithArgs<ThrottledActionCommandStream, ICommandStream>(actionStreamArgs,
+			actionCommand.throttlePeriod));
+	}
+	}
+}
 
+void geng::columns::ColumnsInput::OnStartGame(const ColumnsArgs& args)
+{
 	const InputArgs& inputArgs = args.inputArgs;
 	const SimArgs& simArgs = args.simArgs;
 
+	// The loopback peer is the next player along; nothing but the rollback sets its actions
+	m_userPlayer = inputArgs.userPlayer;
+	m_boardPlayer = inputArgs.loopbackPeer && m_playerCount > 1 ? (m_userPlayer + 1) % m_playerCount
+		: m_userPlayer;
+	m_lateLatch = inputArgs.lateLatch;
+	m_liveInput = inputArgs.pbMode != PlaybackMode::Playback && inputArgs.inputSource == InputSource::Keyboard;
+	m_inputLatency = InputLatencyStats();
+
 	// Create a new command-manager with a description packet
 	if (inputArgs.pbMode != PlaybackMode::Playback)
 	{
 		// Assign the sim args as given to the lvalue "data packet" which will potentially
 		// be passed along for recording
 		m_pSimArgsPacket->Get() = simArgs;
-		std::random_device randomDevice;
-		m_pSimArgsPacket->Get().randomSeed = randomDevice();
+		if (inputArgs.fixedSeed)
+		{
+			m_pSimArgsPacket->Get().randomSeed = inputArgs.randomSeed;
+		}
+		else
+		{
+			std::random_device randomDevice;
+			m_pSimArgsPacket->Get().randomSeed = randomDevice();
+		}
+	}
+
+	if ((inputArgs.inputSource == InputSource::Script && !m_pActionScript)
+		|| (inputArgs.inputSource == InputSource::Bot && !m_botPolicy))
+	{
+		auto pExecutive = m_pExecutive.lock();
+		if (pExecutive)
+		{
+			pExecutive->StartGameError("ColumnsInput: no script or bot to play with");
+		}
+		return;
+	}
+
+	// The user's actions come from the keyboard through throttled streams, unless something else
+	// plays the game.  A bot is shared by all of the user's streams
+	std::vector<CommandDesc>  commandDescriptions;
+	std::shared_ptr<ActionBot> pBot;
+	if (inputArgs.inputSource == InputSource::Bot)
+	{
+		pBot = std::make_shared<ActionBot>(m_botPolicy);
+	}
+
+	for (size_t cmdId = 0; cmdId < m_actionCommands.size(); ++cmdId)
+	{
+		const ActionCommand_& actionCommand = m_actionCommands[cmdId];
+		if (actionCommand.playerId == inputArgs.userPlayer)
+		{
+			unsigned int actionIndex = (unsigned int)(cmdId % m_actionNames.size());
+			commandDescriptions.emplace_back(actionCommand.pCommand,
+				CreateStreamFactory(actionCommand, actionIndex, inputArgs, pBot));
+		}
 	}
 
 	m_pCommandManager.reset(new CommandManager(inputArgs.pbMode, 
@@ -128,7 +211,8 @@ void geng::columns::ColumnsInput::OnStartGame(const ColumnsArgs& args)
 											  ColumnsExecutive::GetGameName(),
 		                                      0,   // format version
 		                                      0,   // min format version,
-										      false, // unsafe playback
+										      inputArgs.allowUnsafePlayback,
+											  inputArgs.compressDemo,
 											  m_pSimArgsPacket,
 										      commandDescriptions));
 
@@ -142,8 +226,40 @@ void geng::columns::ColumnsInput::OnStartGame(const ColumnsArgs& args)
 		}
 	}
 
+	if (!inputArgs.spectatorFeed.empty()
+		&& !m_pCommandManager->PublishSpectatorFeed(inputArgs.spectatorFeed.c_str(), m_pSimArgsPacket))
+	{
+		auto pExecutive = m_pExecutive.lock();
+		if (pExecutive)
+		{
+			pExecutive->StartGameError(m_pCommandManager->GetError().c_str());
+			return;
+		}
+	}
+
+	if (inputArgs.flightRecorderMinutes > 0)
+	{
+		if (!m_pFlightRecorder)
+		{
+			unsigned long retainFrames = inputArgs.flightRecorderMinutes * 60000 / m_msPerFrame;
+			m_pFlightRecorder = std::make_shared<FlightRecorder>(retainFrames, FLIGHT_RECORDER_SNAPSHOT_MS / m_msPerFrame);
+			// Best effort:  without it, the recorder can still be dumped by hand
+			FlightRecorder::DumpOnCrash(m_pFlightRecorder.get(), inputArgs.flightRecorderFile.c_str());
+		}
+
+		m_pCommandManager->AttachFlightRecorder(m_pFlightRecorder,
+			ColumnsExecutive::GetGameName(),
+			0,	// format version
+			m_pSimArgsPacket);
+	}
+
 	// Seed the random generator (the sim args will have a valid value now)
 	m_generator.seed(m_pSimArgsPacket->Get().randomSeed);
+	m_randomDraws = 0;
+	const serial::CommandStartState* pStartState = m_pCommandManager->GetStartState();
+	m_frameCount = pStartState ? pStartState->frame : 0;
+	// Commands may still be on from the last game
+	UpdateInputIdle();
 }
 
 void geng::columns::ColumnsInput::OnFrame(const SimState& rSimState,
@@ -155,18 +271,37 @@ void geng::columns::ColumnsInput::OnFrame(const SimState& rSimState,
 		return;
 	}
 
+	m_frameCount = pContextState->frameCount;
+
+	// Nothing stands between this and the sim but the rollback, if there is one
+	if (m_lateLatch)
+	{
+		m_pInput->LatchInput();
+	}
+
 	// This will update the translator with the state of the input
 	m_actionTranslator->UpdateOnFrame(pContextState->frameCount);
+	if (m_liveInput)
+	{
+		MeasureInputLatency();
+	}
 
 	// Calling Update on the command manager will pull in the values from each stream
 	m_pCommandManager->OnFrame(pContextState->frameCount);
 
+	// The idle flag only needs another look when something changed
+	if (!m_pCommandManager->GetFrameChanges().IsEmpty())
+	{
+		UpdateInputIdle();
+	}
+
 	// TODO:  EndFrame should be called from somewhere else if commands can come from the
 	// sim
 	m_pCommandManager->EndFrame();
 
-	// End the game if in playback mode and the file is done
-	if (m_pCommandManager->IsEndOfPlayback())
+	// End the game if in playback mode and the file is done (or can't be read any further)
+	if (m_pCommandManager->IsEndOfPlayback()
+		|| m_pCommandManager->IsPlaybackError())
 	{
 		auto pExecutive = m_pExecutive.lock();
 		if (pExecutive)
@@ -176,6 +311,47 @@ void geng::columns::ColumnsInput::OnFrame(const SimState& rSimState,
 	}
 }
 
+void geng::columns::ColumnsInput::UpdateInputIdle()
+{
+	m_inputIdle = true;
+	for (const ActionCommand_& actionCommand : m_actionCommands)
+	{
+		if (actionCommand.pCommand->GetState())
+		{
+			m_inputIdle = false;
+			break;
+		}
+	}
+}
+
+void geng::columns::ColumnsInput::MeasureInputLatency()
+{
+	unsigned long inputTime = m_pInput->GetInputTime();
+	for (const ActionCommand_& actionCommand : m_actionCommands)
+	{
+		unsigned long onTime;
+		if (actionCommand.playerId == m_userPlayer
+			&& m_actionTranslator->GetActionOnTime(actionCommand.actionId, onTime)
+			&& onTime <= inputTime)
+		{
+			unsigned long latencyMs = inputTime - onTime;
+			++m_inputLatency.presses;
+			m_inputLatency.totalMs += latencyMs;
+			m_inputLatency.worstMs = std::max(m_inputLatency.worstMs, latencyMs);
+		}
+	}
+}
+
+unsigned long geng::columns::ColumnsInput::GetInputIdleUntilFrame() const
+{
+	// The loopback peer's input comes in on its own schedule
+	if (!m_inputIdle || !m_pCommandManager || HasLoopbackPeer())
+	{
+		return m_frameCount;
+	}
+	return m_pCommandManager->GetNextInputChangeFrame();
+}
+
 void geng::columns::ColumnsInput::OnEndGame()
 {
 	m_pCommandManager->EndSession();
@@ -209,5 +385,37 @@ geng::columns::ActionCommandID geng::columns::ColumnsInput::GetIDFor(const char*
 
 unsigned long geng::columns::ColumnsInput::GetRandomNumber(unsigned long lowerBound, unsigned long upperBound)
 {
+	++m_randomDraws;
 	return m_generator() % (upperBound + 1 - lowerBound) + lowerBound;
-}
\ No newline at end of file
+}
+
+void geng::columns::ColumnsInput::SetRandomDrawCount(unsigned long long drawCount)
+{
+	m_generator.seed(m_pSimArgsPacket->Get().randomSeed);
+	m_generator.discard(drawCount);
+	m_randomDraws = drawCount;
+}
+
+uint32_t geng::columns::ColumnsInput::GetPlayerActions(unsigned int playerId) const
+{
+	uint32_t actionBits{ 0 };
+	size_t firstCommand = playerId * m_actionNames.size();
+	for (size_t actionIndex = 0; actionIndex < m_actionNames.size(); ++actionIndex)
+	{
+		if (m_actionCommands[firstCommand + actionIndex].pCommand->GetState())
+		{
+			actionBits |= 1u << actionIndex;
+		}
+	}
+	return actionBits;
+}
+
+void geng::columns::ColumnsInput::SetPlayerActions(unsigned int playerId, uint32_t actionBits)
+{
+	size_t firstCommand = playerId * m_actionNames.size();
+	for (size_t actionIndex = 0; actionIndex < m_actionNames.size(); ++actionIndex)
+	{
+		m_actionCommands[firstCommand + actionIndex].pCommand->SetState((actionBits & (1u << actionIndex)) != 0);
+	}
+	UpdateInputIdle();
+}
@@ -2,9 +2,11 @@
 
 #include "BaseGameComponent.h"
 #include "ActionCommands.h"
+#include "SyntheticCommands.h"
 #include "ActionMapper.h"
 #include "ActionTranslator.h"
 #include "CommandManager.h"
+#include "FlightRecorder.h"
 #include "DataPacket.h"
 #include "ColumnsData.h"
 
@@ -16,6 +18,18 @@ namespace geng::columns
 {
 	class ColumnsExecutive;
 
+	// How often the flight recorder takes the game's state
+	constexpr unsigned long FLIGHT_RECORDER_SNAPSHOT_MS = 10000;
+
+	// From a key changing to the sim running with the action it turned on, for the user's
+	// live presses
+	struct InputLatencyStats
+	{
+		unsigned long presses{ 0 };
+		unsigned long totalMs{ 0 };
+		unsigned long worstMs{ 0 };
+	};
+
 	struct ActionDesc
 	{
 		const char* pName;
@@ -62,6 +76,12 @@ namespace geng::columns
 
 		bool Initialize(const std::shared_ptr<IGame>& pGame);
 
+		// What InputSource::Script and InputSource::Bot play with.  Every action the script names
+		// must be one of the player's
+		bool SetActionScript(const std::shared_ptr<const ActionScript>& pScript, std::string& rErr);
+		// The bot's action bits are in the order of the action descriptions
+		void SetActionBot(const ActionBotPolicy& botPolicy) { m_botPolicy = botPolicy; }
+
 		void OnStartGame(const ColumnsArgs& args);
 		void OnFrame(const SimState& rSimState,
 			const SimContextState* pContextState) override;
@@ -72,6 +92,17 @@ namespace geng::columns
 			unsigned int playerId,
 			bool* pFound = nullptr) const;
 
+		// Action commands are numbered 0..GetActionCount()-1
+		ActionCommandID GetActionCount() const { return m_actionCommands.size(); }
+		unsigned int GetActionPlayer(ActionCommandID cmdId) const
+		{
+			return m_actionCommands[cmdId].playerId;
+		}
+		const std::string& GetActionKey(ActionCommandID cmdId) const
+		{
+			return m_actionCommands[cmdId].actionKey;
+		}
+
 		bool GetActionState(ActionCommandID cmdId) const
 		{
 			return cmdId < m_actionCommands.size() ?
@@ -79,7 +110,22 @@ namespace geng::columns
 				: false;
 		}
 
+		// The player whose actions drive the board:  the user, or with a loopback peer, the
+		// remote player the user's input comes back as
+		unsigned int GetBoardPlayer() const { return m_boardPlayer; }
+		bool HasLoopbackPeer() const { return m_boardPlayer != m_userPlayer; }
+		unsigned int GetUserPlayer() const { return m_userPlayer; }
+
+		// A player's actions as bits, in the order of the action descriptions.  Setting them is
+		// for players with no command streams of their own
+		uint32_t GetPlayerActions(unsigned int playerId) const;
+		void SetPlayerActions(unsigned int playerId, uint32_t actionBits);
+
 		unsigned long GetRandomNumber(unsigned long min, unsigned long upperBound);
+		// The random numbers drawn so far belong to the game's saved state
+		unsigned long long GetRandomDrawCount() const { return m_randomDraws; }
+		// Put the generator back to where it was after drawCount numbers of this game
+		void SetRandomDrawCount(unsigned long long drawCount);
 
 		const SimArgs* GetSimArgs() const
 		{
@@ -93,6 +139,38 @@ namespace geng::columns
 				&& m_pCommandManager->GetFormatVersion() == formatVersion;
 		}
 
+		const CommandManager* GetCommandManager() const
+		{
+			return m_pCommandManager.get();
+		}
+
+		// A recording of a game in progress starts from this state; null for a fresh game
+		const serial::CommandStartState* GetStartState() const
+		{
+			return m_pCommandManager ? m_pCommandManager->GetStartState() : nullptr;
+		}
+
+		// Null unless turned on in the input args
+		FlightRecorder* GetFlightRecorder() const { return m_pFlightRecorder.get(); }
+
+		// Null unless the game is published to spectators
+		serial::SpectatorFeedWriter* GetSpectatorFeed() const
+		{
+			return m_pCommandManager ? m_pCommandManager->GetSpectatorFeed() : nullptr;
+		}
+
+		// Index of the last frame processed in the current (or last) game
+		unsigned long GetFrameCount() const { return m_frameCount; }
+
+		// No action is on in the current frame
+		bool IsInputIdle() const { return m_inputIdle; }
+		// The input stays idle at least until this frame (exclusive).  Only playback can look ahead;
+		// live input is never promised past the next frame
+		unsigned long GetInputIdleUntilFrame() const;
+
+		// For the current (or last) game
+		const InputLatencyStats& GetInputLatency() const { return m_inputLatency; }
+
 		bool GetPlaybackVersion(uint32_t& formatVersion) const
 		{
 			if (m_pCommandManager && m_pCommandManager->GetPBMode() == PlaybackMode::Playback)
@@ -105,12 +183,27 @@ namespace geng::columns
 		}
 
 	private:
+		FactorySharedPtr<ICommandStream> CreateStreamFactory(const ActionCommand_& actionCommand,
+			unsigned int actionIndex,
+			const InputArgs& inputArgs,
+			const std::shared_ptr<ActionBot>& pBot) const;
+		void UpdateInputIdle();
+		void MeasureInputLatency();
+
 		// Actions
 
 		// data
 		std::vector<std::string>  m_actionNames;
 		std::vector<ActionCommand_> m_actionCommands;
+		unsigned int m_playerCount;
+		unsigned int m_userPlayer{ 0 };
+		unsigned int m_boardPlayer{ 0 };
 		unsigned long m_msPerFrame;
+		unsigned long m_frameCount{ 0 };
+		bool m_inputIdle{ true };
+		bool m_lateLatch{ false };
+		bool m_liveInput{ false };
+		InputLatencyStats m_inputLatency;
 
 		// objects
 		std::shared_ptr<serial::DataPacket<SimArgs> > m_pSimArgsPacket;
@@ -118,11 +211,16 @@ namespace geng::columns
 		std::shared_ptr<ActionTranslator> m_actionTranslator;
 		std::shared_ptr<IInput>  m_pInput;
 		std::weak_ptr<ColumnsExecutive>  m_pExecutive;
+		std::shared_ptr<const ActionScript> m_pActionScript;
+		ActionBotPolicy m_botPolicy;
 
 		std::mt19937_64  m_generator;
+		unsigned long long m_randomDraws{ 0 };
 
 		// Command manager
 		std::shared_ptr<CommandManager>   m_pCommandManager;
+		// Lives across games, so the last one can still be dumped after it ends
+		std::shared_ptr<FlightRecorder>  m_pFlightRecorder;
 
 		bool m_valid{ false };
 		std::string m_error;
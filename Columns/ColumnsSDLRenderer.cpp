@@ -4,7 +4,7 @@
 #include "ResourceLoader.h"
 #include "RawMemoryResource.h"
 #include "SDLRendering.h"
-#include "DTSimple.h"
+#include "DTArena.h"
 #include "ResDescriptor.h"
 
 #include <sstream>
@@ -24,21 +24,24 @@ std::shared_ptr<geng::sdl::TTFResource> geng::columns::ColumnsSDLRenderer::Initi
 {
 	using namespace data;
 
+	// The descriptor is built in an arena of its own, freed with the last reference to it
+	arena::ArenaScope descriptorScope;
+
 	// Keep a reference to the font typeface name in order to be able to change it if loading
 	// fails
 	auto pFontName
-		= DTElem<simple::Suite>("calibri");
+		= DTElem<arena::Suite>("calibri");
 
 	auto pFontDescriptor =
-		DTDict<simple::Suite>
+		DTDict<arena::Suite>
 		({
 		   {res_desc::RES_TYPE,
-				DTElem<simple::Suite>(sdl::TTFResource::GetTypeName())
+				DTElem<arena::Suite>(sdl::TTFResource::GetTypeName())
 		   },
-		   {"size",
-				DTElem<simple::Suite>((int32_t)pointSize)
+		   {res_desc::SIZE,
+				DTElem<arena::Suite>((int32_t)pointSize)
 	       },
-		   {"typeface",
+		   {res_desc::TYPEFACE,
 				pFontName
 		   }
 			});
@@ -2,7 +2,69 @@
 #include "ColumnsExecutive.h"
 #include "EngAlgorithms.h"
 #include "ActionCommands.h"
+#include "SpectatorFeed.h"
 #include <iterator>
+#include <type_traits>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	// Saved state helpers.  Sizes are fixed so a saved state reads back on any platform
+	template<typename T>
+	bool EncodeVector(geng::serial::IWriteStream* pStream, const std::vector<T>& vals)
+	{
+		uint32_t valCount = (uint32_t)vals.size();
+		if (!geng::serial::EncodeData(pStream, valCount))
+		{
+			return false;
+		}
+		for (const T& val : vals)
+		{
+			if (!geng::serial::EncodeData(pStream, val))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template<typename T>
+	bool DecodeVector(geng::serial::IReadStream* pStream, std::vector<T>& vals)
+	{
+		uint32_t valCount{ 0 };
+		if (!geng::serial::DecodeData(pStream, valCount)
+			|| !pStream->CanRead(valCount))
+		{
+			return false;
+		}
+		vals.resize(valCount);
+		for (T& val : vals)
+		{
+			if (!geng::serial::DecodeData(pStream, val))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool EncodeTime(geng::serial::IWriteStream* pStream, unsigned long simTime)
+	{
+		return geng::serial::EncodeData(pStream, (uint32_t)simTime);
+	}
+
+	bool DecodeTime(geng::serial::IReadStream* pStream, unsigned long& simTime)
+	{
+		uint32_t encodedTime{ 0 };
+		if (!geng::serial::DecodeData(pStream, encodedTime))
+		{
+			return false;
+		}
+		simTime = encodedTime;
+		return true;
+	}
+}
 
 unsigned int geng::columns::ColumnsSim::PointToIndex(const Point& at) const
 {
@@ -702,13 +764,6 @@ bool geng::columns::ColumnsSim::Initialize(const std::shared_ptr<IGame>& pGame)
 {
 	m_pColumnsInput = GetComponentAs<ColumnsInput>(pGame.get(), ColumnsExecutive::GetColumnsInputComponentName());
 
-	// Get the actions (for player 0)
-	m_dropId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetDropActionName(), 0);
-	m_shiftLeftId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetShiftLeftActionName(), 0);
-	m_shiftRightId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetShiftRightActionName(), 0);
-	m_rotateId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetRotateActionName(), 0);
-	m_permuteId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetPermuteActionName(), 0);
-
 	auto pExecutive = GetComponentAs<ColumnsExecutive>(pGame.get(), ColumnsExecutive::GetExecutiveName());
 	pExecutive->AddCheat("saxo", CHEAT_MAGIC_COLUMN);
 
@@ -740,6 +795,14 @@ void geng::columns::ColumnsSim::OnStartGame()
 
 	LoadArgs(*pArgs);
 
+	// Get the actions of the player driving the board
+	unsigned int boardPlayer = m_pColumnsInput->GetBoardPlayer();
+	m_dropId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetDropActionName(), boardPlayer);
+	m_shiftLeftId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetShiftLeftActionName(), boardPlayer);
+	m_shiftRightId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetShiftRightActionName(), boardPlayer);
+	m_rotateId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetRotateActionName(), boardPlayer);
+	m_permuteId = m_pColumnsInput->GetIDFor(ColumnsExecutive::GetPermuteActionName(), boardPlayer);
+
 	// Clear the grid
 	GridSquare defaultSquare{ EMPTY, true };
 	std::fill(m_gameGrid.get(), m_gameGrid.get() + m_gameGridSize, defaultSquare);
@@ -751,6 +814,8 @@ void geng::columns::ColumnsSim::OnStartGame()
 	m_level = 1;
 	m_nextMagicLevel = 0;
 	m_magicColumnNext = false;
+	m_cascadeDepth = 0;
+	m_validPlayerColumn = false;
 
 	ComputeNextMagicLevel();
 
@@ -761,12 +826,31 @@ void geng::columns::ColumnsSim::OnStartGame()
 	m_nextColors.clear();
 	m_needNewColumn = true;
 	m_colorsToClear.clear();
+	m_wakeTime = 0;
+	m_wakeOnInput = true;
 
 	StateArgs stateArgs;
 	stateArgs.simTime = 0;
 
 	// This will transition out of game over state
 	m_gameState.Transition<DropColumnState>(m_gameState, stateArgs);
+
+	// A recording of a game in progress picks up where it was saved
+	const serial::CommandStartState* pStartState = m_pColumnsInput->GetStartState();
+	if (pStartState)
+	{
+		serial::MemoryReadStream stateStream(pStartState->gameState.data(), pStartState->gameState.size());
+		if (!LoadState(&stateStream))
+		{
+			auto pExecutive = m_pExecutive.lock();
+			if (pExecutive)
+			{
+				pExecutive->StartGameError("The recording's saved game state could not be loaded");
+			}
+		}
+	}
+
+	PublishSpectatorState();
 }
 
 void geng::columns::ColumnsSim::OnPauseGame(bool pauseState) { }
@@ -775,9 +859,6 @@ void geng::columns::ColumnsSim::OnEndGame() { }
 void geng::columns::ColumnsSim::OnFrame(const SimState& rSimState,
 	const SimContextState* pContextState)
 {
-	StateArgs stateArgs;
-	stateArgs.simTime = pContextState->simulatedTime;
-
 	m_cheatHappened = false;
 
 	bool cheatMagicColumn{ false };
@@ -799,21 +880,107 @@ void geng::columns::ColumnsSim::OnFrame(const SimState& rSimState,
 		m_cheatHappened = true;
 	}
 
-	m_gameState.StartFrame();
+	RunFrame(pContextState->simulatedTime, cheatMagicColumn);
+
+	SaveFlightRecorderState(pContextState->frameCount);
+	PublishSpectatorState();
+}
+
+void geng::columns::ColumnsSim::Resimulate(unsigned long simTime)
+{
+	RunFrame(simTime, false);
+}
+
+void geng::columns::ColumnsSim::RunFrame(unsigned long simTime, bool cheatMagicColumn)
+{
+	StateArgs stateArgs;
+	stateArgs.simTime = simTime;
+
+	// Unless something can happen in this frame, the state would only confirm that nothing did
+	if (cheatMagicColumn || stateArgs.simTime >= m_wakeTime
+		|| (m_wakeOnInput && !m_pColumnsInput->IsInputIdle()))
+	{
+		m_gameState.StartFrame();
+
+		bool shouldContinue = true;
+		while (shouldContinue)
+		{
+			shouldContinue = m_gameState.DispatchState(stateArgs);
+		}
+
+		m_gameState.EndFrame();
+		UpdateWakeTime();
+	}
+}
+
+void geng::columns::ColumnsSim::SaveFlightRecorderState(unsigned long frame)
+{
+	FlightRecorder* pRecorder = m_pColumnsInput->GetFlightRecorder();
+	if (!pRecorder || m_rollbackMode || !pRecorder->IsSnapshotDue(frame))
+	{
+		return;
+	}
+
+	m_snapshotStream.Clear();
+	if (SaveState(&m_snapshotStream))
+	{
+		pRecorder->AddSnapshot(frame, m_snapshotStream.GetData(), m_snapshotStream.GetSize());
+	}
+}
+
+void geng::columns::ColumnsSim::PublishSpectatorState()
+{
+	// A rollback frame is only a prediction, so the feed goes without
+	serial::SpectatorFeedWriter* pFeed = m_pColumnsInput->GetSpectatorFeed();
+	if (!pFeed || m_rollbackMode)
+	{
+		return;
+	}
 
-	bool shouldContinue = true;
-	while (shouldContinue)
+	m_snapshotStream.Clear();
+	if (SaveState(&m_snapshotStream))
 	{
-		shouldContinue = m_gameState.DispatchState(stateArgs);
+		pFeed->SetSimState(m_snapshotStream.GetData(), m_snapshotStream.GetSize());
 	}
+}
+
+void geng::columns::ColumnsSim::UpdateWakeTime()
+{
+	auto getWakeTime = [this](auto& state)
+	{
+		using State = std::decay_t<decltype(state)>;
+		if constexpr (std::is_same_v<State, DropColumnState>)
+		{
+			// The column drops on its own at the next drop time, or sooner if asked to
+			m_wakeTime = m_needNewColumn ? 0 : state.nextDropTime;
+			m_wakeOnInput = true;
+		}
+		else if constexpr (std::is_same_v<State, ClearState>)
+		{
+			// Blinking ignores the input
+			m_wakeTime = state.nextBlinkTime;
+			m_wakeOnInput = false;
+		}
+		else if constexpr (std::is_same_v<State, GameOverState>)
+		{
+			m_wakeTime = std::numeric_limits<unsigned long>::max();
+			m_wakeOnInput = false;
+		}
+		else
+		{
+			m_wakeTime = 0;
+			m_wakeOnInput = true;
+		}
+	};
 
-	m_gameState.EndFrame();
+	m_gameState.DispatchInvoke(getWakeTime);
 }
 
 
 void geng::columns::ColumnsSim::GameState
 ::OnEnterState(DropColumnState& dropState, const StateArgs& args)
 {
+	m_owner.m_cascadeDepth = 0;
 	dropState.nextDropTime = args.simTime + m_owner.m_curDropMiliseconds;
 }
 
@@ -931,6 +1098,8 @@ OnEnterState(ClearState& clearState, const StateArgs& stateArgs)
 
 	if (!m_owner.m_toRemove.empty())
 	{
+		++m_owner.m_cascadeDepth;
+
 		// Initialize the blink phase
 		clearState.blinkPhase = true;
 		clearState.blinkPhaseCount = 0;
@@ -980,6 +1149,12 @@ OnState(ClearState& clearState, const StateArgs& stateArgs)
 void geng::columns::ColumnsSim::GameState::OnEnterState(GameOverState& state, const StateArgs& args)
 {
 	m_owner.m_gameOver = true;
+	// The rollback can still take this back; it ends the game itself
+	if (m_owner.m_rollbackMode)
+	{
+		return;
+	}
+
 	// Tell the executive to end the game
 	auto pExecutive = m_owner.m_pExecutive.lock();
 
@@ -994,3 +1169,149 @@ void geng::columns::ColumnsSim::GameState::OnExitState(GameOverState& state, con
 {
 	m_owner.m_gameOver = false;
 }
+
+bool geng::columns::ColumnsSim::SaveState(serial::IWriteStream* pStream)
+{
+	using serial::EncodeData;
+
+	bool saveOK = EncodeData(pStream, (uint64_t)m_pColumnsInput->GetRandomDrawCount())
+		&& EncodeData(pStream, (uint32_t)m_gameGridSize);
+
+	for (size_t idx = 0; saveOK && idx < m_gameGridSize; ++idx)
+	{
+		const GridSquare& gridSquare = m_gameGrid[idx];
+		saveOK = EncodeData(pStream, (int32_t)gridSquare.contents)
+			&& EncodeData(pStream, gridSquare.isVisible)
+			&& EncodeData(pStream, gridSquare.wasRemoved)
+			&& EncodeData(pStream, gridSquare.seqNumbers);
+	}
+
+	// Only the set of columns matters, not the order
+	std::vector<unsigned int> columnsToCompact(m_columnsToCompact.begin(), m_columnsToCompact.end());
+	std::sort(columnsToCompact.begin(), columnsToCompact.end());
+
+	saveOK = saveOK
+		&& EncodeData(pStream, m_validPlayerColumn)
+		&& EncodeData(pStream, m_playerColumn.locCenter)
+		&& EncodeVector(pStream, m_playerColumn.colors)
+		&& EncodeData(pStream, m_playerColumn.isHorizontal)
+		&& EncodeData(pStream, m_playerColumn.isInverted)
+		&& EncodeData(pStream, m_playerColumn.startPt)
+		&& EncodeVector(pStream, m_nextColors)
+		&& EncodeVector(pStream, m_toRemove)
+		&& EncodeVector(pStream, columnsToCompact)
+		&& EncodeVector(pStream, m_colorsToClear)
+		&& EncodeData(pStream, m_gameOver)
+		&& EncodeData(pStream, m_clearedGems)
+		&& EncodeData(pStream, m_clearedGemsInLevel)
+		&& EncodeData(pStream, m_levelThreshhold)
+		&& EncodeData(pStream, m_level)
+		&& EncodeData(pStream, m_nextMagicLevel)
+		&& EncodeData(pStream, m_cascadeDepth)
+		&& EncodeData(pStream, m_curDropMiliseconds)
+		&& EncodeData(pStream, m_needNewColumn)
+		&& EncodeData(pStream, m_magicColumnNext)
+		&& EncodeData(pStream, (uint8_t)m_gameState.GetStateIndex());
+
+	auto saveGameState = [pStream, &saveOK](auto& state)
+	{
+		using State = std::decay_t<decltype(state)>;
+		if constexpr (std::is_same_v<State, DropColumnState>)
+		{
+			saveOK = saveOK && EncodeTime(pStream, state.nextDropTime);
+		}
+		else if constexpr (std::is_same_v<State, ClearState>)
+		{
+			saveOK = saveOK && EncodeData(pStream, state.blinkPhase)
+				&& EncodeTime(pStream, state.nextBlinkTime)
+				&& EncodeData(pStream, state.blinkPhaseCount);
+		}
+	};
+	m_gameState.DispatchInvoke(saveGameState);
+
+	return saveOK;
+}
+
+bool geng::columns::ColumnsSim::LoadState(serial::IReadStream* pStream)
+{
+	using serial::DecodeData;
+
+	uint64_t randomDraws{ 0 };
+	uint32_t gridSize{ 0 };
+	if (!DecodeData(pStream, randomDraws)
+		|| !DecodeData(pStream, gridSize)
+		|| gridSize != m_gameGridSize)
+	{
+		return false;
+	}
+
+	for (size_t idx = 0; idx < m_gameGridSize; ++idx)
+	{
+		GridSquare& gridSquare = m_gameGrid[idx];
+		int32_t contents{ 0 };
+		if (!DecodeData(pStream, contents)
+			|| !DecodeData(pStream, gridSquare.isVisible)
+			|| !DecodeData(pStream, gridSquare.wasRemoved)
+			|| !DecodeData(pStream, gridSquare.seqNumbers))
+		{
+			return false;
+		}
+		gridSquare.contents = contents;
+	}
+
+	std::vector<unsigned int> columnsToCompact;
+	uint8_t stateIndex{ 0 };
+	if (!DecodeData(pStream, m_validPlayerColumn)
+		|| !DecodeData(pStream, m_playerColumn.locCenter)
+		|| !DecodeVector(pStream, m_playerColumn.colors)
+		|| !DecodeData(pStream, m_playerColumn.isHorizontal)
+		|| !DecodeData(pStream, m_playerColumn.isInverted)
+		|| !DecodeData(pStream, m_playerColumn.startPt)
+		|| !DecodeVector(pStream, m_nextColors)
+		|| !DecodeVector(pStream, m_toRemove)
+		|| !DecodeVector(pStream, columnsToCompact)
+		|| !DecodeVector(pStream, m_colorsToClear)
+		|| !DecodeData(pStream, m_gameOver)
+		|| !DecodeData(pStream, m_clearedGems)
+		|| !DecodeData(pStream, m_clearedGemsInLevel)
+		|| !DecodeData(pStream, m_levelThreshhold)
+		|| !DecodeData(pStream, m_level)
+		|| !DecodeData(pStream, m_nextMagicLevel)
+		|| !DecodeData(pStream, m_cascadeDepth)
+		|| !DecodeData(pStream, m_curDropMiliseconds)
+		|| !DecodeData(pStream, m_needNewColumn)
+		|| !DecodeData(pStream, m_magicColumnNext)
+		|| !DecodeData(pStream, stateIndex)
+		|| !m_gameState.RestoreStateIndex(stateIndex))
+	{
+		return false;
+	}
+
+	m_columnsToCompact.clear();
+	m_columnsToCompact.insert(columnsToCompact.begin(), columnsToCompact.end());
+
+	bool loadOK = true;
+	auto loadGameState = [pStream, &loadOK](auto& state)
+	{
+		using State = std::decay_t<decltype(state)>;
+		if constexpr (std::is_same_v<State, DropColumnState>)
+		{
+			loadOK = DecodeTime(pStream, state.nextDropTime);
+		}
+		else if constexpr (std::is_same_v<State, ClearState>)
+		{
+			loadOK = DecodeData(pStream, state.blinkPhase)
+				&& DecodeTime(pStream, state.nextBlinkTime)
+				&& DecodeData(pStream, state.blinkPhaseCount);
+		}
+	};
+	m_gameState.DispatchInvoke(loadGameState);
+	if (!loadOK)
+	{
+		return false;
+	}
+
+	m_pColumnsInput->SetRandomDrawCount(randomDraws);
+	UpdateWakeTime();
+	return true;
+}
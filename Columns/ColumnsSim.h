@@ -8,6 +8,7 @@
 #include "SharedValueCommand.h"
 #include "ActionCommands.h"
 #include "ColumnsData.h"
+#include "MemoryStream.h"
 
 #include <memory>
 #include <array>
@@ -238,6 +239,12 @@ namespace geng::columns
 		void OnFrame(const SimState& rSimState,
 			const SimContextState* pContextState) override;
 
+		// Under a rollback, frames may be run again with other input.  The game is only over once
+		// the rollback says so, and the flight recorder takes no saved states (it keeps the whole game)
+		void SetRollbackMode(bool rollbackMode) { m_rollbackMode = rollbackMode; }
+		// Run a frame again after LoadState(), without cheats or the flight recorder
+		void Resimulate(unsigned long simTime);
+
 		unsigned int PointToIndex(const Point& at) const;
 		Point IndexToPoint(unsigned int idx) const;
 		// This gets the "predecessor" tile for the algorithm that computes what should be removed
@@ -264,9 +271,23 @@ namespace geng::columns
 
 		const unsigned int GetLevel() const { return m_level; }
 		const unsigned int GetGems() const { return m_clearedGems; }
+		// Number of clears in the current chain; 0 while a column is dropping
+		unsigned int GetCascadeDepth() const { return m_cascadeDepth; }
+		// The player's column, or the last one locked in place; null before the first one is generated
+		const PlayerSet* GetPlayerColumn() const
+		{
+			return m_validPlayerColumn ? &m_playerColumn : nullptr;
+		}
+
+		// Everything the game needs to go on from the end of the current frame, including how far
+		// along the random numbers are.  Loading expects the sim args of the same game
+		bool SaveState(serial::IWriteStream* pStream);
+		bool LoadState(serial::IReadStream* pStream);
 
 		bool IsGameInitialized() const { return m_paramsInit; }
 		bool IsGameOver() const { return m_gameOver; }
+		// While the input stays idle, frames before this sim time have nothing to do
+		unsigned long GetWakeTime() const { return m_wakeTime; }
 		bool CheatHappened() const {
 			return m_cheatHappened;
 		}
@@ -406,6 +427,13 @@ namespace geng::columns
 		void ComputeNextMagicLevel();
 		void LevelUp();
 
+		void RunFrame(unsigned long simTime, bool cheatMagicColumn);
+		// After the state has run for the frame, work out when it next needs to
+		void UpdateWakeTime();
+		void SaveFlightRecorderState(unsigned long frame);
+		// Hand the state the next frame starts from to the spectator feed, if there is one
+		void PublishSpectatorState();
+
 		// Compact columns by shifting all stones down
 		bool CompactColumn(unsigned int x);
 		bool CompactColumns();
@@ -456,6 +484,7 @@ namespace geng::columns
 		unsigned int m_levelThreshhold{ 45 };
 		unsigned int m_level{ 1 };
 		unsigned int m_nextMagicLevel{ 0 };
+		unsigned int m_cascadeDepth{ 0 };
 
 		unsigned int m_curDropMiliseconds{ 0 };
 		unsigned int m_minDropMiliseconds{ 0 };
@@ -466,6 +495,16 @@ namespace geng::columns
 		// Perframe
 		bool m_cheatHappened{ false };
 
+		bool m_rollbackMode{ false };
+
+		// Until this time, the state has nothing to do unless the input does something.
+		// Lets idle frames (most of a fast-forward) skip the dispatch
+		unsigned long m_wakeTime{ 0 };
+		bool m_wakeOnInput{ true };
+
+		// Reused for the flight recorder's snapshots
+		serial::MemoryWriteStream m_snapshotStream;
+
 		std::vector<GridContents> m_colorsToClear;
 
 	};
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cinttypes>
 
 namespace geng
 {
@@ -17,6 +19,47 @@ namespace geng
 			const ICommand& cmd) = 0;
 	};
 
+	// The commands that changed during a frame, in the order they changed.  A command bound to
+	// a change list marks itself there directly when it changes, and consumers go through the
+	// list once at the end of the frame
+	class CommandChangeList
+	{
+	public:
+		void Reset(size_t commandCount)
+		{
+			m_changes.clear();
+			m_isChanged.assign(commandCount, 0);
+		}
+
+		void Clear()
+		{
+			for (uint32_t commandIndex : m_changes)
+			{
+				m_isChanged[commandIndex] = 0;
+			}
+			m_changes.clear();
+		}
+
+		void MarkChanged(uint32_t commandIndex)
+		{
+			if (!m_isChanged[commandIndex])
+			{
+				m_isChanged[commandIndex] = 1;
+				m_changes.push_back(commandIndex);
+			}
+		}
+
+		bool IsChanged(uint32_t commandIndex) const { return m_isChanged[commandIndex] != 0; }
+		bool IsEmpty() const { return m_changes.empty(); }
+
+		std::vector<uint32_t>::const_iterator begin() const { return m_changes.begin(); }
+		std::vector<uint32_t>::const_iterator end() const { return m_changes.end(); }
+
+	private:
+		std::vector<uint32_t> m_changes;
+		std::vector<uint8_t> m_isChanged;
+	};
+
 	class ICommand
 	{
 	public:
@@ -24,6 +67,10 @@ namespace geng
 		virtual void Subscribe(const std::shared_ptr<ICommandListener>& pListener,
 			SubID subISd) = 0;
 		virtual void Unsubscribe(const std::shared_ptr<ICommandListener>& pListener) = 0;
+		// A command is bound to at most one change list at a time
+		virtual void BindChangeList(CommandChangeList* pChangeList, uint32_t commandIndex) = 0;
+		// Only unbinds if still bound to this list
+		virtual void UnbindChangeList(const CommandChangeList* pChangeList) = 0;
 		virtual void Reset() = 0;
 
 		virtual ~ICommand() = default;
@@ -21,7 +21,7 @@ namespace geng::cmdline
 				int minArgCount_ = -1, 
 			    int maxArgCount_ = -1)
 			:argKey(pKey),
-			 argShort(argShort),
+			 argShort(pShort),
 			isOptional(isOptional_),
 			minArgCount(minArgCount_),
 			maxArgCount(maxArgCount_)
@@ -1,6 +1,9 @@
 #include "CommandManager.h"
 #include "FileCommandReader.h"
 #include "FileCommandWriter.h"
+#include "SpectatorFeed.h"
+#include "FlightRecorder.h"
+#include "BlockPool.h"
 
 #include <sstream>
 
@@ -10,6 +13,7 @@ geng::CommandManager::CommandManager(PlaybackMode pbMode,
 	uint32_t formatVersion,
 	uint32_t minVersion,
 	bool allowUnsafePlayback,
+	bool compressRecording,
 	const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
 	const std::vector<CommandDesc>& cmdList)
 	:m_playbackMode(pbMode),
@@ -33,7 +37,7 @@ geng::CommandManager::CommandManager(PlaybackMode pbMode,
 		if (UserControl(pbMode))
 		{
 			// Create the stream too when it's used here
-			cmdInManager.pStream.reset(cmdDesc.m_pStreamFactory->Create());
+			cmdInManager.pStream = SharePooled(cmdDesc.m_pStreamFactory->Create());
 
 			if (!cmdInManager.pStream)
 			{
@@ -46,11 +50,19 @@ geng::CommandManager::CommandManager(PlaybackMode pbMode,
 		m_commands.emplace_back(std::move(cmdInManager));
 	}
 
+	// Commands report their changes straight into the frame's change list
+	m_frameChanges.Reset(m_commands.size());
+	for (uint32_t cmdIdx = 0; cmdIdx < m_commands.size(); ++cmdIdx)
+	{
+		m_commands[cmdIdx].pCommand->BindChangeList(&m_frameChanges, cmdIdx);
+	}
+
 	// Open the file if applicable.  For reading, create the playback streams
 	if (!OpenFile(pGameName, 
 		formatVersion, 
 		minVersion, 
 		allowUnsafePlayback, 
+		compressRecording,
 		pDescriptionPacket, 
 		commandList))
 	{
@@ -65,24 +77,70 @@ geng::CommandManager::CommandManager(PlaybackMode pbMode,
 			cmdInManager.pStream = m_pReader->GetCommandStream(cmdInManager.pCommand->GetKey());
 		}
 	}
-	// And if the mode is "record", subscribe the writer as a listener to each of its commands
-	// Uses the special "SubscribeToCommands" function, which takes a shared_ptr instead of a
-	// normal this pointer
-	else if (pbMode == PlaybackMode::Record)
-	{
-		serial::FileCommandWriter::SubscribeToCommands(m_pWriter, true);
-	}
 
 	m_valid = true;
 }
 
 geng::CommandManager::~CommandManager()
 {
-	if (m_playbackMode == PlaybackMode::Record)
+	// The commands outlive the manager, and the next game's manager may have bound them already
+	for (Command_& cmdInManager : m_commands)
+	{
+		cmdInManager.pCommand->UnbindChangeList(&m_frameChanges);
+	}
+}
+
+bool geng::CommandManager::PublishSpectatorFeed(const char* pFeedName,
+	const std::shared_ptr<serial::IPacket>& pDescriptionPacket)
+{
+	std::vector<std::shared_ptr<serial::ISerializableCommand> > commandList;
+	for (const Command_& cmdInManager : m_commands)
+	{
+		commandList.emplace_back(cmdInManager.pCommand);
+	}
+
+	m_pFeedWriter = std::make_shared<serial::SpectatorFeedWriter>(pFeedName, pDescriptionPacket, commandList);
+	if (!m_pFeedWriter->IsValid())
 	{
-		// This removes the circular references from the commands back to the writer
-		serial::FileCommandWriter::SubscribeToCommands(m_pWriter, false);
+		m_error = m_pFeedWriter->GetError();
+		m_pFeedWriter.reset();
+		return false;
 	}
+
+	return true;
+}
+
+void geng::CommandManager::AttachFlightRecorder(const std::shared_ptr<FlightRecorder>& pRecorder,
+	const char* pGameName,
+	uint32_t formatVersion,
+	const std::shared_ptr<serial::IPacket>& pDescriptionPacket)
+{
+	std::vector<std::shared_ptr<serial::ISerializableCommand> > commandList;
+	for (const Command_& cmdInManager : m_commands)
+	{
+		commandList.emplace_back(cmdInManager.pCommand);
+	}
+
+	m_pFlightRecorder = pRecorder;
+	m_pFlightRecorder->BeginSession(pGameName, formatVersion, pDescriptionPacket, commandList, GetStartState());
+}
+
+const geng::serial::CommandStartState* geng::CommandManager::GetStartState() const
+{
+	return m_pReader && m_pReader->HasStartState() ? &m_pReader->GetStartState() : nullptr;
+}
+
+void geng::CommandManager::GetDemoHeader(serial::FileStreamHeader& rHeader,
+	const char* pGameName,
+	uint32_t formatVersion,
+	bool compress)
+{
+	rHeader.headerConstant = "DemoFile_";
+	rHeader.headerConstant += pGameName;
+	rHeader.versionNo = formatVersion;
+	rHeader.hasChecksum = true;
+	rHeader.checksumSeed = SEED_DEMO_CHECKSUM;
+	rHeader.isCompressed = compress;
 }
 
 bool geng::CommandManager::IsEndOfPlayback() const
@@ -91,26 +149,74 @@ bool geng::CommandManager::IsEndOfPlayback() const
 		&& m_pReader->IsWrappedUp();
 }
 
+bool geng::CommandManager::IsPlaybackError() const
+{
+	// Still answers after the session has ended
+	return m_pReader
+		&& m_pReader->GetPlaybackStatus() == serial::FilePlaybackStatus::FileError;
+}
+
+geng::serial::FileChecksumStatus geng::CommandManager::GetChecksumStatus() const
+{
+	return m_pReader ? m_pReader->GetChecksumStatus() : serial::FileChecksumStatus::FileNoChecksum;
+}
+
 void geng::CommandManager::OnFrame(unsigned long frameIndex)
 {
+	m_frameChanges.Clear();
+	m_currentFrame = frameIndex;
+
 	if (m_playbackMode == PlaybackMode::Record)
 	{
 		m_pWriter->BeginFrame(frameIndex);
 	}
-	
-	// NOTE:  For playback, the first command stream called invokes the reader's 
-	// "update frame" function; so it need not be done explicitly.
+	if (m_pFeedWriter)
+	{
+		m_pFeedWriter->BeginFrame(frameIndex);
+	}
+	if (m_pFlightRecorder)
+	{
+		m_pFlightRecorder->BeginFrame(frameIndex);
+	}
+
+	// On playback, all the streams come from the reader; it's enough to advance it once
+	if (m_playbackMode == PlaybackMode::Playback)
+	{
+		m_pReader->AdvanceTo(frameIndex);
+		return;
+	}
+
 	for (Command_& cmdInManager : m_commands)
 	{
 		cmdInManager.pStream->UpdateOnFrame(frameIndex);
 	}
 }
 
+unsigned long geng::CommandManager::GetNextInputChangeFrame() const
+{
+	if (m_playbackMode != PlaybackMode::Playback || m_pFeedWriter || m_pFlightRecorder)
+	{
+		return m_currentFrame + 1;
+	}
+
+	unsigned long nextChangeFrame = m_pReader->GetNextChangeFrame();
+	return nextChangeFrame == serial::FileCommandReader::NO_CHANGE_FRAME ? NO_INPUT_CHANGE_FRAME
+		: nextChangeFrame;
+}
+
 void geng::CommandManager::EndFrame()
 {
 	if (m_playbackMode == PlaybackMode::Record)
 	{
-		m_pWriter->EndFrame();
+		m_pWriter->EndFrame(m_frameChanges);
+	}
+	if (m_pFeedWriter)
+	{
+		m_pFeedWriter->EndFrame(m_frameChanges);
+	}
+	if (m_pFlightRecorder)
+	{
+		m_pFlightRecorder->EndFrame(m_frameChanges);
 	}
 }
 
@@ -120,6 +226,14 @@ void geng::CommandManager::EndSession()
 	{
 		m_pWriter->EndSession();
 	}
+	if (m_pFeedWriter)
+	{
+		m_pFeedWriter->EndSession();
+	}
+	if (m_pFlightRecorder)
+	{
+		m_pFlightRecorder->EndSession();
+	}
 	m_playbackMode = PlaybackMode::Ended;
 }
 
@@ -128,16 +242,13 @@ bool geng::CommandManager::OpenFile(
 	uint32_t formatVersion,
 	uint32_t minVersion,
 	bool allowUnsafePlayback,
+	bool compressRecording,
 	const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
 	const std::vector<std::shared_ptr<serial::ISerializableCommand> >& commandList)
 {
+	// The compression flag is only meaningful when recording; on playback, it's read from the file
 	serial::FileStreamHeader hdrDesc;
-	
-	hdrDesc.headerConstant = "DemoFile_";
-	hdrDesc.headerConstant += pGameName;
-	hdrDesc.versionNo = formatVersion;
-	hdrDesc.hasChecksum = true;
-	hdrDesc.checksumSeed = SEED_DEMO_CHECKSUM;
+	GetDemoHeader(hdrDesc, pGameName, formatVersion, compressRecording);
 
 	if (HasFile(m_playbackMode))
 	{
@@ -7,6 +7,7 @@
 
 #include <vector>
 #include <memory>
+#include <limits>
 
 namespace geng
 {
@@ -15,12 +16,19 @@ namespace geng
 	{
 		class FileCommandReader;
 		class FileCommandWriter;
+		class SpectatorFeedWriter;
+		enum class FileChecksumStatus;
+		struct FileStreamHeader;
 	}
 
+	class FlightRecorder;
+
 	// TODO: Should this be an argument?
 	constexpr unsigned long long
 		SEED_DEMO_CHECKSUM = 0x0102040509080a0f;
 
+	constexpr unsigned long NO_INPUT_CHANGE_FRAME = std::numeric_limits<unsigned long>::max();
+
 	class CommandDesc
 	{
 	public:
@@ -57,11 +65,11 @@ namespace geng
 			uint32_t formatVersion,
 			uint32_t minVersion,
 			bool allowUnsafePlayback,
+			bool compressRecording,
 			const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
 			const std::vector<CommandDesc>& cmdList);
 
-		// In read mode, unsubscribe the commands from the reader in order
-		// to free up circular refs
+		// Unbind the commands from this manager's change list
 		~CommandManager();
 
 		void OnFrame(unsigned long frameIndex);
@@ -75,12 +83,49 @@ namespace geng
 		uint32_t GetFormatVersion() const { return m_playbackFormatVersion; }
 
 		bool IsEndOfPlayback() const;
+		// The playback file turned out to be truncated or corrupt past its header
+		bool IsPlaybackError() const;
+		// Only meaningful when a playback file has been opened
+		serial::FileChecksumStatus GetChecksumStatus() const;
+
+		// No command changes before this frame, and playback doesn't end before it either;
+		// NO_INPUT_CHANGE_FRAME if the file has nothing left.  OnFrame may skip straight to it.
+		// Only playback knows ahead, and the feed and flight recorder need every frame, so
+		// otherwise this is simply the frame after the current one
+		unsigned long GetNextInputChangeFrame() const;
+
+		// The commands changed in the current frame, indexed in command list order.  Complete once
+		// the streams have been updated in OnFrame, and good until the next frame
+		const CommandChangeList& GetFrameChanges() const { return m_frameChanges; }
+
+		// Publish the commands to a shared-memory feed that spectators can follow
+		bool PublishSpectatorFeed(const char* pFeedName,
+			const std::shared_ptr<serial::IPacket>& pDescriptionPacket);
+		// Null unless a feed is being published
+		serial::SpectatorFeedWriter* GetSpectatorFeed() const { return m_pFeedWriter.get(); }
+
+		// Keep the last stretch of the game in memory, ready to be written out as a demo.  The
+		// recorder starts a new session and outlives the manager
+		void AttachFlightRecorder(const std::shared_ptr<FlightRecorder>& pRecorder,
+			const char* pGameName,
+			uint32_t formatVersion,
+			const std::shared_ptr<serial::IPacket>& pDescriptionPacket);
+
+		// Playback only:  the saved state a recording of a game in progress starts from, or null
+		const serial::CommandStartState* GetStartState() const;
+
+		// The header of a demo file for this game
+		static void GetDemoHeader(serial::FileStreamHeader& rHeader,
+			const char* pGameName,
+			uint32_t formatVersion,
+			bool compress);
 	private:
 		// Open the playback file and create an object to represent it
 		bool OpenFile(const char* pGameName,
 					uint32_t formatVersion,
 					uint32_t minVersion,
 					bool allowUnsafePlayback,
+					bool compressRecording,
 					const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
 					const std::vector<std::shared_ptr<serial::ISerializableCommand> >& commandList);
 		
@@ -106,8 +151,12 @@ namespace geng
 		std::string m_fileName;
 		std::shared_ptr<serial::FileCommandReader>  m_pReader;
 		std::shared_ptr<serial::FileCommandWriter>  m_pWriter;
+		std::shared_ptr<serial::SpectatorFeedWriter>  m_pFeedWriter;
+		std::shared_ptr<FlightRecorder>  m_pFlightRecorder;
 
 		std::vector<Command_>  m_commands;
+		CommandChangeList  m_frameChanges;
+		unsigned long m_currentFrame{ 0 };
 
 	};
 
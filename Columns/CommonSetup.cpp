@@ -4,6 +4,7 @@
 #include "TrueTypeFont.h"
 #include "SDLEventPoller.h"
 #include "SDLInput.h"
+#include "NullInput.h"
 #include "ActionMapper.h"
 #include "SDLRendering.h"
 
@@ -36,6 +37,13 @@ std::shared_ptr<geng::IGameComponent> geng::setup::InitializeSDLInput(geng::IGam
 	return pInput;
 }
 
+std::shared_ptr<geng::IGameComponent> geng::setup::InitializeNullInput(geng::IGame* pGame)
+{
+	auto pInput = std::make_shared<geng::NullInput>();
+	pGame->AddComponent(pInput);
+	return pInput;
+}
+
 std::shared_ptr<geng::IGameComponent> geng::setup::InitializeActionMapper(geng::IGame* pGame,
 	const char* pName)
 {
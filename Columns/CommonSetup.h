@@ -8,6 +8,7 @@ namespace geng::setup
 	std::shared_ptr<IGameComponent> InitializeResourceLoader(geng::IGame* pGame);
 	std::shared_ptr<IGameComponent> InitializeSDLPoller(geng::IGame* pGame);
 	std::shared_ptr<IGameComponent> InitializeSDLInput(geng::IGame* pGame);
+	std::shared_ptr<IGameComponent> InitializeNullInput(geng::IGame* pGame);
 	std::shared_ptr<IGameComponent> InitializeActionMapper(geng::IGame* pGame, 
 															const char* pName);
 
@@ -0,0 +1,33 @@
+#pragma once
+// A summary header including the headers required for producing data trees
+// that live in an arena
+
+#include "DTArenaList.h"
+#include "DTArenaDict.h"
+#include "DTArenaElement.h"
+#include "DTConstruct.h"
+
+namespace geng::data::arena
+{
+	// Builds in the current ArenaScope's arena.  A node made outside of any scope gets a small
+	// arena of its own, which works but saves nothing
+	struct Suite
+	{
+		using Element = geng::data::arena::Element;
+		using List = geng::data::arena::List;
+		using Dict = geng::data::arena::Dictionary;
+
+		template<typename T>
+		static std::shared_ptr<T> Create()
+		{
+			Arena* pArena = ArenaScope::GetCurrentArena();
+			if (pArena)
+			{
+				return pArena->Share(pArena->New<T>(pArena));
+			}
+
+			auto pOwnArena = std::make_shared<Arena>(sizeof(T) + 64);
+			return pOwnArena->Share(pOwnArena->New<T>(pOwnArena.get()));
+		}
+	};
+}
@@ -0,0 +1,109 @@
+#include "DTArenaAlloc.h"
+#include "BlockPool.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+namespace impl_ns = geng::data::arena;
+
+namespace
+{
+	thread_local impl_ns::Arena* t_pCurrentArena{ nullptr };
+
+	constexpr size_t AlignUp(size_t size, size_t alignment)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+impl_ns::Arena::Arena(size_t firstBlockSize)
+	:m_nextBlockSize(firstBlockSize)
+{
+
+}
+
+impl_ns::Arena::~Arena()
+{
+	// Objects were added to the front, so the last made goes first
+	for (Cleanup_* pCleanup = m_pCleanups; pCleanup; pCleanup = pCleanup->pNext)
+	{
+		pCleanup->pDestroy(pCleanup->pObject);
+	}
+
+	while (m_pBlocks)
+	{
+		Block_* pBlock = m_pBlocks;
+		m_pBlocks = pBlock->pNext;
+		BlockPool::Free(pBlock, pBlock->size);
+	}
+}
+
+void* impl_ns::Arena::Allocate(size_t size, size_t alignment)
+{
+	char* pAligned = m_pNext ? reinterpret_cast<char*>(AlignUp(reinterpret_cast<uintptr_t>(m_pNext), alignment))
+		: nullptr;
+	if (!pAligned || pAligned > m_pEnd || size > (size_t)(m_pEnd - pAligned))
+	{
+		AddBlock(size + alignment);
+		pAligned = reinterpret_cast<char*>(AlignUp(reinterpret_cast<uintptr_t>(m_pNext), alignment));
+	}
+
+	m_pNext = pAligned + size;
+	m_bytesAllocated += size;
+	return pAligned;
+}
+
+const char* impl_ns::Arena::CopyString(const char* pText, size_t length)
+{
+	char* pCopy = static_cast<char*>(Allocate(length + 1, 1));
+	std::memcpy(pCopy, pText, length);
+	pCopy[length] = '\0';
+	return pCopy;
+}
+
+void impl_ns::Arena::AddCleanup(void (*pDestroy)(void*), void* pObject)
+{
+	Cleanup_* pCleanup = new (Allocate(sizeof(Cleanup_), alignof(Cleanup_))) Cleanup_{ pDestroy, pObject, m_pCleanups };
+	m_pCleanups = pCleanup;
+}
+
+void impl_ns::Arena::AddBlock(size_t minSize)
+{
+	constexpr size_t HEADER_SIZE = AlignUp(sizeof(Block_), alignof(std::max_align_t));
+
+	// Blocks double until they're big enough that the headers don't matter
+	size_t blockSize = std::max(m_nextBlockSize, minSize + HEADER_SIZE);
+	m_nextBlockSize = std::min(m_nextBlockSize * 2, MAX_BLOCK_SIZE);
+
+	Block_* pBlock = static_cast<Block_*>(BlockPool::Allocate(blockSize));
+	pBlock->pNext = m_pBlocks;
+	pBlock->size = blockSize;
+	m_pBlocks = pBlock;
+	++m_blockCount;
+
+	m_pNext = reinterpret_cast<char*>(pBlock) + HEADER_SIZE;
+	m_pEnd = reinterpret_cast<char*>(pBlock) + blockSize;
+}
+
+impl_ns::ArenaScope::ArenaScope()
+	:ArenaScope(std::make_shared<Arena>())
+{
+
+}
+
+impl_ns::ArenaScope::ArenaScope(const std::shared_ptr<Arena>& pArena)
+	:m_pArena(pArena),
+	m_pPrevious(t_pCurrentArena)
+{
+	t_pCurrentArena = m_pArena.get();
+}
+
+impl_ns::ArenaScope::~ArenaScope()
+{
+	t_pCurrentArena = m_pPrevious;
+}
+
+impl_ns::Arena* impl_ns::ArenaScope::GetCurrentArena()
+{
+	return t_pCurrentArena;
+}
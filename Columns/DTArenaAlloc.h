@@ -0,0 +1,226 @@
+#pragma once
+#include "IDataTree.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace geng::data::arena
+{
+
+	// Bump allocation for one data tree.  Nodes, keys, strings and child arrays all come out of a
+	// chain of blocks that grow as the tree does, and go back all at once when the arena dies.
+	// Objects made with New() are destroyed then too, last first.
+	// Handles to the nodes share ownership of the whole arena (see Share()), so the arena lives
+	// as long as anything holds a part of the tree.  Not thread safe; build a tree on one thread
+	class Arena : public std::enable_shared_from_this<Arena>
+	{
+	public:
+		// The first block comes from the block pool, so small trees cost one pooled allocation
+		static constexpr size_t DEFAULT_FIRST_BLOCK_SIZE = 512;
+		static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+
+		Arena(size_t firstBlockSize = DEFAULT_FIRST_BLOCK_SIZE);
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		// A null-terminated copy
+		const char* CopyString(const char* pText, size_t length);
+
+		template<typename T, typename ... Args>
+		T* New(Args&& ... args)
+		{
+			T* pObject = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				AddCleanup(&DestroyObject<T>, pObject);
+			}
+			return pObject;
+		}
+
+		// A handle to an object in the arena, sharing ownership of the arena
+		template<typename T>
+		std::shared_ptr<T> Share(T* pObject)
+		{
+			return std::shared_ptr<T>(shared_from_this(), pObject);
+		}
+
+		// The datum is one of the handles made by Share()
+		bool Owns(const std::shared_ptr<IDatum>& pDatum) const
+		{
+			std::weak_ptr<const Arena> pSelf = weak_from_this();
+			return !pSelf.owner_before(pDatum) && !pDatum.owner_before(pSelf);
+		}
+
+		size_t GetBytesAllocated() const { return m_bytesAllocated; }
+		size_t GetBlockCount() const { return m_blockCount; }
+
+	private:
+		struct Block_
+		{
+			Block_* pNext;
+			size_t size;
+		};
+
+		struct Cleanup_
+		{
+			void (*pDestroy)(void*);
+			void* pObject;
+			Cleanup_* pNext;
+		};
+
+		template<typename T>
+		static void DestroyObject(void* pObject)
+		{
+			static_cast<T*>(pObject)->~T();
+		}
+
+		void AddCleanup(void (*pDestroy)(void*), void* pObject);
+		void AddBlock(size_t minSize);
+
+		Block_* m_pBlocks{ nullptr };
+		char* m_pNext{ nullptr };
+		char* m_pEnd{ nullptr };
+		size_t m_nextBlockSize;
+		Cleanup_* m_pCleanups{ nullptr };
+
+		size_t m_bytesAllocated{ 0 };
+		size_t m_blockCount{ 0 };
+	};
+
+	// While it lives, arena::Suite builds in this scope's arena on this thread.  Scopes nest; the
+	// innermost one wins.  The arena outlives the scope for as long as its tree is held
+	class ArenaScope
+	{
+	public:
+		ArenaScope();
+		ArenaScope(const std::shared_ptr<Arena>& pArena);
+		~ArenaScope();
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+		const std::shared_ptr<Arena>& GetArena() const { return m_pArena; }
+
+		// Null outside any scope
+		static Arena* GetCurrentArena();
+
+	private:
+		std::shared_ptr<Arena> m_pArena;
+		Arena* m_pPrevious;
+	};
+
+	// An array in an arena.  Growing moves the entries to a bigger array from the arena; the old
+	// one is only given back with the rest of the arena
+	template<typename T>
+	class ArenaVector
+	{
+	public:
+		ArenaVector() = default;
+		ArenaVector(const ArenaVector&) = delete;
+		ArenaVector& operator=(const ArenaVector&) = delete;
+
+		~ArenaVector()
+		{
+			for (size_t i = 0; i < m_size; ++i)
+			{
+				m_pData[i].~T();
+			}
+		}
+
+		bool empty() const { return m_size == 0; }
+		size_t size() const { return m_size; }
+
+		T& operator[](size_t idx) { return m_pData[idx]; }
+		const T& operator[](size_t idx) const { return m_pData[idx]; }
+
+		T* begin() { return m_pData; }
+		T* end() { return m_pData + m_size; }
+		const T* begin() const { return m_pData; }
+		const T* end() const { return m_pData + m_size; }
+
+		void Insert(Arena& rArena, size_t indexBefore, T&& value)
+		{
+			if (m_size == m_capacity)
+			{
+				size_t newCapacity = m_capacity > 0 ? m_capacity * 2 : 4;
+				T* pNewData = static_cast<T*>(rArena.Allocate(newCapacity * sizeof(T), alignof(T)));
+				for (size_t i = 0; i < m_size; ++i)
+				{
+					new (pNewData + i) T(std::move(m_pData[i]));
+					m_pData[i].~T();
+				}
+				m_pData = pNewData;
+				m_capacity = newCapacity;
+			}
+
+			if (indexBefore == m_size)
+			{
+				new (m_pData + m_size) T(std::move(value));
+			}
+			else
+			{
+				new (m_pData + m_size) T(std::move(m_pData[m_size - 1]));
+				for (size_t i = m_size - 1; i > indexBefore; --i)
+				{
+					m_pData[i] = std::move(m_pData[i - 1]);
+				}
+				m_pData[indexBefore] = std::move(value);
+			}
+			++m_size;
+		}
+
+	private:
+		T* m_pData{ nullptr };
+		size_t m_size{ 0 };
+		size_t m_capacity{ 0 };
+	};
+
+	// A node's child.  One from the same arena is held by pointer, since a handle to it would keep
+	// its own arena alive; one from anywhere else is held by its handle
+	class ArenaChild
+	{
+	public:
+		void Set(const Arena& rArena, const std::shared_ptr<IDatum>& pChild)
+		{
+			if (rArena.Owns(pChild))
+			{
+				m_pDatum = pChild.get();
+				m_pForeign.reset();
+			}
+			else
+			{
+				m_pDatum = nullptr;
+				m_pForeign = pChild;
+			}
+		}
+
+		void Get(Arena& rArena, std::shared_ptr<IDatum>& rChild) const
+		{
+			if (m_pDatum)
+			{
+				rChild = rArena.Share(m_pDatum);
+			}
+			else
+			{
+				rChild = m_pForeign;
+			}
+		}
+
+		// Without sharing it
+		const IDatum& Borrow() const
+		{
+			return m_pDatum ? *m_pDatum : *m_pForeign;
+		}
+
+	private:
+		IDatum* m_pDatum{ nullptr };
+		std::shared_ptr<IDatum> m_pForeign;
+	};
+
+}
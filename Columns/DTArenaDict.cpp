@@ -0,0 +1,172 @@
+#include "DTArenaDict.h"
+#include <cstring>
+
+namespace impl_ns = geng::data::arena;
+
+bool impl_ns::Dictionary::IsEmpty() const
+{
+	return m_entries.empty();
+}
+
+geng::data::BaseDatumType impl_ns::Dictionary::GetDatumType() const
+{
+	return BaseDatumType::Dictionary;
+}
+
+bool impl_ns::Dictionary::IsImmutable() const
+{
+	return false;
+}
+
+namespace
+{
+	template<typename E>
+	bool KeyMatches(const E& rEntry, const geng::data::DictKey& key)
+	{
+		return rEntry.keyHash == key.GetHash()
+			&& rEntry.keyLength == key.GetLength()
+			&& std::memcmp(rEntry.pKey, key.GetText(), key.GetLength()) == 0;
+	}
+}
+
+const impl_ns::Dictionary::Entry_* impl_ns::Dictionary::FindEntry(const DictKey& key) const
+{
+	if (!m_pIndex)
+	{
+		for (const Entry_& rEntry : m_entries)
+		{
+			if (KeyMatches(rEntry, key))
+			{
+				return &rEntry;
+			}
+		}
+		return nullptr;
+	}
+
+	// Linear probing; the index is never more than half full, so there is always an empty slot
+	for (size_t slot = key.GetHash() & m_indexMask; m_pIndex[slot] != 0; slot = (slot + 1) & m_indexMask)
+	{
+		const Entry_& rEntry = m_entries[m_pIndex[slot] - 1];
+		if (KeyMatches(rEntry, key))
+		{
+			return &rEntry;
+		}
+	}
+
+	return nullptr;
+}
+
+void impl_ns::Dictionary::Reindex(size_t slotCount)
+{
+	m_pIndex = static_cast<uint32_t*>(m_pArena->Allocate(slotCount * sizeof(uint32_t), alignof(uint32_t)));
+	std::memset(m_pIndex, 0, slotCount * sizeof(uint32_t));
+	m_indexMask = slotCount - 1;
+
+	for (uint32_t entryIdx = 0; entryIdx < (uint32_t)m_entries.size(); ++entryIdx)
+	{
+		AddToIndex(entryIdx);
+	}
+}
+
+void impl_ns::Dictionary::AddToIndex(uint32_t entryIdx)
+{
+	size_t slot = m_entries[entryIdx].keyHash & m_indexMask;
+	while (m_pIndex[slot] != 0)
+	{
+		slot = (slot + 1) & m_indexMask;
+	}
+	m_pIndex[slot] = entryIdx + 1;
+}
+
+bool impl_ns::Dictionary::HasEntry(const char* pKey) const
+{
+	return FindEntry(pKey) != nullptr;
+}
+
+bool impl_ns::Dictionary::GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const
+{
+	return GetEntryByKey(pKey, rChild);
+}
+
+bool impl_ns::Dictionary::GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+{
+	const Entry_* pEntry = FindEntry(key);
+	if (pEntry)
+	{
+		pEntry->child.Get(*m_pArena, rChild);
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::Dictionary::Iterate(geng::data::IDictCallback& rCallback) const
+{
+	std::shared_ptr<IDatum> pChild;
+	for (const Entry_& rEntry : m_entries)
+	{
+		rEntry.child.Get(*m_pArena, pChild);
+		if (!rCallback.OnEntry(rEntry.pKey, pChild))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::Dictionary::ForEachChild(geng::data::IChildCallback& rCallback) const
+{
+	for (const Entry_& rEntry : m_entries)
+	{
+		if (!rCallback.OnChild(rEntry.pKey, rEntry.child.Borrow()))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::Dictionary::SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild)
+{
+	DictKey key(pKey);
+	Entry_* pEntry = const_cast<Entry_*>(FindEntry(key));
+	if (pEntry)
+	{
+		pEntry->child.Set(*m_pArena, rChild);
+		return false;
+	}
+
+	Entry_ newEntry;
+	newEntry.keyHash = key.GetHash();
+	newEntry.keyLength = key.GetLength();
+	newEntry.pKey = m_pArena->CopyString(pKey, newEntry.keyLength);
+	newEntry.child.Set(*m_pArena, rChild);
+	m_entries.Insert(*m_pArena, m_entries.size(), std::move(newEntry));
+
+	size_t entryCount = m_entries.size();
+	if (m_pIndex)
+	{
+		size_t slotCount = m_indexMask + 1;
+		if (entryCount * 2 > slotCount)
+		{
+			Reindex(slotCount * 2);
+		}
+		else
+		{
+			AddToIndex((uint32_t)(entryCount - 1));
+		}
+	}
+	else if (entryCount > MAX_SCANNED_ENTRIES)
+	{
+		size_t slotCount = 4;
+		while (slotCount < entryCount * 2)
+		{
+			slotCount *= 2;
+		}
+		Reindex(slotCount);
+	}
+
+	return true;
+}
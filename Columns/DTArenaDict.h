@@ -0,0 +1,54 @@
+#pragma once
+#include "DTArenaAlloc.h"
+
+namespace geng::data::arena
+{
+
+	// Keys live in the arena next to the entries.  Small dictionaries, as descriptors and most
+	// config are, are scanned, comparing hashes first.  Past MAX_SCANNED_ENTRIES the entries get
+	// an open-addressed index in the arena as well, so big ones don't take quadratic time to build.
+	// The index doubles when half full; the old ones go back with the arena
+	class Dictionary : public IDictDatum
+	{
+	public:
+		Dictionary(Arena* pArena)
+			:m_pArena(pArena)
+		{ }
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		bool HasEntry(const char* pKey) const override;
+		bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const override;
+		bool Iterate(IDictCallback& rCallback) const override;
+		bool ForEachChild(IChildCallback& rCallback) const override;
+
+		bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) override;
+
+	private:
+		static constexpr size_t MAX_SCANNED_ENTRIES = 8;
+
+		struct Entry_
+		{
+			const char* pKey;
+			size_t keyLength;
+			uint32_t keyHash;
+			ArenaChild child;
+		};
+
+		const Entry_* FindEntry(const DictKey& key) const;
+		// Makes a new index with room for the given number of slots, a power of two
+		void Reindex(size_t slotCount);
+		void AddToIndex(uint32_t entryIdx);
+
+		Arena* m_pArena;
+		ArenaVector<Entry_> m_entries;
+		// The number of each entry plus one, by hash; zero is an empty slot.  Null while the
+		// entries are few enough to scan
+		uint32_t* m_pIndex{ nullptr };
+		size_t m_indexMask{ 0 };
+	};
+
+}
@@ -0,0 +1,228 @@
+#include "DTArenaElement.h"
+#include <cstring>
+
+namespace impl_ns = geng::data::arena;
+
+geng::data::BaseDatumType impl_ns::Element::GetDatumType() const
+{
+	return BaseDatumType::Element;
+}
+
+bool impl_ns::Element::IsImmutable() const
+{
+	return false;
+}
+
+geng::data::ElementType impl_ns::Element::GetElementType() const
+{
+	return m_type;
+}
+
+bool impl_ns::Element::Get(bool& rDatum) const
+{
+	if (m_type != ElementType::Boolean)
+	{
+		return false;
+	}
+
+	rDatum = m_b;
+	return true;
+}
+void impl_ns::Element::Set(bool datum)
+{
+	m_type = ElementType::Boolean;
+	m_b = datum;
+}
+
+bool impl_ns::Element::Get(int8_t& rDatum) const
+{
+	if (m_type != ElementType::Int8)
+	{
+		return false;
+	}
+
+	rDatum = m_i8;
+	return true;
+}
+void impl_ns::Element::Set(int8_t datum)
+{
+	m_type = ElementType::Int8;
+	m_i8 = datum;
+}
+
+bool impl_ns::Element::Get(uint8_t& rDatum) const
+{
+	if (m_type != ElementType::UInt8)
+	{
+		return false;
+	}
+
+	rDatum = m_u8;
+	return true;
+}
+void impl_ns::Element::Set(uint8_t datum)
+{
+	m_type = ElementType::UInt8;
+	m_u8 = datum;
+}
+
+bool impl_ns::Element::Get(int16_t& rDatum) const
+{
+	if (m_type != ElementType::Int16)
+	{
+		return false;
+	}
+
+	rDatum = m_i16;
+	return true;
+}
+void impl_ns::Element::Set(int16_t datum)
+{
+	m_type = ElementType::Int16;
+	m_i16 = datum;
+}
+
+bool impl_ns::Element::Get(uint16_t& rDatum) const
+{
+	if (m_type != ElementType::UInt16)
+	{
+		return false;
+	}
+
+	rDatum = m_u16;
+	return true;
+}
+void impl_ns::Element::Set(uint16_t datum)
+{
+	m_type = ElementType::UInt16;
+	m_u16 = datum;
+}
+
+bool impl_ns::Element::Get(int32_t& rDatum) const
+{
+	if (m_type != ElementType::Int32)
+	{
+		return false;
+	}
+
+	rDatum = m_i32;
+	return true;
+}
+void impl_ns::Element::Set(int32_t datum)
+{
+	m_type = ElementType::Int32;
+	m_i32 = datum;
+}
+
+bool impl_ns::Element::Get(uint32_t& rDatum) const
+{
+	if (m_type != ElementType::UInt32)
+	{
+		return false;
+	}
+
+	rDatum = m_u32;
+	return true;
+}
+void impl_ns::Element::Set(uint32_t datum)
+{
+	m_type = ElementType::UInt32;
+	m_u32 = datum;
+}
+
+bool impl_ns::Element::Get(int64_t& rDatum) const
+{
+	if (m_type != ElementType::Int64)
+	{
+		return false;
+	}
+
+	rDatum = m_i64;
+	return true;
+}
+void impl_ns::Element::Set(int64_t datum)
+{
+	m_type = ElementType::Int64;
+	m_i64 = datum;
+}
+
+bool impl_ns::Element::Get(uint64_t& rDatum) const
+{
+	if (m_type != ElementType::UInt64)
+	{
+		return false;
+	}
+
+	rDatum = m_u64;
+	return true;
+}
+void impl_ns::Element::Set(uint64_t datum)
+{
+	m_type = ElementType::UInt64;
+	m_u64 = datum;
+}
+
+bool impl_ns::Element::Get(float& rDatum) const
+{
+	if (m_type != ElementType::Float)
+	{
+		return false;
+	}
+
+	rDatum = m_f;
+	return true;
+}
+void impl_ns::Element::Set(float datum)
+{
+	m_type = ElementType::Float;
+	m_f = datum;
+}
+
+bool impl_ns::Element::Get(double& rDatum) const
+{
+	if (m_type != ElementType::Double)
+	{
+		return false;
+	}
+
+	rDatum = m_d;
+	return true;
+}
+void impl_ns::Element::Set(double datum)
+{
+	m_type = ElementType::Double;
+	m_d = datum;
+}
+
+bool impl_ns::Element::Get(std::string& rDatum) const
+{
+	if (m_type != ElementType::String)
+	{
+		return false;
+	}
+
+	rDatum.assign(m_string.pText, m_string.length);
+	return true;
+}
+bool impl_ns::Element::Get(std::string_view& rDatum) const
+{
+	if (m_type != ElementType::String)
+	{
+		return false;
+	}
+
+	rDatum = std::string_view(m_string.pText, m_string.length);
+	return true;
+}
+void impl_ns::Element::Set(const char* datum)
+{
+	size_t length = std::strlen(datum);
+	m_type = ElementType::String;
+	m_string.pText = m_pArena->CopyString(datum, length);
+	m_string.length = length;
+}
+
+void impl_ns::Element::Clear()
+{
+	m_type = ElementType::None;
+}
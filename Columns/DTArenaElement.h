@@ -0,0 +1,84 @@
+#pragma once
+#include "DTArenaAlloc.h"
+
+namespace geng::data::arena
+{
+
+	// Numbers are held in place; strings are copied into the arena, so an element never touches
+	// the heap.  Setting a string again leaves the old copy in the arena
+	class Element : public IElementDatum
+	{
+	public:
+		Element(Arena* pArena)
+			:m_pArena(pArena)
+		{ }
+
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+		ElementType GetElementType() const override;
+
+		bool Get(bool& rDatum) const override;
+		void Set(bool datum) override;
+
+		bool Get(int8_t& rDatum) const override;
+		void Set(int8_t datum) override;
+
+		bool Get(uint8_t& rDatum) const override;
+		void Set(uint8_t datum) override;
+
+		bool Get(int16_t& rDatum) const override;
+		void Set(int16_t datum) override;
+
+		bool Get(uint16_t& rDatum) const override;
+		void Set(uint16_t datum) override;
+
+		bool Get(int32_t& rDatum) const override;
+		void Set(int32_t datum) override;
+
+		bool Get(uint32_t& rDatum) const override;
+		void Set(uint32_t datum) override;
+
+		bool Get(int64_t& rDatum) const override;
+		void Set(int64_t datum) override;
+
+		bool Get(uint64_t& rDatum) const override;
+		void Set(uint64_t datum) override;
+
+		bool Get(float& rDatum) const override;
+		void Set(float datum) override;
+
+		bool Get(double& rDatum) const override;
+		void Set(double datum) override;
+
+		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
+		void Set(const char* datum) override;
+
+		void Clear() override;
+	private:
+		struct String_
+		{
+			const char* pText;
+			size_t length;
+		};
+
+		Arena* m_pArena;
+		ElementType m_type{ ElementType::None };
+		union
+		{
+			bool m_b;
+			int8_t m_i8;
+			uint8_t m_u8;
+			int16_t m_i16;
+			uint16_t m_u16;
+			int32_t m_i32;
+			uint32_t m_u32;
+			int64_t m_i64;
+			uint64_t m_u64;
+			float m_f;
+			double m_d;
+			String_ m_string;
+		};
+	};
+
+}
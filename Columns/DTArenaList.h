@@ -0,0 +1,34 @@
+#pragma once
+#include "DTArenaAlloc.h"
+
+namespace geng::data::arena
+{
+
+	class List : public IListDatum
+	{
+	public:
+		List(Arena* pArena)
+			:m_pArena(pArena)
+		{ }
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		size_t GetLength() const override;
+		bool GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+			size_t startIdx,
+			size_t endIdx) const override;
+		bool ForEachChild(IChildCallback& rCallback) const override;
+		bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexBefore) override;
+		bool SetEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexAt) override;
+
+	private:
+		Arena* m_pArena;
+		ArenaVector<ArenaChild> m_list;
+	};
+
+}
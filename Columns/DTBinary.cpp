@@ -0,0 +1,622 @@
+#include "DTBinary.h"
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace impl_ns = geng::data;
+
+namespace
+{
+	// A container's count follows its byte length
+	constexpr size_t CONTAINER_FIELD_SIZE = 4;
+	constexpr size_t DISCARD_BUFFER_SIZE = 256;
+	// Ten 7-bit groups hold any uint64_t
+	constexpr unsigned int MAX_VARINT_BYTES = 10;
+}
+
+impl_ns::DTBinaryWriter::DTBinaryWriter(serial::IWriteStream& rStream)
+	:m_rStream(rStream)
+{
+
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnList(const IListDatum& rList,
+	bool hasElements)
+{
+	return OnCompound(BinaryTag::List, hasElements);
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnDict(const IDictDatum& rDict,
+	bool hasElements)
+{
+	return OnCompound(BinaryTag::Dictionary, hasElements);
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnCompound(BinaryTag tag, bool hasElements)
+{
+	BeginValue();
+	PutTag(tag);
+	size_t lengthPosition = m_buffer.size();
+	PutFixed(CONTAINER_FIELD_SIZE, CONTAINER_FIELD_SIZE);
+	PutFixed(0, CONTAINER_FIELD_SIZE);
+
+	if (hasElements)
+	{
+		// Both fields are filled in by EndCompound
+		m_openContainers.push_back(OpenContainer_{ lengthPosition, 0 });
+		return m_failed ? IterInstruction::Break : IterInstruction::Enter;
+	}
+	return EndValue();
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnDictKey(const char* pKey)
+{
+	if (m_openContainers.empty())
+	{
+		throw DataStateException();
+	}
+
+	++m_openContainers.back().count;
+	PutString(pKey, std::strlen(pKey));
+	m_afterKey = true;
+	return m_failed ? IterInstruction::Break : IterInstruction::Enter;
+}
+
+void impl_ns::DTBinaryWriter::EndCompound()
+{
+	if (m_openContainers.empty())
+	{
+		throw DataStateException();
+	}
+
+	OpenContainer_ container = m_openContainers.back();
+	m_openContainers.pop_back();
+
+	size_t length = m_buffer.size() - container.lengthPosition - CONTAINER_FIELD_SIZE;
+	if (length > std::numeric_limits<uint32_t>::max())
+	{
+		m_failed = true;
+		return;
+	}
+	PatchUInt32(container.lengthPosition, (uint32_t)length);
+	PatchUInt32(container.lengthPosition + CONTAINER_FIELD_SIZE, container.count);
+	EndValue();
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnElement(const IElementDatum& rElement)
+{
+	BeginValue();
+	PutElement(rElement);
+	return EndValue();
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::OnObject(const IObjectDatum& rObject)
+{
+	BeginValue();
+
+	// Objects cannot be made again from what they show, so they read back as strings
+	std::string objRep;
+	if (!rObject.GetRepresentation(objRep))
+	{
+		objRep = "<repr-error>";
+	}
+	PutTag(BinaryTag::String);
+	PutString(objRep.data(), objRep.size());
+	return EndValue();
+}
+
+void impl_ns::DTBinaryWriter::BeginValue()
+{
+	// A list counts its entries here; a dictionary counted this one with its key
+	if (!m_openContainers.empty() && !m_afterKey)
+	{
+		++m_openContainers.back().count;
+	}
+	m_afterKey = false;
+}
+
+impl_ns::IterInstruction impl_ns::DTBinaryWriter::EndValue()
+{
+	if (m_openContainers.empty() && !m_failed)
+	{
+		if (m_rStream.Write(m_buffer.data(), m_buffer.size()) != m_buffer.size())
+		{
+			m_failed = true;
+		}
+		m_buffer.clear();
+	}
+	return m_failed ? IterInstruction::Break : IterInstruction::Enter;
+}
+
+template<typename T>
+void impl_ns::DTBinaryWriter::PutNumber(BinaryTag tag, const IElementDatum& rElement)
+{
+	T value;
+	if (!rElement.Get(value))
+	{
+		throw DataStateException();
+	}
+
+	PutTag(tag);
+	if constexpr (std::is_same_v<T, float>)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		PutFixed(bits, sizeof(bits));
+	}
+	else if constexpr (std::is_same_v<T, double>)
+	{
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		PutFixed(bits, sizeof(bits));
+	}
+	else
+	{
+		PutFixed((uint64_t)value, sizeof(T));
+	}
+}
+
+void impl_ns::DTBinaryWriter::PutElement(const IElementDatum& rElement)
+{
+	switch (rElement.GetElementType())
+	{
+	case ElementType::None:
+		PutTag(BinaryTag::None);
+		return;
+	case ElementType::Boolean:
+	{
+		bool bval{ false };
+		if (!rElement.Get(bval))
+		{
+			break;
+		}
+		PutTag(bval ? BinaryTag::True : BinaryTag::False);
+		return;
+	}
+	case ElementType::Int8:
+		PutNumber<int8_t>(BinaryTag::Int8, rElement);
+		return;
+	case ElementType::UInt8:
+		PutNumber<uint8_t>(BinaryTag::UInt8, rElement);
+		return;
+	case ElementType::Int16:
+		PutNumber<int16_t>(BinaryTag::Int16, rElement);
+		return;
+	case ElementType::UInt16:
+		PutNumber<uint16_t>(BinaryTag::UInt16, rElement);
+		return;
+	case ElementType::Int32:
+		PutNumber<int32_t>(BinaryTag::Int32, rElement);
+		return;
+	case ElementType::UInt32:
+		PutNumber<uint32_t>(BinaryTag::UInt32, rElement);
+		return;
+	case ElementType::Int64:
+		PutNumber<int64_t>(BinaryTag::Int64, rElement);
+		return;
+	case ElementType::UInt64:
+		PutNumber<uint64_t>(BinaryTag::UInt64, rElement);
+		return;
+	case ElementType::Float:
+		PutNumber<float>(BinaryTag::Float, rElement);
+		return;
+	case ElementType::Double:
+		PutNumber<double>(BinaryTag::Double, rElement);
+		return;
+	case ElementType::String:
+	{
+		// Read in place, not copied
+		std::string_view strRep;
+		if (!rElement.Get(strRep))
+		{
+			break;
+		}
+		PutTag(BinaryTag::String);
+		PutString(strRep.data(), strRep.size());
+		return;
+	}
+	}
+
+	throw DataStateException();
+}
+
+void impl_ns::DTBinaryWriter::PutFixed(uint64_t value, size_t byteCount)
+{
+	for (size_t i = 0; i < byteCount; ++i)
+	{
+		m_buffer.push_back((uint8_t)(value >> (8 * i)));
+	}
+}
+
+void impl_ns::DTBinaryWriter::PutVarint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		m_buffer.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	m_buffer.push_back((uint8_t)value);
+}
+
+void impl_ns::DTBinaryWriter::PutString(const char* pString, size_t length)
+{
+	PutVarint(length);
+	const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pString);
+	m_buffer.insert(m_buffer.end(), pBytes, pBytes + length);
+}
+
+void impl_ns::DTBinaryWriter::PatchUInt32(size_t position, uint32_t value)
+{
+	for (size_t i = 0; i < sizeof(value); ++i)
+	{
+		m_buffer[position + i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+impl_ns::DTBinaryReader::DTBinaryReader(IDatumFactories& rFactories)
+	:m_rFactories(rFactories)
+{
+
+}
+
+bool impl_ns::DTBinaryReader::Read(serial::IReadStream& rStream, std::shared_ptr<IDatum>& rValue)
+{
+	m_error.clear();
+	rValue.reset();
+	return ReadValue(rStream, 0, rValue);
+}
+
+bool impl_ns::DTBinaryReader::Skip(serial::IReadStream& rStream)
+{
+	m_error.clear();
+	BinaryTag tag;
+	return ReadTag(rStream, tag) && SkipAfterTag(rStream, tag);
+}
+
+bool impl_ns::DTBinaryReader::ReadDictEntry(serial::IReadStream& rStream, const char* pKey,
+	std::shared_ptr<IDatum>& rValue)
+{
+	m_error.clear();
+	rValue.reset();
+
+	BinaryTag tag;
+	uint32_t length;
+	uint32_t count;
+	if (!ReadTag(rStream, tag))
+	{
+		return false;
+	}
+	if (tag != BinaryTag::Dictionary)
+	{
+		return SetError("Expected a dictionary");
+	}
+	if (!ReadContainerHeader(rStream, length, count))
+	{
+		return false;
+	}
+
+	// The rest of the dictionary is read through, so the stream ends up after it either way
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (!ReadString(rStream))
+		{
+			return false;
+		}
+
+		if (!rValue && m_string == pKey)
+		{
+			if (!ReadValue(rStream, 1, rValue))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (!ReadTag(rStream, tag) || !SkipAfterTag(rStream, tag))
+			{
+				return false;
+			}
+		}
+	}
+	return rValue != nullptr;
+}
+
+bool impl_ns::DTBinaryReader::ReadValue(serial::IReadStream& rStream, unsigned int depth,
+	std::shared_ptr<IDatum>& rValue)
+{
+	BinaryTag tag;
+	if (!ReadTag(rStream, tag))
+	{
+		return false;
+	}
+
+	if (tag == BinaryTag::List || tag == BinaryTag::Dictionary)
+	{
+		uint32_t length;
+		uint32_t count;
+		if (depth >= MAX_DEPTH)
+		{
+			return SetError("Too deeply nested");
+		}
+		if (!ReadContainerHeader(rStream, length, count))
+		{
+			return false;
+		}
+
+		std::shared_ptr<IDatum> pChild;
+		if (tag == BinaryTag::List)
+		{
+			if (!MakeDatum(m_rFactories.CreateList(), BaseDatumType::List, rValue))
+			{
+				return false;
+			}
+			IListDatum& rList = static_cast<IListDatum&>(*rValue);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (!ReadValue(rStream, depth + 1, pChild))
+				{
+					return false;
+				}
+				rList.InsertEntry(pChild);
+			}
+		}
+		else
+		{
+			if (!MakeDatum(m_rFactories.CreateDictionary(), BaseDatumType::Dictionary, rValue))
+			{
+				return false;
+			}
+			IDictDatum& rDict = static_cast<IDictDatum&>(*rValue);
+			// Reading the value reuses m_string
+			std::string key;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (!ReadString(rStream))
+				{
+					return false;
+				}
+				key.assign(m_string);
+				if (!ReadValue(rStream, depth + 1, pChild))
+				{
+					return false;
+				}
+				rDict.SetEntry(key.c_str(), pChild);
+			}
+		}
+		return true;
+	}
+
+	return MakeDatum(m_rFactories.CreateElement(), BaseDatumType::Element, rValue)
+		&& ReadElement(rStream, tag, static_cast<IElementDatum&>(*rValue));
+}
+
+template<typename T>
+bool impl_ns::DTBinaryReader::ReadNumber(serial::IReadStream& rStream, size_t byteCount, IElementDatum& rElement)
+{
+	uint64_t bits;
+	if (!ReadFixed(rStream, byteCount, bits))
+	{
+		return false;
+	}
+
+	T value;
+	if constexpr (std::is_same_v<T, float>)
+	{
+		uint32_t floatBits = (uint32_t)bits;
+		std::memcpy(&value, &floatBits, sizeof(value));
+	}
+	else if constexpr (std::is_same_v<T, double>)
+	{
+		std::memcpy(&value, &bits, sizeof(value));
+	}
+	else
+	{
+		value = (T)(std::make_unsigned_t<T>)bits;
+	}
+	rElement.Set(value);
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::ReadElement(serial::IReadStream& rStream, BinaryTag tag, IElementDatum& rElement)
+{
+	switch (tag)
+	{
+	case BinaryTag::None:
+		rElement.Clear();
+		return true;
+	case BinaryTag::False:
+		rElement.Set(false);
+		return true;
+	case BinaryTag::True:
+		rElement.Set(true);
+		return true;
+	case BinaryTag::Int8:
+		return ReadNumber<int8_t>(rStream, 1, rElement);
+	case BinaryTag::UInt8:
+		return ReadNumber<uint8_t>(rStream, 1, rElement);
+	case BinaryTag::Int16:
+		return ReadNumber<int16_t>(rStream, 2, rElement);
+	case BinaryTag::UInt16:
+		return ReadNumber<uint16_t>(rStream, 2, rElement);
+	case BinaryTag::Int32:
+		return ReadNumber<int32_t>(rStream, 4, rElement);
+	case BinaryTag::UInt32:
+		return ReadNumber<uint32_t>(rStream, 4, rElement);
+	case BinaryTag::Int64:
+		return ReadNumber<int64_t>(rStream, 8, rElement);
+	case BinaryTag::UInt64:
+		return ReadNumber<uint64_t>(rStream, 8, rElement);
+	case BinaryTag::Float:
+		return ReadNumber<float>(rStream, 4, rElement);
+	case BinaryTag::Double:
+		return ReadNumber<double>(rStream, 8, rElement);
+	case BinaryTag::String:
+		if (!ReadString(rStream))
+		{
+			return false;
+		}
+		rElement.Set(m_string.c_str());
+		return true;
+	default:
+		break;
+	}
+	return SetError("Unknown tag");
+}
+
+bool impl_ns::DTBinaryReader::ReadContainerHeader(serial::IReadStream& rStream, uint32_t& rLength, uint32_t& rCount)
+{
+	uint64_t length;
+	uint64_t count;
+	if (!ReadFixed(rStream, CONTAINER_FIELD_SIZE, length) || !ReadFixed(rStream, CONTAINER_FIELD_SIZE, count))
+	{
+		return false;
+	}
+	// Every entry takes at least a byte
+	if (length < CONTAINER_FIELD_SIZE || count > length - CONTAINER_FIELD_SIZE)
+	{
+		return SetError("Bad container header");
+	}
+	rLength = (uint32_t)length;
+	rCount = (uint32_t)count;
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::SkipAfterTag(serial::IReadStream& rStream, BinaryTag tag)
+{
+	switch (tag)
+	{
+	case BinaryTag::None:
+	case BinaryTag::False:
+	case BinaryTag::True:
+		return true;
+	case BinaryTag::Int8:
+	case BinaryTag::UInt8:
+		return Discard(rStream, 1);
+	case BinaryTag::Int16:
+	case BinaryTag::UInt16:
+		return Discard(rStream, 2);
+	case BinaryTag::Int32:
+	case BinaryTag::UInt32:
+	case BinaryTag::Float:
+		return Discard(rStream, 4);
+	case BinaryTag::Int64:
+	case BinaryTag::UInt64:
+	case BinaryTag::Double:
+		return Discard(rStream, 8);
+	case BinaryTag::String:
+	{
+		uint64_t length;
+		return ReadVarint(rStream, length) && Discard(rStream, length);
+	}
+	case BinaryTag::List:
+	case BinaryTag::Dictionary:
+	{
+		// The whole subtree in one step
+		uint64_t length;
+		return ReadFixed(rStream, CONTAINER_FIELD_SIZE, length) && Discard(rStream, length);
+	}
+	default:
+		break;
+	}
+	return SetError("Unknown tag");
+}
+
+bool impl_ns::DTBinaryReader::ReadTag(serial::IReadStream& rStream, BinaryTag& rTag)
+{
+	uint8_t tag;
+	if (rStream.Read(&tag, 1) != 1)
+	{
+		return SetError("Unexpected end of data");
+	}
+	rTag = (BinaryTag)tag;
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::ReadFixed(serial::IReadStream& rStream, size_t byteCount, uint64_t& rValue)
+{
+	uint8_t bytes[sizeof(uint64_t)];
+	if (rStream.Read(bytes, byteCount) != byteCount)
+	{
+		return SetError("Unexpected end of data");
+	}
+
+	rValue = 0;
+	for (size_t i = 0; i < byteCount; ++i)
+	{
+		rValue |= (uint64_t)bytes[i] << (8 * i);
+	}
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::ReadVarint(serial::IReadStream& rStream, uint64_t& rValue)
+{
+	rValue = 0;
+	for (unsigned int i = 0; i < MAX_VARINT_BYTES; ++i)
+	{
+		uint8_t byte;
+		if (rStream.Read(&byte, 1) != 1)
+		{
+			return SetError("Unexpected end of data");
+		}
+		rValue |= (uint64_t)(byte & 0x7f) << (7 * i);
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return SetError("Bad length");
+}
+
+bool impl_ns::DTBinaryReader::ReadString(serial::IReadStream& rStream)
+{
+	uint64_t length;
+	if (!ReadVarint(rStream, length))
+	{
+		return false;
+	}
+	// Nothing written here comes near this; it guards against resizing to garbage
+	if (length > std::numeric_limits<uint32_t>::max() || !rStream.CanRead((size_t)length))
+	{
+		return SetError("Unexpected end of data");
+	}
+
+	m_string.resize((size_t)length);
+	if (rStream.Read(&m_string[0], (size_t)length) != length)
+	{
+		return SetError("Unexpected end of data");
+	}
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::Discard(serial::IReadStream& rStream, uint64_t byteCount)
+{
+	uint8_t discarded[DISCARD_BUFFER_SIZE];
+	while (byteCount > 0)
+	{
+		size_t chunk = byteCount < sizeof(discarded) ? (size_t)byteCount : sizeof(discarded);
+		if (rStream.Read(discarded, chunk) != chunk)
+		{
+			return SetError("Unexpected end of data");
+		}
+		byteCount -= chunk;
+	}
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::MakeDatum(IDatum* pDatum, BaseDatumType datumType, std::shared_ptr<IDatum>& rDatum)
+{
+	rDatum = pDatum ? m_rFactories.Adopt(pDatum) : std::shared_ptr<IDatum>();
+	if (!rDatum || rDatum->GetDatumType() != datumType)
+	{
+		rDatum.reset();
+		return SetError("The factories could not make a datum");
+	}
+	return true;
+}
+
+bool impl_ns::DTBinaryReader::SetError(const char* pMessage)
+{
+	m_error = pMessage;
+	return false;
+}
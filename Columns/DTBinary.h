@@ -0,0 +1,125 @@
+#pragma once
+
+#include "IDataTree.h"
+#include "Bytestream.h"
+#include <string>
+#include <vector>
+
+namespace geng::data
+{
+	// A tagged binary encoding of data trees.  Every value starts with a tag byte:
+	//   elements keep their exact type; numbers follow in little endian at their own width,
+	//     booleans and none are the tag alone
+	//   strings (and object representations) are a varint length and the bytes
+	//   lists and dictionaries are a uint32 byte length, a uint32 count and then the entries,
+	//     keys being varint-length strings.  The byte length counts everything after itself,
+	//     so a reader can step over a whole subtree without looking inside it
+	enum class BinaryTag : uint8_t
+	{
+		None,
+		False,
+		True,
+		Int8,
+		UInt8,
+		Int16,
+		UInt16,
+		Int32,
+		UInt32,
+		Int64,
+		UInt64,
+		Float,
+		Double,
+		String,
+		List,
+		Dictionary
+	};
+
+	// Writes a tree walked by SerializeDataTree.  Container lengths are only known at their end, so
+	// each value at the top is built in a buffer and goes to the stream once it is complete.
+	// The buffer is kept, so a writer that is reused stops allocating
+	class DTBinaryWriter : public ITreeSerializer
+	{
+	public:
+		DTBinaryWriter(serial::IWriteStream& rStream);
+
+		IterInstruction OnList(const IListDatum& rList,
+			bool hasElements) override;
+		IterInstruction OnDict(const IDictDatum& rDict,
+			bool hasElements) override;
+		IterInstruction OnDictKey(const char* pKey) override;
+		void EndCompound() override;
+
+		IterInstruction OnElement(const IElementDatum& rElement) override;
+		IterInstruction OnObject(const IObjectDatum& rObject) override;
+
+		bool HasFailed() const { return m_failed; }
+
+	private:
+		struct OpenContainer_
+		{
+			size_t lengthPosition;
+			uint32_t count;
+		};
+
+		IterInstruction OnCompound(BinaryTag tag, bool hasElements);
+		void BeginValue();
+		// Sends a finished value at the top to the stream
+		IterInstruction EndValue();
+		void PutElement(const IElementDatum& rElement);
+		template<typename T>
+		void PutNumber(BinaryTag tag, const IElementDatum& rElement);
+
+		void PutTag(BinaryTag tag) { m_buffer.push_back((uint8_t)tag); }
+		void PutFixed(uint64_t value, size_t byteCount);
+		void PutVarint(uint64_t value);
+		void PutString(const char* pString, size_t length);
+		void PatchUInt32(size_t position, uint32_t value);
+
+		serial::IWriteStream& m_rStream;
+		std::vector<uint8_t> m_buffer;
+		std::vector<OpenContainer_> m_openContainers;
+		// A dictionary's key has been written, and its value counts with it
+		bool m_afterKey{ false };
+		bool m_failed{ false };
+	};
+
+	// Reads trees written by DTBinaryWriter, making the data with a set of factories
+	class DTBinaryReader
+	{
+	public:
+		static constexpr unsigned int MAX_DEPTH = 256;
+
+		DTBinaryReader(IDatumFactories& rFactories);
+
+		// Reads the next value from the stream
+		bool Read(serial::IReadStream& rStream, std::shared_ptr<IDatum>& rValue);
+		// Steps over the next value, reading as little of it as it can
+		bool Skip(serial::IReadStream& rStream);
+		// Reads the next value, which must be a dictionary, keeping only the entry with the key.
+		// The other entries are skipped.  False (with no error) if there is no such entry
+		bool ReadDictEntry(serial::IReadStream& rStream, const char* pKey, std::shared_ptr<IDatum>& rValue);
+
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		bool ReadValue(serial::IReadStream& rStream, unsigned int depth, std::shared_ptr<IDatum>& rValue);
+		bool ReadElement(serial::IReadStream& rStream, BinaryTag tag, IElementDatum& rElement);
+		template<typename T>
+		bool ReadNumber(serial::IReadStream& rStream, size_t byteCount, IElementDatum& rElement);
+		bool ReadContainerHeader(serial::IReadStream& rStream, uint32_t& rLength, uint32_t& rCount);
+		bool SkipAfterTag(serial::IReadStream& rStream, BinaryTag tag);
+
+		bool ReadTag(serial::IReadStream& rStream, BinaryTag& rTag);
+		bool ReadFixed(serial::IReadStream& rStream, size_t byteCount, uint64_t& rValue);
+		bool ReadVarint(serial::IReadStream& rStream, uint64_t& rValue);
+		// Into m_string
+		bool ReadString(serial::IReadStream& rStream);
+		bool Discard(serial::IReadStream& rStream, uint64_t byteCount);
+		bool MakeDatum(IDatum* pDatum, BaseDatumType datumType, std::shared_ptr<IDatum>& rDatum);
+		bool SetError(const char* pMessage);
+
+		IDatumFactories& m_rFactories;
+		std::string m_string;
+		std::string m_error;
+	};
+}
@@ -0,0 +1,237 @@
+#include "DTCompactElement.h"
+
+#include <cstring>
+
+namespace impl_ns = geng::data::compact;
+
+static_assert(sizeof(impl_ns::Element) <= sizeof(void*) + impl_ns::Element::PAYLOAD_SIZE,
+	"compact::Element: the value and its tag must fit in the payload");
+
+impl_ns::Element::~Element()
+{
+	FreeText();
+}
+
+void impl_ns::Element::FreeText()
+{
+	if (m_kind == Kind_::LongString)
+	{
+		char* pText;
+		std::memcpy(&pText, m_payload, sizeof(pText));
+		delete[] pText;
+		m_kind = Kind_::None;
+	}
+}
+
+geng::data::BaseDatumType impl_ns::Element::GetDatumType() const
+{
+	return BaseDatumType::Element;
+}
+
+bool impl_ns::Element::IsImmutable() const
+{
+	return false;
+}
+
+template<typename T>
+bool impl_ns::Element::GetNumber(Kind_ kind, T& rDatum) const
+{
+	if (m_kind != kind)
+	{
+		return false;
+	}
+
+	std::memcpy(&rDatum, m_payload, sizeof(T));
+	return true;
+}
+
+template<typename T>
+void impl_ns::Element::SetNumber(Kind_ kind, T datum)
+{
+	FreeText();
+	std::memcpy(m_payload, &datum, sizeof(T));
+	m_kind = kind;
+}
+
+geng::data::ElementType impl_ns::Element::GetElementType() const
+{
+	switch (m_kind)
+	{
+	case Kind_::None: return ElementType::None;
+	case Kind_::Boolean: return ElementType::Boolean;
+	case Kind_::Int8: return ElementType::Int8;
+	case Kind_::UInt8: return ElementType::UInt8;
+	case Kind_::Int16: return ElementType::Int16;
+	case Kind_::UInt16: return ElementType::UInt16;
+	case Kind_::Int32: return ElementType::Int32;
+	case Kind_::UInt32: return ElementType::UInt32;
+	case Kind_::Int64: return ElementType::Int64;
+	case Kind_::UInt64: return ElementType::UInt64;
+	case Kind_::Float: return ElementType::Float;
+	case Kind_::Double: return ElementType::Double;
+	case Kind_::ShortString:
+	case Kind_::LongString:
+		return ElementType::String;
+	}
+
+	return ElementType::None;
+}
+
+bool impl_ns::Element::Get(bool& rDatum) const
+{
+	return GetNumber(Kind_::Boolean, rDatum);
+}
+void impl_ns::Element::Set(bool datum)
+{
+	SetNumber(Kind_::Boolean, datum);
+}
+
+bool impl_ns::Element::Get(int8_t& rDatum) const
+{
+	return GetNumber(Kind_::Int8, rDatum);
+}
+void impl_ns::Element::Set(int8_t datum)
+{
+	SetNumber(Kind_::Int8, datum);
+}
+
+bool impl_ns::Element::Get(uint8_t& rDatum) const
+{
+	return GetNumber(Kind_::UInt8, rDatum);
+}
+void impl_ns::Element::Set(uint8_t datum)
+{
+	SetNumber(Kind_::UInt8, datum);
+}
+
+bool impl_ns::Element::Get(int16_t& rDatum) const
+{
+	return GetNumber(Kind_::Int16, rDatum);
+}
+void impl_ns::Element::Set(int16_t datum)
+{
+	SetNumber(Kind_::Int16, datum);
+}
+
+bool impl_ns::Element::Get(uint16_t& rDatum) const
+{
+	return GetNumber(Kind_::UInt16, rDatum);
+}
+void impl_ns::Element::Set(uint16_t datum)
+{
+	SetNumber(Kind_::UInt16, datum);
+}
+
+bool impl_ns::Element::Get(int32_t& rDatum) const
+{
+	return GetNumber(Kind_::Int32, rDatum);
+}
+void impl_ns::Element::Set(int32_t datum)
+{
+	SetNumber(Kind_::Int32, datum);
+}
+
+bool impl_ns::Element::Get(uint32_t& rDatum) const
+{
+	return GetNumber(Kind_::UInt32, rDatum);
+}
+void impl_ns::Element::Set(uint32_t datum)
+{
+	SetNumber(Kind_::UInt32, datum);
+}
+
+bool impl_ns::Element::Get(int64_t& rDatum) const
+{
+	return GetNumber(Kind_::Int64, rDatum);
+}
+void impl_ns::Element::Set(int64_t datum)
+{
+	SetNumber(Kind_::Int64, datum);
+}
+
+bool impl_ns::Element::Get(uint64_t& rDatum) const
+{
+	return GetNumber(Kind_::UInt64, rDatum);
+}
+void impl_ns::Element::Set(uint64_t datum)
+{
+	SetNumber(Kind_::UInt64, datum);
+}
+
+bool impl_ns::Element::Get(float& rDatum) const
+{
+	return GetNumber(Kind_::Float, rDatum);
+}
+void impl_ns::Element::Set(float datum)
+{
+	SetNumber(Kind_::Float, datum);
+}
+
+bool impl_ns::Element::Get(double& rDatum) const
+{
+	return GetNumber(Kind_::Double, rDatum);
+}
+void impl_ns::Element::Set(double datum)
+{
+	SetNumber(Kind_::Double, datum);
+}
+
+bool impl_ns::Element::Get(std::string& rDatum) const
+{
+	std::string_view text;
+	if (!Get(text))
+	{
+		return false;
+	}
+
+	rDatum.assign(text.data(), text.size());
+	return true;
+}
+bool impl_ns::Element::Get(std::string_view& rDatum) const
+{
+	if (m_kind == Kind_::ShortString)
+	{
+		rDatum = std::string_view(reinterpret_cast<const char*>(m_payload));
+		return true;
+	}
+
+	if (m_kind == Kind_::LongString)
+	{
+		const char* pText;
+		uint32_t length;
+		std::memcpy(&pText, m_payload, sizeof(pText));
+		std::memcpy(&length, m_payload + sizeof(pText), sizeof(length));
+		rDatum = std::string_view(pText, length);
+		return true;
+	}
+
+	return false;
+}
+void impl_ns::Element::Set(const char* datum)
+{
+	// The text may be the element's own, so it is copied before the old one goes
+	size_t length = std::strlen(datum);
+	if (length <= INLINE_CAPACITY)
+	{
+		char inlineText[INLINE_CAPACITY + 1];
+		std::memcpy(inlineText, datum, length + 1);
+		FreeText();
+		std::memcpy(m_payload, inlineText, length + 1);
+		m_kind = Kind_::ShortString;
+		return;
+	}
+
+	char* pText = new char[length + 1];
+	std::memcpy(pText, datum, length + 1);
+	FreeText();
+	uint32_t storedLength = (uint32_t)length;
+	std::memcpy(m_payload, &pText, sizeof(pText));
+	std::memcpy(m_payload + sizeof(pText), &storedLength, sizeof(storedLength));
+	m_kind = Kind_::LongString;
+}
+
+void impl_ns::Element::Clear()
+{
+	FreeText();
+	m_kind = Kind_::None;
+}
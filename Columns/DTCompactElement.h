@@ -0,0 +1,101 @@
+#pragma once
+#include "IDataTree.h"
+
+namespace geng::data::compact
+{
+
+	// An element in 16 bytes past its vtable: the value and a tag.  Strings of up to
+	// INLINE_CAPACITY characters are kept inside; longer ones get a copy of their own on the heap,
+	// as std::string would, which goes when the element changes or dies.
+	// Gets and sets behave as simple::Element's do
+	class Element : public IElementDatum
+	{
+	public:
+		static constexpr size_t PAYLOAD_SIZE = 16;
+		static constexpr size_t INLINE_CAPACITY = PAYLOAD_SIZE - 2;
+
+		Element() = default;
+		~Element();
+
+		Element(const Element&) = delete;
+		Element& operator=(const Element&) = delete;
+
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+		ElementType GetElementType() const override;
+
+		bool Get(bool& rDatum) const override;
+		void Set(bool datum) override;
+
+		bool Get(int8_t& rDatum) const override;
+		void Set(int8_t datum) override;
+
+		bool Get(uint8_t& rDatum) const override;
+		void Set(uint8_t datum) override;
+
+		bool Get(int16_t& rDatum) const override;
+		void Set(int16_t datum) override;
+
+		bool Get(uint16_t& rDatum) const override;
+		void Set(uint16_t datum) override;
+
+		bool Get(int32_t& rDatum) const override;
+		void Set(int32_t datum) override;
+
+		bool Get(uint32_t& rDatum) const override;
+		void Set(uint32_t datum) override;
+
+		bool Get(int64_t& rDatum) const override;
+		void Set(int64_t datum) override;
+
+		bool Get(uint64_t& rDatum) const override;
+		void Set(uint64_t datum) override;
+
+		bool Get(float& rDatum) const override;
+		void Set(float datum) override;
+
+		bool Get(double& rDatum) const override;
+		void Set(double datum) override;
+
+		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
+		void Set(const char* datum) override;
+
+		void Clear() override;
+
+	private:
+		enum class Kind_ : uint8_t
+		{
+			None,
+			Boolean,
+			Int8,
+			UInt8,
+			Int16,
+			UInt16,
+			Int32,
+			UInt32,
+			Int64,
+			UInt64,
+			Float,
+			Double,
+			// The text in the payload, null terminated
+			ShortString,
+			// The address of the element's own copy of the text, null terminated, then its
+			// length as a uint32_t
+			LongString
+		};
+
+		template<typename T>
+		bool GetNumber(Kind_ kind, T& rDatum) const;
+
+		template<typename T>
+		void SetNumber(Kind_ kind, T datum);
+
+		// Frees a long string, if the element holds one
+		void FreeText();
+
+		alignas(8) uint8_t m_payload[PAYLOAD_SIZE - 1]{};
+		Kind_ m_kind{ Kind_::None };
+	};
+
+}
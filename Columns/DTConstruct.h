@@ -6,6 +6,8 @@
 namespace geng::data
 {
 
+	// A suite names the element, dictionary and list types, and makes them with Suite::Create<T>()
+
 	template<typename Suite, typename B>
 	std::shared_ptr<IElementDatum> DTElem(B&& val)
 	{
@@ -13,7 +15,7 @@ namespace geng::data
 
 		static_assert(std::is_base_of_v<IElementDatum, T>, "DTElem: specify an implementation of IElementDatum");
 
-		std::shared_ptr<IElementDatum> pDatum = std::make_shared<T>();
+		std::shared_ptr<IElementDatum> pDatum = Suite::template Create<T>();
 		pDatum->Set(std::forward<B>(val));
 
 		return pDatum;
@@ -24,7 +26,7 @@ namespace geng::data
 		std::string key;
 		std::shared_ptr<IDatum> val;
 
-		DictPair(const std::string& key_,
+		DictPair(std::string_view key_,
 				 const std::shared_ptr<IDatum>& val_)
 			:key(key_),
 			val(val_)
@@ -37,7 +39,7 @@ namespace geng::data
 		using T = typename Suite::Dict;
 
 		static_assert(std::is_base_of_v<IDictDatum, T>, "DTDict: specify an implementation of IDictDatum");
-		std::shared_ptr<IDictDatum> pDatum = std::make_shared<T>();
+		std::shared_ptr<IDictDatum> pDatum = Suite::template Create<T>();
 
 		for (const DictPair& dictPair : dictPairs)
 		{
@@ -53,7 +55,7 @@ namespace geng::data
 		using T = typename Suite::List;
 
 		static_assert(std::is_base_of_v<IListDatum, T>, "DTList: specify an implementation of IListDatum");
-		std::shared_ptr<IListDatum> pDatum = std::make_shared<T>();
+		std::shared_ptr<IListDatum> pDatum = Suite::template Create<T>();
 
 		for (const std::shared_ptr<IDatum>& listEntry : listEntries)
 		{
@@ -63,5 +65,45 @@ namespace geng::data
 		return pDatum;
 	}
 
+	// The factories interface for a suite.  Each datum is made with Suite::Create<T>(), and the
+	// handle is kept until Adopt() claims it, so suites with their own allocation work too
+	template<typename Suite>
+	class SuiteFactories : public IDatumFactories
+	{
+	public:
+		IDatum* CreateElement() override
+		{
+			return Keep(Suite::template Create<typename Suite::Element>());
+		}
+
+		IDatum* CreateDictionary() override
+		{
+			return Keep(Suite::template Create<typename Suite::Dict>());
+		}
+
+		IDatum* CreateList() override
+		{
+			return Keep(Suite::template Create<typename Suite::List>());
+		}
+
+		// Only the last datum made can be adopted
+		std::shared_ptr<IDatum> Adopt(IDatum* pDatum) override
+		{
+			if (pDatum != m_pLast.get())
+			{
+				return std::shared_ptr<IDatum>();
+			}
+			return std::move(m_pLast);
+		}
+
+	private:
+		IDatum* Keep(std::shared_ptr<IDatum> pDatum)
+		{
+			m_pLast = std::move(pDatum);
+			return m_pLast.get();
+		}
+
+		std::shared_ptr<IDatum> m_pLast;
+	};
 
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#include "DTFrozen.h"
+
+namespace impl_ns = geng::data::frozen;
+
+std::shared_ptr<geng::data::IDatum> impl_ns::Freeze(const std::shared_ptr<IDatum>& pRoot)
+{
+	switch (pRoot->GetDatumType())
+	{
+	case BaseDatumType::Dictionary:
+	{
+		if (dynamic_cast<const Dictionary*>(pRoot.get()))
+		{
+			return pRoot;
+		}
+
+		struct Collector : public IDictCallback
+		{
+			bool OnEntry(const char* pKey, const std::shared_ptr<IDatum>& pChild) override
+			{
+				// The key is interned before the dictionary's text can go
+				entries.push_back(Dictionary::Entry{ KeyTable::Intern(pKey), Freeze(pChild) });
+				return true;
+			}
+
+			std::vector<Dictionary::Entry> entries;
+		};
+
+		Collector collector;
+		static_cast<const IDictDatum&>(*pRoot).Iterate(collector);
+		return std::make_shared<Dictionary>(std::move(collector.entries));
+	}
+	case BaseDatumType::List:
+	{
+		if (dynamic_cast<const List*>(pRoot.get()))
+		{
+			return pRoot;
+		}
+
+		std::vector<std::shared_ptr<IDatum> > entries;
+		static_cast<const IListDatum&>(*pRoot).GetRange(entries);
+		for (auto& rpEntry : entries)
+		{
+			rpEntry = Freeze(rpEntry);
+		}
+		return std::make_shared<List>(std::move(entries));
+	}
+	default:
+		return pRoot;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+// A summary header including the headers required for freezing data trees
+
+#include "DTFrozenDict.h"
+#include "DTFrozenList.h"
+#include "DTKeyTable.h"
+
+namespace geng::data::frozen
+{
+	// A copy of a tree whose dictionaries and lists are frozen.  Elements and objects are shared
+	// with the tree, and parts that are frozen already are shared as they are
+	std::shared_ptr<IDatum> Freeze(const std::shared_ptr<IDatum>& pRoot);
+}
@@ -0,0 +1,141 @@
+#include "DTFrozenDict.h"
+#include "DTKeyTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace impl_ns = geng::data::frozen;
+
+namespace
+{
+	bool KeysMatch(const geng::data::DictKey& entryKey, const geng::data::DictKey& key)
+	{
+		// Interned keys are equal when their texts are the same text
+		return entryKey.GetText() == key.GetText()
+			|| (entryKey.GetLength() == key.GetLength()
+				&& std::memcmp(entryKey.GetText(), key.GetText(), key.GetLength()) == 0);
+	}
+}
+
+impl_ns::Dictionary::Dictionary(std::vector<Entry>&& entries)
+	:m_entries(std::move(entries))
+{
+	for (Entry& rEntry : m_entries)
+	{
+		rEntry.key = KeyTable::Intern(rEntry.key);
+	}
+
+	// Equal keys are now the same text, so they end up together, in the order they came
+	std::stable_sort(m_entries.begin(), m_entries.end(), [](const Entry& rLeft, const Entry& rRight)
+	{
+		if (rLeft.key.GetHash() != rRight.key.GetHash())
+		{
+			return rLeft.key.GetHash() < rRight.key.GetHash();
+		}
+		return std::less<const char*>()(rLeft.key.GetText(), rRight.key.GetText());
+	});
+
+	auto itOut = m_entries.begin();
+	for (auto itEntry = m_entries.begin(); itEntry != m_entries.end(); ++itEntry)
+	{
+		if (itOut != m_entries.begin() && (itOut - 1)->key.GetText() == itEntry->key.GetText())
+		{
+			(itOut - 1)->child = std::move(itEntry->child);
+		}
+		else
+		{
+			if (itOut != itEntry)
+			{
+				*itOut = std::move(*itEntry);
+			}
+			++itOut;
+		}
+	}
+	m_entries.erase(itOut, m_entries.end());
+	m_entries.shrink_to_fit();
+}
+
+bool impl_ns::Dictionary::IsEmpty() const
+{
+	return m_entries.empty();
+}
+
+geng::data::BaseDatumType impl_ns::Dictionary::GetDatumType() const
+{
+	return BaseDatumType::Dictionary;
+}
+
+bool impl_ns::Dictionary::IsImmutable() const
+{
+	return true;
+}
+
+const impl_ns::Dictionary::Entry* impl_ns::Dictionary::FindEntry(const DictKey& key) const
+{
+	uint32_t hash = key.GetHash();
+	auto itEntry = m_entries.begin();
+	if (m_entries.size() > MAX_SCANNED_ENTRIES)
+	{
+		itEntry = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+			[](const Entry& rEntry, uint32_t hash)
+		{
+			return rEntry.key.GetHash() < hash;
+		});
+	}
+
+	for (; itEntry != m_entries.end() && itEntry->key.GetHash() <= hash; ++itEntry)
+	{
+		if (itEntry->key.GetHash() == hash && KeysMatch(itEntry->key, key))
+		{
+			return &*itEntry;
+		}
+	}
+
+	return nullptr;
+}
+
+const geng::data::IDatum* impl_ns::Dictionary::FindChild(const DictKey& key) const
+{
+	const Entry* pEntry = FindEntry(key);
+	return pEntry ? pEntry->child.get() : nullptr;
+}
+
+bool impl_ns::Dictionary::HasEntry(const char* pKey) const
+{
+	return FindEntry(pKey) != nullptr;
+}
+
+bool impl_ns::Dictionary::GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const
+{
+	return GetEntryByKey(pKey, rChild);
+}
+
+bool impl_ns::Dictionary::GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+{
+	const Entry* pEntry = FindEntry(key);
+	if (pEntry)
+	{
+		rChild = pEntry->child;
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::Dictionary::Iterate(geng::data::IDictCallback& rCallback) const
+{
+	for (const Entry& rEntry : m_entries)
+	{
+		if (!rCallback.OnEntry(rEntry.key.GetText(), rEntry.child))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::Dictionary::SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild)
+{
+	throw DataStateException();
+}
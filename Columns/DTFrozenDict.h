@@ -0,0 +1,47 @@
+#pragma once
+#include "IDataTree.h"
+#include <vector>
+
+namespace geng::data::frozen
+{
+
+	// A dictionary made all at once, that never changes after.  Its keys are interned (see
+	// KeyTable) and its entries sorted by hash, so a lookup costs no copy of the key; small
+	// dictionaries are scanned, bigger ones searched.  The order of Iterate() is the hash order
+	class Dictionary : public IDictDatum
+	{
+	public:
+		struct Entry
+		{
+			DictKey key;
+			std::shared_ptr<IDatum> child;
+		};
+
+		// A key given twice keeps its last child
+		Dictionary(std::vector<Entry>&& entries);
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		bool HasEntry(const char* pKey) const override;
+		bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const override;
+		bool Iterate(IDictCallback& rCallback) const override;
+
+		// Throws DataStateException
+		bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) override;
+
+		size_t GetSize() const { return m_entries.size(); }
+		// The child without taking a reference to it; null if there is none
+		const IDatum* FindChild(const DictKey& key) const;
+
+	private:
+		static constexpr size_t MAX_SCANNED_ENTRIES = 8;
+
+		const Entry* FindEntry(const DictKey& key) const;
+
+		std::vector<Entry> m_entries;
+	};
+
+}
@@ -0,0 +1,82 @@
+#include "DTFrozenList.h"
+namespace impl_ns = geng::data::frozen;
+
+impl_ns::List::List(std::vector<std::shared_ptr<IDatum> >&& entries)
+	:m_list(std::move(entries))
+{
+	m_list.shrink_to_fit();
+}
+
+bool impl_ns::List::IsEmpty() const
+{
+	return m_list.empty();
+}
+
+geng::data::BaseDatumType impl_ns::List::GetDatumType() const
+{
+	return BaseDatumType::List;
+}
+
+bool impl_ns::List::IsImmutable() const
+{
+	return true;
+}
+
+size_t impl_ns::List::GetLength() const
+{
+	return m_list.size();
+}
+
+bool impl_ns::List::GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const
+{
+	if (idx < m_list.size())
+	{
+		rChild = m_list[idx];
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::List::GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+	size_t startIdx,
+	size_t endIdx) const
+{
+	if (endIdx == LIST_NPOS)
+	{
+		endIdx = m_list.size();
+	}
+
+	if (startIdx >= m_list.size() || endIdx > m_list.size() || startIdx >= endIdx)
+	{
+		return false;
+	}
+
+	rSequence.insert(rSequence.end(), m_list.begin() + startIdx, m_list.begin() + endIdx);
+	return true;
+}
+
+bool impl_ns::List::ForEachChild(geng::data::IChildCallback& rCallback) const
+{
+	for (const std::shared_ptr<IDatum>& pChild : m_list)
+	{
+		if (!rCallback.OnChild(nullptr, *pChild))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::List::InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexBefore)
+{
+	throw DataStateException();
+}
+
+bool impl_ns::List::SetEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexAt)
+{
+	throw DataStateException();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "IDataTree.h"
+#include <vector>
+
+namespace geng::data::frozen
+{
+
+	// A list made all at once, that never changes after
+	class List : public IListDatum
+	{
+	public:
+		List(std::vector<std::shared_ptr<IDatum> >&& entries);
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		size_t GetLength() const override;
+		bool GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+			size_t startIdx,
+			size_t endIdx) const override;
+		bool ForEachChild(IChildCallback& rCallback) const override;
+
+		// Both throw DataStateException
+		bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexBefore) override;
+		bool SetEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexAt) override;
+
+	private:
+		std::vector<std::shared_ptr<IDatum> > m_list;
+	};
+
+}
@@ -0,0 +1,765 @@
+#include "DTJsonParser.h"
+#include "MappedFile.h"
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DT_JSON_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace impl_ns = geng::data;
+
+namespace
+{
+	enum CharClass : uint8_t
+	{
+		CHAR_OTHER,
+		CHAR_BLANK,
+		CHAR_DIGIT,
+		// Structural characters, quotes and backslashes
+		CHAR_MARK
+	};
+
+	constexpr std::array<uint8_t, 256> MakeCharClasses()
+	{
+		std::array<uint8_t, 256> classes{};
+		for (const char c : { ' ', '\t', '\n', '\r' })
+		{
+			classes[(unsigned char)c] = CHAR_BLANK;
+		}
+		for (char c = '0'; c <= '9'; ++c)
+		{
+			classes[(unsigned char)c] = CHAR_DIGIT;
+		}
+		for (const char c : { '{', '}', '[', ']', ':', ',', '"', '\\' })
+		{
+			classes[(unsigned char)c] = CHAR_MARK;
+		}
+		return classes;
+	}
+
+	constexpr std::array<uint8_t, 256> s_charClasses = MakeCharClasses();
+
+	// Every power of ten up to here is exact in a double
+	constexpr double s_exactPowersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	constexpr int MAX_EXACT_POWER_OF_10 = 22;
+	constexpr uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+	// A uint64_t holds any 19 digits
+	constexpr int MAX_MANTISSA_DIGITS = 19;
+
+	inline bool IsBlank(char c)
+	{
+		return s_charClasses[(unsigned char)c] == CHAR_BLANK;
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return s_charClasses[(unsigned char)c] == CHAR_DIGIT;
+	}
+
+	// Follows strings through the marks found by the first pass, keeping the positions that matter
+	struct MarkFilter_
+	{
+		std::vector<uint32_t>& rStructurals;
+		bool inString;
+		// An escaped character is skipped, even if it is in the next block
+		size_t skipTo;
+
+		void OnMark(size_t position, char c)
+		{
+			if (position < skipTo)
+			{
+				return;
+			}
+
+			if (inString)
+			{
+				if (c == '\\')
+				{
+					skipTo = position + 2;
+				}
+				else if (c == '"')
+				{
+					rStructurals.push_back((uint32_t)position);
+					inString = false;
+				}
+			}
+			else
+			{
+				// A backslash outside a string is kept, to be rejected later
+				rStructurals.push_back((uint32_t)position);
+				inString = c == '"';
+			}
+		}
+	};
+
+#ifdef DT_JSON_SSE2
+	inline unsigned int LowestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (unsigned int)index;
+#else
+		return (unsigned int)__builtin_ctz(mask);
+#endif
+	}
+#endif
+
+	int HexValue(char c)
+	{
+		if (c >= '0' && c <= '9') return c - '0';
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		return -1;
+	}
+
+	bool ReadHex4(const char* pHex, uint32_t& rValue)
+	{
+		rValue = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			int digit = HexValue(pHex[i]);
+			if (digit < 0)
+			{
+				return false;
+			}
+			rValue = (rValue << 4) | (uint32_t)digit;
+		}
+		return true;
+	}
+
+	char* WriteUtf8(uint32_t codePoint, char* pOut)
+	{
+		if (codePoint < 0x80)
+		{
+			*pOut++ = (char)codePoint;
+		}
+		else if (codePoint < 0x800)
+		{
+			*pOut++ = (char)(0xc0 | (codePoint >> 6));
+			*pOut++ = (char)(0x80 | (codePoint & 0x3f));
+		}
+		else if (codePoint < 0x10000)
+		{
+			*pOut++ = (char)(0xe0 | (codePoint >> 12));
+			*pOut++ = (char)(0x80 | ((codePoint >> 6) & 0x3f));
+			*pOut++ = (char)(0x80 | (codePoint & 0x3f));
+		}
+		else
+		{
+			*pOut++ = (char)(0xf0 | (codePoint >> 18));
+			*pOut++ = (char)(0x80 | ((codePoint >> 12) & 0x3f));
+			*pOut++ = (char)(0x80 | ((codePoint >> 6) & 0x3f));
+			*pOut++ = (char)(0x80 | (codePoint & 0x3f));
+		}
+		return pOut;
+	}
+}
+
+impl_ns::DTJsonParser::DTJsonParser(IDatumFactories& rFactories)
+	:m_rFactories(rFactories)
+{
+
+}
+
+bool impl_ns::DTJsonParser::Parse(const char* pText, size_t length, std::shared_ptr<IDatum>& rRoot)
+{
+	m_buffer.assign(pText, pText + length);
+	return ParseInSitu(m_buffer.data(), length, rRoot);
+}
+
+bool impl_ns::DTJsonParser::ParseFile(const char* pFileName, std::shared_ptr<IDatum>& rRoot)
+{
+	MappedFile file;
+	if (!file.Open(pFileName, true))
+	{
+		m_error = file.GetError();
+		return false;
+	}
+
+	// Every datum copies what it keeps, so the mapping can go once the tree is built
+	if (!ParseInSitu(file.GetData(), file.GetSize(), rRoot))
+	{
+		m_error = std::string(pFileName) + ": " + m_error;
+		return false;
+	}
+	return true;
+}
+
+bool impl_ns::DTJsonParser::ParseInSitu(char* pText, size_t length, std::shared_ptr<IDatum>& rRoot)
+{
+	rRoot.reset();
+	m_error.clear();
+	if (length >= std::numeric_limits<uint32_t>::max())
+	{
+		m_error = "The text is too long to parse";
+		return false;
+	}
+
+	m_pText = pText;
+	m_length = length;
+
+	std::shared_ptr<IDatum> pRoot;
+	size_t idx = 0;
+	size_t cursor = 0;
+	bool ok = IndexStructurals() && ParseValue(idx, cursor, 0, pRoot);
+	if (ok)
+	{
+		while (cursor < m_length && IsBlank(m_pText[cursor]))
+		{
+			++cursor;
+		}
+		if (cursor < m_length)
+		{
+			ok = SetError(cursor, "Unexpected text after the value");
+		}
+	}
+
+	m_pText = nullptr;
+	m_length = 0;
+	if (ok)
+	{
+		rRoot = std::move(pRoot);
+	}
+	return ok;
+}
+
+bool impl_ns::DTJsonParser::IndexStructurals()
+{
+	m_structurals.clear();
+	m_structurals.reserve(m_length / 8 + 16);
+
+	MarkFilter_ filter{ m_structurals, false, 0 };
+	size_t position = 0;
+
+#ifdef DT_JSON_SSE2
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i colon = _mm_set1_epi8(':');
+	const __m128i comma = _mm_set1_epi8(',');
+	// [ and ] differ from { and } by one bit, so they can be found together
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i openBrace = _mm_set1_epi8('{');
+	const __m128i closeBrace = _mm_set1_epi8('}');
+
+	for (; position + 16 <= m_length; position += 16)
+	{
+		__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_pText + position));
+		__m128i folded = _mm_or_si128(chunk, caseBit);
+		__m128i marks = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+		marks = _mm_or_si128(marks,
+			_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)));
+
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(marks);
+		while (mask)
+		{
+			size_t markPosition = position + LowestBit(mask);
+			filter.OnMark(markPosition, m_pText[markPosition]);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; position < m_length; ++position)
+	{
+		if (s_charClasses[(unsigned char)m_pText[position]] == CHAR_MARK)
+		{
+			filter.OnMark(position, m_pText[position]);
+		}
+	}
+
+	if (filter.inString)
+	{
+		return SetError(m_structurals.back(), "Unterminated string");
+	}
+
+	// The end of the text ends the last value
+	m_structurals.push_back((uint32_t)m_length);
+	return true;
+}
+
+bool impl_ns::DTJsonParser::ParseValue(size_t& rIdx, size_t& rCursor, unsigned int depth,
+	std::shared_ptr<IDatum>& rValue)
+{
+	size_t next = m_structurals[rIdx];
+	size_t begin = rCursor;
+	while (begin < next && IsBlank(m_pText[begin]))
+	{
+		++begin;
+	}
+
+	if (begin < next)
+	{
+		// Numbers and literals run up to the next structural character
+		size_t end = next;
+		while (IsBlank(m_pText[end - 1]))
+		{
+			--end;
+		}
+
+		if (!MakeDatum(m_rFactories.CreateElement(), BaseDatumType::Element, rValue, begin)
+			|| !ParseScalar(begin, end, static_cast<IElementDatum&>(*rValue)))
+		{
+			return false;
+		}
+		rCursor = next;
+		return true;
+	}
+
+	char c = next < m_length ? m_pText[next] : '\0';
+	if (c == '{')
+	{
+		return ParseDict(rIdx, rCursor, depth, rValue);
+	}
+	else if (c == '[')
+	{
+		return ParseList(rIdx, rCursor, depth, rValue);
+	}
+	else if (c == '"')
+	{
+		const char* pString;
+		if (!MakeDatum(m_rFactories.CreateElement(), BaseDatumType::Element, rValue, next)
+			|| !ParseString(rIdx, rCursor, pString))
+		{
+			return false;
+		}
+		static_cast<IElementDatum&>(*rValue).Set(pString);
+		return true;
+	}
+
+	return SetError(next, "Expected a value");
+}
+
+bool impl_ns::DTJsonParser::ParseDict(size_t& rIdx, size_t& rCursor, unsigned int depth,
+	std::shared_ptr<IDatum>& rValue)
+{
+	size_t opener = m_structurals[rIdx];
+	if (depth >= MAX_DEPTH)
+	{
+		return SetError(opener, "Too deeply nested");
+	}
+	if (!MakeDatum(m_rFactories.CreateDictionary(), BaseDatumType::Dictionary, rValue, opener))
+	{
+		return false;
+	}
+	IDictDatum& rDict = static_cast<IDictDatum&>(*rValue);
+
+	++rIdx;
+	rCursor = opener + 1;
+	if (ExpectStructural(rIdx, rCursor, '}', nullptr))
+	{
+		rCursor = m_structurals[rIdx++] + 1;
+		return true;
+	}
+
+	std::shared_ptr<IDatum> pChild;
+	while (true)
+	{
+		const char* pKey;
+		if (!ExpectStructural(rIdx, rCursor, '"', "Expected a key")
+			|| !ParseString(rIdx, rCursor, pKey)
+			|| !ExpectStructural(rIdx, rCursor, ':', "Expected ':'"))
+		{
+			return false;
+		}
+		rCursor = m_structurals[rIdx++] + 1;
+
+		if (!ParseValue(rIdx, rCursor, depth + 1, pChild))
+		{
+			return false;
+		}
+		rDict.SetEntry(pKey, pChild);
+
+		if (ExpectStructural(rIdx, rCursor, '}', nullptr))
+		{
+			rCursor = m_structurals[rIdx++] + 1;
+			return true;
+		}
+		if (!ExpectStructural(rIdx, rCursor, ',', "Expected ',' or '}'"))
+		{
+			return false;
+		}
+		rCursor = m_structurals[rIdx++] + 1;
+	}
+}
+
+bool impl_ns::DTJsonParser::ParseList(size_t& rIdx, size_t& rCursor, unsigned int depth,
+	std::shared_ptr<IDatum>& rValue)
+{
+	size_t opener = m_structurals[rIdx];
+	if (depth >= MAX_DEPTH)
+	{
+		return SetError(opener, "Too deeply nested");
+	}
+	if (!MakeDatum(m_rFactories.CreateList(), BaseDatumType::List, rValue, opener))
+	{
+		return false;
+	}
+	IListDatum& rList = static_cast<IListDatum&>(*rValue);
+
+	++rIdx;
+	rCursor = opener + 1;
+	if (ExpectStructural(rIdx, rCursor, ']', nullptr))
+	{
+		rCursor = m_structurals[rIdx++] + 1;
+		return true;
+	}
+
+	std::shared_ptr<IDatum> pChild;
+	while (true)
+	{
+		if (!ParseValue(rIdx, rCursor, depth + 1, pChild))
+		{
+			return false;
+		}
+		rList.InsertEntry(pChild);
+
+		if (ExpectStructural(rIdx, rCursor, ']', nullptr))
+		{
+			rCursor = m_structurals[rIdx++] + 1;
+			return true;
+		}
+		if (!ExpectStructural(rIdx, rCursor, ',', "Expected ',' or ']'"))
+		{
+			return false;
+		}
+		rCursor = m_structurals[rIdx++] + 1;
+	}
+}
+
+bool impl_ns::DTJsonParser::ParseString(size_t& rIdx, size_t& rCursor, const char*& rpString)
+{
+	// The first pass only ever leaves a quote paired with the next one
+	size_t opener = m_structurals[rIdx];
+	size_t closer = m_structurals[rIdx + 1];
+	rIdx += 2;
+	rCursor = closer + 1;
+
+	char* pBegin = m_pText + opener + 1;
+	char* pEnd = m_pText + closer;
+	char* pIn = pBegin;
+	while (pIn < pEnd && *pIn != '\\' && (unsigned char)*pIn >= 0x20)
+	{
+		++pIn;
+	}
+
+	// Escapes only ever shrink, so the string can be rewritten where it is
+	char* pOut = pIn;
+	while (pIn < pEnd)
+	{
+		char c = *pIn;
+		if ((unsigned char)c < 0x20)
+		{
+			return SetError((size_t)(pIn - m_pText), "Control character in a string");
+		}
+		if (c != '\\')
+		{
+			*pOut++ = *pIn++;
+			continue;
+		}
+
+		// An escape never ends a string, so there is a character after it
+		char escaped = pIn[1];
+		switch (escaped)
+		{
+		case '"': case '\\': case '/':
+			*pOut++ = escaped;
+			break;
+		case 'b': *pOut++ = '\b'; break;
+		case 'f': *pOut++ = '\f'; break;
+		case 'n': *pOut++ = '\n'; break;
+		case 'r': *pOut++ = '\r'; break;
+		case 't': *pOut++ = '\t'; break;
+		case 'u':
+		{
+			uint32_t codePoint;
+			if (pEnd - pIn < 6 || !ReadHex4(pIn + 2, codePoint))
+			{
+				return SetError((size_t)(pIn - m_pText), "Invalid \\u escape");
+			}
+			if (codePoint >= 0xdc00 && codePoint < 0xe000)
+			{
+				return SetError((size_t)(pIn - m_pText), "Unpaired surrogate");
+			}
+			if (codePoint >= 0xd800 && codePoint < 0xdc00)
+			{
+				uint32_t lowSurrogate;
+				if (pEnd - pIn < 12 || pIn[6] != '\\' || pIn[7] != 'u' || !ReadHex4(pIn + 8, lowSurrogate)
+					|| lowSurrogate < 0xdc00 || lowSurrogate >= 0xe000)
+				{
+					return SetError((size_t)(pIn - m_pText), "Unpaired surrogate");
+				}
+				codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (lowSurrogate - 0xdc00);
+				pIn += 6;
+			}
+			if (codePoint == 0)
+			{
+				return SetError((size_t)(pIn - m_pText), "Null characters are not supported in strings");
+			}
+			pOut = WriteUtf8(codePoint, pOut);
+			pIn += 4;
+			break;
+		}
+		default:
+			return SetError((size_t)(pIn - m_pText), "Invalid escape");
+		}
+		pIn += 2;
+	}
+
+	*pOut = '\0';
+	rpString = pBegin;
+	return true;
+}
+
+bool impl_ns::DTJsonParser::ParseScalar(size_t begin, size_t end, IElementDatum& rElement)
+{
+	const char* pBegin = m_pText + begin;
+	size_t length = end - begin;
+	switch (*pBegin)
+	{
+	case 't':
+		if (length == 4 && std::memcmp(pBegin, "true", 4) == 0)
+		{
+			rElement.Set(true);
+			return true;
+		}
+		break;
+	case 'f':
+		if (length == 5 && std::memcmp(pBegin, "false", 5) == 0)
+		{
+			rElement.Set(false);
+			return true;
+		}
+		break;
+	case 'n':
+		if (length == 4 && std::memcmp(pBegin, "null", 4) == 0)
+		{
+			rElement.Clear();
+			return true;
+		}
+		break;
+	default:
+		if (ParseNumber(pBegin, pBegin + length, rElement))
+		{
+			return true;
+		}
+		if (!m_error.empty())
+		{
+			return false;
+		}
+		break;
+	}
+	return SetError(begin, "Invalid value");
+}
+
+bool impl_ns::DTJsonParser::ParseNumber(const char* pBegin, const char* pEnd, IElementDatum& rElement)
+{
+	const char* p = pBegin;
+	bool negative = *p == '-';
+	if (negative)
+	{
+		++p;
+	}
+	if (p == pEnd || !IsDigit(*p) || (*p == '0' && p + 1 < pEnd && IsDigit(p[1])))
+	{
+		return false;
+	}
+
+	// Up to 19 significant digits are kept; a number with more is left to from_chars
+	uint64_t mantissa = 0;
+	int mantissaDigits = 0;
+	bool truncated = false;
+	int exponent = 0;
+	auto addDigit = [&](char c)
+	{
+		if (mantissaDigits < MAX_MANTISSA_DIGITS)
+		{
+			mantissa = mantissa * 10 + (uint64_t)(c - '0');
+			if (mantissa != 0)
+			{
+				++mantissaDigits;
+			}
+			return true;
+		}
+		truncated = true;
+		return false;
+	};
+
+	for (; p < pEnd && IsDigit(*p); ++p)
+	{
+		addDigit(*p);
+	}
+
+	bool isInteger = true;
+	if (p < pEnd && *p == '.')
+	{
+		isInteger = false;
+		++p;
+		if (p == pEnd || !IsDigit(*p))
+		{
+			return false;
+		}
+		for (; p < pEnd && IsDigit(*p); ++p)
+		{
+			if (addDigit(*p))
+			{
+				--exponent;
+			}
+		}
+	}
+
+	if (p < pEnd && (*p == 'e' || *p == 'E'))
+	{
+		isInteger = false;
+		++p;
+		bool negativeExponent = false;
+		if (p < pEnd && (*p == '+' || *p == '-'))
+		{
+			negativeExponent = *p == '-';
+			++p;
+		}
+		if (p == pEnd || !IsDigit(*p))
+		{
+			return false;
+		}
+		int explicitExponent = 0;
+		for (; p < pEnd && IsDigit(*p); ++p)
+		{
+			// Anything this big is out of range anyway
+			if (explicitExponent < 100000)
+			{
+				explicitExponent = explicitExponent * 10 + (*p - '0');
+			}
+		}
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	if (p != pEnd)
+	{
+		return false;
+	}
+
+	if (isInteger && !truncated)
+	{
+		if (negative)
+		{
+			if (mantissa <= (uint64_t)std::numeric_limits<int32_t>::max() + 1)
+			{
+				rElement.Set((int32_t)(0 - (int64_t)mantissa));
+				return true;
+			}
+			if (mantissa <= (uint64_t)std::numeric_limits<int64_t>::max() + 1)
+			{
+				rElement.Set((int64_t)(0 - mantissa));
+				return true;
+			}
+		}
+		else
+		{
+			if (mantissa <= (uint64_t)std::numeric_limits<int32_t>::max())
+			{
+				rElement.Set((int32_t)mantissa);
+				return true;
+			}
+			if (mantissa <= (uint64_t)std::numeric_limits<int64_t>::max())
+			{
+				rElement.Set((int64_t)mantissa);
+				return true;
+			}
+			rElement.Set(mantissa);
+			return true;
+		}
+	}
+	else if (isInteger && !negative)
+	{
+		uint64_t value;
+		auto result = std::from_chars(pBegin, pEnd, value);
+		if (result.ec == std::errc() && result.ptr == pEnd)
+		{
+			rElement.Set(value);
+			return true;
+		}
+	}
+
+	// A mantissa and a power of ten that are both exact give a correctly rounded quotient or product
+	if (!truncated && mantissa <= MAX_EXACT_MANTISSA
+		&& exponent >= -MAX_EXACT_POWER_OF_10 && exponent <= MAX_EXACT_POWER_OF_10)
+	{
+		double value = (double)mantissa;
+		value = exponent < 0 ? value / s_exactPowersOf10[-exponent] : value * s_exactPowersOf10[exponent];
+		rElement.Set(negative ? -value : value);
+		return true;
+	}
+
+	double value;
+	auto result = std::from_chars(pBegin, pEnd, value);
+	if (result.ec == std::errc::result_out_of_range)
+	{
+		return SetError((size_t)(pBegin - m_pText), "Number out of range");
+	}
+	if (result.ec != std::errc() || result.ptr != pEnd)
+	{
+		return false;
+	}
+	rElement.Set(value);
+	return true;
+}
+
+bool impl_ns::DTJsonParser::ExpectStructural(size_t idx, size_t cursor, char expected, const char* pWhat)
+{
+	size_t next = m_structurals[idx];
+	while (cursor < next && IsBlank(m_pText[cursor]))
+	{
+		++cursor;
+	}
+
+	if (cursor == next && next < m_length && m_pText[next] == expected)
+	{
+		return true;
+	}
+	// Without a message, this only asks whether the character is there
+	return pWhat ? SetError(cursor, pWhat) : false;
+}
+
+bool impl_ns::DTJsonParser::MakeDatum(IDatum* pDatum, BaseDatumType datumType,
+	std::shared_ptr<IDatum>& rDatum, size_t position)
+{
+	rDatum = pDatum ? m_rFactories.Adopt(pDatum) : std::shared_ptr<IDatum>();
+	if (!rDatum || rDatum->GetDatumType() != datumType)
+	{
+		rDatum.reset();
+		return SetError(position, "The factories could not make a datum");
+	}
+	return true;
+}
+
+bool impl_ns::DTJsonParser::SetError(size_t position, const char* pMessage)
+{
+	size_t line = 1;
+	size_t lineStart = 0;
+	for (size_t i = 0; i < position; ++i)
+	{
+		if (m_pText[i] == '\n')
+		{
+			++line;
+			lineStart = i + 1;
+		}
+	}
+
+	m_error = "Line " + std::to_string(line) + ", column " + std::to_string(position - lineStart + 1)
+		+ ": " + pMessage;
+	return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "IDataTree.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace geng::data
+{
+	// Builds data trees from JSON text, making the data with a set of factories.
+	// The text is parsed in two passes.  The first finds every structural character ({}[]:,)
+	// outside a string and both quotes of every string, 16 bytes at a time where SSE2 is there.
+	// The second walks those positions and makes the data.  Strings are terminated and unescaped
+	// in the text itself, so the text must be writable; numbers are parsed without the locale.
+	// Integers become the smallest of Int32, Int64 and UInt64 that holds them; other numbers are
+	// doubles, and null is an empty element
+	class DTJsonParser
+	{
+	public:
+		static constexpr unsigned int MAX_DEPTH = 256;
+
+		DTJsonParser(IDatumFactories& rFactories);
+
+		// Parses the text in place, overwriting it
+		bool ParseInSitu(char* pText, size_t length, std::shared_ptr<IDatum>& rRoot);
+		// Parses a copy of the text
+		bool Parse(const char* pText, size_t length, std::shared_ptr<IDatum>& rRoot);
+		// Parses a private mapping of the file, leaving the file as it was
+		bool ParseFile(const char* pFileName, std::shared_ptr<IDatum>& rRoot);
+
+		// The last error, with its line and column
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		bool IndexStructurals();
+		bool ParseValue(size_t& rIdx, size_t& rCursor, unsigned int depth, std::shared_ptr<IDatum>& rValue);
+		bool ParseDict(size_t& rIdx, size_t& rCursor, unsigned int depth, std::shared_ptr<IDatum>& rValue);
+		bool ParseList(size_t& rIdx, size_t& rCursor, unsigned int depth, std::shared_ptr<IDatum>& rValue);
+		bool ParseString(size_t& rIdx, size_t& rCursor, const char*& rpString);
+		bool ParseScalar(size_t begin, size_t end, IElementDatum& rElement);
+		bool ParseNumber(const char* pBegin, const char* pEnd, IElementDatum& rElement);
+		// Checks that only whitespace comes before the structural at idx, and that it is the one expected
+		bool ExpectStructural(size_t idx, size_t cursor, char expected, const char* pWhat);
+		bool MakeDatum(IDatum* pDatum, BaseDatumType datumType, std::shared_ptr<IDatum>& rDatum, size_t position);
+		bool SetError(size_t position, const char* pMessage);
+
+		IDatumFactories& m_rFactories;
+
+		char* m_pText{ nullptr };
+		size_t m_length{ 0 };
+		// Positions of structural characters and quotes, ending with the length of the text
+		std::vector<uint32_t> m_structurals;
+		// Holds the text for Parse()
+		std::vector<char> m_buffer;
+		std::string m_error;
+	};
+}
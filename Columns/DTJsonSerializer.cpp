@@ -75,7 +75,7 @@ void impl_ns::DTJsonTokenGenerator::AddSeparator()
 	m_tokenList.emplace_back(separatorToken);
 }
 
-impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnList(const std::shared_ptr<IListDatum>& pList,
+impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnList(const IListDatum& rList,
 	bool hasElements)
 {
 	// Separator?
@@ -105,7 +105,7 @@ impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnList(const std::shared
 
 	return IterInstruction::Enter;
 }
-impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnDict(const std::shared_ptr<IDictDatum>& pDict,
+impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnDict(const IDictDatum& rDict,
 	bool hasElements)
 {
 	if (m_firstElement)
@@ -165,7 +165,7 @@ void impl_ns::DTJsonTokenGenerator::EndCompound()
 	PopLevel();
 }
 
-impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnElement(const std::shared_ptr<IElementDatum>& pElement)
+impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnElement(const IElementDatum& rElement)
 {
 	if (m_firstElement)
 	{
@@ -176,12 +176,12 @@ impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnElement(const std::sha
 		AddSeparator();
 	}
 	
-	std::string elementRep = GetRepresentation(pElement);
+	std::string elementRep = GetRepresentation(rElement);
 	JsonToken elementToken{ TokenType::Value, elementRep, false, 0 };
 	m_tokenList.emplace_back(elementToken);
 	return IterInstruction::Enter;
 }
-impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnObject(const std::shared_ptr<IObjectDatum>& pObject)
+impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnObject(const IObjectDatum& rObject)
 {
 	if (m_firstElement)
 	{
@@ -194,7 +194,7 @@ impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnObject(const std::shar
 
 	// Add the object rep
 	std::string objRep;
-	if (!pObject->GetRepresentation(objRep))
+	if (!rObject.GetRepresentation(objRep))
 	{
 		objRep = "<repr-error>";
 	}
@@ -208,10 +208,10 @@ impl_ns::IterInstruction impl_ns::DTJsonTokenGenerator::OnObject(const std::shar
 }
 
 template<typename T>
-std::string impl_ns::DTJsonTokenGenerator::ToString(const std::shared_ptr<IElementDatum>& pDatum)
+std::string impl_ns::DTJsonTokenGenerator::ToString(const IElementDatum& rDatum)
 {
 	T dataVal;
-	if (!pDatum->Get(dataVal))
+	if (!rDatum.Get(dataVal))
 	{
 		throw DataStateException();
 	}
@@ -221,16 +221,16 @@ std::string impl_ns::DTJsonTokenGenerator::ToString(const std::shared_ptr<IEleme
 	return ssm.str();
 }
 
-std::string impl_ns::DTJsonTokenGenerator::GetRepresentation(const std::shared_ptr<IElementDatum>& pElement)
+std::string impl_ns::DTJsonTokenGenerator::GetRepresentation(const IElementDatum& rElement)
 {
-	switch (pElement->GetElementType())
+	switch (rElement.GetElementType())
 	{
 		case ElementType::None:
 			return std::string(NULL_REP);
 		case ElementType::Boolean:
 		{
 			bool bval{ false };
-			if (!pElement->Get(bval))
+			if (!rElement.Get(bval))
 			{
 				// error...
 				break;
@@ -238,29 +238,29 @@ std::string impl_ns::DTJsonTokenGenerator::GetRepresentation(const std::shared_p
 			return std::string(bval ? TRUE_REP : FALSE_REP);
 		}
 		case ElementType::Int8:
-			return ToString<int8_t>(pElement);
+			return ToString<int8_t>(rElement);
 		case ElementType::UInt8:
-			return ToString<uint8_t>(pElement);
+			return ToString<uint8_t>(rElement);
 		case ElementType::Int16:
-			return ToString<int16_t>(pElement);
+			return ToString<int16_t>(rElement);
 		case ElementType::UInt16:
-			return ToString<uint16_t>(pElement);
+			return ToString<uint16_t>(rElement);
 		case ElementType::Int32:
-			return ToString<int32_t>(pElement);
+			return ToString<int32_t>(rElement);
 		case ElementType::UInt32:
-			return ToString<uint32_t>(pElement);
+			return ToString<uint32_t>(rElement);
 		case ElementType::Int64:
-			return ToString<int64_t>(pElement);
+			return ToString<int64_t>(rElement);
 		case ElementType::UInt64:
-			return ToString<uint64_t>(pElement);
+			return ToString<uint64_t>(rElement);
 		case ElementType::Float:
-			return ToString<float>(pElement);
+			return ToString<float>(rElement);
 		case ElementType::Double:
-			return ToString<double>(pElement);
+			return ToString<double>(rElement);
 		case ElementType::String:
 		{
 			std::string strRep;
-			if (!pElement->Get(strRep))
+			if (!rElement.Get(strRep))
 			{
 				break;
 			}
@@ -30,15 +30,15 @@ namespace geng::data
 	class DTJsonTokenGenerator : public ITreeSerializer
 	{
 	public:
-		IterInstruction OnList(const std::shared_ptr<IListDatum>& pList,
+		IterInstruction OnList(const IListDatum& rList,
 		    bool hasElements) override;
-		IterInstruction OnDict(const std::shared_ptr<IDictDatum>& pDict,
+		IterInstruction OnDict(const IDictDatum& rDict,
 		    bool hasElements) override;
 		IterInstruction OnDictKey(const char* pKey) override;
 		void EndCompound() override;
 
-		IterInstruction OnElement(const std::shared_ptr<IElementDatum>& pElement) override;
-		IterInstruction OnObject(const std::shared_ptr<IObjectDatum>& pObject) override;
+		IterInstruction OnElement(const IElementDatum& rElement) override;
+		IterInstruction OnObject(const IObjectDatum& rObject) override;
 
 		const std::vector<JsonToken>&
 			GetTokenVector() const
@@ -46,10 +46,10 @@ namespace geng::data
 			return m_tokenList;
 		}
 	private:
-		static std::string GetRepresentation(const std::shared_ptr<IElementDatum>& pElement);
+		static std::string GetRepresentation(const IElementDatum& rElement);
 
 		template<typename T>
-		static std::string ToString(const std::shared_ptr<IElementDatum>& pDatum);
+		static std::string ToString(const IElementDatum& rDatum);
 		
 		// Call PushLevel _after_ creating a token
 		void PushLevel();
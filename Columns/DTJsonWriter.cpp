@@ -0,0 +1,356 @@
+#include "DTJsonWriter.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace impl_ns = geng::data;
+
+namespace
+{
+	constexpr std::string_view NULL_REP{ "null" };
+	constexpr std::string_view TRUE_REP{ "true" };
+	constexpr std::string_view FALSE_REP{ "false" };
+
+	constexpr char SPACES[] = "                                ";
+	constexpr size_t SPACES_LENGTH = sizeof(SPACES) - 1;
+
+	// Room for any integer or shortest double, with ".0" after it
+	constexpr size_t NUMBER_BUFFER_SIZE = 40;
+
+	// Characters that can be copied into a string as they are
+	inline bool IsPlain(char c)
+	{
+		return (unsigned char)c >= 0x20 && c != '"' && c != '\\';
+	}
+}
+
+impl_ns::DTJsonWriter::DTJsonWriter(serial::IWriteStream& rStream, unsigned int levelIndent)
+	:m_pStream(&rStream),
+	m_streamBuffer(STREAM_BUFFER_SIZE),
+	m_pBuffer(m_streamBuffer.data()),
+	m_capacity(m_streamBuffer.size()),
+	m_levelIndent(levelIndent)
+{
+
+}
+
+impl_ns::DTJsonWriter::DTJsonWriter(char* pBuffer, size_t bufferSize, unsigned int levelIndent)
+	:m_pBuffer(pBuffer),
+	m_capacity(bufferSize),
+	m_levelIndent(levelIndent)
+{
+
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnList(const IListDatum& rList,
+	bool hasElements)
+{
+	return OnCompound('[', ']', hasElements);
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnDict(const IDictDatum& rDict,
+	bool hasElements)
+{
+	return OnCompound('{', '}', hasElements);
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnCompound(char opener, char closer, bool hasElements)
+{
+	BeginValue();
+	Put(opener);
+	if (hasElements)
+	{
+		// Closed in EndCompound
+		m_closers.push_back(closer);
+		m_firstElement = true;
+		NewLine();
+	}
+	else
+	{
+		Put(closer);
+	}
+	return Result();
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnDictKey(const char* pKey)
+{
+	BeginValue();
+	PutString(pKey);
+	Put(':');
+	if (m_levelIndent > 0)
+	{
+		Put(' ');
+	}
+
+	// No comma before the value
+	m_firstElement = true;
+	return Result();
+}
+
+void impl_ns::DTJsonWriter::EndCompound()
+{
+	if (m_closers.empty())
+	{
+		throw DataStateException();
+	}
+
+	char closer = m_closers.back();
+	m_closers.pop_back();
+	NewLine();
+	Put(closer);
+	m_firstElement = false;
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnElement(const IElementDatum& rElement)
+{
+	BeginValue();
+	PutElement(rElement);
+	return Result();
+}
+
+impl_ns::IterInstruction impl_ns::DTJsonWriter::OnObject(const IObjectDatum& rObject)
+{
+	BeginValue();
+
+	std::string objRep;
+	if (!rObject.GetRepresentation(objRep))
+	{
+		objRep = "<repr-error>";
+	}
+	PutString(objRep);
+	return Result();
+}
+
+bool impl_ns::DTJsonWriter::Finish()
+{
+	if (m_pStream && m_used > 0)
+	{
+		Drain();
+	}
+	return !m_failed;
+}
+
+void impl_ns::DTJsonWriter::BeginValue()
+{
+	if (m_firstElement)
+	{
+		m_firstElement = false;
+	}
+	else
+	{
+		Put(',');
+		NewLine();
+	}
+}
+
+void impl_ns::DTJsonWriter::NewLine()
+{
+	if (m_levelIndent == 0)
+	{
+		return;
+	}
+
+	Put('\n');
+	size_t spaces = (size_t)m_levelIndent * m_closers.size();
+	while (spaces > 0)
+	{
+		size_t length = spaces < SPACES_LENGTH ? spaces : SPACES_LENGTH;
+		Put(SPACES, length);
+		spaces -= length;
+	}
+}
+
+void impl_ns::DTJsonWriter::PutString(std::string_view text)
+{
+	Put('"');
+	const char* pRun = text.data();
+	const char* pTextEnd = pRun + text.size();
+	while (true)
+	{
+		// Copy runs that need no escapes in one go
+		const char* pEnd = pRun;
+		while (pEnd != pTextEnd && IsPlain(*pEnd))
+		{
+			++pEnd;
+		}
+		Put(pRun, (size_t)(pEnd - pRun));
+
+		if (pEnd == pTextEnd)
+		{
+			break;
+		}
+
+		char c = *pEnd;
+
+		char escape[6] = { '\\', '\0' };
+		size_t escapeLength = 2;
+		switch (c)
+		{
+		case '"': escape[1] = '"'; break;
+		case '\\': escape[1] = '\\'; break;
+		case '\b': escape[1] = 'b'; break;
+		case '\f': escape[1] = 'f'; break;
+		case '\n': escape[1] = 'n'; break;
+		case '\r': escape[1] = 'r'; break;
+		case '\t': escape[1] = 't'; break;
+		default:
+		{
+			constexpr char HEX_DIGITS[] = "0123456789abcdef";
+			escape[1] = 'u';
+			escape[2] = '0';
+			escape[3] = '0';
+			escape[4] = HEX_DIGITS[((unsigned char)c >> 4) & 0xf];
+			escape[5] = HEX_DIGITS[(unsigned char)c & 0xf];
+			escapeLength = 6;
+			break;
+		}
+		}
+		Put(escape, escapeLength);
+		pRun = pEnd + 1;
+	}
+	Put('"');
+}
+
+template<typename T>
+void impl_ns::DTJsonWriter::PutInteger(const IElementDatum& rElement)
+{
+	T value;
+	if (!rElement.Get(value))
+	{
+		throw DataStateException();
+	}
+
+	char number[NUMBER_BUFFER_SIZE];
+	auto result = std::to_chars(number, number + sizeof(number), value);
+	Put(number, (size_t)(result.ptr - number));
+}
+
+template<typename T>
+void impl_ns::DTJsonWriter::PutFloat(const IElementDatum& rElement)
+{
+	T value;
+	if (!rElement.Get(value))
+	{
+		throw DataStateException();
+	}
+
+	// JSON has no infinities or NaNs
+	if (!std::isfinite(value))
+	{
+		Put(NULL_REP.data(), NULL_REP.size());
+		return;
+	}
+
+	// The shortest text that reads back as the same value
+	char number[NUMBER_BUFFER_SIZE];
+	char* pEnd = std::to_chars(number, number + sizeof(number) - 2, value).ptr;
+	// Keep whole numbers from reading back as integers
+	if (!std::memchr(number, '.', (size_t)(pEnd - number)) && !std::memchr(number, 'e', (size_t)(pEnd - number)))
+	{
+		*pEnd++ = '.';
+		*pEnd++ = '0';
+	}
+	Put(number, (size_t)(pEnd - number));
+}
+
+void impl_ns::DTJsonWriter::PutElement(const IElementDatum& rElement)
+{
+	switch (rElement.GetElementType())
+	{
+	case ElementType::None:
+		Put(NULL_REP.data(), NULL_REP.size());
+		return;
+	case ElementType::Boolean:
+	{
+		bool bval{ false };
+		if (!rElement.Get(bval))
+		{
+			break;
+		}
+		std::string_view rep = bval ? TRUE_REP : FALSE_REP;
+		Put(rep.data(), rep.size());
+		return;
+	}
+	case ElementType::Int8:
+		PutInteger<int8_t>(rElement);
+		return;
+	case ElementType::UInt8:
+		PutInteger<uint8_t>(rElement);
+		return;
+	case ElementType::Int16:
+		PutInteger<int16_t>(rElement);
+		return;
+	case ElementType::UInt16:
+		PutInteger<uint16_t>(rElement);
+		return;
+	case ElementType::Int32:
+		PutInteger<int32_t>(rElement);
+		return;
+	case ElementType::UInt32:
+		PutInteger<uint32_t>(rElement);
+		return;
+	case ElementType::Int64:
+		PutInteger<int64_t>(rElement);
+		return;
+	case ElementType::UInt64:
+		PutInteger<uint64_t>(rElement);
+		return;
+	case ElementType::Float:
+		PutFloat<float>(rElement);
+		return;
+	case ElementType::Double:
+		PutFloat<double>(rElement);
+		return;
+	case ElementType::String:
+	{
+		// Read in place, not copied
+		std::string_view strRep;
+		if (!rElement.Get(strRep))
+		{
+			break;
+		}
+		PutString(strRep);
+		return;
+	}
+	}
+
+	throw DataStateException();
+}
+
+void impl_ns::DTJsonWriter::Put(const char* pText, size_t length)
+{
+	while (length > 0)
+	{
+		if (m_used == m_capacity && !Drain())
+		{
+			return;
+		}
+
+		size_t chunk = m_capacity - m_used;
+		if (chunk > length)
+		{
+			chunk = length;
+		}
+		std::memcpy(m_pBuffer + m_used, pText, chunk);
+		m_used += chunk;
+		pText += chunk;
+		length -= chunk;
+	}
+}
+
+bool impl_ns::DTJsonWriter::Drain()
+{
+	// A caller's buffer that is full stays full
+	if (!m_pStream || m_failed || m_pStream->Write(m_pBuffer, m_used) != m_used)
+	{
+		m_failed = true;
+		return false;
+	}
+
+	m_drained += m_used;
+	m_used = 0;
+	return true;
+}
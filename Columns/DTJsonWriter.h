@@ -0,0 +1,81 @@
+#pragma once
+
+#include "IDataTree.h"
+#include "Bytestream.h"
+#include <vector>
+
+namespace geng::data
+{
+	// Writes JSON as the tree is walked, with no tokens or strings in between.  The text goes into a
+	// buffer, which is either the caller's or a small one of the writer's own that is emptied into
+	// a stream whenever it fills.  With a level indent, every element goes on its own line
+	class DTJsonWriter : public ITreeSerializer
+	{
+	public:
+		static constexpr size_t STREAM_BUFFER_SIZE = 4096;
+
+		DTJsonWriter(serial::IWriteStream& rStream, unsigned int levelIndent = 0);
+		// Stops, breaking the walk, when the buffer is full.  The text is not null terminated
+		DTJsonWriter(char* pBuffer, size_t bufferSize, unsigned int levelIndent = 0);
+
+		IterInstruction OnList(const IListDatum& rList,
+			bool hasElements) override;
+		IterInstruction OnDict(const IDictDatum& rDict,
+			bool hasElements) override;
+		IterInstruction OnDictKey(const char* pKey) override;
+		void EndCompound() override;
+
+		IterInstruction OnElement(const IElementDatum& rElement) override;
+		IterInstruction OnObject(const IObjectDatum& rObject) override;
+
+		// Writes what is still buffered to the stream.  False if anything was not written
+		bool Finish();
+
+		bool HasFailed() const { return m_failed; }
+		// Everything written so far, including what has gone to the stream
+		size_t GetLength() const { return m_drained + m_used; }
+
+	private:
+		IterInstruction OnCompound(char opener, char closer, bool hasElements);
+		void BeginValue();
+		void NewLine();
+		void PutString(std::string_view text);
+		void PutElement(const IElementDatum& rElement);
+
+		template<typename T>
+		void PutInteger(const IElementDatum& rElement);
+		template<typename T>
+		void PutFloat(const IElementDatum& rElement);
+
+		void Put(char c)
+		{
+			if (m_used == m_capacity && !Drain())
+			{
+				return;
+			}
+			m_pBuffer[m_used++] = c;
+		}
+
+		void Put(const char* pText, size_t length);
+		bool Drain();
+
+		IterInstruction Result() const
+		{
+			return m_failed ? IterInstruction::Break : IterInstruction::Enter;
+		}
+
+		serial::IWriteStream* m_pStream{ nullptr };
+		std::vector<char> m_streamBuffer;
+		char* m_pBuffer;
+		size_t m_capacity;
+		size_t m_used{ 0 };
+		size_t m_drained{ 0 };
+		bool m_failed{ false };
+
+		unsigned int m_levelIndent;
+		// The closer of every open list or dictionary
+		std::vector<char> m_closers;
+		// First element of a JSON, list or dictionary
+		bool m_firstElement{ true };
+	};
+}
@@ -0,0 +1,66 @@
+#include "DTKeyTable.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include <cstring>
+
+namespace impl_ns = geng::data;
+
+namespace
+{
+	struct KeyTableState_
+	{
+		std::mutex mutex;
+		// Views of the texts below
+		std::unordered_set<std::string_view> keys;
+		std::vector<std::unique_ptr<char[]> > textBlocks;
+		char* pNext{ nullptr };
+		size_t spaceLeft{ 0 };
+	};
+
+	KeyTableState_& GetState()
+	{
+		static KeyTableState_ s_state;
+		return s_state;
+	}
+}
+
+impl_ns::DictKey impl_ns::KeyTable::Intern(std::string_view text)
+{
+	KeyTableState_& rState = GetState();
+	std::lock_guard<std::mutex> lock(rState.mutex);
+
+	auto itKey = rState.keys.find(text);
+	if (itKey != rState.keys.end())
+	{
+		return DictKey(itKey->data(), itKey->size());
+	}
+
+	// Texts are packed into blocks that are never freed or moved
+	size_t size = text.size() + 1;
+	if (size > rState.spaceLeft)
+	{
+		size_t blockSize = size > TEXT_BLOCK_SIZE ? size : TEXT_BLOCK_SIZE;
+		rState.textBlocks.emplace_back(new char[blockSize]);
+		rState.pNext = rState.textBlocks.back().get();
+		rState.spaceLeft = blockSize;
+	}
+
+	char* pText = rState.pNext;
+	std::memcpy(pText, text.data(), text.size());
+	pText[text.size()] = '\0';
+	rState.pNext += size;
+	rState.spaceLeft -= size;
+
+	rState.keys.emplace(pText, text.size());
+	return DictKey(pText, text.size());
+}
+
+size_t impl_ns::KeyTable::GetKeyCount()
+{
+	KeyTableState_& rState = GetState();
+	std::lock_guard<std::mutex> lock(rState.mutex);
+	return rState.keys.size();
+}
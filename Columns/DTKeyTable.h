@@ -0,0 +1,18 @@
+#pragma once
+#include "IDataTree.h"
+
+namespace geng::data
+{
+	// The one copy of every key frozen dictionaries hold.  Interned keys last as long as the
+	// program, so trees frozen again and again cost nothing more for their keys, and equal keys
+	// share one text: a lookup with an interned key matches on the pointer alone.
+	// Thread safe; interning takes a lock, which only freezing does
+	class KeyTable
+	{
+	public:
+		static constexpr size_t TEXT_BLOCK_SIZE = 4096;
+
+		static DictKey Intern(std::string_view text);
+		static size_t GetKeyCount();
+	};
+}
@@ -0,0 +1,683 @@
+#include "DTMapped.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace impl_ns = geng::data::mapped;
+
+namespace
+{
+	using geng::data::BinaryTag;
+
+	// A container's byte length, then its count
+	constexpr size_t CONTAINER_FIELD_SIZE = 4;
+	constexpr size_t CONTAINER_HEADER_SIZE = 1 + 2 * CONTAINER_FIELD_SIZE;
+	constexpr unsigned int MAX_VARINT_BYTES = 10;
+
+	uint64_t DecodeFixed(const uint8_t* pBytes, size_t byteCount)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < byteCount; ++i)
+		{
+			value |= (uint64_t)pBytes[i] << (8 * i);
+		}
+		return value;
+	}
+
+	bool DecodeVarint(const uint8_t*& rpBytes, const uint8_t* pEnd, uint64_t& rValue)
+	{
+		rValue = 0;
+		for (unsigned int i = 0; i < MAX_VARINT_BYTES && rpBytes < pEnd; ++i)
+		{
+			uint8_t byte = *rpBytes++;
+			rValue |= (uint64_t)(byte & 0x7f) << (7 * i);
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// The bytes a whole number takes after its tag; 0 if it is not a number
+	size_t NumberSize(BinaryTag tag)
+	{
+		switch (tag)
+		{
+		case BinaryTag::Int8:
+		case BinaryTag::UInt8:
+			return 1;
+		case BinaryTag::Int16:
+		case BinaryTag::UInt16:
+			return 2;
+		case BinaryTag::Int32:
+		case BinaryTag::UInt32:
+		case BinaryTag::Float:
+			return 4;
+		case BinaryTag::Int64:
+		case BinaryTag::UInt64:
+		case BinaryTag::Double:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+
+	// The bytes the value at pValue takes, tag and all; 0 if it does not fit before pEnd
+	size_t ValueSize(const uint8_t* pValue, const uint8_t* pEnd)
+	{
+		if (pValue >= pEnd)
+		{
+			return 0;
+		}
+
+		size_t available = (size_t)(pEnd - pValue);
+		size_t size = 0;
+		BinaryTag tag = (BinaryTag)*pValue;
+		switch (tag)
+		{
+		case BinaryTag::None:
+		case BinaryTag::False:
+		case BinaryTag::True:
+			size = 1;
+			break;
+		case BinaryTag::String:
+		{
+			const uint8_t* pBytes = pValue + 1;
+			uint64_t length;
+			if (!DecodeVarint(pBytes, pEnd, length) || length > (uint64_t)(pEnd - pBytes))
+			{
+				return 0;
+			}
+			size = (size_t)(pBytes - pValue) + (size_t)length;
+			break;
+		}
+		case BinaryTag::List:
+		case BinaryTag::Dictionary:
+		{
+			if (available < CONTAINER_HEADER_SIZE)
+			{
+				return 0;
+			}
+			uint64_t length = DecodeFixed(pValue + 1, CONTAINER_FIELD_SIZE);
+			uint64_t count = DecodeFixed(pValue + 1 + CONTAINER_FIELD_SIZE, CONTAINER_FIELD_SIZE);
+			// Every entry takes at least a byte
+			if (length < CONTAINER_FIELD_SIZE || count > length - CONTAINER_FIELD_SIZE)
+			{
+				return 0;
+			}
+			size = 1 + CONTAINER_FIELD_SIZE + (size_t)length;
+			break;
+		}
+		default:
+			size = NumberSize(tag);
+			if (size == 0)
+			{
+				return 0;
+			}
+			++size;
+			break;
+		}
+
+		return size <= available ? size : 0;
+	}
+
+	std::shared_ptr<geng::data::IDatum> MakeView(const std::shared_ptr<const void>& pOwner,
+		const uint8_t* pValue, size_t size)
+	{
+		switch ((BinaryTag)*pValue)
+		{
+		case BinaryTag::List:
+			return std::make_shared<impl_ns::List>(pOwner, pValue, pValue + size);
+		case BinaryTag::Dictionary:
+			return std::make_shared<impl_ns::Dictionary>(pOwner, pValue, pValue + size);
+		default:
+			return std::make_shared<impl_ns::Element>(pOwner, pValue, pValue + size);
+		}
+	}
+
+	// Views are made once; a thread that loses a race takes the other's
+	std::shared_ptr<geng::data::IDatum> CachedView(std::shared_ptr<geng::data::IDatum>& rpCached,
+		const std::shared_ptr<const void>& pOwner, const uint8_t* pValue, size_t size)
+	{
+		std::shared_ptr<geng::data::IDatum> pView = std::atomic_load(&rpCached);
+		if (!pView)
+		{
+			std::shared_ptr<geng::data::IDatum> pMade = MakeView(pOwner, pValue, size);
+			if (std::atomic_compare_exchange_strong(&rpCached, &pView, pMade))
+			{
+				pView = std::move(pMade);
+			}
+		}
+		return pView;
+	}
+
+	// The views only ever read from a value that ValueSize() measured
+	void ReadContainerHeader(const uint8_t* pValue, const uint8_t*& rpBody, uint32_t& rCount)
+	{
+		rpBody = pValue + CONTAINER_HEADER_SIZE;
+		rCount = (uint32_t)DecodeFixed(pValue + 1 + CONTAINER_FIELD_SIZE, CONTAINER_FIELD_SIZE);
+	}
+}
+
+// Element
+impl_ns::Element::Element(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd)
+	:m_pOwner(std::move(pOwner)),
+	m_tag((BinaryTag)*pValue),
+	m_pData(pValue + 1),
+	m_pEnd(pEnd)
+{
+}
+
+geng::data::BaseDatumType impl_ns::Element::GetDatumType() const
+{
+	return BaseDatumType::Element;
+}
+
+bool impl_ns::Element::IsImmutable() const
+{
+	return true;
+}
+
+geng::data::ElementType impl_ns::Element::GetElementType() const
+{
+	switch (m_tag)
+	{
+	case BinaryTag::False:
+	case BinaryTag::True:
+		return ElementType::Boolean;
+	case BinaryTag::Int8:
+		return ElementType::Int8;
+	case BinaryTag::UInt8:
+		return ElementType::UInt8;
+	case BinaryTag::Int16:
+		return ElementType::Int16;
+	case BinaryTag::UInt16:
+		return ElementType::UInt16;
+	case BinaryTag::Int32:
+		return ElementType::Int32;
+	case BinaryTag::UInt32:
+		return ElementType::UInt32;
+	case BinaryTag::Int64:
+		return ElementType::Int64;
+	case BinaryTag::UInt64:
+		return ElementType::UInt64;
+	case BinaryTag::Float:
+		return ElementType::Float;
+	case BinaryTag::Double:
+		return ElementType::Double;
+	case BinaryTag::String:
+		return ElementType::String;
+	default:
+		return ElementType::None;
+	}
+}
+
+template<typename T>
+bool impl_ns::Element::GetNumber(BinaryTag tag, T& rDatum) const
+{
+	if (m_tag != tag)
+	{
+		return false;
+	}
+
+	uint64_t bits = DecodeFixed(m_pData, sizeof(T));
+	if constexpr (std::is_floating_point_v<T>)
+	{
+		if constexpr (sizeof(T) == sizeof(uint32_t))
+		{
+			uint32_t floatBits = (uint32_t)bits;
+			std::memcpy(&rDatum, &floatBits, sizeof(rDatum));
+		}
+		else
+		{
+			std::memcpy(&rDatum, &bits, sizeof(rDatum));
+		}
+	}
+	else
+	{
+		rDatum = (T)(std::make_unsigned_t<T>)bits;
+	}
+	return true;
+}
+
+bool impl_ns::Element::Get(bool& rDatum) const
+{
+	if (m_tag != BinaryTag::False && m_tag != BinaryTag::True)
+	{
+		return false;
+	}
+	rDatum = m_tag == BinaryTag::True;
+	return true;
+}
+
+bool impl_ns::Element::Get(int8_t& rDatum) const
+{
+	return GetNumber(BinaryTag::Int8, rDatum);
+}
+
+bool impl_ns::Element::Get(uint8_t& rDatum) const
+{
+	return GetNumber(BinaryTag::UInt8, rDatum);
+}
+
+bool impl_ns::Element::Get(int16_t& rDatum) const
+{
+	return GetNumber(BinaryTag::Int16, rDatum);
+}
+
+bool impl_ns::Element::Get(uint16_t& rDatum) const
+{
+	return GetNumber(BinaryTag::UInt16, rDatum);
+}
+
+bool impl_ns::Element::Get(int32_t& rDatum) const
+{
+	return GetNumber(BinaryTag::Int32, rDatum);
+}
+
+bool impl_ns::Element::Get(uint32_t& rDatum) const
+{
+	return GetNumber(BinaryTag::UInt32, rDatum);
+}
+
+bool impl_ns::Element::Get(int64_t& rDatum) const
+{
+	return GetNumber(BinaryTag::Int64, rDatum);
+}
+
+bool impl_ns::Element::Get(uint64_t& rDatum) const
+{
+	return GetNumber(BinaryTag::UInt64, rDatum);
+}
+
+bool impl_ns::Element::Get(float& rDatum) const
+{
+	return GetNumber(BinaryTag::Float, rDatum);
+}
+
+bool impl_ns::Element::Get(double& rDatum) const
+{
+	return GetNumber(BinaryTag::Double, rDatum);
+}
+
+bool impl_ns::Element::Get(std::string& rDatum) const
+{
+	std::string_view text;
+	if (!Get(text))
+	{
+		return false;
+	}
+	rDatum.assign(text.data(), text.size());
+	return true;
+}
+
+bool impl_ns::Element::Get(std::string_view& rDatum) const
+{
+	if (m_tag != BinaryTag::String)
+	{
+		return false;
+	}
+
+	// Measured when the view was made
+	const uint8_t* pText = m_pData;
+	uint64_t length;
+	DecodeVarint(pText, m_pEnd, length);
+	rDatum = std::string_view(reinterpret_cast<const char*>(pText), (size_t)length);
+	return true;
+}
+
+void impl_ns::Element::Set(bool datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int8_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint8_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int16_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint16_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int32_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint32_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int64_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint64_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(float datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(double datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(const char* datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Clear()
+{
+	throw DataStateException();
+}
+
+// List
+impl_ns::List::List(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd)
+	:m_pOwner(std::move(pOwner)),
+	m_pEnd(pEnd)
+{
+	ReadContainerHeader(pValue, m_pBody, m_count);
+}
+
+void impl_ns::List::Index() const
+{
+	std::call_once(m_indexed, [this]()
+	{
+		m_entries.reserve(m_count);
+		const uint8_t* pEntry = m_pBody;
+		for (uint32_t i = 0; i < m_count; ++i)
+		{
+			size_t size = ValueSize(pEntry, m_pEnd);
+			if (size == 0)
+			{
+				break;
+			}
+			m_entries.push_back(Entry_{ (uint32_t)(pEntry - m_pBody), (uint32_t)size });
+			pEntry += size;
+		}
+		m_children.resize(m_entries.size());
+	});
+}
+
+std::shared_ptr<geng::data::IDatum> impl_ns::List::ChildAt(size_t idx) const
+{
+	const Entry_& rEntry = m_entries[idx];
+	return CachedView(m_children[idx], m_pOwner, m_pBody + rEntry.offset, rEntry.length);
+}
+
+bool impl_ns::List::IsEmpty() const
+{
+	return GetLength() == 0;
+}
+
+geng::data::BaseDatumType impl_ns::List::GetDatumType() const
+{
+	return BaseDatumType::List;
+}
+
+bool impl_ns::List::IsImmutable() const
+{
+	return true;
+}
+
+size_t impl_ns::List::GetLength() const
+{
+	Index();
+	return m_entries.size();
+}
+
+bool impl_ns::List::GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const
+{
+	Index();
+	if (idx < m_entries.size())
+	{
+		rChild = ChildAt(idx);
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::List::GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+	size_t startIdx,
+	size_t endIdx) const
+{
+	Index();
+	if (endIdx == LIST_NPOS)
+	{
+		endIdx = m_entries.size();
+	}
+
+	if (startIdx >= m_entries.size() || endIdx > m_entries.size())
+	{
+		return false;
+	}
+
+	for (size_t i = startIdx; i < endIdx; ++i)
+	{
+		rSequence.emplace_back(ChildAt(i));
+	}
+
+	return endIdx > startIdx;
+}
+
+bool impl_ns::List::InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexBefore)
+{
+	throw DataStateException();
+}
+
+bool impl_ns::List::SetEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexAt)
+{
+	throw DataStateException();
+}
+
+// Dictionary
+impl_ns::Dictionary::Dictionary(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd)
+	:m_pOwner(std::move(pOwner)),
+	m_pEnd(pEnd)
+{
+	ReadContainerHeader(pValue, m_pBody, m_count);
+}
+
+void impl_ns::Dictionary::Index() const
+{
+	std::call_once(m_indexed, [this]()
+	{
+		struct RawEntry
+		{
+			const uint8_t* pKey;
+			size_t keyLength;
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		std::vector<RawEntry> rawEntries;
+		rawEntries.reserve(m_count);
+		size_t textSize = 0;
+
+		const uint8_t* pEntry = m_pBody;
+		for (uint32_t i = 0; i < m_count; ++i)
+		{
+			uint64_t keyLength;
+			if (!DecodeVarint(pEntry, m_pEnd, keyLength) || keyLength > (uint64_t)(m_pEnd - pEntry))
+			{
+				break;
+			}
+			const uint8_t* pKey = pEntry;
+			pEntry += keyLength;
+
+			size_t size = ValueSize(pEntry, m_pEnd);
+			if (size == 0)
+			{
+				break;
+			}
+			rawEntries.push_back(RawEntry{ pKey, (size_t)keyLength, (uint32_t)(pEntry - m_pBody), (uint32_t)size });
+			textSize += (size_t)keyLength + 1;
+			pEntry += size;
+		}
+
+		// Keys are copied out so they end in nulls
+		m_keyText.resize(textSize);
+		m_entries.reserve(rawEntries.size());
+		char* pText = m_keyText.data();
+		for (const RawEntry& rRaw : rawEntries)
+		{
+			std::memcpy(pText, rRaw.pKey, rRaw.keyLength);
+			pText[rRaw.keyLength] = '\0';
+			m_entries.push_back(Entry_{ DictKey(pText, rRaw.keyLength), rRaw.offset, rRaw.length });
+			pText += rRaw.keyLength + 1;
+		}
+
+		std::sort(m_entries.begin(), m_entries.end(), [](const Entry_& rLeft, const Entry_& rRight)
+		{
+			return rLeft.key.GetHash() < rRight.key.GetHash();
+		});
+		m_children.resize(m_entries.size());
+	});
+}
+
+size_t impl_ns::Dictionary::FindEntry(const DictKey& key) const
+{
+	Index();
+
+	uint32_t hash = key.GetHash();
+	auto itEntry = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+		[](const Entry_& rEntry, uint32_t hash)
+	{
+		return rEntry.key.GetHash() < hash;
+	});
+
+	for (; itEntry != m_entries.end() && itEntry->key.GetHash() == hash; ++itEntry)
+	{
+		if (itEntry->key.GetLength() == key.GetLength()
+			&& std::memcmp(itEntry->key.GetText(), key.GetText(), key.GetLength()) == 0)
+		{
+			return (size_t)(itEntry - m_entries.begin());
+		}
+	}
+
+	return std::numeric_limits<size_t>::max();
+}
+
+std::shared_ptr<geng::data::IDatum> impl_ns::Dictionary::ChildAt(size_t idx) const
+{
+	const Entry_& rEntry = m_entries[idx];
+	return CachedView(m_children[idx], m_pOwner, m_pBody + rEntry.offset, rEntry.length);
+}
+
+bool impl_ns::Dictionary::IsEmpty() const
+{
+	Index();
+	return m_entries.empty();
+}
+
+geng::data::BaseDatumType impl_ns::Dictionary::GetDatumType() const
+{
+	return BaseDatumType::Dictionary;
+}
+
+bool impl_ns::Dictionary::IsImmutable() const
+{
+	return true;
+}
+
+bool impl_ns::Dictionary::HasEntry(const char* pKey) const
+{
+	return FindEntry(pKey) != std::numeric_limits<size_t>::max();
+}
+
+bool impl_ns::Dictionary::GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const
+{
+	return GetEntryByKey(pKey, rChild);
+}
+
+bool impl_ns::Dictionary::GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+{
+	size_t idx = FindEntry(key);
+	if (idx == std::numeric_limits<size_t>::max())
+	{
+		return false;
+	}
+
+	rChild = ChildAt(idx);
+	return true;
+}
+
+bool impl_ns::Dictionary::Iterate(geng::data::IDictCallback& rCallback) const
+{
+	Index();
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		if (!rCallback.OnEntry(m_entries[i].key.GetText(), ChildAt(i)))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::Dictionary::SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild)
+{
+	throw DataStateException();
+}
+
+bool impl_ns::OpenMemory(const void* pData, size_t size, std::shared_ptr<const void> pOwner,
+	std::shared_ptr<IDatum>& rRoot, std::string& rError)
+{
+	rRoot.reset();
+
+	const uint8_t* pValue = static_cast<const uint8_t*>(pData);
+	size_t valueSize = pValue ? ValueSize(pValue, pValue + size) : 0;
+	if (valueSize == 0)
+	{
+		rError = size == 0 ? "No data" : "The data does not start with a whole value";
+		return false;
+	}
+
+	rRoot = MakeView(pOwner, pValue, valueSize);
+	return true;
+}
+
+bool impl_ns::OpenFile(const char* pFileName, std::shared_ptr<IDatum>& rRoot, std::string& rError)
+{
+	rRoot.reset();
+
+	auto pFile = std::make_shared<MappedFile>();
+	if (!pFile->Open(pFileName))
+	{
+		rError = pFile->GetError();
+		return false;
+	}
+
+	const char* pData = pFile->GetData();
+	size_t size = pFile->GetSize();
+	return OpenMemory(pData, size, std::move(pFile), rRoot, rError);
+}
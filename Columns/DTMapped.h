@@ -0,0 +1,159 @@
+#pragma once
+#include "IDataTree.h"
+#include "DTBinary.h"
+#include <mutex>
+#include <vector>
+
+namespace geng::data::mapped
+{
+	// Views of a tree written by DTBinaryWriter, read where it lies: nothing is decoded or copied
+	// when the tree is opened.  The first look into a list or a dictionary steps over its entries
+	// once, to make a table of where they are (a dictionary copies its keys then, too); elements
+	// are decoded each time they are read, and strings come straight from the bytes.
+	// Views of a child are made when it is first asked for, and kept.
+	//
+	// Everything here is immutable, and any number of threads can read it.  Bad data does not
+	// crash: a container whose entries run out of bounds shows those before the bad one
+
+	class Element : public IElementDatum
+	{
+	public:
+		// The bytes start with the tag
+		Element(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd);
+
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+		ElementType GetElementType() const override;
+
+		bool Get(bool& rDatum) const override;
+		bool Get(int8_t& rDatum) const override;
+		bool Get(uint8_t& rDatum) const override;
+		bool Get(int16_t& rDatum) const override;
+		bool Get(uint16_t& rDatum) const override;
+		bool Get(int32_t& rDatum) const override;
+		bool Get(uint32_t& rDatum) const override;
+		bool Get(int64_t& rDatum) const override;
+		bool Get(uint64_t& rDatum) const override;
+		bool Get(float& rDatum) const override;
+		bool Get(double& rDatum) const override;
+		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
+
+		// These throw DataStateException
+		void Set(bool datum) override;
+		void Set(int8_t datum) override;
+		void Set(uint8_t datum) override;
+		void Set(int16_t datum) override;
+		void Set(uint16_t datum) override;
+		void Set(int32_t datum) override;
+		void Set(uint32_t datum) override;
+		void Set(int64_t datum) override;
+		void Set(uint64_t datum) override;
+		void Set(float datum) override;
+		void Set(double datum) override;
+		void Set(const char* datum) override;
+		void Clear() override;
+
+	private:
+		template<typename T>
+		bool GetNumber(BinaryTag tag, T& rDatum) const;
+
+		std::shared_ptr<const void> m_pOwner;
+		BinaryTag m_tag;
+		// After the tag
+		const uint8_t* m_pData;
+		const uint8_t* m_pEnd;
+	};
+
+	class List : public IListDatum
+	{
+	public:
+		List(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd);
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		size_t GetLength() const override;
+		bool GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+			size_t startIdx,
+			size_t endIdx) const override;
+		// These throw DataStateException
+		bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexBefore) override;
+		bool SetEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexAt) override;
+
+	private:
+		struct Entry_
+		{
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		void Index() const;
+		std::shared_ptr<IDatum> ChildAt(size_t idx) const;
+
+		std::shared_ptr<const void> m_pOwner;
+		// The entries, and where they must end
+		const uint8_t* m_pBody{ nullptr };
+		const uint8_t* m_pEnd{ nullptr };
+		uint32_t m_count{ 0 };
+
+		mutable std::once_flag m_indexed;
+		mutable std::vector<Entry_> m_entries;
+		mutable std::vector<std::shared_ptr<IDatum> > m_children;
+	};
+
+	class Dictionary : public IDictDatum
+	{
+	public:
+		Dictionary(std::shared_ptr<const void> pOwner, const uint8_t* pValue, const uint8_t* pEnd);
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		bool HasEntry(const char* pKey) const override;
+		bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const override;
+		// In the order of the keys' hashes
+		bool Iterate(IDictCallback& rCallback) const override;
+
+		// Throws DataStateException
+		bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) override;
+
+	private:
+		struct Entry_
+		{
+			DictKey key;
+			uint32_t offset;
+			uint32_t length;
+		};
+
+		void Index() const;
+		// SIZE_MAX if there is no such key
+		size_t FindEntry(const DictKey& key) const;
+		std::shared_ptr<IDatum> ChildAt(size_t idx) const;
+
+		std::shared_ptr<const void> m_pOwner;
+		const uint8_t* m_pBody{ nullptr };
+		const uint8_t* m_pEnd{ nullptr };
+		uint32_t m_count{ 0 };
+
+		mutable std::once_flag m_indexed;
+		// Sorted by hash
+		mutable std::vector<Entry_> m_entries;
+		// The keys, null terminated
+		mutable std::vector<char> m_keyText;
+		mutable std::vector<std::shared_ptr<IDatum> > m_children;
+	};
+
+	// Maps a file and views the first value in it.  The file stays mapped while any view of it
+	// is held
+	bool OpenFile(const char* pFileName, std::shared_ptr<IDatum>& rRoot, std::string& rError);
+	// Views a value in memory.  The owner, if there is one, is kept while the views are
+	bool OpenMemory(const void* pData, size_t size, std::shared_ptr<const void> pOwner,
+		std::shared_ptr<IDatum>& rRoot, std::string& rError);
+}
@@ -0,0 +1,126 @@
+#include "DTPath.h"
+#include "DTKeyTable.h"
+
+namespace impl_ns = geng::data;
+
+impl_ns::DTPath::DTPath(std::string_view path)
+{
+	size_t pos = 0;
+	while (pos < path.size())
+	{
+		// A key runs up to a dot or a bracket
+		size_t keyEnd = path.find_first_of(".[", pos);
+		if (keyEnd == std::string_view::npos)
+		{
+			keyEnd = path.size();
+		}
+
+		if (keyEnd > pos)
+		{
+			AddKey(path.substr(pos, keyEnd - pos));
+		}
+		else if (path[pos] != '[' || m_segments.empty())
+		{
+			// Empty keys, and paths starting with an index, are not paths
+			m_segments.clear();
+			return;
+		}
+		pos = keyEnd;
+
+		while (pos < path.size() && path[pos] == '[')
+		{
+			size_t index = 0;
+			size_t digitsStart = ++pos;
+			while (pos < path.size() && path[pos] >= '0' && path[pos] <= '9')
+			{
+				index = index * 10 + (path[pos] - '0');
+				++pos;
+			}
+			if (pos == digitsStart || pos == path.size() || path[pos] != ']')
+			{
+				m_segments.clear();
+				return;
+			}
+			++pos;
+
+			Segment_ segment;
+			segment.index = index;
+			m_segments.push_back(segment);
+		}
+
+		if (pos < path.size())
+		{
+			if (path[pos] != '.' || pos + 1 == path.size())
+			{
+				m_segments.clear();
+				return;
+			}
+			++pos;
+		}
+	}
+
+	m_valid = !m_segments.empty();
+}
+
+void impl_ns::DTPath::AddKey(std::string_view key)
+{
+	Segment_ segment;
+	segment.key = KeyTable::Intern(key);
+	m_segments.push_back(segment);
+}
+
+impl_ns::AccessResult impl_ns::DTPath::Resolve(const IDatum& root, std::shared_ptr<IDatum>& rNode) const
+{
+	if (!m_valid)
+	{
+		return AccessResult::NoSuchElement;
+	}
+
+	const IDatum* pCurrent = &root;
+	std::shared_ptr<IDatum> pNode;
+	for (const Segment_& rSegment : m_segments)
+	{
+		std::shared_ptr<IDatum> pNext;
+		AccessResult result = rSegment.index == LIST_NPOS
+			? GetDictChild(*pCurrent, rSegment.key, pNext)
+			: GetListChild(*pCurrent, rSegment.index, pNext);
+		if (result != AccessResult::OK)
+		{
+			return result;
+		}
+
+		pNode = std::move(pNext);
+		pCurrent = pNode.get();
+	}
+
+	rNode = std::move(pNode);
+	return AccessResult::OK;
+}
+
+impl_ns::AccessResult impl_ns::DTCachedPath::Resolve(const std::shared_ptr<IDatum>& pRoot,
+	std::shared_ptr<IDatum>& rNode)
+{
+	// A live weak pointer holds the root's control block, so no other root can share it
+	bool sameRoot = m_pCachedNode
+		&& !m_pCachedRoot.owner_before(pRoot)
+		&& !pRoot.owner_before(m_pCachedRoot);
+	if (sameRoot)
+	{
+		rNode = m_pCachedNode;
+		return AccessResult::OK;
+	}
+
+	AccessResult result = m_path.Resolve(*pRoot, rNode);
+	if (result == AccessResult::OK && pRoot->IsImmutable())
+	{
+		m_pCachedRoot = pRoot;
+		m_pCachedNode = rNode;
+	}
+	return result;
+}
+
+void impl_ns::DTCachedPath::Forget()
+{
+	m_pCachedRoot.reset();
+	m_pCachedNode.reset();
+}
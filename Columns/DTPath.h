@@ -0,0 +1,126 @@
+#pragma once
+#include "DTUtils.h"
+#include <string_view>
+#include <vector>
+
+namespace geng::data
+{
+	// A path into a tree, compiled once: "source.filepath", "levels[2].speed".  Keys are split
+	// on dots and interned (see KeyTable), so they are hashed here and never again; an index in
+	// brackets steps into a list.  Resolving a path allocates nothing.
+	// A path never changes after it is made, so one path can serve any number of threads
+	class DTPath
+	{
+	public:
+		DTPath(std::string_view path);
+
+		// False if the text was not a path; such a path finds nothing
+		bool IsValid() const { return m_valid; }
+		size_t GetSegmentCount() const { return m_segments.size(); }
+
+		AccessResult Resolve(const IDatum& root, std::shared_ptr<IDatum>& rNode) const;
+
+		template<typename T>
+		AccessResult GetChild(const IDatum& root, std::shared_ptr<T>& rChild) const
+		{
+			static_assert(std::is_base_of_v<IDatum, T>, "DTPath::GetChild: T must derive from IDatum");
+
+			std::shared_ptr<IDatum> pNode;
+			AccessResult result = Resolve(root, pNode);
+			if (result != AccessResult::OK)
+			{
+				return result;
+			}
+			return CastNode(std::move(pNode), rChild);
+		}
+
+		// The value of the element at the path, converted as GetValue() converts
+		template<typename B>
+		AccessResult GetValue(const IDatum& root, B& value) const
+		{
+			std::shared_ptr<IElementDatum> pEl;
+			AccessResult result = GetChild(root, pEl);
+			if (result != AccessResult::OK)
+			{
+				return result;
+			}
+			return data::GetValue(*pEl, value);
+		}
+
+		template<typename T>
+		static AccessResult CastNode(std::shared_ptr<IDatum>&& pNode, std::shared_ptr<T>& rChild)
+		{
+			if constexpr (std::is_same_v<IDatum, T>)
+			{
+				rChild = std::move(pNode);
+			}
+			else
+			{
+				if (pNode->GetDatumType() != DatumTraits<T>::tag)
+				{
+					return AccessResult::WrongTargetType;
+				}
+				rChild = std::static_pointer_cast<T>(std::move(pNode));
+			}
+			return AccessResult::OK;
+		}
+
+	private:
+		struct Segment_
+		{
+			DictKey key{ "" };
+			// LIST_NPOS for a key
+			size_t index{ LIST_NPOS };
+		};
+
+		void AddKey(std::string_view key);
+
+		std::vector<Segment_> m_segments;
+		bool m_valid{ false };
+	};
+
+	// A path that remembers the node it last found, for trees that never change: frozen trees
+	// and persistent snapshots.  Asked again about the same root, it answers without walking.
+	// Roots that are not immutable are walked every time.  Not thread safe: keep one per user
+	class DTCachedPath
+	{
+	public:
+		DTCachedPath(DTPath path)
+			:m_path(std::move(path))
+		{ }
+
+		AccessResult Resolve(const std::shared_ptr<IDatum>& pRoot, std::shared_ptr<IDatum>& rNode);
+
+		template<typename T>
+		AccessResult GetChild(const std::shared_ptr<IDatum>& pRoot, std::shared_ptr<T>& rChild)
+		{
+			std::shared_ptr<IDatum> pNode;
+			AccessResult result = Resolve(pRoot, pNode);
+			if (result != AccessResult::OK)
+			{
+				return result;
+			}
+			return DTPath::CastNode(std::move(pNode), rChild);
+		}
+
+		template<typename B>
+		AccessResult GetValue(const std::shared_ptr<IDatum>& pRoot, B& value)
+		{
+			std::shared_ptr<IElementDatum> pEl;
+			AccessResult result = GetChild(pRoot, pEl);
+			if (result != AccessResult::OK)
+			{
+				return result;
+			}
+			return data::GetValue(*pEl, value);
+		}
+
+		void Forget();
+
+	private:
+		DTPath m_path;
+		// The root only identifies the tree; it is not kept alive
+		std::weak_ptr<IDatum> m_pCachedRoot;
+		std::shared_ptr<IDatum> m_pCachedNode;
+	};
+}
@@ -0,0 +1,64 @@
+#include "DTPersistent.h"
+
+namespace impl_ns = geng::data::persistent;
+
+std::shared_ptr<geng::data::IDatum> impl_ns::Persist(const std::shared_ptr<IDatum>& pDatum)
+{
+	if (!pDatum)
+	{
+		return pDatum;
+	}
+
+	switch (pDatum->GetDatumType())
+	{
+	case BaseDatumType::Dictionary:
+	{
+		if (auto pDict = dynamic_cast<const Dictionary*>(pDatum.get()))
+		{
+			return pDict->IsImmutable() ? pDatum : pDict->Snapshot();
+		}
+
+		struct Copier : public IDictCallback
+		{
+			bool OnEntry(const char* pKey, const std::shared_ptr<IDatum>& pChild) override
+			{
+				dict.SetEntry(pKey, pChild);
+				return true;
+			}
+
+			Dictionary dict;
+		};
+
+		Copier copier;
+		static_cast<const IDictDatum&>(*pDatum).Iterate(copier);
+		return copier.dict.Snapshot();
+	}
+	case BaseDatumType::List:
+	{
+		if (auto pList = dynamic_cast<const List*>(pDatum.get()))
+		{
+			return pList->IsImmutable() ? pDatum : pList->Snapshot();
+		}
+
+		std::vector<std::shared_ptr<IDatum> > entries;
+		static_cast<const IListDatum&>(*pDatum).GetRange(entries);
+		List list;
+		for (const auto& pEntry : entries)
+		{
+			list.InsertEntry(pEntry, LIST_NPOS);
+		}
+		return list.Snapshot();
+	}
+	case BaseDatumType::Element:
+	{
+		// Setting the element later must not reach into the trees and snapshots holding it
+		if (pDatum->IsImmutable())
+		{
+			return pDatum;
+		}
+		return std::make_shared<Element>(static_cast<const IElementDatum&>(*pDatum));
+	}
+	default:
+		return pDatum;
+	}
+}
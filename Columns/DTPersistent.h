@@ -0,0 +1,15 @@
+#pragma once
+// A summary header including the headers required for persistent data trees
+
+#include "DTPersistentDict.h"
+#include "DTPersistentList.h"
+#include "DTPersistentElement.h"
+
+namespace geng::data::persistent
+{
+	// The form a datum takes inside a persistent tree.  Persistent dictionaries and lists give
+	// their snapshot, which costs nothing for their size; other dictionaries and lists are
+	// copied into persistent ones.  Elements that can change are copied into persistent
+	// (immutable) ones.  Objects are kept as they are
+	std::shared_ptr<IDatum> Persist(const std::shared_ptr<IDatum>& pDatum);
+}
@@ -0,0 +1,303 @@
+#include "DTPersistentDict.h"
+#include "DTPersistent.h"
+#include "DTKeyTable.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace impl_ns = geng::data::persistent;
+
+namespace
+{
+	bool KeysMatch(const geng::data::DictKey& entryKey, const geng::data::DictKey& key)
+	{
+		return entryKey.GetText() == key.GetText()
+			|| (entryKey.GetLength() == key.GetLength()
+				&& std::memcmp(entryKey.GetText(), key.GetText(), key.GetLength()) == 0);
+	}
+}
+
+impl_ns::Dictionary::Dictionary(const Dictionary& other)
+	// The other dictionary's writer may be replacing its root
+	:m_pRoot(std::atomic_load(&other.m_pRoot))
+{
+}
+
+bool impl_ns::Dictionary::IsEmpty() const
+{
+	// Entries are never removed, so any root has some
+	return !m_pRoot;
+}
+
+geng::data::BaseDatumType impl_ns::Dictionary::GetDatumType() const
+{
+	return BaseDatumType::Dictionary;
+}
+
+bool impl_ns::Dictionary::IsImmutable() const
+{
+	return m_immutable;
+}
+
+unsigned int impl_ns::Dictionary::SlotOf(uint32_t map, uint32_t bit)
+{
+	// The number of bits set below this one
+	uint32_t below = map & (bit - 1);
+	below = below - ((below >> 1) & 0x55555555u);
+	below = (below & 0x33333333u) + ((below >> 2) & 0x33333333u);
+	return (((below + (below >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+const impl_ns::Dictionary::Entry_* impl_ns::Dictionary::FindEntry(const DictKey& key) const
+{
+	uint32_t hash = key.GetHash();
+	const Node_* pNode = m_pRoot.get();
+	unsigned int shift = 0;
+
+	while (pNode)
+	{
+		if (shift >= 32)
+		{
+			for (const Entry_& rEntry : pNode->entries)
+			{
+				if (KeysMatch(rEntry.key, key))
+				{
+					return &rEntry;
+				}
+			}
+			return nullptr;
+		}
+
+		uint32_t bit = 1u << ((hash >> shift) & HASH_MASK);
+		if (pNode->entryMap & bit)
+		{
+			const Entry_& rEntry = pNode->entries[SlotOf(pNode->entryMap, bit)];
+			return rEntry.key.GetHash() == hash && KeysMatch(rEntry.key, key) ? &rEntry : nullptr;
+		}
+		if (!(pNode->nodeMap & bit))
+		{
+			return nullptr;
+		}
+
+		pNode = pNode->nodes[SlotOf(pNode->nodeMap, bit)].get();
+		shift += HASH_BITS;
+	}
+
+	return nullptr;
+}
+
+bool impl_ns::Dictionary::HasEntry(const char* pKey) const
+{
+	return FindEntry(pKey) != nullptr;
+}
+
+bool impl_ns::Dictionary::GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const
+{
+	return GetEntryByKey(pKey, rChild);
+}
+
+bool impl_ns::Dictionary::GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+{
+	const Entry_* pEntry = FindEntry(key);
+	if (pEntry)
+	{
+		rChild = pEntry->child;
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::Dictionary::IterateNode(const Node_& rNode, IDictCallback& rCallback)
+{
+	for (const Entry_& rEntry : rNode.entries)
+	{
+		if (!rCallback.OnEntry(rEntry.key.GetText(), rEntry.child))
+		{
+			return false;
+		}
+	}
+
+	for (const NodePtr_& pNode : rNode.nodes)
+	{
+		if (!IterateNode(*pNode, rCallback))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool impl_ns::Dictionary::Iterate(geng::data::IDictCallback& rCallback) const
+{
+	return !m_pRoot || IterateNode(*m_pRoot, rCallback);
+}
+
+impl_ns::Dictionary::NodePtr_ impl_ns::Dictionary::MakePair(unsigned int shift,
+	const Entry_& first, Entry_&& second)
+{
+	auto pNode = std::make_shared<Node_>();
+	if (shift >= 32)
+	{
+		pNode->entries.push_back(first);
+		pNode->entries.push_back(std::move(second));
+		return pNode;
+	}
+
+	uint32_t firstBit = 1u << ((first.key.GetHash() >> shift) & HASH_MASK);
+	uint32_t secondBit = 1u << ((second.key.GetHash() >> shift) & HASH_MASK);
+	if (firstBit == secondBit)
+	{
+		pNode->nodeMap = firstBit;
+		pNode->nodes.push_back(MakePair(shift + HASH_BITS, first, std::move(second)));
+	}
+	else
+	{
+		pNode->entryMap = firstBit | secondBit;
+		if (firstBit < secondBit)
+		{
+			pNode->entries.push_back(first);
+			pNode->entries.push_back(std::move(second));
+		}
+		else
+		{
+			pNode->entries.push_back(std::move(second));
+			pNode->entries.push_back(first);
+		}
+	}
+
+	return pNode;
+}
+
+impl_ns::Dictionary::NodePtr_ impl_ns::Dictionary::Insert(const Node_* pNode,
+	unsigned int shift, Entry_&& entry)
+{
+	// The path is copied; what hangs off it is shared
+	auto pCopy = std::make_shared<Node_>(*pNode);
+
+	if (shift >= 32)
+	{
+		for (Entry_& rEntry : pCopy->entries)
+		{
+			if (rEntry.key.GetText() == entry.key.GetText())
+			{
+				rEntry.child = std::move(entry.child);
+				return pCopy;
+			}
+		}
+		pCopy->entries.push_back(std::move(entry));
+		return pCopy;
+	}
+
+	uint32_t bit = 1u << ((entry.key.GetHash() >> shift) & HASH_MASK);
+	if (pNode->entryMap & bit)
+	{
+		unsigned int slot = SlotOf(pNode->entryMap, bit);
+		Entry_& rOld = pCopy->entries[slot];
+		if (rOld.key.GetText() == entry.key.GetText())
+		{
+			rOld.child = std::move(entry.child);
+			return pCopy;
+		}
+
+		// Two keys at one place: both go down a level
+		NodePtr_ pPair = MakePair(shift + HASH_BITS, rOld, std::move(entry));
+		pCopy->entries.erase(pCopy->entries.begin() + slot);
+		pCopy->entryMap &= ~bit;
+		pCopy->nodes.insert(pCopy->nodes.begin() + SlotOf(pCopy->nodeMap, bit), std::move(pPair));
+		pCopy->nodeMap |= bit;
+	}
+	else if (pNode->nodeMap & bit)
+	{
+		unsigned int slot = SlotOf(pNode->nodeMap, bit);
+		pCopy->nodes[slot] = Insert(pNode->nodes[slot].get(), shift + HASH_BITS, std::move(entry));
+	}
+	else
+	{
+		pCopy->entries.insert(pCopy->entries.begin() + SlotOf(pNode->entryMap, bit), std::move(entry));
+		pCopy->entryMap |= bit;
+	}
+
+	return pCopy;
+}
+
+void impl_ns::Dictionary::InsertEntry(const DictKey& key, std::shared_ptr<IDatum> pChild)
+{
+	// Interned keys are equal when their texts are the same text
+	Entry_ entry{ KeyTable::Intern(key), std::move(pChild) };
+
+	Node_ emptyRoot;
+	NodePtr_ pRoot = Insert(m_pRoot ? m_pRoot.get() : &emptyRoot, 0, std::move(entry));
+	std::atomic_store(&m_pRoot, std::move(pRoot));
+}
+
+bool impl_ns::Dictionary::SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild)
+{
+	if (m_immutable)
+	{
+		throw DataStateException();
+	}
+
+	InsertEntry(pKey, Persist(rChild));
+	return true;
+}
+
+bool impl_ns::Dictionary::SetPathFrom(const DictKey* pFirst, const DictKey* pLast,
+	const std::shared_ptr<IDatum>& rChild)
+{
+	if (pLast - pFirst == 1)
+	{
+		InsertEntry(*pFirst, Persist(rChild));
+		return true;
+	}
+
+	std::shared_ptr<Dictionary> pNested;
+	const Entry_* pEntry = FindEntry(*pFirst);
+	if (pEntry)
+	{
+		auto pExisting = dynamic_cast<const Dictionary*>(pEntry->child.get());
+		if (!pExisting)
+		{
+			return false;
+		}
+		pNested = std::make_shared<Dictionary>(*pExisting);
+	}
+	else
+	{
+		pNested = std::make_shared<Dictionary>();
+	}
+
+	if (!pNested->SetPathFrom(pFirst + 1, pLast, rChild))
+	{
+		return false;
+	}
+
+	// Nothing else holds the copy, so it can be kept as it is
+	pNested->m_immutable = true;
+	InsertEntry(*pFirst, std::move(pNested));
+	return true;
+}
+
+bool impl_ns::Dictionary::SetPath(std::initializer_list<DictKey> path,
+	const std::shared_ptr<IDatum>& rChild)
+{
+	if (m_immutable)
+	{
+		throw DataStateException();
+	}
+
+	if (path.size() == 0)
+	{
+		return false;
+	}
+
+	return SetPathFrom(path.begin(), path.end(), rChild);
+}
+
+std::shared_ptr<impl_ns::Dictionary> impl_ns::Dictionary::Snapshot() const
+{
+	auto pSnapshot = std::make_shared<Dictionary>(*this);
+	pSnapshot->m_immutable = true;
+	return pSnapshot;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "IDataTree.h"
+#include <initializer_list>
+#include <vector>
+
+namespace geng::data::persistent
+{
+
+	// A dictionary whose versions share structure.  The entries live in a hash trie (32 ways a
+	// level, on the key's FNV-1a hash) of nodes that never change once made: SetEntry() copies
+	// the path from the root down to the entry and shares the rest, and Snapshot() keeps the
+	// current root, so it costs one allocation whatever the size.
+	//
+	// A snapshot is immutable, and reading it takes no lock; it can go to other threads while
+	// the writer goes on changing the dictionary it came from.  Snapshot() may be called from
+	// any thread, but everything else on a dictionary being changed belongs to its writer.
+	//
+	// Children are kept in persistent form (see Persist()), so a snapshot does not change with
+	// a dictionary, list or element set into it.  Elements are copied into immutable ones, whose
+	// Set() throws:  replace one with SetEntry() instead.  Keys are interned (see KeyTable)
+	class Dictionary : public IDictDatum
+	{
+	public:
+		Dictionary() = default;
+		// A changeable copy of the version the other dictionary holds
+		Dictionary(const Dictionary& other);
+		Dictionary& operator=(const Dictionary&) = delete;
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		bool HasEntry(const char* pKey) const override;
+		bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const override;
+		bool Iterate(IDictCallback& rCallback) const override;
+
+		// Throws DataStateException on a snapshot
+		bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) override;
+		// Sets the entry at the end of a path of keys, copying the dictionaries on the way; those
+		// missing are made.  False if one on the way is not a dictionary
+		bool SetPath(std::initializer_list<DictKey> path, const std::shared_ptr<IDatum>& rChild);
+
+		std::shared_ptr<Dictionary> Snapshot() const;
+
+	private:
+		struct Entry_
+		{
+			DictKey key;
+			std::shared_ptr<IDatum> child;
+		};
+
+		// Entries and subtries both sit at their hash's 5 bits, in bit order.  Below the 32 bits
+		// of hash, a node is a plain list of keys whose hashes are equal
+		struct Node_
+		{
+			uint32_t entryMap{ 0 };
+			uint32_t nodeMap{ 0 };
+			std::vector<Entry_> entries;
+			std::vector<std::shared_ptr<const Node_> > nodes;
+		};
+
+		using NodePtr_ = std::shared_ptr<const Node_>;
+
+		static constexpr unsigned int HASH_BITS = 5;
+		static constexpr unsigned int HASH_MASK = (1u << HASH_BITS) - 1;
+
+		const Entry_* FindEntry(const DictKey& key) const;
+		bool SetPathFrom(const DictKey* pFirst, const DictKey* pLast, const std::shared_ptr<IDatum>& rChild);
+		// The child must be persistent already
+		void InsertEntry(const DictKey& key, std::shared_ptr<IDatum> pChild);
+
+		static NodePtr_ Insert(const Node_* pNode, unsigned int shift, Entry_&& entry);
+		static NodePtr_ MakePair(unsigned int shift, const Entry_& first, Entry_&& second);
+		static bool IterateNode(const Node_& rNode, IDictCallback& rCallback);
+		static unsigned int SlotOf(uint32_t map, uint32_t bit);
+
+		NodePtr_ m_pRoot;
+		bool m_immutable{ false };
+	};
+
+}
@@ -0,0 +1,213 @@
+#include "DTPersistentElement.h"
+
+namespace impl_ns = geng::data::persistent;
+
+namespace
+{
+	template<typename T>
+	void CopyValue(const geng::data::IElementDatum& source, geng::data::compact::Element& rDest)
+	{
+		T value;
+		if (source.Get(value))
+		{
+			rDest.Set(value);
+		}
+	}
+}
+
+impl_ns::Element::Element(const IElementDatum& source)
+{
+	switch (source.GetElementType())
+	{
+	case ElementType::Boolean:
+		CopyValue<bool>(source, m_value);
+		break;
+	case ElementType::Int8:
+		CopyValue<int8_t>(source, m_value);
+		break;
+	case ElementType::UInt8:
+		CopyValue<uint8_t>(source, m_value);
+		break;
+	case ElementType::Int16:
+		CopyValue<int16_t>(source, m_value);
+		break;
+	case ElementType::UInt16:
+		CopyValue<uint16_t>(source, m_value);
+		break;
+	case ElementType::Int32:
+		CopyValue<int32_t>(source, m_value);
+		break;
+	case ElementType::UInt32:
+		CopyValue<uint32_t>(source, m_value);
+		break;
+	case ElementType::Int64:
+		CopyValue<int64_t>(source, m_value);
+		break;
+	case ElementType::UInt64:
+		CopyValue<uint64_t>(source, m_value);
+		break;
+	case ElementType::Float:
+		CopyValue<float>(source, m_value);
+		break;
+	case ElementType::Double:
+		CopyValue<double>(source, m_value);
+		break;
+	case ElementType::String:
+	{
+		// Set() wants the text null terminated, which a view may not be
+		std::string text;
+		if (source.Get(text))
+		{
+			m_value.Set(text.c_str());
+		}
+		break;
+	}
+	case ElementType::None:
+		break;
+	}
+}
+
+geng::data::BaseDatumType impl_ns::Element::GetDatumType() const
+{
+	return BaseDatumType::Element;
+}
+
+bool impl_ns::Element::IsImmutable() const
+{
+	return true;
+}
+
+geng::data::ElementType impl_ns::Element::GetElementType() const
+{
+	return m_value.GetElementType();
+}
+
+bool impl_ns::Element::Get(bool& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(int8_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(uint8_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(int16_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(uint16_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(int32_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(uint32_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(int64_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(uint64_t& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(float& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(double& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(std::string& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+bool impl_ns::Element::Get(std::string_view& rDatum) const
+{
+	return m_value.Get(rDatum);
+}
+
+void impl_ns::Element::Set(bool datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int8_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint8_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int16_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint16_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int32_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint32_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(int64_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(uint64_t datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(float datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(double datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Set(const char* datum)
+{
+	throw DataStateException();
+}
+
+void impl_ns::Element::Clear()
+{
+	throw DataStateException();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "IDataTree.h"
+#include "DTCompactElement.h"
+
+namespace geng::data::persistent
+{
+
+	// An element as persistent trees keep it:  a copy of the value made when it went in, which
+	// nothing can change.  Writers and snapshots alike can hand it to other threads
+	class Element : public IElementDatum
+	{
+	public:
+		explicit Element(const IElementDatum& source);
+
+		Element(const Element&) = delete;
+		Element& operator=(const Element&) = delete;
+
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+		ElementType GetElementType() const override;
+
+		bool Get(bool& rDatum) const override;
+		bool Get(int8_t& rDatum) const override;
+		bool Get(uint8_t& rDatum) const override;
+		bool Get(int16_t& rDatum) const override;
+		bool Get(uint16_t& rDatum) const override;
+		bool Get(int32_t& rDatum) const override;
+		bool Get(uint32_t& rDatum) const override;
+		bool Get(int64_t& rDatum) const override;
+		bool Get(uint64_t& rDatum) const override;
+		bool Get(float& rDatum) const override;
+		bool Get(double& rDatum) const override;
+		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
+
+		// These throw DataStateException
+		void Set(bool datum) override;
+		void Set(int8_t datum) override;
+		void Set(uint8_t datum) override;
+		void Set(int16_t datum) override;
+		void Set(uint16_t datum) override;
+		void Set(int32_t datum) override;
+		void Set(uint32_t datum) override;
+		void Set(int64_t datum) override;
+		void Set(uint64_t datum) override;
+		void Set(float datum) override;
+		void Set(double datum) override;
+		void Set(const char* datum) override;
+		void Clear() override;
+
+	private:
+		compact::Element m_value;
+	};
+
+}
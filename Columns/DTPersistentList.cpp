@@ -0,0 +1,282 @@
+#include "DTPersistentList.h"
+#include "DTPersistent.h"
+
+#include <atomic>
+
+namespace impl_ns = geng::data::persistent;
+
+impl_ns::List::List(const List& other)
+	// The other list's writer may be replacing its version
+	:m_pTrie(std::atomic_load(&other.m_pTrie))
+{
+}
+
+bool impl_ns::List::IsEmpty() const
+{
+	return m_pTrie->length == 0;
+}
+
+geng::data::BaseDatumType impl_ns::List::GetDatumType() const
+{
+	return BaseDatumType::List;
+}
+
+bool impl_ns::List::IsImmutable() const
+{
+	return m_immutable;
+}
+
+size_t impl_ns::List::GetLength() const
+{
+	return m_pTrie->length;
+}
+
+const impl_ns::List::Node_& impl_ns::List::LeafFor(const Trie_& rTrie, size_t idx)
+{
+	const Node_* pNode = rTrie.pRoot.get();
+	for (unsigned int shift = rTrie.shift; shift > 0; shift -= NODE_BITS)
+	{
+		pNode = pNode->nodes[(idx >> shift) & NODE_MASK].get();
+	}
+	return *pNode;
+}
+
+bool impl_ns::List::GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const
+{
+	const Trie_& rTrie = *m_pTrie;
+	if (idx < rTrie.length)
+	{
+		rChild = LeafFor(rTrie, idx).entries[idx & NODE_MASK];
+		return true;
+	}
+
+	return false;
+}
+
+bool impl_ns::List::GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+	size_t startIdx,
+	size_t endIdx) const
+{
+	const Trie_& rTrie = *m_pTrie;
+	if (endIdx == LIST_NPOS)
+	{
+		endIdx = rTrie.length;
+	}
+
+	if (startIdx >= rTrie.length || endIdx > rTrie.length)
+	{
+		return false;
+	}
+
+	// A bottom node at a time
+	size_t idx = startIdx;
+	while (idx < endIdx)
+	{
+		const Node_& rLeaf = LeafFor(rTrie, idx);
+		size_t leafEnd = (idx | NODE_MASK) + 1;
+		if (leafEnd > endIdx)
+		{
+			leafEnd = endIdx;
+		}
+		rSequence.insert(rSequence.end(),
+			rLeaf.entries.begin() + (idx & NODE_MASK),
+			rLeaf.entries.begin() + (idx & NODE_MASK) + (leafEnd - idx));
+		idx = leafEnd;
+	}
+
+	return endIdx > startIdx;
+}
+
+bool impl_ns::List::ForEachChild(geng::data::IChildCallback& rCallback) const
+{
+	// A bottom node at a time
+	const Trie_& rTrie = *m_pTrie;
+	for (size_t idx = 0; idx < rTrie.length; idx += NODE_WIDTH)
+	{
+		for (const std::shared_ptr<IDatum>& pChild : LeafFor(rTrie, idx).entries)
+		{
+			if (!rCallback.OnChild(nullptr, *pChild))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+impl_ns::List::NodePtr_ impl_ns::List::MakePath(unsigned int shift, std::shared_ptr<IDatum>&& pEntry)
+{
+	auto pNode = std::make_shared<Node_>();
+	if (shift == 0)
+	{
+		pNode->entries.push_back(std::move(pEntry));
+	}
+	else
+	{
+		pNode->nodes.push_back(MakePath(shift - NODE_BITS, std::move(pEntry)));
+	}
+	return pNode;
+}
+
+impl_ns::List::NodePtr_ impl_ns::List::Append(const Node_& rNode, unsigned int shift, size_t idx,
+	std::shared_ptr<IDatum>&& pEntry)
+{
+	auto pCopy = std::make_shared<Node_>(rNode);
+	if (shift == 0)
+	{
+		pCopy->entries.push_back(std::move(pEntry));
+		return pCopy;
+	}
+
+	size_t slot = (idx >> shift) & NODE_MASK;
+	if (slot < pCopy->nodes.size())
+	{
+		pCopy->nodes[slot] = Append(*rNode.nodes[slot], shift - NODE_BITS, idx, std::move(pEntry));
+	}
+	else
+	{
+		pCopy->nodes.push_back(MakePath(shift - NODE_BITS, std::move(pEntry)));
+	}
+	return pCopy;
+}
+
+impl_ns::List::NodePtr_ impl_ns::List::Replace(const Node_& rNode, unsigned int shift, size_t idx,
+	std::shared_ptr<IDatum>&& pEntry)
+{
+	auto pCopy = std::make_shared<Node_>(rNode);
+	if (shift == 0)
+	{
+		pCopy->entries[idx & NODE_MASK] = std::move(pEntry);
+	}
+	else
+	{
+		size_t slot = (idx >> shift) & NODE_MASK;
+		pCopy->nodes[slot] = Replace(*rNode.nodes[slot], shift - NODE_BITS, idx, std::move(pEntry));
+	}
+	return pCopy;
+}
+
+impl_ns::List::TriePtr_ impl_ns::List::Build(std::vector<std::shared_ptr<IDatum> >&& entries)
+{
+	auto pTrie = std::make_shared<Trie_>();
+	pTrie->length = entries.size();
+	if (entries.empty())
+	{
+		return pTrie;
+	}
+
+	std::vector<NodePtr_> level;
+	for (size_t idx = 0; idx < entries.size(); idx += NODE_WIDTH)
+	{
+		auto pLeaf = std::make_shared<Node_>();
+		size_t leafEnd = idx + NODE_WIDTH < entries.size() ? idx + NODE_WIDTH : entries.size();
+		pLeaf->entries.assign(std::make_move_iterator(entries.begin() + idx),
+			std::make_move_iterator(entries.begin() + leafEnd));
+		level.push_back(std::move(pLeaf));
+	}
+
+	while (level.size() > 1)
+	{
+		std::vector<NodePtr_> above;
+		for (size_t idx = 0; idx < level.size(); idx += NODE_WIDTH)
+		{
+			auto pNode = std::make_shared<Node_>();
+			size_t nodeEnd = idx + NODE_WIDTH < level.size() ? idx + NODE_WIDTH : level.size();
+			pNode->nodes.assign(std::make_move_iterator(level.begin() + idx),
+				std::make_move_iterator(level.begin() + nodeEnd));
+			above.push_back(std::move(pNode));
+		}
+		level = std::move(above);
+		pTrie->shift += NODE_BITS;
+	}
+
+	pTrie->pRoot = std::move(level.front());
+	return pTrie;
+}
+
+void impl_ns::List::SetTrie(TriePtr_ pTrie)
+{
+	std::atomic_store(&m_pTrie, std::move(pTrie));
+}
+
+bool impl_ns::List::InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexBefore)
+{
+	if (m_immutable)
+	{
+		throw DataStateException();
+	}
+
+	const Trie_& rTrie = *m_pTrie;
+	if (indexBefore == LIST_NPOS)
+	{
+		indexBefore = rTrie.length;
+	}
+
+	if (indexBefore > rTrie.length)
+	{
+		return false;
+	}
+
+	if (indexBefore < rTrie.length)
+	{
+		std::vector<std::shared_ptr<IDatum> > entries;
+		entries.reserve(rTrie.length + 1);
+		GetRange(entries, 0, LIST_NPOS);
+		entries.insert(entries.begin() + indexBefore, Persist(pEntry));
+		SetTrie(Build(std::move(entries)));
+		return true;
+	}
+
+	auto pNewTrie = std::make_shared<Trie_>(rTrie);
+	++pNewTrie->length;
+
+	if (!rTrie.pRoot)
+	{
+		pNewTrie->pRoot = MakePath(0, Persist(pEntry));
+	}
+	else if (rTrie.length == NODE_WIDTH << rTrie.shift)
+	{
+		// The root is full: it goes down a level
+		auto pRoot = std::make_shared<Node_>();
+		pRoot->nodes.push_back(rTrie.pRoot);
+		pRoot->nodes.push_back(MakePath(rTrie.shift, Persist(pEntry)));
+		pNewTrie->pRoot = std::move(pRoot);
+		pNewTrie->shift += NODE_BITS;
+	}
+	else
+	{
+		pNewTrie->pRoot = Append(*rTrie.pRoot, rTrie.shift, rTrie.length, Persist(pEntry));
+	}
+
+	SetTrie(std::move(pNewTrie));
+	return true;
+}
+
+bool impl_ns::List::SetEntry(const std::shared_ptr<IDatum>& pEntry,
+	size_t indexAt)
+{
+	if (m_immutable)
+	{
+		throw DataStateException();
+	}
+
+	const Trie_& rTrie = *m_pTrie;
+	if (indexAt >= rTrie.length)
+	{
+		return false;
+	}
+
+	auto pNewTrie = std::make_shared<Trie_>(rTrie);
+	pNewTrie->pRoot = Replace(*rTrie.pRoot, rTrie.shift, indexAt, Persist(pEntry));
+	SetTrie(std::move(pNewTrie));
+	return true;
+}
+
+std::shared_ptr<impl_ns::List> impl_ns::List::Snapshot() const
+{
+	auto pSnapshot = std::make_shared<List>(*this);
+	pSnapshot->m_immutable = true;
+	return pSnapshot;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "IDataTree.h"
+#include <vector>
+
+namespace geng::data::persistent
+{
+
+	// A list whose versions share structure, kept as a trie of nodes 32 wide that never change
+	// once made.  Setting an entry or adding one at the end copies one path of nodes; inserting
+	// before the end builds the list again.  Snapshots and threads work as they do for
+	// persistent::Dictionary
+	class List : public IListDatum
+	{
+	public:
+		List() = default;
+		// A changeable copy of the version the other list holds
+		List(const List& other);
+		List& operator=(const List&) = delete;
+
+		bool IsEmpty() const override;
+		BaseDatumType GetDatumType() const override;
+		bool IsImmutable() const override;
+
+		size_t GetLength() const override;
+		bool GetEntry(size_t idx, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
+			size_t startIdx,
+			size_t endIdx) const override;
+		bool ForEachChild(IChildCallback& rCallback) const override;
+		// These throw DataStateException on a snapshot
+		bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexBefore) override;
+		bool SetEntry(const std::shared_ptr<IDatum>& pEntry,
+			size_t indexAt) override;
+
+		std::shared_ptr<List> Snapshot() const;
+
+	private:
+		// Inner nodes have nodes, the bottom ones entries
+		struct Node_
+		{
+			std::vector<std::shared_ptr<const Node_> > nodes;
+			std::vector<std::shared_ptr<IDatum> > entries;
+		};
+
+		using NodePtr_ = std::shared_ptr<const Node_>;
+
+		// A version: the root, with what it takes to read it
+		struct Trie_
+		{
+			NodePtr_ pRoot;
+			size_t length{ 0 };
+			// Of the bits of an index, those the root picks by
+			unsigned int shift{ 0 };
+		};
+
+		using TriePtr_ = std::shared_ptr<const Trie_>;
+
+		static constexpr unsigned int NODE_BITS = 5;
+		static constexpr size_t NODE_WIDTH = size_t(1) << NODE_BITS;
+		static constexpr size_t NODE_MASK = NODE_WIDTH - 1;
+
+		static const Node_& LeafFor(const Trie_& rTrie, size_t idx);
+		void SetTrie(TriePtr_ pTrie);
+
+		static NodePtr_ Append(const Node_& rNode, unsigned int shift, size_t idx,
+			std::shared_ptr<IDatum>&& pEntry);
+		static NodePtr_ Replace(const Node_& rNode, unsigned int shift, size_t idx,
+			std::shared_ptr<IDatum>&& pEntry);
+		static NodePtr_ MakePath(unsigned int shift, std::shared_ptr<IDatum>&& pEntry);
+		// Builds a whole trie from the bottom up
+		static TriePtr_ Build(std::vector<std::shared_ptr<IDatum> >&& entries);
+
+		TriePtr_ m_pTrie{ std::make_shared<Trie_>() };
+		bool m_immutable{ false };
+	};
+
+}
@@ -5,6 +5,7 @@
 #include "DTSimpleList.h"
 #include "DTSimpleDict.h"
 #include "DTSimpleElement.h"
+#include "DTCompactElement.h"
 #include "DTConstruct.h"
 
 namespace geng::data::simple
@@ -13,9 +14,16 @@ namespace geng::data::simple
 	{
 		// The names of the first two typedeffed types and the source types coincide,
 		// but the target types are inside this struct whereas the source types
-		// are in the namespace
-		using Element = geng::data::simple::Element;
+		// are in the namespace.  Elements are compact ones, which hold the same values
+		// in far less memory; make_shared puts each in one block with its count
+		using Element = geng::data::compact::Element;
 		using List = geng::data::simple::List;
 		using Dict = geng::data::simple::Dictionary;
+
+		template<typename T>
+		static std::shared_ptr<T> Create()
+		{
+			return std::make_shared<T>();
+		}
 	};
 }
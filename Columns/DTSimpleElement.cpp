@@ -148,6 +148,17 @@ bool impl_ns::Element::Get(std::string& rDatum) const
 {
 	return GenericGet(rDatum);
 }
+bool impl_ns::Element::Get(std::string_view& rDatum) const
+{
+	auto pstring = std::get_if<StringIndex>(&m_data);
+	if (pstring)
+	{
+		rDatum = *pstring;
+		return true;
+	}
+
+	return false;
+}
 void impl_ns::Element::Set(const char* datum) 
 {
 	auto pstring = std::get_if<StringIndex>(&m_data);
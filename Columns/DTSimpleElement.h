@@ -83,6 +83,7 @@ namespace geng::data::simple
 		void Set(double datum) override;
 
 		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
 		void Set(const char* datum) override;
 
 		void Clear() override;
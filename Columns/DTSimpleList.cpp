@@ -55,6 +55,19 @@ bool impl_ns::List::GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
 	return nAdded != 0;
 	
 }
+
+bool impl_ns::List::ForEachChild(geng::data::IChildCallback& rCallback) const
+{
+	for (const std::shared_ptr<IDatum>& pChild : m_list)
+	{
+		if (!rCallback.OnChild(nullptr, *pChild))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
 bool impl_ns::List::InsertEntry(const std::shared_ptr<IDatum>& pEntry,
 	size_t indexBefore) 
 {
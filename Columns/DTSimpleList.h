@@ -16,6 +16,7 @@ namespace geng::data::simple
 		bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
 			size_t startIdx,
 			size_t endIdx) const override;
+		bool ForEachChild(IChildCallback& rCallback) const override;
 		bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
 			size_t indexBefore) override;
 		bool SetEntry(const std::shared_ptr<IDatum>& pEntry,
@@ -7,9 +7,44 @@
 namespace geng::data
 {
 
+	// Walks the tree depth first, lending each datum to the serializer.  False if it broke the walk
+	bool SerializeDataTree(const IDatum& root,
+		ITreeSerializer& serializer);
 	bool SerializeDataTree(const std::shared_ptr<IDatum>& pRoot,
 		ITreeSerializer& serializer);
 
+	// Calls f(pKey, child) with each child of a list or a dictionary, as IChildCallback does: the
+	// child is lent, and the key is null in a list.  f returns false to stop, and then so does this.
+	// Elements and objects have no children
+	template<typename F>
+	bool ForEachChild(const IDatum& datum, F&& f)
+	{
+		struct Call_ : public IChildCallback
+		{
+			Call_(F& f_)
+				:f(f_)
+			{ }
+
+			bool OnChild(const char* pKey, const IDatum& child) override
+			{
+				return f(pKey, child);
+			}
+
+			F& f;
+		};
+
+		Call_ call(f);
+		switch (datum.GetDatumType())
+		{
+		case BaseDatumType::List:
+			return static_cast<const IListDatum&>(datum).ForEachChild(call);
+		case BaseDatumType::Dictionary:
+			return static_cast<const IDictDatum&>(datum).ForEachChild(call);
+		default:
+			return true;
+		}
+	}
+
 	enum AccessResult
 	{
 		OK,
@@ -111,6 +146,12 @@ namespace geng::data
 	{
 		static constexpr ElementType tag = ElementType::String;
 	};
+	// Good while the element holds the same string
+	template<>
+	struct ElementTraits<std::string_view>
+	{
+		static constexpr ElementType tag = ElementType::String;
+	};
 
 	enum class ConvertResult
 	{
@@ -255,7 +296,7 @@ namespace geng::data
 	// Accessors for closures
 	template<typename T>
 	AccessResult GetDictChild(const IDatum& datum,
-		const char* pKey,
+		const DictKey& key,
 		std::shared_ptr<T>& rChild)
 	{
 		static_assert(std::is_base_of_v<IDatum, T>, "GetDictChild: T must derive from IDatum");
@@ -270,7 +311,7 @@ namespace geng::data
 		// Two cases: base class or derived class with type check
 		if constexpr (std::is_same_v<IDatum, T>)
 		{
-			if (!dictDatum.GetEntry(pKey, rChild))
+			if (!dictDatum.GetEntryByKey(key, rChild))
 			{
 				return AccessResult::NoSuchElement;
 			}
@@ -278,7 +319,7 @@ namespace geng::data
 		else
 		{
 			std::shared_ptr<IDatum> genericChild;
-			if (!dictDatum.GetEntry(pKey, genericChild))
+			if (!dictDatum.GetEntryByKey(key, genericChild))
 			{
 				return AccessResult::NoSuchElement;
 			}
@@ -410,14 +451,14 @@ namespace geng::data
 		return AccessResult::OK;
 	}
 		  
-	// Accessors for values inside closures
+	// Accessors for values inside closures.  Keys hashed ahead (see DictKey) are not hashed again
 	template<typename B>
 	AccessResult GetDictValue(const IDatum& datum,
-		const char* pKey,
+		const DictKey& key,
 		B& value)
 	{
 		std::shared_ptr<IElementDatum> pEl;
-		auto childResult = GetDictChild<IElementDatum>(datum, pKey, pEl);
+		auto childResult = GetDictChild<IElementDatum>(datum, key, pEl);
 		if (childResult != AccessResult::OK)
 		{
 			return childResult;
@@ -439,7 +480,7 @@ namespace geng::data
 			return childResult;
 		}
 
-		auto valResult = GetValue(pEl, value);
+		auto valResult = GetValue(*pEl, value);
 		return valResult;
 	}
 
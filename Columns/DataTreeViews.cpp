@@ -119,6 +119,10 @@ bool geng::data::ElementView::Get(std::string& rDatum) const
 {
 	return GenericGet(rDatum);
 }
+bool geng::data::ElementView::Get(std::string_view& rDatum) const
+{
+	return GenericGet(rDatum);
+}
 void geng::data::ElementView::Set(const char* datum) 
 { 
 	throw DataStateException();
@@ -159,6 +163,19 @@ bool geng::data::DictionaryView::GetEntry(const char* pKey, std::shared_ptr<IDat
 		return false;
 	});
 }
+bool geng::data::DictionaryView::GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+{
+	return IfValid([&key, &rChild](const IDictDatum* pDatum)
+	{
+		std::shared_ptr<IDatum> pUnsafe;
+		if (pDatum->GetEntryByKey(key, pUnsafe))
+		{
+			rChild = MakeViewDynamic(pUnsafe);
+			return true;
+		}
+		return false;
+	});
+}
 bool geng::data::DictionaryView::Iterate(IDictCallback& rCallback) const
 {
 	return IfValid([&rCallback](const IDictDatum* pDatum)
@@ -91,6 +91,7 @@ namespace geng::data
 		void Set(double datum) override;
 
 		bool Get(std::string& rDatum) const override;
+		bool Get(std::string_view& rDatum) const override;
 		void Set(const char* datum) override;
 
 		void Clear() override;
@@ -109,6 +110,7 @@ namespace geng::data
 		bool IsEmpty() const;
 		bool HasEntry(const char* pKey) const override;
 		bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const override;
+		bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const override;
 		bool Iterate(IDictCallback& rCallback) const override;
 
 		bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) override;
@@ -487,6 +487,14 @@ void geng::DefaultGame::RunGameLoop()
 		ContextRenderCallbacks();
 		UpdateContextStateAfter();
 
+		if (m_isActive && m_gameArgs.unthrottled)
+		{
+			// No catching up and no waiting -- just go on to the next frame
+			++m_simState.execFrameCount;
+			m_simState.execSimulatedTime += m_gameArgs.msTimePerFrame;
+			continue;
+		}
+
 		if (m_isActive)
 		{
 			++m_simState.execFrameCount;
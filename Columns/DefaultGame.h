@@ -15,6 +15,8 @@ namespace geng
 	{
 		unsigned long msBreather;
 		unsigned long maxMsPerFrame; // For monitoring
+		// Run frames back to back without tracking real time (headless runs)
+		bool unthrottled{ false };
 	};
 
 	class ListenerGroup
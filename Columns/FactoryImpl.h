@@ -1,5 +1,6 @@
 #pragma once
 #include "IFactory.h"
+#include "BlockPool.h"
 #include <type_traits>
 #include <tuple>
 
@@ -34,7 +35,7 @@ namespace geng
 	template<typename Product, 
 				typename Base,
 				typename ... Args>
-	class ForwardingFactory : public IFactory<Base>
+	class ForwardingFactory : public IFactory<Base>, public PooledObject
 	{
 	private:
 		static_assert(std::is_base_of_v<Base, Product>, "Product class P must be derived from B");
@@ -19,7 +19,7 @@ bool geng::serial::FileCommandReader::FileCommandStream::UpdateOnFrame(unsigned
 
 	if (m_rOwner.CurrentFrame() < frameIndex)
 	{
-		m_rOwner.SetFrame(frameIndex);
+		m_rOwner.AdvanceTo(frameIndex);
 	}
 
 	return true;
@@ -82,6 +82,30 @@ geng::serial::FileCommandReader::FileCommandReader(FileUPtr&& pFile,
 		return;
 	}
 
+	if (m_fileStream.HasStartState())
+	{
+		uint32_t startFrame{ 0 };
+		uint32_t stateSize{ 0 };
+		if (m_fileStream.Read(&startFrame, sizeof(startFrame)) < sizeof(startFrame)
+			|| m_fileStream.Read(&stateSize, sizeof(stateSize)) < sizeof(stateSize))
+		{
+			m_error = "Command file: could not read the start state";
+			return;
+		}
+
+		m_startState.frame = startFrame;
+		m_startState.gameState.resize(stateSize);
+		if (m_fileStream.Read(m_startState.gameState.data(), stateSize) < stateSize)
+		{
+			m_error = "Command file: could not read the start state";
+			return;
+		}
+
+		// The commands as they were at the start frame come in a record for that frame
+		m_hasStartState = true;
+		m_currentFrame = startFrame;
+	}
+
 	// Read the data header, which is a list of keys
 	uint16_t keySize{ 0 };
 	constexpr size_t sizeOfSize = sizeof(decltype(keySize));
@@ -158,7 +182,7 @@ geng::serial::FileCommandReader::FileCommandReader(FileUPtr&& pFile,
 		}
 
 		auto idxCommand = itCommandEntry->second;
-		m_commandStreams[idxCommand].cmdStream.reset(new FileCommandStream(*this, pCommand));
+		m_commandStreams[idxCommand].cmdStream = SharePooled(new FileCommandStream(*this, pCommand));
 
 		unmatchedCommands.erase(commandKey);
 	}
@@ -275,47 +299,52 @@ bool geng::serial::FileCommandReader::LoadNextFrame()
 	return true;
 }
 
-bool geng::serial::FileCommandReader::SetFrame(unsigned long curFrame)
+bool geng::serial::FileCommandReader::AdvanceTo(unsigned long targetFrame, std::vector<unsigned long>* pChangeFrames)
 {
-
-	if (m_filePBStatus != FilePlaybackStatus::FilePlaybackOpen)
+	if (targetFrame <= m_currentFrame)
 	{
-		return false;
+		return m_filePBStatus != FilePlaybackStatus::FileError;
 	}
 
-	if (m_nextFrame > curFrame)
-	{
-		m_currentFrame = curFrame;
-		return true;
-	}
-	else if (m_nextFrame < curFrame)
+	// Apply the frames in the interval one after another; frames with no changes aren't in the file
+	while (m_filePBStatus == FilePlaybackStatus::FilePlaybackOpen
+		&& m_nextFrame <= targetFrame)
 	{
-		return false;
-	}
+		// If there are no deltas for this frame, we consider playback ended
+		if (m_nextDeltas.empty())
+		{
+			m_filePBStatus = FilePlaybackStatus::FilePlaybackComplete;
+			break;
+		}
 
-	//fprintf(stderr, "SetFrame, playback state %u cur %lu target %lu next %lu\n",
-//		(unsigned int)m_filePBStatus, m_currentFrame, curFrame, m_nextFrame);
+		for (size_t deltaIndex : m_nextDeltas)
+		{
+			m_commandStreams[deltaIndex].cmdStream->ApplyDelta();
+		}
 
-	// If there are no deltas for this frame, we consider playback ended
-	if (m_nextDeltas.empty())
-	{
-		m_filePBStatus = FilePlaybackStatus::FilePlaybackComplete;
-		return true;
-	}
+		if (pChangeFrames)
+		{
+			pChangeFrames->push_back(m_nextFrame);
+		}
 
-	// Apply and load the next frame
-	for (size_t deltaIndex : m_nextDeltas)
-	{
-		m_commandStreams[deltaIndex].cmdStream->ApplyDelta();
+		// This will update the next frame
+		if (!LoadNextFrame())
+		{
+			break;
+		}
 	}
 
-	// This will update the next frame
-	if (!LoadNextFrame())
+	m_currentFrame = targetFrame;
+	return m_filePBStatus != FilePlaybackStatus::FileError;
+}
+
+unsigned long geng::serial::FileCommandReader::GetNextChangeFrame() const
+{
+	// A frame with no deltas is the end marker, which ends the playback on that frame
+	if (m_filePBStatus != FilePlaybackStatus::FilePlaybackOpen)
 	{
-		return false;
+		return NO_CHANGE_FRAME;
 	}
 
-	m_currentFrame = curFrame;
-	return true;
+	return m_nextFrame;
 }
-
@@ -2,8 +2,10 @@
 
 #include "SerializedCommands.h"
 #include "Filestream.h"
+#include "BlockPool.h"
 
 #include <unordered_map>
+#include <limits>
 
 namespace geng::serial
 {
@@ -29,7 +31,7 @@ namespace geng::serial
 	{
 	private:
 
-		class FileCommandStream : public ICommandStream
+		class FileCommandStream : public ICommandStream, public PooledObject
 		{
 		public:
 			FileCommandStream(FileCommandReader& rOwner,
@@ -77,12 +79,30 @@ namespace geng::serial
 			return m_fileChecksumStatus;
 		}
 
+		FilePlaybackStatus GetPlaybackStatus() const
+		{
+			return m_filePBStatus;
+		}
+
 		uint32_t GetFormatVersion() const { return m_formatVersion; }
 
+		// Recordings of a game already in progress start from a saved state; playback
+		// begins with the frame after it
+		bool HasStartState() const { return m_hasStartState; }
+		const CommandStartState& GetStartState() const { return m_startState; }
+
+		// Apply the deltas of every frame up to and including targetFrame in one pass.  The frames
+		// at which commands changed are appended to pChangeFrames, if given.  Frames at or before
+		// the current one are ignored
+		bool AdvanceTo(unsigned long targetFrame, std::vector<unsigned long>* pChangeFrames = nullptr);
+
+		// The next frame the file has anything for -- a command change, or the end of playback --
+		// or NO_CHANGE_FRAME if it has nothing more
+		static constexpr unsigned long NO_CHANGE_FRAME = std::numeric_limits<unsigned long>::max();
+		unsigned long GetNextChangeFrame() const;
+
 	private:
 		unsigned long CurrentFrame() const { return m_currentFrame; }
-		// Set the frame and load the deltas
-		bool SetFrame(unsigned long curFrame);
 
 		bool LoadNextFrame();
 
@@ -92,13 +112,16 @@ namespace geng::serial
 		// There are two ways this variable is set to "complete"
 		// One is the LoadNextFrame() function, which sets it if it encounters an "end" signal
 		// for the same frame.
-		// Another is the calling SetFrame() function, which sets it when it reaches a frame 
+		// Another is the AdvanceTo() function, which sets it when it reaches a frame 
 		// with an explicitly zero-set of deltas
 
 		FilePlaybackStatus  m_filePBStatus{ FilePlaybackStatus::FileError };
 		FileChecksumStatus  m_fileChecksumStatus{ FileChecksumStatus::FileNoChecksum };
 		uint32_t m_formatVersion{ 0 };
 
+		bool m_hasStartState{ false };
+		CommandStartState m_startState;
+
 		std::string m_error;
 
 		// Map of command keys to command vector entries
@@ -10,7 +10,8 @@ geng::serial::FileCommandWriter::Command_::Command_(const std::shared_ptr<ISeria
 geng::serial::FileCommandWriter::FileCommandWriter(FileUPtr&& pFile,
 	const std::shared_ptr<IPacket>& pDescriptionPacket,
 	const std::vector<std::shared_ptr<ISerializableCommand> >& commandList,
-	const FileStreamHeader* pHeader)
+	const FileStreamHeader* pHeader,
+	const CommandStartState* pStartState)
 	:m_fileStream(std::move(pFile), pHeader),
 	m_hasChecksum(pHeader != nullptr && pHeader->hasChecksum)
 {
@@ -26,45 +27,72 @@ geng::serial::FileCommandWriter::FileCommandWriter(FileUPtr&& pFile,
 		}
 	}
 
-	pDescriptionPacket->Write(&m_fileStream);
+	if ((pStartState != nullptr) != (pHeader != nullptr && pHeader->hasStartState))
+	{
+		m_error = "Command file: the start state and the header disagree";
+		return;
+	}
 
-	for (auto& pCommand : commandList)
+	WritePreamble(&m_fileStream, pDescriptionPacket, commandList, pStartState);
+	if (pStartState)
 	{
-		std::string cmdKey{ pCommand->GetKey() };
+		m_currentFrame = pStartState->frame;
+	}
 
-		if (cmdKey.empty() || cmdKey.size() > std::numeric_limits<uint16_t>::max())
+	for (auto& pCommand : commandList)
+	{
+		if (!CanWriteKey(pCommand->GetKey()))
 		{
 			// Ignore this command
+			m_commandSlots.push_back(NO_COMMAND_SLOT);
 			continue;
 		}
-		
-		uint16_t keySize = (uint16_t)(cmdKey.size());
-		m_fileStream.Write(&keySize, sizeof(keySize));
-		m_fileStream.Write(cmdKey.c_str(), keySize);
+
+		m_commandSlots.push_back((uint32_t)m_commands.size());
 		m_commands.emplace_back(pCommand);
 	}
 
-	const uint16_t endMarker{ 0 };
-	m_fileStream.Write(&endMarker, sizeof(endMarker));
-
 	m_valid = true;
 }
 
-void geng::serial::FileCommandWriter::SubscribeToCommands(const std::shared_ptr<FileCommandWriter>& pThis, bool subscribe)
+void geng::serial::FileCommandWriter::WritePreamble(IWriteStream* pStream,
+	const std::shared_ptr<IPacket>& pDescriptionPacket,
+	const std::vector<std::shared_ptr<ISerializableCommand> >& commandList,
+	const CommandStartState* pStartState)
 {
-	SubID cmdIdx{ 0 };
-	for (Command_& cmd : pThis->m_commands)
+	pDescriptionPacket->Write(pStream);
+
+	// The start state, if any:  frame, size, then the state itself
+	if (pStartState)
 	{
-		if (subscribe)
-		{
-			cmd.pCommand->Subscribe(pThis, cmdIdx);
-		}
-		else
+		uint32_t startFrame = (uint32_t)pStartState->frame;
+		uint32_t stateSize = (uint32_t)pStartState->gameState.size();
+		pStream->Write(&startFrame, sizeof(startFrame));
+		pStream->Write(&stateSize, sizeof(stateSize));
+		pStream->Write(pStartState->gameState.data(), stateSize);
+	}
+
+	for (auto& pCommand : commandList)
+	{
+		std::string cmdKey{ pCommand->GetKey() };
+
+		if (!CanWriteKey(cmdKey))
 		{
-			cmd.pCommand->Unsubscribe(pThis);
+			continue;
 		}
-		++cmdIdx;
+		
+		uint16_t keySize = (uint16_t)(cmdKey.size());
+		pStream->Write(&keySize, sizeof(keySize));
+		pStream->Write(cmdKey.c_str(), keySize);
 	}
+
+	const uint16_t endMarker{ 0 };
+	pStream->Write(&endMarker, sizeof(endMarker));
+}
+
+bool geng::serial::FileCommandWriter::CanWriteKey(const std::string& cmdKey)
+{
+	return !cmdKey.empty() && cmdKey.size() <= std::numeric_limits<uint16_t>::max();
 }
 
 void geng::serial::FileCommandWriter::BeginFrame(unsigned long currentFrame)
@@ -73,33 +101,26 @@ void geng::serial::FileCommandWriter::BeginFrame(unsigned long currentFrame)
 	m_currentFrame = currentFrame;
 }
 
-void geng::serial::FileCommandWriter::OnCommandChanged(SubID subId,
-	const ICommand& cmd)
+void geng::serial::FileCommandWriter::EndFrame(const CommandChangeList& changes)
 {
-//	fprintf(stderr, "cmdwriter %p subid %llu commands size %llu\n", this, subId, m_commands.size());
-	Command_& cmdObject = m_commands[subId];
-
-	bool hadDelta{ false };
-	if (cmdObject.lastUpdatedFrame == INITIAL_FRAME_TAG ||
-		cmdObject.lastUpdatedFrame < m_currentFrame)
+	for (uint32_t changeIndex : changes)
 	{
+		uint32_t commandSlot = m_commandSlots[changeIndex];
+		if (commandSlot == NO_COMMAND_SLOT)
+		{
+			continue;
+		}
+
+		Command_& cmdObject = m_commands[commandSlot];
 		cmdObject.pDelta->OnCommand(*cmdObject.pCommand.get());
 
 		if (cmdObject.pDelta->HasDelta())
 		{
 			cmdObject.lastUpdatedFrame = m_currentFrame;
 			++m_frameChanges;
-			hadDelta = true;
 		}
 	}
 
-	//fprintf(stderr, "OnCommandChanged frame %lu subid %llu delta %d\n", m_currentFrame, subId, hadDelta);
-
-}
-
-
-void geng::serial::FileCommandWriter::EndFrame()
-{
 	if (m_frameChanges > 0)
 	{
 		SaveFrame(false);
@@ -150,6 +171,11 @@ void geng::serial::FileCommandWriter::SaveFrame(bool lastFrame)
 	}
 }
 
+bool geng::serial::FileCommandWriter::WriteFrames(const void* pData, size_t size)
+{
+	return m_fileStream.Write(pData, size) == size;
+}
+
 void geng::serial::FileCommandWriter::Flush()
 {
 	m_fileStream.Flush();
@@ -8,38 +8,46 @@
 namespace geng::serial
 {
 
-	class FileCommandWriter : public ICommandListener
+	class FileCommandWriter
 	{
 	private:
 		static constexpr unsigned long INITIAL_FRAME_TAG =
 			std::numeric_limits<unsigned long>::max();
+		static constexpr uint32_t NO_COMMAND_SLOT =
+			std::numeric_limits<uint32_t>::max();
 
 		struct Command_
 		{
 			std::shared_ptr<ISerializableCommand>  pCommand;
 			std::shared_ptr<ICommandDelta>  pDelta;
-			// Prevents changes from being applied twice
+			// The last frame with a delta; SaveFrame writes the commands changed in the current one
 			unsigned long lastUpdatedFrame{ INITIAL_FRAME_TAG };
 
 			Command_(const std::shared_ptr<ISerializableCommand>& pCommand_);
 		};
 	public:
+		// With a start state, the header must have hasStartState set.  The state is written
+		// after the description; the commands' own state at the start frame is up to the caller
 		FileCommandWriter(FileUPtr&& pFile,
 			const std::shared_ptr<IPacket>& pDescriptionPacket,
 			const std::vector<std::shared_ptr<ISerializableCommand> >& commandList,
-			const FileStreamHeader* pStreamHeader);
+			const FileStreamHeader* pStreamHeader,
+			const CommandStartState* pStartState = nullptr);
+
+		// Commands with keys that can't be written are left out of the file
+		static bool CanWriteKey(const std::string& cmdKey);
+		// What the constructor writes after the stream header:  the description, the start state
+		// and the command keys.  For files put together some other way
+		static void WritePreamble(IWriteStream* pStream,
+			const std::shared_ptr<IPacket>& pDescriptionPacket,
+			const std::vector<std::shared_ptr<ISerializableCommand> >& commandList,
+			const CommandStartState* pStartState);
 
-		// This is done thus strangely to avoid declaring the class enable_shared_from_this
-		// simply for this one step
-		static void SubscribeToCommands(const std::shared_ptr<FileCommandWriter>& pThis, 
-			bool subscribe = true);
-	
 		// Must be called before the commands are updated
 		void BeginFrame(unsigned long curFrame);
-		void OnCommandChanged(SubID subId,
-			const ICommand& cmd) override;
-		// Must be called after the commands are updated
-		void EndFrame();
+		// Must be called after the commands are updated.  The change list is indexed
+		// in the order of the command list given to the constructor
+		void EndFrame(const CommandChangeList& changes);
 		// Called at the end of the game
 		void EndSession();
 
@@ -51,6 +59,10 @@ namespace geng::serial
 			return m_error;
 		}
 
+		// Copy frames already serialized in the layout SaveFrame uses, with commands numbered
+		// as in the file (skipping the ones CanWriteKey refuses)
+		bool WriteFrames(const void* pData, size_t size);
+
 		void Flush();
 
 	private:
@@ -60,6 +72,9 @@ namespace geng::serial
 		bool m_hasChecksum{ false };
 
 		std::vector<Command_>   m_commands;
+		// Index into m_commands of every command in the constructor's list; commands that
+		// can't be written are left out
+		std::vector<uint32_t>  m_commandSlots;
 		unsigned long m_currentFrame{ 0 };
 
 		// We only write frames with at least one changed command
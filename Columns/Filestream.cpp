@@ -1,7 +1,9 @@
 #include "Filestream.h"
 #include "Packet.h"
 #include "ChecksumCalc.h"
+#include "LZBlockCodec.h"
 #include <cstring>
+#include <algorithm>
 
 #include <cassert>
 
@@ -74,7 +76,9 @@ bool geng::serial::FileReadStream::ProcessHeader()
 		return false;
 	}
 
-	FileStreamBase<IReadStream>::SetFormatVersion(formatVersion);
+	m_isCompressed = (formatVersion & STREAM_FLAG_COMPRESSED) != 0;
+	m_hasStartState = (formatVersion & STREAM_FLAG_START_STATE) != 0;
+	FileStreamBase<IReadStream>::SetFormatVersion(formatVersion & ~STREAM_FLAGS_MASK);
 
 	// Checksum
 	if (hdrSettings.hasChecksum)
@@ -143,13 +147,66 @@ size_t geng::serial::FileReadStream::Read(void* pBuff, size_t byteCount)
 		return 0;
 	}
 
-	// Read
-	size_t nRead = fread(pBuff, sizeof(uint8_t), byteCount, GetFile());
-	
-	SetValid(nRead == byteCount);
+	if (!m_isCompressed)
+	{
+		// Read
+		size_t nRead = fread(pBuff, sizeof(uint8_t), byteCount, GetFile());
+
+		SetValid(nRead == byteCount);
+		return nRead;
+	}
+
+	// Serve the request from the current block, loading blocks as they run out
+	uint8_t* pByteBuff = static_cast<uint8_t*>(pBuff);
+	size_t nRead{ 0 };
+	while (nRead < byteCount)
+	{
+		if (m_blockPos == m_block.size() && !LoadBlock())
+		{
+			SetValid(false);
+			break;
+		}
+		size_t numToCopy = std::min(byteCount - nRead, m_block.size() - m_blockPos);
+		memcpy(pByteBuff + nRead, m_block.data() + m_blockPos, numToCopy);
+		m_blockPos += numToCopy;
+		nRead += numToCopy;
+	}
+
 	return nRead;
 }
 
+bool geng::serial::FileReadStream::LoadBlock()
+{
+	// Each block is [raw size][stored size][stored bytes]; if the sizes match, the block is stored as is
+	uint32_t rawSize{ 0 };
+	uint32_t storedSize{ 0 };
+	if (fread(&rawSize, sizeof(rawSize), 1, GetFile()) != 1
+		|| fread(&storedSize, sizeof(storedSize), 1, GetFile()) != 1)
+	{
+		return false;
+	}
+
+	if (rawSize == 0 || rawSize > COMPRESSED_BLOCK_SIZE 
+		|| storedSize == 0 || storedSize > LZCompressBound(rawSize))
+	{
+		return false;
+	}
+
+	m_block.resize(rawSize);
+	m_blockPos = 0;
+	if (storedSize == rawSize)
+	{
+		return fread(m_block.data(), sizeof(uint8_t), rawSize, GetFile()) == rawSize;
+	}
+
+	m_storedBlock.resize(storedSize);
+	if (fread(m_storedBlock.data(), sizeof(uint8_t), storedSize, GetFile()) != storedSize)
+	{
+		return false;
+	}
+	return LZDecompressBlock(m_storedBlock.data(), storedSize, m_block.data(), rawSize);
+}
+
 // FileWriteStream
 geng::serial::FileWriteStream::FileWriteStream(FileUPtr&& pFile, const FileStreamHeader* pHeader)
 :FileStreamBase<IWriteStream>(std::move(pFile), pHeader)
@@ -164,11 +221,27 @@ geng::serial::FileWriteStream::FileWriteStream(FileUPtr&& pFile, const FileStrea
 			m_checksumCalc.emplace();
 			m_checksumCalc->Seed(hdrSettings.checksumSeed);
 		}
+
+		m_isCompressed = hdrSettings.isCompressed;
+		if (m_isCompressed)
+		{
+			m_block.reserve(COMPRESSED_BLOCK_SIZE);
+			m_storedBlock.resize(LZCompressBound(COMPRESSED_BLOCK_SIZE));
+		}
 	}
 
 	SetValid(true);
 }
 
+geng::serial::FileWriteStream::~FileWriteStream()
+{
+	// Don't lose a partially filled block
+	if (GetFile())
+	{
+		FlushBlock();
+	}
+}
+
 bool geng::serial::FileWriteStream::CanWrite(size_t byteCount)
 {
 	if (!IsValid())
@@ -186,6 +259,32 @@ size_t geng::serial::FileWriteStream::Write(const void* pBuff, size_t byteCount)
 		return 0;
 	}
 
+	if (!m_isCompressed)
+	{
+		return WriteToFile(pBuff, byteCount);
+	}
+
+	// Accumulate the bytes into blocks and compress each block once it fills up
+	const uint8_t* pByteBuff = static_cast<const uint8_t*>(pBuff);
+	size_t nWritten{ 0 };
+	while (nWritten < byteCount)
+	{
+		size_t numToCopy = std::min(byteCount - nWritten, COMPRESSED_BLOCK_SIZE - m_block.size());
+		m_block.insert(m_block.end(), pByteBuff + nWritten, pByteBuff + nWritten + numToCopy);
+		nWritten += numToCopy;
+		if (m_block.size() == COMPRESSED_BLOCK_SIZE && !FlushBlock())
+		{
+			return 0;
+		}
+	}
+
+	return nWritten;
+}
+
+size_t geng::serial::FileWriteStream::WriteToFile(const void* pBuff, size_t byteCount)
+{
+	// The checksum covers the bytes as they appear in the file, so that it can be verified
+	// without decompressing anything
 	if (m_checksumCalc.has_value())
 	{
 		if (!m_checksumCalc->UpdateChecksum(pBuff, byteCount))
@@ -204,54 +303,64 @@ bool geng::serial::FileWriteStream::WriteHeader()
 {
 	if (FileStreamBase<IWriteStream>::HasHeader())
 	{
-		// Write the header to the beginning of the file, and save the position of the checksum
-		const FileStreamHeader& hdrSettings = FileStreamBase<IWriteStream>::GetHeader();
-
 		if (ftell(GetFile()) != 0)
 		{
 			return false;
 		}
 
-		// Write the signature string
-		if (!hdrSettings.headerConstant.empty())
-		{
-			using THeaderChar = decltype(hdrSettings.headerConstant)::value_type;
-			auto hdrLength = hdrSettings.headerConstant.size();
-
-			if (fwrite(hdrSettings.headerConstant.data(),
-				sizeof(THeaderChar),
-				hdrLength,
-				GetFile()) != hdrLength)
-			{
-				return false;
-			}
-		}
-
-		// Write the version number
-		if (fwrite(&hdrSettings.versionNo, sizeof(hdrSettings.versionNo), 1, GetFile())
-			!= 1)
-		{
-			return false;
-		}
-
-		// Save the position of the checksum to overwrite it later
-		m_checksumPos = ftell(GetFile());
-
-		static ChecksumRecord blankChecksum{};
-		if (fwrite(&blankChecksum, sizeof(blankChecksum), 1, GetFile())
-			!= 1)
+		// Write the header to the beginning of the file, and save the position of the checksum
+		std::vector<uint8_t> headerBytes;
+		EncodeHeader(FileStreamBase<IWriteStream>::GetHeader(), headerBytes);
+		if (fwrite(headerBytes.data(), sizeof(uint8_t), headerBytes.size(), GetFile())
+			!= headerBytes.size())
 		{
 			return false;
 		}
 
+		m_checksumPos = (long int)(headerBytes.size() - sizeof(ChecksumRecord));
 		return true;
 	}
 
 	return false;
 }
 
+void geng::serial::FileWriteStream::EncodeHeader(const FileStreamHeader& rHeader, std::vector<uint8_t>& rBytes)
+{
+	auto append = [&rBytes](const void* pData, size_t size)
+	{
+		const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+		rBytes.insert(rBytes.end(), pBytes, pBytes + size);
+	};
+
+	// The signature string
+	using THeaderChar = decltype(rHeader.headerConstant)::value_type;
+	append(rHeader.headerConstant.data(), rHeader.headerConstant.size() * sizeof(THeaderChar));
+
+	// The version number, along with the flags
+	TFormatVersion versionWord = rHeader.versionNo & ~STREAM_FLAGS_MASK;
+	if (rHeader.isCompressed)
+	{
+		versionWord |= STREAM_FLAG_COMPRESSED;
+	}
+	if (rHeader.hasStartState)
+	{
+		versionWord |= STREAM_FLAG_START_STATE;
+	}
+	append(&versionWord, sizeof(versionWord));
+
+	// Overwritten by WriteChecksum()
+	static ChecksumRecord blankChecksum{};
+	append(&blankChecksum, sizeof(blankChecksum));
+}
+
 bool geng::serial::FileWriteStream::WriteChecksum()
 {
+	// The last block has to make it into the checksum
+	if (!FlushBlock())
+	{
+		return false;
+	}
+
 	if (m_checksumCalc.has_value())
 	{
 		// Go to the beginning, where the checksum needs to be recorded
@@ -274,7 +383,47 @@ bool geng::serial::FileWriteStream::WriteChecksum()
 
 bool geng::serial::FileWriteStream::Flush()
 {
+	if (!FlushBlock())
+	{
+		return false;
+	}
+
 	auto flushRet = fflush(GetFile());
 
 	return flushRet == 0;
+}
+
+bool geng::serial::FileWriteStream::FlushBlock()
+{
+	if (!m_isCompressed || m_block.empty())
+	{
+		return true;
+	}
+
+	if (!IsValid())
+	{
+		return false;
+	}
+
+	uint32_t rawSize = (uint32_t)m_block.size();
+	uint32_t storedSize = (uint32_t)LZCompressBlock(m_block.data(), m_block.size(),
+		m_storedBlock.data(), m_storedBlock.size());
+	
+	// Store the block as is if compression doesn't help
+	const uint8_t* pStored = m_storedBlock.data();
+	if (storedSize == 0 || storedSize >= rawSize)
+	{
+		storedSize = rawSize;
+		pStored = m_block.data();
+	}
+	
+	m_block.clear();
+	if (WriteToFile(&rawSize, sizeof(rawSize)) != sizeof(rawSize)
+		|| WriteToFile(&storedSize, sizeof(storedSize)) != sizeof(storedSize)
+		|| WriteToFile(pStored, storedSize) != storedSize)
+	{
+		return false;
+	}
+
+	return true;
 }
\ No newline at end of file
@@ -6,10 +6,20 @@
 #include <optional>
 #include <string>
 #include <random>
+#include <vector>
 
 namespace geng::serial
 {
+	// Stream flags share the version word in the header.  Versions never come near the high bits,
+	// so files written before the flags existed read back as uncompressed
+	constexpr TFormatVersion STREAM_FLAG_COMPRESSED = 0x80000000;
+	// The payload picks up from a saved state rather than from the beginning.  The stream only
+	// carries the bit; the layer above knows what the state looks like
+	constexpr TFormatVersion STREAM_FLAG_START_STATE = 0x40000000;
+	constexpr TFormatVersion STREAM_FLAGS_MASK = 0xff000000;
 
+	// Size of the uncompressed payload of a single compressed block
+	constexpr size_t COMPRESSED_BLOCK_SIZE = 64 * 1024;
 
 	struct FileStreamHeader
 	{
@@ -17,6 +27,10 @@ namespace geng::serial
 		TFormatVersion versionNo;
 		bool hasChecksum;
 		unsigned long long checksumSeed;
+		// Everything after the header is written as a sequence of independently compressed blocks
+		bool isCompressed{ false };
+		// Sets STREAM_FLAG_START_STATE
+		bool hasStartState{ false };
 	};
 
 	enum class FileValidityCheckResult
@@ -98,22 +112,42 @@ namespace geng::serial
 			return m_checkResult;
 		}
 
+		bool IsCompressed() const
+		{
+			return m_isCompressed;
+		}
+
+		bool HasStartState() const
+		{
+			return m_hasStartState;
+		}
+
 		// WARNING:  Due to the way C file IO works, this function always returns true
 		bool CanRead(size_t byteCount) override;
 		size_t Read(void* pBuff, size_t byteCount) override;
 
 	private:
 		bool ProcessHeader();
+		bool LoadBlock();
 
 		FileValidityCheckResult m_checkResult{ FileValidityCheckResult::NoFile };
+
+		bool m_isCompressed{ false };
+		bool m_hasStartState{ false };
+		std::vector<uint8_t> m_block;
+		std::vector<uint8_t> m_storedBlock;
+		size_t m_blockPos{ 0 };
 	};
 
 	class FileWriteStream : public FileStreamBase<IWriteStream>
 	{
 	public:
 		FileWriteStream(FileUPtr&& pFile, const FileStreamHeader* pHeader = nullptr);
+		~FileWriteStream();
 
 		bool WriteHeader();
+		// The bytes WriteHeader() writes, ending with a blank checksum record
+		static void EncodeHeader(const FileStreamHeader& rHeader, std::vector<uint8_t>& rBytes);
 		// Should be called at the end of all write operations
 		// Rewinds the file pointer to the beginning and 
 		bool WriteChecksum(); 
@@ -123,10 +157,17 @@ namespace geng::serial
 		bool Flush() override;
 
 	private:
+		size_t WriteToFile(const void* pBuff, size_t byteCount);
+		bool FlushBlock();
+
 		bool m_headerWritten{ false };
 		long int m_checksumPos{ 0 };
 
 		std::optional<ChecksumCalculator> m_checksumCalc;
+
+		bool m_isCompressed{ false };
+		std::vector<uint8_t> m_block;
+		std::vector<uint8_t> m_storedBlock;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,461 @@
+#include "FlightRecorder.h"
+#include "FileCommandWriter.h"
+#include "CommandManager.h"
+
+#include <csignal>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace
+{
+	geng::FlightRecorder* s_pCrashRecorder{ nullptr };
+
+	// Plain file descriptors, since the crash dump is written from a signal handler
+
+#ifdef _WIN32
+	int OpenCrashFile(const char* pFileName, bool& rCreated)
+	{
+		int file = _open(pFileName, _O_WRONLY | _O_BINARY | _O_CREAT | _O_EXCL, _S_IREAD | _S_IWRITE);
+		rCreated = file >= 0;
+		return rCreated ? file : _open(pFileName, _O_WRONLY | _O_BINARY);
+	}
+
+	bool WriteCrashBytes(int file, const void* pData, size_t size)
+	{
+		const char* pBytes = static_cast<const char*>(pData);
+		while (size > 0)
+		{
+			unsigned int chunk = size > 0x40000000 ? 0x40000000 : (unsigned int)size;
+			int nWritten = _write(file, pBytes, chunk);
+			if (nWritten <= 0)
+			{
+				return false;
+			}
+			pBytes += nWritten;
+			size -= (size_t)nWritten;
+		}
+		return true;
+	}
+
+	bool RewindCrashFile(int file) { return _lseek(file, 0, SEEK_SET) == 0; }
+	void EndCrashFile(int file, size_t size) { _chsize(file, (long)size); }
+	bool IsCrashFileEmpty(int file) { return _lseek(file, 0, SEEK_END) == 0; }
+	void CloseCrashFileHandle(int file) { _close(file); }
+#else
+	int OpenCrashFile(const char* pFileName, bool& rCreated)
+	{
+		int file = open(pFileName, O_WRONLY | O_CREAT | O_EXCL, 0644);
+		rCreated = file >= 0;
+		return rCreated ? file : open(pFileName, O_WRONLY);
+	}
+
+	bool WriteCrashBytes(int file, const void* pData, size_t size)
+	{
+		const char* pBytes = static_cast<const char*>(pData);
+		while (size > 0)
+		{
+			ssize_t nWritten = write(file, pBytes, size);
+			if (nWritten < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (nWritten <= 0)
+			{
+				return false;
+			}
+			pBytes += nWritten;
+			size -= (size_t)nWritten;
+		}
+		return true;
+	}
+
+	bool RewindCrashFile(int file) { return lseek(file, 0, SEEK_SET) == 0; }
+	void EndCrashFile(int file, size_t size) { (void)ftruncate(file, (off_t)size); }
+	bool IsCrashFileEmpty(int file) { return lseek(file, 0, SEEK_END) == 0; }
+	void CloseCrashFileHandle(int file) { close(file); }
+#endif
+
+	// Frame records have the layout FileCommandWriter gives them
+	void WriteFrameRecord(geng::serial::IWriteStream* pStream,
+		unsigned long frame,
+		uint32_t changeCount,
+		const geng::serial::MemoryWriteStream& deltaStream)
+	{
+		uint32_t frameNumber = (uint32_t)frame;
+		pStream->Write(&frameNumber, sizeof(frameNumber));
+		pStream->Write(&changeCount, sizeof(changeCount));
+		pStream->Write(deltaStream.GetData(), deltaStream.GetSize());
+	}
+}
+
+geng::FlightRecorder::Command_::Command_(const std::shared_ptr<serial::ISerializableCommand>& pCommand_)
+	:pCommand(pCommand_)
+{
+	pDelta.reset(pCommand->AllocateDeltaObject());
+}
+
+geng::FlightRecorder::FlightRecorder(unsigned long retainFrames, unsigned long snapshotInterval)
+	:m_retainFrames(retainFrames),
+	m_snapshotInterval(snapshotInterval > 0 ? snapshotInterval : 1)
+{
+
+}
+
+geng::FlightRecorder::~FlightRecorder()
+{
+	if (s_pCrashRecorder == this)
+	{
+		s_pCrashRecorder = nullptr;
+	}
+	CloseCrashFile();
+}
+
+void geng::FlightRecorder::BeginSession(const char* pGameName,
+	uint32_t formatVersion,
+	const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
+	const std::vector<std::shared_ptr<serial::ISerializableCommand> >& commandList,
+	const serial::CommandStartState* pStartState)
+{
+	m_gameName = pGameName;
+	m_formatVersion = formatVersion;
+	m_pDescriptionPacket = pDescriptionPacket;
+	m_commandList = commandList;
+
+	m_commands.clear();
+	m_commandSlots.clear();
+	for (const auto& pCommand : commandList)
+	{
+		if (!serial::FileCommandWriter::CanWriteKey(pCommand->GetKey()))
+		{
+			m_commandSlots.push_back(NO_COMMAND_SLOT);
+			continue;
+		}
+		m_commandSlots.push_back((uint32_t)m_commands.size());
+		m_commands.emplace_back(pCommand);
+	}
+
+	// The first segment starts with the game; its commands come in with the first frame
+	m_segments.clear();
+	m_segments.emplace_back();
+	if (pStartState)
+	{
+		m_segments.back().startState = *pStartState;
+	}
+
+	m_currentFrame = m_segments.back().startState.frame;
+	m_inSession = true;
+
+	if (m_dumpsOnCrash)
+	{
+		PrepareCrashHeader(m_segments.front());
+	}
+}
+
+void geng::FlightRecorder::BeginFrame(unsigned long curFrame)
+{
+	m_currentFrame = curFrame;
+}
+
+void geng::FlightRecorder::EndFrame(const CommandChangeList& changes)
+{
+	if (!m_inSession)
+	{
+		return;
+	}
+
+	m_deltaStream.Clear();
+	uint32_t changeCount{ 0 };
+	for (uint32_t changeIndex : changes)
+	{
+		uint32_t commandSlot = m_commandSlots[changeIndex];
+		if (commandSlot == NO_COMMAND_SLOT)
+		{
+			continue;
+		}
+
+		Command_& cmdObject = m_commands[commandSlot];
+		cmdObject.pDelta->OnCommand(*cmdObject.pCommand);
+		if (cmdObject.pDelta->HasDelta())
+		{
+			m_deltaStream.Write(&commandSlot, sizeof(commandSlot));
+			cmdObject.pDelta->Write(&m_deltaStream);
+			++changeCount;
+		}
+	}
+
+	if (changeCount > 0)
+	{
+		WriteFrameRecord(&m_segments.back().frames, m_currentFrame, changeCount, m_deltaStream);
+	}
+}
+
+void geng::FlightRecorder::EndSession()
+{
+	m_inSession = false;
+}
+
+void geng::FlightRecorder::AddSnapshot(unsigned long frame, const void* pState, size_t stateSize)
+{
+	if (!m_inSession)
+	{
+		return;
+	}
+
+	m_segments.emplace_back();
+	Segment_& segment = m_segments.back();
+	segment.startState.frame = frame;
+	const uint8_t* pStateBytes = static_cast<const uint8_t*>(pState);
+	segment.startState.gameState.assign(pStateBytes, pStateBytes + stateSize);
+
+	// The commands as they are now, against their default state
+	m_deltaStream.Clear();
+	uint32_t changeCount{ 0 };
+	for (uint32_t commandSlot = 0; commandSlot < m_commands.size(); ++commandSlot)
+	{
+		std::unique_ptr<serial::ICommandDelta> pDefaultDelta{ m_commands[commandSlot].pCommand->AllocateDeltaObject() };
+		pDefaultDelta->OnCommand(*m_commands[commandSlot].pCommand);
+		if (pDefaultDelta->HasDelta())
+		{
+			m_deltaStream.Write(&commandSlot, sizeof(commandSlot));
+			pDefaultDelta->Write(&m_deltaStream);
+			++changeCount;
+		}
+	}
+
+	if (changeCount > 0)
+	{
+		serial::MemoryWriteStream commandStream;
+		WriteFrameRecord(&commandStream, frame, changeCount, m_deltaStream);
+		segment.startCommands.assign(commandStream.GetData(), commandStream.GetData() + commandStream.GetSize());
+	}
+
+	// The oldest segments can go once the next one alone covers the retained frames
+	size_t dropCount{ 0 };
+	while (m_segments.size() > dropCount + 1
+		&& m_segments[dropCount + 1].startState.frame + m_retainFrames <= frame)
+	{
+		++dropCount;
+	}
+
+	if (dropCount > 0)
+	{
+		// A crash dump leaves out the segments before the one its header starts with, so the
+		// header can go first
+		if (m_dumpsOnCrash)
+		{
+			PrepareCrashHeader(m_segments[dropCount]);
+		}
+		m_segments.erase(m_segments.begin(), m_segments.begin() + dropCount);
+	}
+}
+
+unsigned long geng::FlightRecorder::GetFirstFrame() const
+{
+	return m_segments.empty() ? 0 : m_segments.front().startState.frame;
+}
+
+bool geng::FlightRecorder::Dump(const char* pFileName, bool compress)
+{
+	if (m_segments.empty())
+	{
+		m_error = "Flight recorder: nothing has been recorded";
+		return false;
+	}
+
+	const Segment_& firstSegment = m_segments.front();
+	bool hasStartState = !firstSegment.startState.gameState.empty();
+
+	FileUPtr filePtr{ fopen(pFileName, "wb") };
+	if (!filePtr)
+	{
+		m_error = "Flight recorder: could not open file for writing: ";
+		m_error += pFileName;
+		return false;
+	}
+
+	serial::FileStreamHeader hdrDesc;
+	CommandManager::GetDemoHeader(hdrDesc, m_gameName.c_str(), m_formatVersion, compress);
+	hdrDesc.hasStartState = hasStartState;
+
+	serial::FileCommandWriter demoWriter(std::move(filePtr),
+		m_pDescriptionPacket,
+		m_commandList,
+		&hdrDesc,
+		hasStartState ? &firstSegment.startState : nullptr);
+	if (!demoWriter.IsValid())
+	{
+		m_error = demoWriter.GetError().empty() ? "Flight recorder: could not write the demo header"
+			: demoWriter.GetError();
+		return false;
+	}
+
+	bool writeOK = demoWriter.WriteFrames(firstSegment.startCommands.data(), firstSegment.startCommands.size());
+	for (const Segment_& segment : m_segments)
+	{
+		writeOK = writeOK && demoWriter.WriteFrames(segment.frames.GetData(), segment.frames.GetSize());
+	}
+
+	// The end marker goes on the last frame seen
+	demoWriter.BeginFrame(m_currentFrame);
+	demoWriter.EndSession();
+
+	if (!writeOK)
+	{
+		m_error = "Flight recorder: could not write the frames";
+		return false;
+	}
+	return true;
+}
+
+bool geng::FlightRecorder::DumpOnCrash(FlightRecorder* pRecorder, const char* pFileName)
+{
+	if (s_pCrashRecorder)
+	{
+		FlightRecorder* pPrevious = s_pCrashRecorder;
+		s_pCrashRecorder = nullptr;
+		pPrevious->CloseCrashFile();
+	}
+
+	if (!pRecorder)
+	{
+		return true;
+	}
+
+	pRecorder->CloseCrashFile();
+	pRecorder->m_crashFile = OpenCrashFile(pFileName, pRecorder->m_crashFileCreated);
+	if (pRecorder->m_crashFile < 0)
+	{
+		pRecorder->m_error = "Flight recorder: could not open the crash dump file: ";
+		pRecorder->m_error += pFileName;
+		return false;
+	}
+	pRecorder->m_crashFileName = pFileName;
+	pRecorder->m_dumpsOnCrash = true;
+	if (!pRecorder->m_segments.empty())
+	{
+		pRecorder->PrepareCrashHeader(pRecorder->m_segments.front());
+	}
+
+	s_pCrashRecorder = pRecorder;
+	for (int signalNo : { SIGSEGV, SIGABRT, SIGFPE, SIGILL })
+	{
+		signal(signalNo, OnCrashSignal);
+	}
+	return true;
+}
+
+void geng::FlightRecorder::OnCrashSignal(int signalNo)
+{
+	// Only once, even if the dump itself crashes
+	FlightRecorder* pRecorder = s_pCrashRecorder;
+	s_pCrashRecorder = nullptr;
+	if (pRecorder)
+	{
+		pRecorder->WriteCrashDump();
+	}
+
+	signal(signalNo, SIG_DFL);
+	raise(signalNo);
+}
+
+void geng::FlightRecorder::PrepareCrashHeader(const Segment_& firstSegment)
+{
+	bool hasStartState = !firstSegment.startState.gameState.empty();
+
+	serial::FileStreamHeader hdrDesc;
+	CommandManager::GetDemoHeader(hdrDesc, m_gameName.c_str(), m_formatVersion, false);
+	hdrDesc.hasStartState = hasStartState;
+
+	std::vector<uint8_t> crashHeader;
+	serial::FileWriteStream::EncodeHeader(hdrDesc, crashHeader);
+	size_t payloadPos = crashHeader.size();
+
+	serial::MemoryWriteStream preamble;
+	serial::FileCommandWriter::WritePreamble(&preamble,
+		m_pDescriptionPacket,
+		m_commandList,
+		hasStartState ? &firstSegment.startState : nullptr);
+	preamble.Write(firstSegment.startCommands.data(), firstSegment.startCommands.size());
+	crashHeader.insert(crashHeader.end(), preamble.GetData(), preamble.GetData() + preamble.GetSize());
+
+	if (m_crashHeader.empty())
+	{
+		m_crashChecksum.Seed(hdrDesc.checksumSeed);
+	}
+	m_crashHeader.swap(crashHeader);
+	m_crashPayloadPos = payloadPos;
+	m_crashStartFrame = firstSegment.startState.frame;
+}
+
+void geng::FlightRecorder::WriteCrashDump() const
+{
+	if (m_crashFile < 0 || m_crashHeader.empty())
+	{
+		return;
+	}
+
+	// The end marker goes on the last frame seen, as in Dump()
+	const uint32_t endRecord[2] = { (uint32_t)m_currentFrame, 0 };
+
+	// Everything after the stream header is checksummed
+	serial::ChecksumCalculator checksumCalc = m_crashChecksum;
+	checksumCalc.UpdateChecksum(m_crashHeader.data() + m_crashPayloadPos, m_crashHeader.size() - m_crashPayloadPos);
+	size_t fileSize = m_crashHeader.size() + sizeof(endRecord);
+	for (const Segment_& segment : m_segments)
+	{
+		if (segment.startState.frame >= m_crashStartFrame)
+		{
+			checksumCalc.UpdateChecksum(segment.frames.GetData(), segment.frames.GetSize());
+			fileSize += segment.frames.GetSize();
+		}
+	}
+	checksumCalc.UpdateChecksum(endRecord, sizeof(endRecord));
+
+	serial::ChecksumRecord csRecord{ true, checksumCalc.FinalizeChecksum() };
+	size_t checksumPos = m_crashPayloadPos - sizeof(csRecord);
+
+	bool writeOK = RewindCrashFile(m_crashFile)
+		&& WriteCrashBytes(m_crashFile, m_crashHeader.data(), checksumPos)
+		&& WriteCrashBytes(m_crashFile, &csRecord, sizeof(csRecord))
+		&& WriteCrashBytes(m_crashFile, m_crashHeader.data() + m_crashPayloadPos, m_crashHeader.size() - m_crashPayloadPos);
+	for (const Segment_& segment : m_segments)
+	{
+		if (writeOK && segment.startState.frame >= m_crashStartFrame)
+		{
+			writeOK = WriteCrashBytes(m_crashFile, segment.frames.GetData(), segment.frames.GetSize());
+		}
+	}
+	if (writeOK && WriteCrashBytes(m_crashFile, endRecord, sizeof(endRecord)))
+	{
+		// What a longer file had left there
+		EndCrashFile(m_crashFile, fileSize);
+	}
+}
+
+void geng::FlightRecorder::CloseCrashFile()
+{
+	m_dumpsOnCrash = false;
+	m_crashHeader.clear();
+	if (m_crashFile < 0)
+	{
+		return;
+	}
+
+	// Don't leave behind an empty file that was only made for a crash that never came
+	bool unused = m_crashFileCreated && IsCrashFileEmpty(m_crashFile);
+	CloseCrashFileHandle(m_crashFile);
+	m_crashFile = -1;
+	if (unused)
+	{
+		std::remove(m_crashFileName.c_str());
+	}
+}
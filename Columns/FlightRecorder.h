@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SerializedCommands.h"
+#include "MemoryStream.h"
+#include "ChecksumCalc.h"
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <string>
+#include <limits>
+
+namespace geng
+{
+	// Keeps the last stretch of a game in memory:  the description packet, the game's saved
+	// state every so often, and the command deltas since.  At any time, what's held can be
+	// written out as a demo that starts from the oldest saved state.
+	// A frame costs no more than the deltas of the commands that changed in it
+	class FlightRecorder
+	{
+	private:
+		static constexpr uint32_t NO_COMMAND_SLOT =
+			std::numeric_limits<uint32_t>::max();
+
+		struct Command_
+		{
+			std::shared_ptr<serial::ISerializableCommand>  pCommand;
+			std::unique_ptr<serial::ICommandDelta>  pDelta;
+
+			Command_(const std::shared_ptr<serial::ISerializableCommand>& pCommand_);
+		};
+
+		// The frames from one saved state up to the next
+		struct Segment_
+		{
+			// The game state at the end of the start frame; no state for the start of a game
+			serial::CommandStartState startState;
+			// The commands at the end of the start frame, as a frame record
+			std::vector<uint8_t> startCommands;
+			// Records of the frames after the start frame
+			serial::MemoryWriteStream frames;
+		};
+
+	public:
+		// At least retainFrames frames are kept; the game is asked for its state every snapshotInterval
+		FlightRecorder(unsigned long retainFrames, unsigned long snapshotInterval);
+		~FlightRecorder();
+
+		FlightRecorder(const FlightRecorder&) = delete;
+		FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+		// Drops whatever the last session left.  Give the start state if the game doesn't start
+		// from the beginning
+		void BeginSession(const char* pGameName,
+			uint32_t formatVersion,
+			const std::shared_ptr<serial::IPacket>& pDescriptionPacket,
+			const std::vector<std::shared_ptr<serial::ISerializableCommand> >& commandList,
+			const serial::CommandStartState* pStartState = nullptr);
+		void BeginFrame(unsigned long curFrame);
+		// The change list is indexed in the order of the session's command list
+		void EndFrame(const CommandChangeList& changes);
+		// The frames are kept until the next session, so the game that just ended can be dumped
+		void EndSession();
+
+		// The game should hand over its state at the end of this frame
+		bool IsSnapshotDue(unsigned long frame) const
+		{
+			return m_inSession && frame >= m_segments.back().startState.frame + m_snapshotInterval;
+		}
+
+		// Start a new segment from the game's state at the end of the frame.  Segments no longer
+		// needed to cover the retained frames are dropped
+		void AddSnapshot(unsigned long frame, const void* pState, size_t stateSize);
+
+		bool HasFrames() const { return !m_segments.empty(); }
+		unsigned long GetFirstFrame() const;
+
+		// Write out everything held as a demo file
+		bool Dump(const char* pFileName, bool compress);
+
+		// Dump to the file if the process crashes.  The file is opened now (but not emptied), and
+		// the recorder keeps its demo header ready, so that the dump only has to write bytes that
+		// are already in memory:  a crash may leave the heap unusable.  Crash dumps are never
+		// compressed.  This is best effort:  the crash may have happened in the middle of a frame,
+		// or in the recorder itself.  Pass a null recorder to stop
+		static bool DumpOnCrash(FlightRecorder* pRecorder, const char* pFileName);
+
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		// Renews the crash image's header for a demo that starts with the segment
+		void PrepareCrashHeader(const Segment_& firstSegment);
+		// Safe in a signal handler:  no allocation, no locks, only writes to the open file
+		void WriteCrashDump() const;
+		void CloseCrashFile();
+		static void OnCrashSignal(int signalNo);
+
+		unsigned long m_retainFrames;
+		unsigned long m_snapshotInterval;
+
+		std::string m_gameName;
+		uint32_t m_formatVersion{ 0 };
+		std::shared_ptr<serial::IPacket> m_pDescriptionPacket;
+		std::vector<std::shared_ptr<serial::ISerializableCommand> > m_commandList;
+		std::vector<Command_> m_commands;
+		// Index into m_commands, and the file, of every command in the session's list
+		std::vector<uint32_t> m_commandSlots;
+
+		std::deque<Segment_> m_segments;
+		bool m_inSession{ false };
+		unsigned long m_currentFrame{ 0 };
+
+		// Reused from frame to frame
+		serial::MemoryWriteStream m_deltaStream;
+
+		// For crash dumps:  the demo up to the first segment's frames, with the checksum left
+		// blank, and the checksum's state before anything is added to it
+		bool m_dumpsOnCrash{ false };
+		int m_crashFile{ -1 };
+		bool m_crashFileCreated{ false };
+		std::string m_crashFileName;
+		std::vector<uint8_t> m_crashHeader;
+		size_t m_crashPayloadPos{ 0 };
+		// The start of the segment the header was made for; older segments are left out
+		unsigned long m_crashStartFrame{ 0 };
+		serial::ChecksumCalculator m_crashChecksum;
+
+		std::string m_error;
+	};
+}
@@ -0,0 +1,240 @@
+#include "FrameExporter.h"
+#include "ColumnsExecutive.h"
+#include "ColumnsInput.h"
+#include "ColumnsSim.h"
+#include "Filestream.h"
+#include "Packet.h"
+
+#include <filesystem>
+#include <unordered_set>
+#include <string>
+#include <limits>
+
+geng::columns::FrameExporter::FrameExporter()
+	:ReplayObserver("FrameExporter")
+{ }
+
+bool geng::columns::FrameExporter::Initialize(const std::shared_ptr<IGame>& pGame)
+{
+	m_pColumnsInput = GetComponentAs<ColumnsInput>(pGame.get(), ColumnsExecutive::GetColumnsInputComponentName());
+	m_pColumnsSim = GetComponentAs<ColumnsSim>(pGame.get(), "ColumnsSim");
+
+	if (!m_pColumnsInput || !m_pColumnsSim)
+	{
+		pGame->LogError("FrameExporter: could not get the input or sim component");
+		return false;
+	}
+
+	m_columns.clear();
+	m_actionIds.clear();
+	m_rowCount = 0;
+
+	m_frameColumn = AddColumn("frame", 4);
+	// Only the recorded player's actions make it into a demo
+	m_firstActionColumn = m_columns.size();
+	for (ActionCommandID cmdId = 0; cmdId < m_pColumnsInput->GetActionCount(); ++cmdId)
+	{
+		if (m_pColumnsInput->GetActionPlayer(cmdId) == 0)
+		{
+			AddColumn(m_pColumnsInput->GetActionKey(cmdId).c_str(), 1);
+			m_actionIds.push_back(cmdId);
+		}
+	}
+	m_columnXColumn = AddColumn("columnX", 1);
+	m_columnYColumn = AddColumn("columnY", 1);
+	m_levelColumn = AddColumn("level", 2);
+	m_gemsColumn = AddColumn("gems", 4);
+	m_cascadeColumn = AddColumn("cascadeDepth", 1);
+
+	return true;
+}
+
+void geng::columns::FrameExporter::OnFrame(const SimState& rSimState,
+	const SimContextState* pContextState)
+{
+	if (!pContextState->runstate.curValue)
+	{
+		// The sim didn't advance, so there is no new row
+		return;
+	}
+
+	AppendValue(m_frameColumn, (uint32_t)m_pColumnsInput->GetFrameCount());
+	for (size_t actionIndex = 0; actionIndex < m_actionIds.size(); ++actionIndex)
+	{
+		AppendValue(m_firstActionColumn + actionIndex,
+			m_pColumnsInput->GetActionState(m_actionIds[actionIndex]) ? 1 : 0);
+	}
+
+	const PlayerSet* pPlayerColumn = m_pColumnsSim->GetPlayerColumn();
+	AppendValue(m_columnXColumn, pPlayerColumn ? pPlayerColumn->locCenter.x : NO_COLUMN_POSITION);
+	AppendValue(m_columnYColumn, pPlayerColumn ? pPlayerColumn->locCenter.y : NO_COLUMN_POSITION);
+	AppendValue(m_levelColumn, m_pColumnsSim->GetLevel());
+	AppendValue(m_gemsColumn, m_pColumnsSim->GetGems());
+	AppendValue(m_cascadeColumn, m_pColumnsSim->GetCascadeDepth());
+
+	++m_rowCount;
+}
+
+size_t geng::columns::FrameExporter::AddColumn(const char* pName, uint8_t width)
+{
+	m_columns.emplace_back(pName, width);
+	return m_columns.size() - 1;
+}
+
+void geng::columns::FrameExporter::AppendValue(size_t columnIndex, uint32_t value)
+{
+	Column_& column = m_columns[columnIndex];
+
+	// Clamp to the width of the column rather than wrap around
+	uint32_t maxValue = column.width >= 4 ? std::numeric_limits<uint32_t>::max()
+		: (uint32_t(1) << (8 * column.width)) - 1;
+	if (value > maxValue)
+	{
+		value = maxValue;
+	}
+
+	// Little-endian, regardless of the platform
+	for (uint8_t i = 0; i < column.width; ++i)
+	{
+		column.values.push_back((uint8_t)(value >> (8 * i)));
+	}
+}
+
+uint32_t geng::columns::FrameExporter::GetValue(const Column_& column, size_t rowIndex) const
+{
+	const uint8_t* pValue = column.values.data() + rowIndex * column.width;
+	uint32_t value = 0;
+	for (uint8_t i = 0; i < column.width; ++i)
+	{
+		value |= uint32_t(pValue[i]) << (8 * i);
+	}
+	return value;
+}
+
+bool geng::columns::FrameExporter::Write(const char* pFileName, FrameTableFormat format, std::string& rErr) const
+{
+	FileUPtr pFile = FUPtrOpen(pFileName, format == FrameTableFormat::Binary ? "wb" : "w");
+	if (!pFile)
+	{
+		rErr = "Could not open frame table for writing: ";
+		rErr += pFileName;
+		return false;
+	}
+
+	bool written = format == FrameTableFormat::Binary ? WriteBinary(std::move(pFile))
+		: WriteCSV(pFile.get());
+
+	if (!written)
+	{
+		rErr = "Could not write frame table: ";
+		rErr += pFileName;
+	}
+	return written;
+}
+
+bool geng::columns::FrameExporter::WriteBinary(FileUPtr&& pFile) const
+{
+	serial::FileStreamHeader hdrDesc;
+	hdrDesc.headerConstant = "FrameTable_";
+	hdrDesc.headerConstant += ColumnsExecutive::GetGameName();
+	hdrDesc.versionNo = FRAME_TABLE_VERSION;
+	hdrDesc.hasChecksum = true;
+	hdrDesc.checksumSeed = SEED_FRAME_TABLE_CHECKSUM;
+	// Most columns barely change from frame to frame, so they compress very well
+	hdrDesc.isCompressed = true;
+
+	serial::FileWriteStream fileStream(std::move(pFile), &hdrDesc);
+	if (!fileStream.WriteHeader())
+	{
+		return false;
+	}
+
+	if (!serial::EncodeData(&fileStream, (uint32_t)m_rowCount)
+		|| !serial::EncodeData(&fileStream, (uint16_t)m_columns.size()))
+	{
+		return false;
+	}
+
+	for (const Column_& column : m_columns)
+	{
+		if (!serial::EncodeData(&fileStream, (uint16_t)column.name.size())
+			|| fileStream.Write(column.name.data(), column.name.size()) != column.name.size()
+			|| !serial::EncodeData(&fileStream, column.width))
+		{
+			return false;
+		}
+	}
+
+	for (const Column_& column : m_columns)
+	{
+		if (!column.values.empty()
+			&& fileStream.Write(column.values.data(), column.values.size()) != column.values.size())
+		{
+			return false;
+		}
+	}
+
+	return fileStream.WriteChecksum();
+}
+
+bool geng::columns::FrameExporter::WriteCSV(FILE* pFile) const
+{
+	for (size_t columnIndex = 0; columnIndex < m_columns.size(); ++columnIndex)
+	{
+		fprintf(pFile, columnIndex == 0 ? "%s" : ",%s", m_columns[columnIndex].name.c_str());
+	}
+	fputc('\n', pFile);
+
+	for (size_t rowIndex = 0; rowIndex < m_rowCount; ++rowIndex)
+	{
+		for (size_t columnIndex = 0; columnIndex < m_columns.size(); ++columnIndex)
+		{
+			fprintf(pFile, columnIndex == 0 ? "%u" : ",%u", GetValue(m_columns[columnIndex], rowIndex));
+		}
+		fputc('\n', pFile);
+	}
+
+	return !ferror(pFile) && fflush(pFile) == 0;
+}
+
+void geng::columns::ExportDemoFile(const std::string& fileName, const std::string& outFileName, FrameTableFormat format,
+	const ReplayArgs& args, ReplayReport& report)
+{
+	auto pExporter = std::make_shared<FrameExporter>();
+	ReplayDemoFile(fileName, args, report, pExporter);
+
+	if (!report.parsed)
+	{
+		return;
+	}
+
+	pExporter->Write(outFileName.c_str(), format, report.error);
+}
+
+void geng::columns::ExportDemoFiles(const std::vector<std::string>& fileNames, const char* pOutDirectory,
+	FrameTableFormat format, const ReplayArgs& args, std::vector<ReplayReport>& reports)
+{
+	reports.clear();
+	reports.resize(fileNames.size());
+
+	const char* pExtension = format == FrameTableFormat::Binary ? ".cfr" : ".csv";
+
+	// The whole file name is kept, so demos that differ only in extension don't overwrite each other
+	std::vector<std::string> outFileNames;
+	std::unordered_set<std::string> usedNames;
+	for (const std::string& fileName : fileNames)
+	{
+		std::string baseName = std::filesystem::path(fileName).filename().string();
+		std::string outName = baseName + pExtension;
+		for (unsigned int copyIndex = 2; !usedNames.insert(outName).second; ++copyIndex)
+		{
+			outName = baseName + "-" + std::to_string(copyIndex) + pExtension;
+		}
+		outFileNames.emplace_back((std::filesystem::path(pOutDirectory) / outName).string());
+	}
+
+	ForEachInParallel(fileNames.size(), args.threadCount, [&](size_t fileIndex)
+		{
+			ExportDemoFile(fileNames[fileIndex], outFileNames[fileIndex], format, args, reports[fileIndex]);
+		});
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ReplayVerifier.h"
+#include "ColumnsData.h"
+#include "FileUtils.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+namespace geng::columns
+{
+	class ColumnsInput;
+	class ColumnsSim;
+
+	enum class FrameTableFormat
+	{
+		// Columnar binary (.cfr):  header, then rowCount (u32), columnCount (u16),
+		// for each column its name (u16 length + bytes) and value width in bytes (u8),
+		// then each column's values packed end to end.  Written compressed and checksummed
+		Binary,
+		// One line per frame (.csv); easy to read, much larger
+		CSV
+	};
+
+	constexpr uint32_t FRAME_TABLE_VERSION = 1;
+	constexpr unsigned long long SEED_FRAME_TABLE_CHECKSUM = 0x0f0e0c0a09080706;
+	// Stored in the one-byte position columns when there is no player column yet
+	constexpr uint32_t NO_COLUMN_POSITION = 255;
+
+	// Records one row per simulated frame of a replay:  the frame number, the state of every
+	// player-0 action and a few fields read back from the sim
+	class FrameExporter : public ReplayObserver
+	{
+	private:
+		struct Column_
+		{
+			std::string name;
+			uint8_t width;
+			std::vector<uint8_t> values;
+
+			Column_(const char* pName, uint8_t width_)
+				:name(pName),
+				width(width_)
+			{ }
+		};
+
+	public:
+		FrameExporter();
+
+		bool Initialize(const std::shared_ptr<IGame>& pGame) override;
+		void OnFrame(const SimState& rSimState,
+			const SimContextState* pContextState) override;
+
+		size_t GetRowCount() const { return m_rowCount; }
+
+		bool Write(const char* pFileName, FrameTableFormat format, std::string& rErr) const;
+
+	private:
+		size_t AddColumn(const char* pName, uint8_t width);
+		void AppendValue(size_t columnIndex, uint32_t value);
+		uint32_t GetValue(const Column_& column, size_t rowIndex) const;
+
+		bool WriteBinary(FileUPtr&& pFile) const;
+		bool WriteCSV(FILE* pFile) const;
+
+		std::shared_ptr<ColumnsInput> m_pColumnsInput;
+		std::shared_ptr<ColumnsSim> m_pColumnsSim;
+
+		// Action ids, in the same order as the action columns
+		std::vector<ActionCommandID> m_actionIds;
+		std::vector<Column_> m_columns;
+		size_t m_rowCount{ 0 };
+
+		size_t m_frameColumn{ 0 };
+		size_t m_firstActionColumn{ 0 };
+		size_t m_columnXColumn{ 0 };
+		size_t m_columnYColumn{ 0 };
+		size_t m_levelColumn{ 0 };
+		size_t m_gemsColumn{ 0 };
+		size_t m_cascadeColumn{ 0 };
+	};
+
+	// Replay a demo and write its frame table to outFileName.  The report is filled in as by ReplayDemoFile;
+	// a failure to write the table is reported in report.error
+	void ExportDemoFile(const std::string& fileName, const std::string& outFileName, FrameTableFormat format,
+		const ReplayArgs& args, ReplayReport& report);
+
+	// Export a batch of demos in parallel into pOutDirectory.  Each table is named after its demo's
+	// file name with the format's extension (.cfr or .csv) added; a name that comes up again in the
+	// batch (demos from different directories) gets a number as well
+	void ExportDemoFiles(const std::vector<std::string>& fileNames, const char* pOutDirectory,
+		FrameTableFormat format, const ReplayArgs& args, std::vector<ReplayReport>& reports);
+}
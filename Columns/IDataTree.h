@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cinttypes>
 #include <memory>
 #include <limits>
@@ -83,11 +84,64 @@ namespace geng::data
 		virtual void Set(double datum) = 0;
 
 		virtual bool Get(std::string& rDatum) const = 0;
+		// The text in place, without copying it; good until the element changes or goes
+		virtual bool Get(std::string_view& rDatum) const = 0;
 		virtual void Set(const char* datum) = 0;
 
 		virtual void Clear() = 0;  // reset to none
 	};
 
+	// A dictionary key hashed once, where it is made; constants can be hashed at compile time.
+	// Dictionaries that keep hashes look one up without hashing or copying it again.  The text must
+	// be null terminated, and outlive the key
+	class DictKey
+	{
+	public:
+		constexpr DictKey(const char* pText)
+			:m_pText(pText),
+			m_length(Length(pText)),
+			m_hash(Hash(pText, m_length))
+		{ }
+
+		constexpr DictKey(const char* pText, size_t length)
+			:m_pText(pText),
+			m_length(length),
+			m_hash(Hash(pText, length))
+		{ }
+
+		constexpr const char* GetText() const { return m_pText; }
+		constexpr size_t GetLength() const { return m_length; }
+		constexpr uint32_t GetHash() const { return m_hash; }
+
+		constexpr operator std::string_view() const { return std::string_view(m_pText, m_length); }
+
+		// FNV-1a, which every dictionary that keeps hashes uses
+		static constexpr uint32_t Hash(const char* pText, size_t length)
+		{
+			uint32_t hash = 2166136261u;
+			for (size_t i = 0; i < length; ++i)
+			{
+				hash = (hash ^ (unsigned char)pText[i]) * 16777619u;
+			}
+			return hash;
+		}
+
+	private:
+		static constexpr size_t Length(const char* pText)
+		{
+			size_t length = 0;
+			while (pText[length] != '\0')
+			{
+				++length;
+			}
+			return length;
+		}
+
+		const char* m_pText;
+		size_t m_length;
+		uint32_t m_hash;
+	};
+
 	class IDictCallback
 	{
 	public:
@@ -95,13 +149,48 @@ namespace geng::data
 		virtual bool OnEntry(const char* pKey, const std::shared_ptr<IDatum>& pChild) = 0;
 	};
 
+	// For walks that only look.  Each child is lent for the call, not shared, so walking costs
+	// no reference counts.  The key is null for the entries of a list
+	class IChildCallback
+	{
+	public:
+		virtual ~IChildCallback() = default;
+		virtual bool OnChild(const char* pKey, const IDatum& child) = 0;
+	};
+
 	class IDictDatum : public IDatum
 	{
 	public:
 		virtual bool IsEmpty() const = 0;
 		virtual bool HasEntry(const char* pKey) const = 0;
 		virtual bool GetEntry(const char* pKey, std::shared_ptr<IDatum>& rChild) const = 0;
+		// Dictionaries that keep hashes use the key's own
+		virtual bool GetEntryByKey(const DictKey& key, std::shared_ptr<IDatum>& rChild) const
+		{
+			return GetEntry(key.GetText(), rChild);
+		}
 		virtual bool Iterate(IDictCallback& rCallback) const = 0;
+		// In the order of Iterate(); false if the callback stopped it.  Dictionaries that hold
+		// their children other than as handles override this
+		virtual bool ForEachChild(IChildCallback& rCallback) const
+		{
+			struct Lend_ : public IDictCallback
+			{
+				Lend_(IChildCallback& rCallback_)
+					:rCallback(rCallback_)
+				{ }
+
+				bool OnEntry(const char* pKey, const std::shared_ptr<IDatum>& pChild) override
+				{
+					return rCallback.OnChild(pKey, *pChild);
+				}
+
+				IChildCallback& rCallback;
+			};
+
+			Lend_ lend(rCallback);
+			return Iterate(lend);
+		}
 
 		virtual bool SetEntry(const char* pKey, const std::shared_ptr<IDatum>& rChild) = 0;
 	};
@@ -119,6 +208,21 @@ namespace geng::data
 		virtual bool GetRange(std::vector<std::shared_ptr<IDatum> >& rSequence,
 							  size_t startIdx = 0, 
 							  size_t endIdx = LIST_NPOS) const = 0;
+		// In order; false if the callback stopped it.  This one shares each entry in turn, so
+		// lists that can reach their entries directly override it
+		virtual bool ForEachChild(IChildCallback& rCallback) const
+		{
+			std::shared_ptr<IDatum> pChild;
+			size_t length = GetLength();
+			for (size_t i = 0; i < length; ++i)
+			{
+				if (GetEntry(i, pChild) && !rCallback.OnChild(nullptr, *pChild))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
 
 		virtual bool InsertEntry(const std::shared_ptr<IDatum>& pEntry,
 			size_t indexBefore = LIST_NPOS) = 0;
@@ -138,9 +242,18 @@ namespace geng::data
 	class IDatumFactories
 	{
 	public:
+		virtual ~IDatumFactories() = default;
+
 		virtual IDatum* CreateElement() = 0;
 		virtual IDatum* CreateDictionary() = 0;
 		virtual IDatum* CreateList() = 0;
+
+		// Take ownership of a datum just made by one of the factories.  Factories whose data
+		// do not come from new must override this
+		virtual std::shared_ptr<IDatum> Adopt(IDatum* pDatum)
+		{
+			return std::shared_ptr<IDatum>(pDatum);
+		}
 	};
 
 	enum class IterInstruction
@@ -159,15 +272,16 @@ namespace geng::data
 	public:
 		virtual ~ITreeSerializer() = default;
 
-		virtual IterInstruction OnList(const std::shared_ptr<IListDatum>& pList,
+		// The data are lent for the call only
+		virtual IterInstruction OnList(const IListDatum& rList,
 			bool hasElements) = 0;
-		virtual IterInstruction OnDict(const std::shared_ptr<IDictDatum>& pDict,
+		virtual IterInstruction OnDict(const IDictDatum& rDict,
 			bool hasElements) = 0;
 		virtual IterInstruction OnDictKey(const char* pKey) = 0;
 		virtual void EndCompound() = 0;
 
-		virtual IterInstruction OnElement(const std::shared_ptr<IElementDatum>& pElement) = 0;
-		virtual IterInstruction OnObject(const std::shared_ptr<IObjectDatum>& pObject) = 0;
+		virtual IterInstruction OnElement(const IElementDatum& rElement) = 0;
+		virtual IterInstruction OnObject(const IObjectDatum& rObject) = 0;
 	};
 
 }
\ No newline at end of file
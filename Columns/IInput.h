@@ -19,6 +19,8 @@ namespace geng
 		KeyCode keyCode;  // [in]
 		unsigned int numChanges;  // [out]
 		KeySignal finalState;  // [out]
+		// When the first of the frame's changes happened, on the input's clock (ms)
+		unsigned long changeTime{ 0 };  // [out]
 
 		KeyState() = default;
 		KeyState(KeyCode keyCode_)
@@ -49,6 +51,12 @@ namespace geng
 			KeyboardState* pkeyboardState,
 			KeyState** ppKeyStates,
 			size_t nKeyStates) = 0;
+
+		// Take in whatever input has arrived since the frame began, so it counts in this frame
+		// rather than the next
+		virtual void LatchInput() = 0;
+		// The clock the change times are on, in ms
+		virtual unsigned long GetInputTime() const = 0;
 	};
 
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cinttypes>
+
+namespace geng
+{
+	// One frame of a player's actions, one bit per action
+	struct RemoteInput
+	{
+		unsigned long frame{ 0 };
+		uint32_t actionBits{ 0 };
+	};
+
+	// Carries each side's input to the other.  Inputs may arrive late, and out of order,
+	// but each one arrives once
+	class IInputTransport
+	{
+	public:
+		virtual ~IInputTransport() = default;
+
+		// Drops anything still in flight, for a new game
+		virtual void Reset() = 0;
+		virtual void Send(const RemoteInput& input) = 0;
+		// Called once a frame, before the inputs that arrived are taken
+		virtual void Update(unsigned long simTime) = 0;
+		// False when nothing more has arrived
+		virtual bool Receive(RemoteInput& input) = 0;
+	};
+}
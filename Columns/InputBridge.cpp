@@ -1,6 +1,8 @@
 #include "InputBridge.h"
 #include "KeyDebug.h"
 
+#include <algorithm>
+
 geng::InputBridge::InputBridge(const char* pName, const std::shared_ptr<IInput>& pUnderlying)
 	:TemplatedGameComponent<IInput>(pName),
 	m_pUnderlying(pUnderlying)
@@ -8,19 +10,25 @@ geng::InputBridge::InputBridge(const char* pName, const std::shared_ptr<IInput>&
 
 }
 
-// Yes, this was copied from SDLInput
-// TODO
 void geng::InputBridge::AddCode(KeyCode code)
 {
-	if (m_keyState.count(code) == 0)
+	if (m_slots.count(code) == 0)
 	{
-		KeyData_ kdata;
-		kdata.state.keyCode = code;
-		kdata.state.finalState = KeySignal::KeyUp;
-		kdata.state.numChanges = 0;
+		KeyState state(code);
+		state.finalState = KeySignal::KeyUp;
+		state.numChanges = 0;
 
-		auto emplaceResult = m_keyState.emplace(code, kdata);
-		m_stateRefs.emplace_back(&(emplaceResult.first->second.state));
+		m_slots.emplace(code, m_keys.size());
+		m_keys.emplace_back(state);
+		m_earlyChanges.emplace_back(0);
+		m_carriedChanges.emplace_back(0);
+
+		// The keys may have moved
+		m_stateRefs.clear();
+		for (KeyState& rKey : m_keys)
+		{
+			m_stateRefs.emplace_back(&rKey);
+		}
 
 		m_pUnderlying->AddCode(code);
 	}
@@ -28,10 +36,10 @@ void geng::InputBridge::AddCode(KeyCode code)
 
 bool geng::InputBridge::ForceState(const KeyState& keyState)
 {
-	auto itState = m_keyState.find(keyState.keyCode);
-	if (itState != m_keyState.end())
+	auto itSlot = m_slots.find(keyState.keyCode);
+	if (itSlot != m_slots.end())
 	{
-		itState->second.state = keyState;
+		m_keys[itSlot->second] = keyState;
 		return true;
 	}
 
@@ -43,15 +51,26 @@ bool geng::InputBridge::QueryInput(MouseState* pMouseState,
 	KeyState** ppKeyStates,
 	size_t nKeyStates)
 {
+	if (m_querySlots.size() < nKeyStates)
+	{
+		m_querySlots.resize(nKeyStates, NO_SLOT);
+	}
+
 	for (size_t i = 0; i < nKeyStates; ++i)
 	{
-		auto itCode = m_keyState.find(ppKeyStates[i]->keyCode);
-		if (itCode == m_keyState.end())
+		KeyCode code = ppKeyStates[i]->keyCode;
+		size_t& rSlot = m_querySlots[i];
+		if (rSlot == NO_SLOT || m_keys[rSlot].keyCode != code)
 		{
-			return false;
+			auto itSlot = m_slots.find(code);
+			if (itSlot == m_slots.end())
+			{
+				return false;
+			}
+			rSlot = itSlot->second;
 		}
 
-		*ppKeyStates[i] = itCode->second.state;
+		*ppKeyStates[i] = m_keys[rSlot];
 	}
 
 	if (pkeyboardState)
@@ -62,8 +81,53 @@ bool geng::InputBridge::QueryInput(MouseState* pMouseState,
 	return true;
 }
 
+void geng::InputBridge::LatchInput()
+{
+	if (!m_focused)
+	{
+		return;
+	}
+
+	// The changes as of the frame's poll
+	for (size_t slot = 0; slot < m_keys.size(); ++slot)
+	{
+		m_earlyChanges[slot] = m_keys[slot].numChanges - std::min(m_keys[slot].numChanges, m_earlyChanges[slot]);
+	}
+
+	m_pUnderlying->LatchInput();
+	m_pUnderlying->QueryInput(nullptr, nullptr, m_stateRefs.data(), m_stateRefs.size());
+
+	// Only what came in after the poll is early; what the last frame's latch took in
+	// is still there and has counted already
+	for (size_t slot = 0; slot < m_keys.size(); ++slot)
+	{
+		KeyState& rKey = m_keys[slot];
+		rKey.numChanges -= std::min(rKey.numChanges, m_carriedChanges[slot]);
+		m_earlyChanges[slot] = rKey.numChanges - std::min(rKey.numChanges, m_earlyChanges[slot]);
+	}
+	CountDownKeys();
+}
+
+unsigned long geng::InputBridge::GetInputTime() const
+{
+	return m_pUnderlying->GetInputTime();
+}
+
+void geng::InputBridge::CountDownKeys()
+{
+	m_downKeys = 0;
+	for (const KeyState& rKey : m_keys)
+	{
+		if (rKey.finalState == KeySignal::KeyDown)
+		{
+			++m_downKeys;
+		}
+	}
+}
+
 void geng::InputBridge::OnFrame(const SimState& simState, const SimContextState* pContextState)
 {
+	m_focused = pContextState->focus.curValue;
 	if (pContextState->focus.curValue)
 	{
 		// In focus.  Get all the elements from the underlying input and count how many of them
@@ -79,14 +143,15 @@ void geng::InputBridge::OnFrame(const SimState& simState, const SimContextState*
 
 		m_pUnderlying->QueryInput(nullptr, nullptr, m_stateRefs.data(), m_stateRefs.size());
 
-		m_downKeys = 0;
-		for (KeyState* pKey : m_stateRefs)
+		// What the last frame's latch took in has counted already
+		for (size_t slot = 0; slot < m_keys.size(); ++slot)
 		{
-			if (pKey->finalState == KeySignal::KeyDown)
-			{
-				++m_downKeys;
-			}
+			KeyState& rKey = m_keys[slot];
+			m_carriedChanges[slot] = std::min(rKey.numChanges, m_earlyChanges[slot]);
+			rKey.numChanges -= m_carriedChanges[slot];
+			m_earlyChanges[slot] = 0;
 		}
+		CountDownKeys();
 	}
 	else if (pContextState->focus.prevValue)
 	{
@@ -96,5 +161,7 @@ void geng::InputBridge::OnFrame(const SimState& simState, const SimContextState*
 		{
 			pKey->finalState = KeySignal::KeyUp;
 		}
+		std::fill(m_earlyChanges.begin(), m_earlyChanges.end(), 0);
+		std::fill(m_carriedChanges.begin(), m_carriedChanges.end(), 0);
 	}
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "IInput.h"
 #include "BaseGameComponent.h"
 
+#include <vector>
+#include <limits>
 #include <unordered_map>
 
 namespace geng
@@ -10,10 +12,7 @@ namespace geng
 		public IGameListener
 	{
 	private:
-		struct KeyData_
-		{
-			KeyState state;
-		};
+		static constexpr size_t NO_SLOT = std::numeric_limits<size_t>::max();
 	public:
 		InputBridge(const char* pName, const std::shared_ptr<IInput>& pUnderlying);
 		bool ForceState(const KeyState& keyState) override;
@@ -24,13 +23,29 @@ namespace geng
 			KeyboardState* pkeyboardState,
 			KeyState** ppKeyStates,
 			size_t nKeyStates) override;
+		void LatchInput() override;
+		unsigned long GetInputTime() const override;
 
 	private:
+		void CountDownKeys();
+
 		MouseState m_mouseState;
 		KeyboardState m_keyboardState;
 		std::shared_ptr<IInput> m_pUnderlying;
-		std::unordered_map<KeyCode, KeyData_>   m_keyState;
+		// The keys in the order they were added
+		std::vector<KeyState> m_keys;
 		std::vector<KeyState*> m_stateRefs;
+		std::unordered_map<KeyCode, size_t>   m_slots;
+		// The slot of every key in the last query.  Callers ask for the same keys in the same
+		// order every frame, so only a key that isn't where it was last time has to be looked up
+		std::vector<size_t> m_querySlots;
+		// Changes a latch brought in, by slot.  The underlying input counts them again
+		// in the next frame, where they've been seen already
+		std::vector<unsigned int> m_earlyChanges;
+		// Of those, what the underlying input still counts in this frame.  Every query in the
+		// frame gets them back, the latch's included
+		std::vector<unsigned int> m_carriedChanges;
+		bool m_focused{ false };
 		unsigned int m_downKeys{ 0 };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "InputThread.h"
+
+#include <algorithm>
+
+geng::InputThread::InputThread(std::unique_ptr<IInputEventSource>&& pSource,
+	unsigned int sampleMicros,
+	size_t queueSize)
+	:m_pSource(std::move(pSource)),
+	m_samplePeriod(sampleMicros),
+	m_queue(queueSize)
+{
+
+}
+
+geng::InputThread::~InputThread()
+{
+	Stop();
+}
+
+void geng::InputThread::Start()
+{
+	if (m_running.exchange(true))
+	{
+		return;
+	}
+
+	m_thread = std::thread(&InputThread::Run, this);
+}
+
+void geng::InputThread::Stop()
+{
+	m_running.store(false, std::memory_order_release);
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+bool geng::InputThread::WatchKey(KeyCode keyCode)
+{
+	if (!m_pSource->CanSample(keyCode))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> keysLock(m_keysMutex);
+	if (std::find(m_keys.begin(), m_keys.end(), keyCode) == m_keys.end())
+	{
+		m_keys.emplace_back(keyCode);
+		m_keysChanged.store(true, std::memory_order_release);
+	}
+	return true;
+}
+
+void geng::InputThread::Run()
+{
+	std::vector<KeyCode> keys;
+	std::vector<InputEvent> events;
+
+	auto nextSample = std::chrono::steady_clock::now();
+	while (m_running.load(std::memory_order_acquire))
+	{
+		if (m_keysChanged.exchange(false, std::memory_order_acquire))
+		{
+			std::lock_guard<std::mutex> keysLock(m_keysMutex);
+			keys = m_keys;
+		}
+
+		if (m_active.load(std::memory_order_relaxed))
+		{
+			events.clear();
+			m_pSource->Sample(keys, events);
+			for (const InputEvent& rEvent : events)
+			{
+				if (!m_queue.Push(rEvent))
+				{
+					m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		}
+
+		nextSample += m_samplePeriod;
+		std::this_thread::sleep_until(nextSample);
+
+		// After a stall, go on from now rather than sampling in a burst to catch up
+		auto now = std::chrono::steady_clock::now();
+		if (now - nextSample > m_samplePeriod)
+		{
+			nextSample = now;
+		}
+	}
+}
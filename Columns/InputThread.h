@@ -0,0 +1,84 @@
+#pragma once
+
+#include "IInput.h"
+#include "SPSCQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geng
+{
+	struct InputEvent
+	{
+		KeyCode keyCode;
+		KeySignal signal;
+		// On the source's clock, which should be the one the input's change times are on (ms)
+		unsigned long timestamp;
+	};
+
+	// Reads key transitions for the input thread, which calls it on its own schedule
+	class IInputEventSource
+	{
+	public:
+		virtual ~IInputEventSource() = default;
+
+		// Whether the source can follow the key at all.  Called from the main thread
+		virtual bool CanSample(KeyCode keyCode) const = 0;
+		// Add the keys' transitions since the last call.  Keys are only ever added to the end
+		// of the list, and only ones the source can sample
+		virtual void Sample(const std::vector<KeyCode>& keys, std::vector<InputEvent>& rEvents) = 0;
+	};
+
+	constexpr unsigned int DEFAULT_INPUT_SAMPLE_MICROS = 1000;
+	constexpr size_t DEFAULT_INPUT_QUEUE_SIZE = 1024;
+
+	// Samples an event source on a thread of its own, so input is read at a steady rate however
+	// the frames are paced, and however long a frame takes to render and present.  Every transition
+	// goes into a queue with its time, and the main thread takes them out once a frame
+	class InputThread
+	{
+	public:
+		InputThread(std::unique_ptr<IInputEventSource>&& pSource,
+			unsigned int sampleMicros = DEFAULT_INPUT_SAMPLE_MICROS,
+			size_t queueSize = DEFAULT_INPUT_QUEUE_SIZE);
+		~InputThread();
+
+		InputThread(const InputThread&) = delete;
+		InputThread& operator=(const InputThread&) = delete;
+
+		void Start();
+		void Stop();
+
+		// False if the source can't sample the key
+		bool WatchKey(KeyCode keyCode);
+		// Nothing is sampled while inactive (the window is out of focus, say).  Whatever changed
+		// in the meantime comes through once it's active again
+		void SetActive(bool active) { m_active.store(active, std::memory_order_relaxed); }
+
+		// Main thread only
+		bool Pop(InputEvent& rEvent) { return m_queue.Pop(rEvent); }
+		// Transitions lost to a full queue
+		unsigned long GetDroppedEvents() const { return m_droppedEvents.load(std::memory_order_relaxed); }
+
+	private:
+		void Run();
+
+		std::unique_ptr<IInputEventSource> m_pSource;
+		std::chrono::microseconds m_samplePeriod;
+		SPSCQueue<InputEvent> m_queue;
+
+		// The keys to sample, as the main thread left them
+		std::mutex m_keysMutex;
+		std::vector<KeyCode> m_keys;
+		std::atomic<bool> m_keysChanged{ false };
+
+		std::atomic<bool> m_running{ false };
+		std::atomic<bool> m_active{ true };
+		std::atomic<unsigned long> m_droppedEvents{ 0 };
+		std::thread m_thread;
+	};
+}
@@ -0,0 +1,216 @@
+#include "LZBlockCodec.h"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// A sequence is a token byte (literal length in the high nibble, match length - MIN_MATCH in the low nibble),
+	// an optional literal length extension, the literals, a 16-bit offset and an optional match length extension.
+	// The last sequence in a block only carries literals
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t LAST_LITERALS = 5;
+	constexpr size_t MATCH_FIND_LIMIT = 12;
+	constexpr size_t MAX_OFFSET = 65535;
+	constexpr unsigned HASH_LOG = 12;
+	constexpr uint8_t NIBBLE_MAX = 15;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline uint32_t HashSequence(uint32_t seq)
+	{
+		return (seq * 2654435761u) >> (32 - HASH_LOG);
+	}
+
+	bool WriteLength(size_t len, uint8_t*& pOut, const uint8_t* pOutEnd)
+	{
+		// The remainder of a length past the nibble is written as a run of 255s and a terminating byte
+		while (len >= 255)
+		{
+			if (pOut == pOutEnd)
+			{
+				return false;
+			}
+			*pOut++ = 255;
+			len -= 255;
+		}
+		if (pOut == pOutEnd)
+		{
+			return false;
+		}
+		*pOut++ = (uint8_t)len;
+		return true;
+	}
+
+	bool ReadLength(size_t& len, const uint8_t*& pIn, const uint8_t* pInEnd)
+	{
+		uint8_t b;
+		do
+		{
+			if (pIn == pInEnd)
+			{
+				return false;
+			}
+			b = *pIn++;
+			len += b;
+		} while (b == 255);
+		return true;
+	}
+
+	bool WriteSequence(const uint8_t* pLiterals, size_t litLen, size_t offset, size_t matchLen,
+		uint8_t*& pOut, const uint8_t* pOutEnd)
+	{
+		if (pOut == pOutEnd)
+		{
+			return false;
+		}
+		uint8_t* pToken = pOut++;
+		uint8_t token = litLen >= NIBBLE_MAX ? NIBBLE_MAX : (uint8_t)litLen;
+		token <<= 4;
+		if (litLen >= NIBBLE_MAX && !WriteLength(litLen - NIBBLE_MAX, pOut, pOutEnd))
+		{
+			return false;
+		}
+		if ((size_t)(pOutEnd - pOut) < litLen)
+		{
+			return false;
+		}
+		if (litLen > 0)
+		{
+			memcpy(pOut, pLiterals, litLen);
+			pOut += litLen;
+		}
+
+		if (matchLen > 0)
+		{
+			size_t matchCode = matchLen - MIN_MATCH;
+			token |= matchCode >= NIBBLE_MAX ? NIBBLE_MAX : (uint8_t)matchCode;
+			if (pOutEnd - pOut < 2)
+			{
+				return false;
+			}
+			*pOut++ = (uint8_t)(offset & 0xff);
+			*pOut++ = (uint8_t)(offset >> 8);
+			if (matchCode >= NIBBLE_MAX && !WriteLength(matchCode - NIBBLE_MAX, pOut, pOutEnd))
+			{
+				return false;
+			}
+		}
+		*pToken = token;
+		return true;
+	}
+}
+
+size_t geng::serial::LZCompressBlock(const uint8_t* pSrc, size_t srcSize,
+	uint8_t* pDst, size_t dstCapacity)
+{
+	uint8_t* pOut = pDst;
+	const uint8_t* pOutEnd = pDst + dstCapacity;
+	size_t anchor = 0;
+
+	if (srcSize > MATCH_FIND_LIMIT)
+	{
+		// Positions are stored off by one so that 0 can mean "empty"
+		std::vector<uint32_t> hashTable(size_t(1) << HASH_LOG, 0);
+		const size_t matchFindEnd = srcSize - MATCH_FIND_LIMIT;
+		const size_t matchEnd = srcSize - LAST_LITERALS;
+		size_t pos = 0;
+		while (pos <= matchFindEnd)
+		{
+			uint32_t seq = Read32(pSrc + pos);
+			uint32_t& slot = hashTable[HashSequence(seq)];
+			size_t ref = slot;
+			slot = (uint32_t)(pos + 1);
+			if (ref == 0 || pos - (ref - 1) > MAX_OFFSET || Read32(pSrc + ref - 1) != seq)
+			{
+				++pos;
+				continue;
+			}
+			--ref;
+			size_t matchLen = MIN_MATCH;
+			while (pos + matchLen < matchEnd && pSrc[ref + matchLen] == pSrc[pos + matchLen])
+			{
+				++matchLen;
+			}
+			if (!WriteSequence(pSrc + anchor, pos - anchor, pos - ref, matchLen, pOut, pOutEnd))
+			{
+				return 0;
+			}
+			pos += matchLen;
+			anchor = pos;
+		}
+	}
+	// Whatever is left goes out as literals
+	if (!WriteSequence(pSrc + anchor, srcSize - anchor, 0, 0, pOut, pOutEnd))
+	{
+		return 0;
+	}
+	return pOut - pDst;
+}
+
+bool geng::serial::LZDecompressBlock(const uint8_t* pSrc, size_t srcSize,
+	uint8_t* pDst, size_t dstSize)
+{
+	const uint8_t* pIn = pSrc;
+	const uint8_t* pInEnd = pSrc + srcSize;
+	uint8_t* pOut = pDst;
+	uint8_t* pOutEnd = pDst + dstSize;
+
+	while (pIn < pInEnd)
+	{
+		uint8_t token = *pIn++;
+		size_t litLen = token >> 4;
+		if (litLen == NIBBLE_MAX && !ReadLength(litLen, pIn, pInEnd))
+		{
+			return false;
+		}
+		if ((size_t)(pInEnd - pIn) < litLen || (size_t)(pOutEnd - pOut) < litLen)
+		{
+			return false;
+		}
+		if (litLen > 0)
+		{
+			memcpy(pOut, pIn, litLen);
+			pIn += litLen;
+			pOut += litLen;
+		}
+
+		if (pIn == pInEnd)
+		{
+			// The last sequence has no match
+			break;
+		}
+		if (pInEnd - pIn < 2)
+		{
+			return false;
+		}
+		size_t offset = pIn[0] | (size_t(pIn[1]) << 8);
+		pIn += 2;
+		if (offset == 0 || offset > (size_t)(pOut - pDst))
+		{
+			return false;
+		}
+		size_t matchLen = token & NIBBLE_MAX;
+		if (matchLen == NIBBLE_MAX && !ReadLength(matchLen, pIn, pInEnd))
+		{
+			return false;
+		}
+		matchLen += MIN_MATCH;
+		if ((size_t)(pOutEnd - pOut) < matchLen)
+		{
+			return false;
+		}
+		// Matches may overlap the bytes they produce, so copy byte by byte
+		const uint8_t* pMatch = pOut - offset;
+		for (size_t i = 0; i < matchLen; ++i)
+		{
+			pOut[i] = pMatch[i];
+		}
+		pOut += matchLen;
+	}
+	return pOut == pOutEnd;
+}
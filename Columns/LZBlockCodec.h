@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+namespace geng::serial
+{
+	// A small LZ77-family block codec (byte-compatible with the LZ4 block format)
+	// Every block is compressed independently, with no history carried over from previous blocks.
+	// This is what makes it possible to seek to, or decompress in parallel, any block in a stream
+
+	// Maximum size of the compressed output for an input of a given size
+	constexpr size_t LZCompressBound(size_t srcSize)
+	{
+		return srcSize + srcSize / 255 + 16;
+	}
+
+	// Compress srcSize bytes into pDst.  Returns the compressed size, or 0 if the
+	// result does not fit into dstCapacity bytes
+	size_t LZCompressBlock(const uint8_t* pSrc, size_t srcSize,
+		uint8_t* pDst, size_t dstCapacity);
+
+	// Decompress a block produced by LZCompressBlock.  The decompressed size must be known
+	// in advance (it is stored alongside each block) and must match exactly
+	bool LZDecompressBlock(const uint8_t* pSrc, size_t srcSize,
+		uint8_t* pDst, size_t dstSize);
+}
@@ -0,0 +1,39 @@
+#include "LoopbackTransport.h"
+
+geng::LoopbackTransport::LoopbackTransport(unsigned long delayMs, unsigned long jitterMs, unsigned long seed)
+	:m_delayMs(delayMs),
+	m_jitterMs(jitterMs),
+	m_jitterGenerator(seed)
+{
+
+}
+
+void geng::LoopbackTransport::Reset()
+{
+	m_inFlight = decltype(m_inFlight)();
+	m_currentTime = 0;
+	m_nextSequence = 0;
+}
+
+void geng::LoopbackTransport::Send(const RemoteInput& input)
+{
+	unsigned long jitter = m_jitterMs > 0 ? m_jitterGenerator() % (m_jitterMs + 1) : 0;
+	m_inFlight.push(Packet_{ m_currentTime + m_delayMs + jitter, m_nextSequence++, input });
+}
+
+void geng::LoopbackTransport::Update(unsigned long simTime)
+{
+	m_currentTime = simTime;
+}
+
+bool geng::LoopbackTransport::Receive(RemoteInput& input)
+{
+	if (m_inFlight.empty() || m_inFlight.top().deliveryTime > m_currentTime)
+	{
+		return false;
+	}
+
+	input = m_inFlight.top().input;
+	m_inFlight.pop();
+	return true;
+}
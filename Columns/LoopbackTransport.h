@@ -0,0 +1,48 @@
+#pragma once
+
+#include "IInputTransport.h"
+
+#include <queue>
+#include <vector>
+#include <random>
+
+namespace geng
+{
+	// Hands every input sent straight back, after an artificial delay plus a random jitter of
+	// up to jitterMs.  With jitter, inputs can overtake each other.
+	// Stands in for a network peer so the rollback can be exercised in one process
+	class LoopbackTransport : public IInputTransport
+	{
+	private:
+		struct Packet_
+		{
+			unsigned long deliveryTime;
+			// Breaks ties in the order sent
+			unsigned long long sequence;
+			RemoteInput input;
+
+			bool operator>(const Packet_& other) const
+			{
+				return deliveryTime != other.deliveryTime ? deliveryTime > other.deliveryTime
+					: sequence > other.sequence;
+			}
+		};
+
+	public:
+		LoopbackTransport(unsigned long delayMs, unsigned long jitterMs, unsigned long seed);
+
+		void Reset() override;
+		void Send(const RemoteInput& input) override;
+		void Update(unsigned long simTime) override;
+		bool Receive(RemoteInput& input) override;
+
+	private:
+		unsigned long m_delayMs;
+		unsigned long m_jitterMs;
+		std::mt19937 m_jitterGenerator;
+
+		unsigned long m_currentTime{ 0 };
+		unsigned long long m_nextSequence{ 0 };
+		std::priority_queue<Packet_, std::vector<Packet_>, std::greater<Packet_> > m_inFlight;
+	};
+}
@@ -0,0 +1,157 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+geng::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool geng::MappedFile::Open(const char* pFileName, bool privateCopy)
+{
+	Close();
+
+	HANDLE hFile = CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		m_error = "Could not open ";
+		m_error += pFileName;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(hFile, &fileSize))
+	{
+		CloseHandle(hFile);
+		m_error = "Could not size ";
+		m_error += pFileName;
+		return false;
+	}
+
+	m_handle = (intptr_t)hFile;
+	m_isOpen = true;
+	if (fileSize.QuadPart == 0)
+	{
+		// Nothing to map
+		return true;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, nullptr, privateCopy ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+	if (!hMapping)
+	{
+		Close();
+		m_error = "Could not map ";
+		m_error += pFileName;
+		return false;
+	}
+	m_mappingHandle = (intptr_t)hMapping;
+
+	m_pData = static_cast<char*>(MapViewOfFile(hMapping, privateCopy ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+	if (!m_pData)
+	{
+		Close();
+		m_error = "Could not map ";
+		m_error += pFileName;
+		return false;
+	}
+
+	m_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void geng::MappedFile::Close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+	if (m_mappingHandle != -1)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+		m_mappingHandle = -1;
+	}
+	if (m_handle != -1)
+	{
+		CloseHandle((HANDLE)m_handle);
+		m_handle = -1;
+	}
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#else
+
+bool geng::MappedFile::Open(const char* pFileName, bool privateCopy)
+{
+	Close();
+
+	int fd = open(pFileName, O_RDONLY);
+	if (fd < 0)
+	{
+		m_error = "Could not open ";
+		m_error += pFileName;
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0)
+	{
+		close(fd);
+		m_error = "Could not size ";
+		m_error += pFileName;
+		return false;
+	}
+
+	m_handle = fd;
+	m_isOpen = true;
+	if (fileStat.st_size == 0)
+	{
+		// Nothing to map
+		return true;
+	}
+
+	void* pData = mmap(nullptr, (size_t)fileStat.st_size, privateCopy ? PROT_READ | PROT_WRITE : PROT_READ,
+		MAP_PRIVATE, fd, 0);
+	if (pData == MAP_FAILED)
+	{
+		Close();
+		m_error = "Could not map ";
+		m_error += pFileName;
+		return false;
+	}
+
+	m_pData = static_cast<char*>(pData);
+	m_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+void geng::MappedFile::Close()
+{
+	if (m_pData)
+	{
+		munmap(m_pData, m_size);
+		m_pData = nullptr;
+	}
+	if (m_handle != -1)
+	{
+		close((int)m_handle);
+		m_handle = -1;
+	}
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace geng
+{
+	// A whole file mapped into memory for reading.  A private mapping can be written to as well:
+	// the pages written are copied, and the file itself never changes, which lets parsers work
+	// on it in place
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// An empty file opens with no data
+		bool Open(const char* pFileName, bool privateCopy = false);
+		void Close();
+
+		bool IsOpen() const { return m_isOpen; }
+		char* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_size; }
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		char* m_pData{ nullptr };
+		size_t m_size{ 0 };
+		bool m_isOpen{ false };
+		// File descriptor, or file and mapping handles
+		intptr_t m_handle{ -1 };
+		intptr_t m_mappingHandle{ -1 };
+		std::string m_error;
+	};
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Bytestream.h"
+
+#include <vector>
+#include <cstring>
+
+namespace geng::serial
+{
+	// Appends to a byte vector it owns
+	class MemoryWriteStream : public IWriteStream
+	{
+	public:
+		MemoryWriteStream(TFormatVersion version = 0)
+			:m_version(version)
+		{ }
+
+		TFormatVersion GetFormatVersion() const override
+		{
+			return m_version;
+		}
+
+		bool CanWrite(size_t byteCount) override
+		{
+			return true;
+		}
+
+		size_t Write(const void* pBuff, size_t byteCount) override
+		{
+			const uint8_t* pBytes = static_cast<const uint8_t*>(pBuff);
+			m_buffer.insert(m_buffer.end(), pBytes, pBytes + byteCount);
+			return byteCount;
+		}
+
+		bool Flush() override
+		{
+			return true;
+		}
+
+		// The capacity is kept, so a stream reused every frame stops allocating
+		void Clear() { m_buffer.clear(); }
+
+		const uint8_t* GetData() const { return m_buffer.data(); }
+		size_t GetSize() const { return m_buffer.size(); }
+
+	private:
+		TFormatVersion m_version;
+		std::vector<uint8_t> m_buffer;
+	};
+
+	// Reads from a buffer it does not own
+	class MemoryReadStream : public IReadStream
+	{
+	public:
+		MemoryReadStream(const void* pData, size_t size, TFormatVersion version = 0)
+			:m_pData(static_cast<const uint8_t*>(pData)),
+			m_size(size),
+			m_version(version)
+		{ }
+
+		TFormatVersion GetFormatVersion() const override
+		{
+			return m_version;
+		}
+
+		bool CanRead(size_t byteCount) override
+		{
+			return m_size - m_pos >= byteCount;
+		}
+
+		size_t Read(void* pBuff, size_t byteCount) override
+		{
+			if (!CanRead(byteCount))
+			{
+				return 0;
+			}
+			memcpy(pBuff, m_pData + m_pos, byteCount);
+			m_pos += byteCount;
+			return byteCount;
+		}
+
+		size_t GetPosition() const { return m_pos; }
+		bool IsAtEnd() const { return m_pos == m_size; }
+
+	private:
+		const uint8_t* m_pData;
+		size_t m_size;
+		size_t m_pos{ 0 };
+		TFormatVersion m_version;
+	};
+}
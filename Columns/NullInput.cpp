@@ -0,0 +1,36 @@
+#include "NullInput.h"
+
+geng::NullInput::NullInput()
+	:TemplatedGameComponent<IInput>("NullInput")
+{
+
+}
+
+bool geng::NullInput::ForceState(const KeyState& keyState)
+{
+	return true;
+}
+
+void geng::NullInput::AddCode(KeyCode code)
+{
+
+}
+
+bool geng::NullInput::QueryInput(MouseState* pMouseState,
+	KeyboardState* pkeyboardState,
+	KeyState** ppKeyStates,
+	size_t nKeyStates)
+{
+	for (size_t i = 0; i < nKeyStates; ++i)
+	{
+		ppKeyStates[i]->finalState = KeySignal::KeyUp;
+		ppKeyStates[i]->numChanges = 0;
+	}
+
+	if (pkeyboardState)
+	{
+		pkeyboardState->numKeysDownInFrame = 0;
+	}
+
+	return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "IInput.h"
+#include "BaseGameComponent.h"
+
+namespace geng
+{
+	// Input with no device behind it:  every key is always up.
+	// Used for headless runs, where all commands come from a playback file
+	class NullInput : public TemplatedGameComponent<IInput>
+	{
+	public:
+		NullInput();
+
+		bool ForceState(const KeyState& keyState) override;
+		void AddCode(KeyCode code) override;
+		bool QueryInput(MouseState* pMouseState,
+			KeyboardState* pkeyboardState,
+			KeyState** ppKeyStates,
+			size_t nKeyStates) override;
+		void LatchInput() override { }
+		unsigned long GetInputTime() const override { return 0; }
+	};
+}
@@ -32,9 +32,8 @@ geng::RawMemoryFactory::RawMemoryFactory(size_t bufferSize)
 
 bool geng::RawMemoryFactory::IsMyResource(const data::IDatum& resDescriptor) const
 {
-	std::string resType;
-	if (data::GetDictValue(resDescriptor, res_desc::RES_TYPE, resType)
-		!= data::AccessResult::OK)
+	std::string_view resType;
+	if (res_desc::ResTypePath().GetValue(resDescriptor, resType) != data::AccessResult::OK)
 	{
 		return false;
 	}
@@ -52,7 +51,7 @@ std::shared_ptr<geng::IResource> geng::RawMemoryFactory
 	// Get the "source" node
 	// It is either an object datum of resource type, or a path specifier
 	std::shared_ptr<data::IDatum> pSourceNode;
-	if (data::GetDictChild(resourceDesc, res_desc::SOURCE, pSourceNode) != data::AccessResult::OK)
+	if (res_desc::SourcePath().GetChild(resourceDesc, pSourceNode) != data::AccessResult::OK)
 	{
 		rErr = "Descriptor missing source";
 		return pRet;
@@ -79,7 +78,7 @@ std::shared_ptr<geng::IResource> geng::RawMemoryFactory
 	else if (pSourceNode->GetDatumType() == data::BaseDatumType::Dictionary)
 	{
 		std::string filePathProperty;
-		if (data::GetDictValue(*pSourceNode, res_desc::FILE_PATH, filePathProperty) != data::AccessResult::OK)
+		if (res_desc::SourceFilePath().GetValue(resourceDesc, filePathProperty) != data::AccessResult::OK)
 		{
 			rErr = "Load RawMem resource: filepath in descriptor missing or not a string";
 			return pRet;
@@ -0,0 +1,408 @@
+#include "ReplayVerifier.h"
+#include "DefaultGame.h"
+#include "ColumnsExecutive.h"
+#include "ColumnsInput.h"
+#include "ColumnsSim.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+
+namespace
+{
+	// Stops the game if a demo runs for too long
+	class FrameLimit : public geng::IGameListener
+	{
+	public:
+		FrameLimit(geng::IGame* pGame, unsigned long maxFrames)
+			:m_pGame(pGame),
+			m_maxFrames(maxFrames)
+		{ }
+
+		void OnFrame(const geng::SimState& rSimState,
+			const geng::SimContextState* pContextState) override
+		{
+			if (rSimState.execFrameCount >= m_maxFrames)
+			{
+				m_limitReached = true;
+				m_pGame->Quit();
+			}
+		}
+
+		bool LimitReached() const { return m_limitReached; }
+	private:
+		geng::IGame* m_pGame;
+		unsigned long m_maxFrames;
+		bool m_limitReached{ false };
+	};
+
+	// Jumps a played back game over the frames where neither the input nor the sim has anything
+	// to do, which is most of a demo.  Only for games nobody watches frame by frame
+	class IdleSkip : public geng::IGameListener
+	{
+	public:
+		IdleSkip(geng::IGame* pGame, unsigned long msPerFrame)
+			:m_pGame(pGame),
+			m_msPerFrame(msPerFrame)
+		{ }
+
+		void OnFrame(const geng::SimState& rSimState,
+			const geng::SimContextState* pContextState) override
+		{
+			using namespace geng::columns;
+
+			// The components are there once the executive has set the game up
+			if (!m_pColumnsInput || !m_pSim)
+			{
+				m_pColumnsInput = geng::GetComponentAs<ColumnsInput>(m_pGame, ColumnsExecutive::GetColumnsInputComponentName());
+				m_pSim = geng::GetComponentAs<ColumnsSim>(m_pGame, "ColumnsSim");
+				if (!m_pColumnsInput || !m_pSim)
+				{
+					return;
+				}
+			}
+
+			// The first frame the sim would do anything in, if the input stays idle
+			unsigned long wakeTime = m_pSim->GetWakeTime();
+			unsigned long wakeFrame = wakeTime / m_msPerFrame + (wakeTime % m_msPerFrame != 0 ? 1 : 0);
+			unsigned long targetFrame = std::min(m_pColumnsInput->GetInputIdleUntilFrame(), wakeFrame);
+
+			if (targetFrame != geng::NO_INPUT_CHANGE_FRAME
+				&& targetFrame > m_pColumnsInput->GetFrameCount() + 1)
+			{
+				m_pGame->SetFrameIndex(m_pGame->GetSimContext(ColumnsExecutive::GetColumnsSimContextName()),
+					targetFrame);
+			}
+		}
+
+	private:
+		geng::IGame* m_pGame;
+		unsigned long m_msPerFrame;
+		std::shared_ptr<geng::columns::ColumnsInput> m_pColumnsInput;
+		std::shared_ptr<geng::columns::ColumnsSim> m_pSim;
+	};
+
+	const char* ChecksumStatusText(geng::serial::FileChecksumStatus status)
+	{
+		switch (status)
+		{
+		case geng::serial::FileChecksumStatus::FileChecksumOK:
+			return "ok";
+		case geng::serial::FileChecksumStatus::FileChecksumInvalid:
+			return "INVALID";
+		default:
+			return "none";
+		}
+	}
+}
+
+namespace
+{
+	// Set up a headless game on the settings and run it to its end.  A played back game is judged
+	// by whether the demo played out; any other just has to finish
+	void PlayHeadlessGame(const geng::columns::ExecutiveSettings& execSettings,
+		const geng::columns::ReplayArgs& args,
+		geng::columns::ReplayReport& report,
+		const std::shared_ptr<geng::columns::ReplayObserver>& pObserver)
+	{
+		using namespace geng;
+		using namespace geng::columns;
+
+		auto startTime = std::chrono::steady_clock::now();
+
+		DefaultGameArgs gameArgs;
+		gameArgs.msTimePerFrame = args.msTimePerFrame;
+		gameArgs.msBreather = 0;
+		gameArgs.maxMsPerFrame = 0;
+		gameArgs.unthrottled = true;
+		auto pGame = DefaultGame::CreateGame(gameArgs);
+
+		auto pExecutive = std::make_shared<ColumnsExecutive>(execSettings);
+		if (!pExecutive->AddToGame(pGame))
+		{
+			report.error = "Could not set up the game";
+			return;
+		}
+		pGame->AddComponent(pExecutive);
+
+		auto pFrameLimit = std::make_shared<FrameLimit>(pGame.get(), args.maxFrames);
+		pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT, pFrameLimit, nullptr);
+
+		bool playback = execSettings.pbMode == PlaybackMode::Playback;
+		if (playback && !pObserver)
+		{
+			pGame->AddListener(ListenerType::Executive, EXECUTIVE_CONTEXT,
+				std::make_shared<IdleSkip>(pGame.get(), args.msTimePerFrame), nullptr);
+		}
+
+		if (pObserver)
+		{
+			pGame->AddComponent(pObserver);
+			pGame->AddListener(ListenerType::Rendering, 
+				pGame->GetSimContext(ColumnsExecutive::GetColumnsSimContextName()),
+				pObserver, 
+				nullptr);
+		}
+
+		if (!pGame->Run())
+		{
+			report.error = "Could not initialize the game";
+			return;
+		}
+
+		auto pColumnsInput = GetComponentAs<ColumnsInput>(pGame.get(), ColumnsExecutive::GetColumnsInputComponentName());
+		auto pSim = GetComponentAs<ColumnsSim>(pGame.get(), "ColumnsSim");
+		const CommandManager* pCommandManager = pColumnsInput ? pColumnsInput->GetCommandManager() : nullptr;
+
+		if (!pCommandManager)
+		{
+			report.error = "Game never started";
+		}
+		else
+		{
+			report.checksumStatus = pCommandManager->GetChecksumStatus();
+			report.formatVersion = pCommandManager->GetFormatVersion();
+
+			if (!pCommandManager->IsValid())
+			{
+				report.error = pCommandManager->GetError();
+			}
+			else if (playback && pCommandManager->IsPlaybackError())
+			{
+				report.error = "Playback file is truncated or corrupt";
+			}
+			else if (pFrameLimit->LimitReached())
+			{
+				report.error = playback ? "Frame limit reached before the end of the playback file"
+					: "Frame limit reached before the game was over";
+			}
+			else
+			{
+				report.parsed = true;
+			}
+
+			report.randomSeed = pColumnsInput->GetSimArgs()->randomSeed;
+			report.frameCount = pColumnsInput->GetFrameCount();
+			report.gems = pSim->GetGems();
+			report.level = pSim->GetLevel();
+			report.gameOver = pSim->IsGameOver();
+		}
+
+		// Tear the game down before the clock stops; that's part of the cost of a replay
+		pGame.reset();
+		pExecutive.reset();
+
+		auto endTime = std::chrono::steady_clock::now();
+		report.msWallTime = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	}
+}
+
+void geng::columns::ReplayDemoFile(const std::string& fileName, const ReplayArgs& args, ReplayReport& report,
+	const std::shared_ptr<ReplayObserver>& pObserver)
+{
+	report = ReplayReport();
+	report.fileName = fileName;
+
+	ExecutiveSettings execSettings;
+	execSettings.pbMode = PlaybackMode::Playback;
+	execSettings.pbFileName = fileName;
+	// Play even demos with bad checksums; the status is reported
+	execSettings.allowUnsafePlayback = true;
+	execSettings.headless = true;
+
+	PlayHeadlessGame(execSettings, args, report, pObserver);
+}
+
+void geng::columns::PlaySyntheticGame(const SyntheticGameArgs& gameArgs, RandomSeedType randomSeed,
+	const ReplayArgs& args, ReplayReport& report)
+{
+	report = ReplayReport();
+	switch (gameArgs.inputSource)
+	{
+	case InputSource::Script:
+		report.fileName = gameArgs.scriptFile;
+		break;
+	case InputSource::Random:
+		report.fileName = "random";
+		break;
+	case InputSource::Bot:
+		report.fileName = "bot";
+		break;
+	default:
+		report.fileName = "keyboard";
+		break;
+	}
+
+	ExecutiveSettings execSettings;
+	execSettings.pbMode = PlaybackMode::None;
+	execSettings.inputSource = gameArgs.inputSource;
+	execSettings.inputScript = gameArgs.scriptFile;
+	execSettings.botPolicy = gameArgs.botPolicy;
+	execSettings.fixedSeed = true;
+	execSettings.randomSeed = randomSeed;
+	execSettings.headless = true;
+
+	PlayHeadlessGame(execSettings, args, report, nullptr);
+}
+
+void geng::columns::PlaySyntheticGames(const SyntheticGameArgs& gameArgs, size_t gameCount,
+	const ReplayArgs& args, std::vector<ReplayReport>& reports)
+{
+	reports.clear();
+	reports.resize(gameCount);
+
+	ForEachInParallel(gameCount, args.threadCount, [&](size_t gameIndex)
+		{
+			PlaySyntheticGame(gameArgs, gameArgs.firstSeed + gameIndex, args, reports[gameIndex]);
+		});
+}
+
+void geng::columns::ForEachInParallel(size_t count, unsigned int threadCount, const std::function<void(size_t)>& job)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	threadCount = (unsigned int)std::min<size_t>(threadCount, count);
+
+	// Jobs are expected to be self-contained, so workers just pull the next index off a shared counter
+	std::atomic<size_t> nextIndex{ 0 };
+	auto worker = [&]()
+	{
+		size_t index;
+		while ((index = nextIndex.fetch_add(1)) < count)
+		{
+			job(index);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		workers.emplace_back(worker);
+	}
+
+	for (std::thread& workerThread : workers)
+	{
+		workerThread.join();
+	}
+}
+
+void geng::columns::ReplayDemoFiles(const std::vector<std::string>& fileNames, const ReplayArgs& args,
+	std::vector<ReplayReport>& reports)
+{
+	reports.clear();
+	reports.resize(fileNames.size());
+
+	ForEachInParallel(fileNames.size(), args.threadCount, [&](size_t fileIndex)
+		{
+			ReplayDemoFile(fileNames[fileIndex], args, reports[fileIndex]);
+		});
+}
+
+bool geng::columns::ListDemoFiles(const char* pDirectory, std::vector<std::string>& fileNames, std::string& rErr)
+{
+	std::error_code errCode;
+	std::filesystem::directory_iterator itDir(pDirectory, errCode);
+	if (errCode)
+	{
+		rErr = "Could not list directory ";
+		rErr += pDirectory;
+		rErr += ": ";
+		rErr += errCode.message();
+		return false;
+	}
+
+	for (const std::filesystem::directory_entry& dirEntry : itDir)
+	{
+		if (dirEntry.is_regular_file())
+		{
+			fileNames.emplace_back(dirEntry.path().string());
+		}
+	}
+
+	std::sort(fileNames.begin(), fileNames.end());
+	return true;
+}
+
+size_t geng::columns::PrintReplayReports(std::ostream& os, const std::vector<ReplayReport>& reports)
+{
+	size_t failCount{ 0 };
+	double msTotal{ 0.0 };
+
+	for (const ReplayReport& report : reports)
+	{
+		bool failed = !report.parsed
+			|| !report.error.empty()
+			|| report.checksumStatus != serial::FileChecksumStatus::FileChecksumOK;
+		if (failed)
+		{
+			++failCount;
+		}
+		msTotal += report.msWallTime;
+
+		os << (failed ? "FAIL " : "OK   ") << report.fileName
+			<< "  checksum=" << ChecksumStatusText(report.checksumStatus)
+			<< " version=" << report.formatVersion
+			<< " frames=" << report.frameCount
+			<< " gems=" << report.gems
+			<< " level=" << report.level
+			<< (report.gameOver ? " (game over)" : "")
+			<< " time=" << std::fixed << std::setprecision(1) << report.msWallTime << "ms";
+		if (!report.error.empty())
+		{
+			os << "  error: " << report.error;
+		}
+		os << '\n';
+	}
+
+	os << reports.size() << " demo(s), " << failCount << " failed; "
+		<< std::fixed << std::setprecision(1) << msTotal << "ms of replay time\n";
+
+	return failCount;
+}
+
+size_t geng::columns::PrintGameReports(std::ostream& os, const std::vector<ReplayReport>& reports)
+{
+	size_t failCount{ 0 };
+	double msTotal{ 0.0 };
+	unsigned long long frameTotal{ 0 };
+
+	for (const ReplayReport& report : reports)
+	{
+		bool failed = !report.parsed || !report.error.empty();
+		if (failed)
+		{
+			++failCount;
+		}
+		msTotal += report.msWallTime;
+		frameTotal += report.frameCount;
+
+		os << (failed ? "FAIL " : "OK   ") << report.fileName
+			<< "  seed=" << report.randomSeed
+			<< " frames=" << report.frameCount
+			<< " gems=" << report.gems
+			<< " level=" << report.level
+			<< (report.gameOver ? " (game over)" : "")
+			<< " time=" << std::fixed << std::setprecision(1) << report.msWallTime << "ms";
+		if (!report.error.empty())
+		{
+			os << "  error: " << report.error;
+		}
+		os << '\n';
+	}
+
+	os << reports.size() << " game(s), " << failCount << " failed; "
+		<< frameTotal << " frames in " << std::fixed << std::setprecision(1) << msTotal << "ms of game time";
+	if (msTotal > 0.0)
+	{
+		os << " (" << std::setprecision(0) << frameTotal * 1000.0 / msTotal << " frames/s)";
+	}
+	os << '\n';
+
+	return failCount;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "FileCommandReader.h"
+#include "BaseGameComponent.h"
+#include "ColumnsData.h"
+#include "SyntheticCommands.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <iosfwd>
+
+namespace geng::columns
+{
+	struct ReplayArgs
+	{
+		// Must match the frame length the demos were recorded with
+		unsigned long msTimePerFrame{ 20 };
+		// Safety net for demos that never reach their end marker
+		unsigned long maxFrames{ 10000000 };
+		// 0 means one thread per core
+		unsigned int threadCount{ 0 };
+	};
+
+	struct ReplayReport
+	{
+		std::string fileName;
+		// Parsed means the header was accepted and playback ran to the end marker
+		bool parsed{ false };
+		std::string error;
+
+		serial::FileChecksumStatus checksumStatus{ serial::FileChecksumStatus::FileNoChecksum };
+		uint32_t formatVersion{ 0 };
+		RandomSeedType randomSeed{ 0 };
+		unsigned long frameCount{ 0 };
+		unsigned int gems{ 0 };
+		unsigned int level{ 0 };
+		bool gameOver{ false };
+		double msWallTime{ 0.0 };
+	};
+
+	// A component that watches a replay.  It is added to the game and listens to the sim context
+	// in the rendering slot, i.e. after the sim has run for the frame
+	class ReplayObserver : public BaseGameComponent,
+		public IGameListener
+	{
+	protected:
+		ReplayObserver(const char* pName)
+			:BaseGameComponent(pName)
+		{ }
+	};
+
+	// Play one demo file through a headless game running as fast as it can
+	void ReplayDemoFile(const std::string& fileName, const ReplayArgs& args, ReplayReport& report,
+		const std::shared_ptr<ReplayObserver>& pObserver = nullptr);
+
+	// A game played by something other than the keyboard
+	struct SyntheticGameArgs
+	{
+		InputSource inputSource{ InputSource::Random };
+		std::string scriptFile;
+		ActionBotPolicy botPolicy;
+		// Game i of a run plays with the seed firstSeed + i
+		RandomSeedType firstSeed{ 0 };
+	};
+
+	// Play one game headlessly, as fast as it can go, until it's over.  The report names the
+	// input source rather than a file
+	void PlaySyntheticGame(const SyntheticGameArgs& gameArgs, RandomSeedType randomSeed,
+		const ReplayArgs& args, ReplayReport& report);
+
+	// Play a run of games spread over worker threads; the same arguments make the same games.
+	// A bot policy is called from the worker threads, and so must not share state between games
+	void PlaySyntheticGames(const SyntheticGameArgs& gameArgs, size_t gameCount,
+		const ReplayArgs& args, std::vector<ReplayReport>& reports);
+
+	// Call job(i) for every i in [0, count), spread over worker threads (0 = one per core)
+	void ForEachInParallel(size_t count, unsigned int threadCount, const std::function<void(size_t)>& job);
+
+	// Play a set of demo files, spreading them over worker threads.  Reports are in the same order as the files
+	void ReplayDemoFiles(const std::vector<std::string>& fileNames, const ReplayArgs& args,
+		std::vector<ReplayReport>& reports);
+
+	// All regular files in a directory, sorted by name
+	bool ListDemoFiles(const char* pDirectory, std::vector<std::string>& fileNames, std::string& rErr);
+
+	// One line per file and a summary.  Returns the number of failed files
+	size_t PrintReplayReports(std::ostream& os, const std::vector<ReplayReport>& reports);
+
+	// The same for synthetic games, with the frame rate over the whole run
+	size_t PrintGameReports(std::ostream& os, const std::vector<ReplayReport>& reports);
+}
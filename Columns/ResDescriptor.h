@@ -1,9 +1,43 @@
 #pragma once
+#include "IDataTree.h"
+#include "DTPath.h"
 
 namespace geng::res_desc
 {
-	inline const char* RES_TYPE = "res_type";
-	inline const char* SOURCE = "source";
-	inline const char* FILE_PATH = "filepath";
+	// Hashed here, once; descriptor lookups never copy or hash them again
+	inline constexpr data::DictKey RES_TYPE{ "res_type" };
+	inline constexpr data::DictKey SOURCE{ "source" };
+	inline constexpr data::DictKey FILE_PATH{ "filepath" };
+	// Fonts
+	inline constexpr data::DictKey SIZE{ "size" };
+	inline constexpr data::DictKey TYPEFACE{ "typeface" };
 
-}
\ No newline at end of file
+	// The paths descriptors are read through.  Each is compiled the first time it is used, once
+	// the key table it interns into is surely there
+	inline const data::DTPath& ResTypePath()
+	{
+		static const data::DTPath path("res_type");
+		return path;
+	}
+	inline const data::DTPath& SourcePath()
+	{
+		static const data::DTPath path("source");
+		return path;
+	}
+	inline const data::DTPath& SourceFilePath()
+	{
+		static const data::DTPath path("source.filepath");
+		return path;
+	}
+	inline const data::DTPath& SizePath()
+	{
+		static const data::DTPath path("size");
+		return path;
+	}
+	inline const data::DTPath& TypefacePath()
+	{
+		static const data::DTPath path("typeface");
+		return path;
+	}
+
+}
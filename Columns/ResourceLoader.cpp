@@ -1,5 +1,6 @@
 #include "ResourceLoader.h"
 #include "DTUtils.h"
+#include "DTMapped.h"
 #include "ResDescriptor.h"
 
 // ResourceType
@@ -21,7 +22,8 @@ std::shared_ptr<geng::IResource> geng::ResourceType::LoadResource(const data::ID
 	std::shared_ptr<geng::IResource> pRet{};
 	unsigned int timesTried{ 0 };
 
-	std::string errors = "Errors reported:\n";
+	// Only filled in on failure, so a load that works allocates nothing here
+	std::string errors;
 
 	std::string facError;
 	for (auto& rFactory : m_factories)
@@ -42,7 +44,6 @@ std::shared_ptr<geng::IResource> geng::ResourceType::LoadResource(const data::ID
 		++timesTried;
 	}
 
-	rErr = errors;
 	if (timesTried == 0)
 	{
 		rErr = "No resource factories available for this type";
@@ -50,6 +51,11 @@ std::shared_ptr<geng::IResource> geng::ResourceType::LoadResource(const data::ID
 	else
 	{
 		rErr = "No resource factory for this type could load the resource";
+		if (!errors.empty())
+		{
+			rErr += "; errors reported:\n";
+			rErr += errors;
+		}
 	}
 
 	return pRet;
@@ -86,8 +92,8 @@ std::shared_ptr<geng::IResource> geng::ResourceLoader::LoadResource(const geng::
 	std::shared_ptr<IResource> pRet;
 
 	// Get resource type
-	std::string resType;
-	if (data::GetDictValue(resDescriptor, res_desc::RES_TYPE, resType) != data::AccessResult::OK)
+	std::string_view resType;
+	if (res_desc::ResTypePath().GetValue(resDescriptor, resType) != data::AccessResult::OK)
 	{
 		m_error = "Could not get resource type from descriptor";
 		return pRet;
@@ -103,4 +109,43 @@ std::shared_ptr<geng::IResource> geng::ResourceLoader::LoadResource(const geng::
 	}
 
 	return m_resTypes[itTypeObj->second].LoadResource(resDescriptor, m_error);
+}
+
+void geng::ResourceLoader::AddCatalog(const std::shared_ptr<data::IDatum>& pCatalog)
+{
+	m_catalogs.emplace_back(pCatalog);
+}
+
+bool geng::ResourceLoader::OpenCatalog(const char* pFileName)
+{
+	std::shared_ptr<data::IDatum> pCatalog;
+	if (!data::mapped::OpenFile(pFileName, pCatalog, m_error))
+	{
+		return false;
+	}
+
+	if (pCatalog->GetDatumType() != data::BaseDatumType::Dictionary)
+	{
+		m_error = "A catalog must be a dictionary";
+		return false;
+	}
+
+	AddCatalog(pCatalog);
+	return true;
+}
+
+std::shared_ptr<geng::IResource> geng::ResourceLoader::LoadNamedResource(const data::DictKey& name)
+{
+	for (auto itCatalog = m_catalogs.rbegin(); itCatalog != m_catalogs.rend(); ++itCatalog)
+	{
+		std::shared_ptr<data::IDatum> pDescriptor;
+		if (data::GetDictChild(**itCatalog, name, pDescriptor) == data::AccessResult::OK)
+		{
+			return LoadResource(*pDescriptor);
+		}
+	}
+
+	m_error = "No catalog has a resource named ";
+	m_error += name.GetText();
+	return std::shared_ptr<IResource>();
 }
\ No newline at end of file
@@ -6,7 +6,7 @@
 #include "DTSimple.h"
 
 #include <memory>
-#include <unordered_map>
+#include <map>
 #include <vector>
 #include <cinttypes>
 #include <string>
@@ -42,10 +42,20 @@ namespace geng
 
 		std::shared_ptr<IResource> LoadResource(const data::IDatum& resDescriptor) override;
 		const char* GetResourceLoadError() const override;
+
+		// Catalogs are dictionaries from names to descriptors.  Names are looked up in the
+		// catalog added last first
+		void AddCatalog(const std::shared_ptr<data::IDatum>& pCatalog);
+		// A catalog written by DTBinaryWriter, mapped: nothing in it is read before a name is
+		// looked up, and then only the descriptor used
+		bool OpenCatalog(const char* pFileName);
+		std::shared_ptr<IResource> LoadNamedResource(const data::DictKey& name);
 	private:
 		// Resource types
-		std::unordered_map<std::string, ResourceTypeID>  m_resourceTypeMap;
+		// Ordered so a type can be found by a view of the descriptor's string
+		std::map<std::string, ResourceTypeID, std::less<> >  m_resourceTypeMap;
 		std::vector<ResourceType>    m_resTypes;
+		std::vector<std::shared_ptr<data::IDatum> > m_catalogs;
 		
 		// Error
 		std::string m_error;
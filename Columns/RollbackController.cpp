@@ -0,0 +1,252 @@
+#include "RollbackController.h"
+#include "ColumnsExecutive.h"
+#include "ColumnsInput.h"
+#include "ColumnsSim.h"
+
+#include <chrono>
+#include <algorithm>
+
+geng::columns::RollbackController::RollbackController(std::unique_ptr<IInputTransport>&& pTransport,
+	unsigned long msPerFrame,
+	unsigned int maxRollbackFrames)
+	:BaseGameComponent("RollbackController"),
+	m_pTransport(std::move(pTransport)),
+	m_msPerFrame(msPerFrame),
+	m_maxRollbackFrames(maxRollbackFrames),
+	// The frames that can be rolled back, the one they'd go back to, and the current one
+	m_frames(maxRollbackFrames + 2)
+{
+
+}
+
+bool geng::columns::RollbackController::Initialize(const std::shared_ptr<IGame>& pGame)
+{
+	m_pGame = pGame;
+	m_pColumnsInput = GetComponentAs<ColumnsInput>(pGame.get(), ColumnsExecutive::GetColumnsInputComponentName());
+	m_pSim = GetComponentAs<ColumnsSim>(pGame.get(), "ColumnsSim");
+	m_pExecutive = GetComponentAs<ColumnsExecutive>(pGame.get(), ColumnsExecutive::GetExecutiveName());
+
+	if (!m_pColumnsInput || !m_pSim)
+	{
+		pGame->LogError("RollbackController: could not get the input and sim components");
+		return false;
+	}
+
+	return true;
+}
+
+void geng::columns::RollbackController::OnStartGame()
+{
+	m_inGame = m_pColumnsInput->HasLoopbackPeer();
+	if (!m_inGame)
+	{
+		return;
+	}
+
+	m_pSim->SetRollbackMode(true);
+	m_pTransport->Reset();
+	for (Frame_& frame : m_frames)
+	{
+		frame.frame = NO_FRAME;
+		frame.confirmed = false;
+		frame.gameOver = false;
+	}
+
+	// Nothing is needed from the remote player for the frame the game starts from
+	unsigned long startFrame = m_pColumnsInput->GetFrameCount();
+	Frame_& startSlot = GetFrame(startFrame);
+	startSlot.frame = startFrame;
+	startSlot.confirmed = true;
+	startSlot.remoteActions = 0;
+	startSlot.usedActions = 0;
+	m_confirmedFrame = startFrame;
+	m_confirmedActions = 0;
+
+	m_boardPlayer = m_pColumnsInput->GetBoardPlayer();
+	m_pColumnsInput->SetPlayerActions(m_boardPlayer, 0);
+
+	m_rollbackCount = 0;
+	m_resimulatedFrames = 0;
+	m_deepestRollback = 0;
+	m_longestRollbackMicros = 0;
+	m_error.clear();
+}
+
+void geng::columns::RollbackController::OnEndGame()
+{
+	m_inGame = false;
+}
+
+void geng::columns::RollbackController::OnFrame(const SimState& rSimState,
+	const SimContextState* pContextState)
+{
+	if (!m_inGame || !pContextState->runstate.curValue)
+	{
+		return;
+	}
+
+	unsigned long curFrame = pContextState->frameCount;
+
+	// The board as the last frame left it
+	SaveBoard(curFrame - 1);
+
+	Frame_& curSlot = GetFrame(curFrame);
+	curSlot.frame = curFrame;
+	curSlot.confirmed = false;
+
+	// The transport's clock goes first, so what's sent now is stamped with this frame's time
+	m_pTransport->Update(pContextState->simulatedTime);
+	m_pTransport->Send(RemoteInput{ curFrame, m_pColumnsInput->GetPlayerActions(m_pColumnsInput->GetUserPlayer()) });
+
+	unsigned long rollbackFrame = curFrame;
+	if (!ReceiveInputs(curFrame, rollbackFrame))
+	{
+		return;
+	}
+
+	if (rollbackFrame < curFrame && !RollBack(rollbackFrame, curFrame))
+	{
+		return;
+	}
+
+	// The game is over only once every input that led there is in
+	if (GetFrame(std::min(m_confirmedFrame, curFrame - 1)).gameOver)
+	{
+		EndGame();
+		return;
+	}
+
+	curSlot.usedActions = GetRemoteActions(curFrame);
+	m_pColumnsInput->SetPlayerActions(m_boardPlayer, curSlot.usedActions);
+}
+
+uint32_t geng::columns::RollbackController::GetRemoteActions(unsigned long frame)
+{
+	// Past what has arrived, the player is taken to hold on to whatever was last seen.
+	// A rollback can also ask for frames that are all confirmed by now
+	for (unsigned long prevFrame = frame; ; --prevFrame)
+	{
+		const Frame_& slot = GetFrame(prevFrame);
+		if (slot.frame == prevFrame && slot.confirmed)
+		{
+			return slot.remoteActions;
+		}
+
+		if (prevFrame <= m_confirmedFrame + 1)
+		{
+			break;
+		}
+	}
+
+	return m_confirmedActions;
+}
+
+bool geng::columns::RollbackController::ReceiveInputs(unsigned long curFrame, unsigned long& rollbackFrame)
+{
+	RemoteInput input;
+	while (m_pTransport->Receive(input))
+	{
+		if (input.frame <= m_confirmedFrame)
+		{
+			continue;
+		}
+
+		if (input.frame > curFrame)
+		{
+			Fail("RollbackController: the remote input is ahead of the game");
+			return false;
+		}
+
+		if (curFrame - input.frame > m_maxRollbackFrames)
+		{
+			Fail("RollbackController: the remote input arrived too late to roll back");
+			return false;
+		}
+
+		Frame_& slot = GetFrame(input.frame);
+		if (slot.confirmed)
+		{
+			continue;
+		}
+
+		slot.confirmed = true;
+		slot.remoteActions = input.actionBits;
+		if (input.frame < curFrame && slot.usedActions != input.actionBits)
+		{
+			rollbackFrame = std::min(rollbackFrame, input.frame);
+		}
+	}
+
+	while (m_confirmedFrame < curFrame)
+	{
+		const Frame_& nextSlot = GetFrame(m_confirmedFrame + 1);
+		if (nextSlot.frame != m_confirmedFrame + 1 || !nextSlot.confirmed)
+		{
+			break;
+		}
+
+		++m_confirmedFrame;
+		m_confirmedActions = nextSlot.remoteActions;
+	}
+
+	return true;
+}
+
+bool geng::columns::RollbackController::RollBack(unsigned long fromFrame, unsigned long curFrame)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	const Frame_& baseSlot = GetFrame(fromFrame - 1);
+	serial::MemoryReadStream boardStream(baseSlot.state.GetData(), baseSlot.state.GetSize());
+	if (!m_pSim->LoadState(&boardStream))
+	{
+		Fail("RollbackController: could not restore the board");
+		return false;
+	}
+
+	for (unsigned long frame = fromFrame; frame < curFrame; ++frame)
+	{
+		Frame_& slot = GetFrame(frame);
+		slot.usedActions = GetRemoteActions(frame);
+		m_pColumnsInput->SetPlayerActions(m_boardPlayer, slot.usedActions);
+		m_pSim->Resimulate(frame * m_msPerFrame);
+		SaveBoard(frame);
+	}
+
+	auto rollbackMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - startTime).count();
+
+	++m_rollbackCount;
+	m_resimulatedFrames += curFrame - fromFrame;
+	m_deepestRollback = std::max(m_deepestRollback, curFrame - fromFrame);
+	m_longestRollbackMicros = std::max(m_longestRollbackMicros, (unsigned long)rollbackMicros);
+	return true;
+}
+
+void geng::columns::RollbackController::SaveBoard(unsigned long frame)
+{
+	Frame_& slot = GetFrame(frame);
+	slot.state.Clear();
+	m_pSim->SaveState(&slot.state);
+	slot.gameOver = m_pSim->IsGameOver();
+}
+
+void geng::columns::RollbackController::Fail(const char* pError)
+{
+	m_error = pError;
+	auto pGame = m_pGame.lock();
+	if (pGame)
+	{
+		pGame->LogError(pError);
+	}
+	EndGame();
+}
+
+void geng::columns::RollbackController::EndGame()
+{
+	auto pExecutive = m_pExecutive.lock();
+	if (pExecutive)
+	{
+		pExecutive->EndGame();
+	}
+}
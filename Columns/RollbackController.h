@@ -0,0 +1,108 @@
+#pragma once
+
+#include "BaseGameComponent.h"
+#include "IInputTransport.h"
+#include "MemoryStream.h"
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <limits>
+
+namespace geng::columns
+{
+	class ColumnsExecutive;
+	class ColumnsInput;
+	class ColumnsSim;
+
+	// 200ms at 50 frames a second; enough to cover a round trip over the internet
+	constexpr unsigned int DEFAULT_MAX_ROLLBACK_FRAMES = 10;
+
+	// Runs the board ahead of the remote player's input.  Every frame, the user's actions go out
+	// over the transport, and the remote player's actions are taken as they arrived or, if they
+	// haven't yet, predicted to be the last ones that did.  The board is saved at the end of every
+	// frame; when an input arrives that was predicted wrong, the board goes back to the frame before
+	// it and runs the frames since again, all within the current frame.
+	// Listens on input after ColumnsInput, so the user's commands are up to date and the sim hasn't run
+	class RollbackController : public IGameListener,
+		public BaseGameComponent
+	{
+	private:
+		static constexpr unsigned long NO_FRAME = std::numeric_limits<unsigned long>::max();
+
+		struct Frame_
+		{
+			unsigned long frame{ NO_FRAME };
+			// The remote player's actions, once they've arrived
+			bool confirmed{ false };
+			uint32_t remoteActions{ 0 };
+			// What the board last ran the frame with
+			uint32_t usedActions{ 0 };
+			// The board at the end of the frame
+			serial::MemoryWriteStream state;
+			bool gameOver{ false };
+		};
+
+	public:
+		RollbackController(std::unique_ptr<IInputTransport>&& pTransport,
+			unsigned long msPerFrame,
+			unsigned int maxRollbackFrames = DEFAULT_MAX_ROLLBACK_FRAMES);
+
+		bool Initialize(const std::shared_ptr<IGame>& pGame) override;
+
+		// After the sim has started the game
+		void OnStartGame();
+		void OnEndGame();
+		void OnFrame(const SimState& rSimState,
+			const SimContextState* pContextState) override;
+
+		// For the current (or last) game
+		unsigned long GetRollbackCount() const { return m_rollbackCount; }
+		unsigned long GetResimulatedFrames() const { return m_resimulatedFrames; }
+		unsigned long GetDeepestRollback() const { return m_deepestRollback; }
+		// To hold against the frame budget
+		unsigned long GetLongestRollbackMicros() const { return m_longestRollbackMicros; }
+
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		Frame_& GetFrame(unsigned long frame)
+		{
+			return m_frames[frame % m_frames.size()];
+		}
+
+		// The remote player's actions as they arrived, or as predicted
+		uint32_t GetRemoteActions(unsigned long frame);
+		// Take in whatever has arrived.  rollbackFrame is lowered to the earliest frame
+		// that was run with the wrong input
+		bool ReceiveInputs(unsigned long curFrame, unsigned long& rollbackFrame);
+		bool RollBack(unsigned long fromFrame, unsigned long curFrame);
+		void SaveBoard(unsigned long frame);
+		void Fail(const char* pError);
+		void EndGame();
+
+		std::unique_ptr<IInputTransport> m_pTransport;
+		unsigned long m_msPerFrame;
+		unsigned long m_maxRollbackFrames;
+
+		std::weak_ptr<IGame> m_pGame;
+		std::weak_ptr<ColumnsExecutive> m_pExecutive;
+		std::shared_ptr<ColumnsInput> m_pColumnsInput;
+		std::shared_ptr<ColumnsSim> m_pSim;
+
+		// Ring of the frames that can still be rolled back, and the one before them
+		std::vector<Frame_> m_frames;
+		bool m_inGame{ false };
+		unsigned int m_boardPlayer{ 0 };
+		// Every remote input up to and including this frame has arrived
+		unsigned long m_confirmedFrame{ 0 };
+		uint32_t m_confirmedActions{ 0 };
+
+		unsigned long m_rollbackCount{ 0 };
+		unsigned long m_resimulatedFrames{ 0 };
+		unsigned long m_deepestRollback{ 0 };
+		unsigned long m_longestRollbackMicros{ 0 };
+
+		std::string m_error;
+	};
+}
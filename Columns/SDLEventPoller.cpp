@@ -12,10 +12,66 @@ bool geng::sdl::EventPoller::Initialize(const std::shared_ptr<IGame>& pGame)
 	return true;
 }
 
+void geng::sdl::EventPoller::WindDown(const std::shared_ptr<IGame>& pGame)
+{
+	if (m_pInputThread)
+	{
+		m_pInputThread->Stop();
+	}
+}
+
+void geng::sdl::EventPoller::StartInputThread(std::unique_ptr<InputThread>&& pInputThread)
+{
+	m_pInputThread = std::move(pInputThread);
+	m_threadKeys.assign(SDL_NUM_SCANCODES, false);
+	m_pInputThread->Start();
+}
+
+void geng::sdl::EventPoller::WatchKey(KeyCode keyCode)
+{
+	if (!m_pInputThread || !m_pInputThread->WatchKey(keyCode))
+	{
+		return;
+	}
+
+	SDL_Scancode scancode = SDL_GetScancodeFromKey(keyCode);
+	if (scancode > SDL_SCANCODE_UNKNOWN && scancode < SDL_NUM_SCANCODES)
+	{
+		m_threadKeys[scancode] = true;
+	}
+}
+
 void geng::sdl::EventPoller::OnFrame(const SimState& simState, const SimContextState* pCtxState)
 {
 	m_events.clear();
+	PollEvents();
+}
 
+void geng::sdl::EventPoller::LatchEvents()
+{
+	PollEvents();
+}
+
+void geng::sdl::EventPoller::DrainInputThread()
+{
+	// In with the rest as SDL's own key events, so whatever reads them can't tell the difference
+	InputEvent inputEvent;
+	while (m_pInputThread->Pop(inputEvent))
+	{
+		SDL_Event evt{};
+		bool keyDown = inputEvent.signal == KeySignal::KeyDown;
+		evt.type = keyDown ? SDL_KEYDOWN : SDL_KEYUP;
+		evt.key.type = evt.type;
+		evt.key.timestamp = inputEvent.timestamp;
+		evt.key.state = keyDown ? SDL_PRESSED : SDL_RELEASED;
+		evt.key.keysym.sym = inputEvent.keyCode;
+		evt.key.keysym.scancode = SDL_GetScancodeFromKey(inputEvent.keyCode);
+		m_events.emplace_back(evt);
+	}
+}
+
+void geng::sdl::EventPoller::PollEvents()
+{
 	SDL_Event evt;
 	while (SDL_PollEvent(&evt))
 	{
@@ -26,6 +82,35 @@ void geng::sdl::EventPoller::OnFrame(const SimState& simState, const SimContextS
 			break;
 		}
 
+		if (m_pInputThread)
+		{
+			if ((evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP)
+				&& evt.key.keysym.scancode > SDL_SCANCODE_UNKNOWN
+				&& evt.key.keysym.scancode < SDL_NUM_SCANCODES
+				&& m_threadKeys[evt.key.keysym.scancode])
+			{
+				continue;
+			}
+
+			// The thread reads the keyboard whichever window has it
+			if (evt.type == SDL_WINDOWEVENT)
+			{
+				if (evt.window.event == SDL_WINDOWEVENT_FOCUS_GAINED)
+				{
+					m_pInputThread->SetActive(true);
+				}
+				else if (evt.window.event == SDL_WINDOWEVENT_FOCUS_LOST)
+				{
+					m_pInputThread->SetActive(false);
+				}
+			}
+		}
+
 		m_events.emplace_back(evt);
 	}
+
+	if (m_pInputThread)
+	{
+		DrainInputThread();
+	}
 }
\ No newline at end of file
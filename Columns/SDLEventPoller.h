@@ -4,6 +4,9 @@
 #include <vector>
 
 #include "BaseGameComponent.h"
+#include "InputThread.h"
+
+#include <memory>
 
 namespace geng::sdl
 {
@@ -17,25 +20,43 @@ namespace geng::sdl
 		EventPoller();
 
 		bool Initialize(const std::shared_ptr<IGame>& pGame) override;
+		void WindDown(const std::shared_ptr<IGame>& pGame) override;
 		void OnFrame(const SimState& simState, const SimContextState* pContextState) override;
 
+		// Take key events from an input thread, for the keys it can sample; SDL's own events for
+		// those keys are dropped.  The thread starts right away
+		void StartInputThread(std::unique_ptr<InputThread>&& pInputThread);
+		// A key the input is interested in
+		void WatchKey(KeyCode keyCode);
+		// Add the events that arrived since the frame's poll
+		void LatchEvents();
+
+		// From firstEvent on, to go over only what a latch added
 		template<typename F>
-		void IterateEvents(F&& callback)
+		void IterateEvents(F&& callback, size_t firstEvent = 0)
 		{
-			if (m_events.empty())
+			for (size_t eventIndex = firstEvent; eventIndex < m_events.size(); ++eventIndex)
 			{
-				return;
+				callback(m_events[eventIndex]);
 			}
+		}
 
-			for (const SDL_Event& evt : m_events)
-			{
-				callback(evt);
-			}
+		size_t GetEventCount() const { return m_events.size(); }
+		// Key transitions the input thread lost to a full queue, over the whole run
+		unsigned long GetDroppedInputEvents() const
+		{
+			return m_pInputThread ? m_pInputThread->GetDroppedEvents() : 0;
 		}
 
 	private:
+		void PollEvents();
+		void DrainInputThread();
+
 		std::vector<SDL_Event>   m_events;
 		std::shared_ptr<IGame>   m_pGame;
+		std::unique_ptr<InputThread>   m_pInputThread;
+		// By scancode; the keys whose events come from the input thread
+		std::vector<bool>   m_threadKeys;
 	};
 
 
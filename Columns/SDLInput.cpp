@@ -4,8 +4,10 @@
 #include <ctime>
 
 geng::sdl::Input::Input()
-	:TemplatedGameComponent<IInput>("SDLInput")
+	:TemplatedGameComponent<IInput>("SDLInput"),
+	m_keys(SDL_NUM_SCANCODES)
 {
+	m_charSlots.fill(NO_SLOT);
 
 }
 
@@ -26,19 +28,67 @@ bool geng::sdl::Input::Initialize(const std::shared_ptr<IGame>& pGame)
 		return false;
 	}
 
+	for (KeyCode code : m_codes)
+	{
+		m_pEventPoller->WatchKey(code);
+	}
+
 	return true;
 }
 
+size_t geng::sdl::Input::GetSlot(KeyCode code) const
+{
+	// Keys without a character carry their scancode
+	if (code & SDLK_SCANCODE_MASK)
+	{
+		size_t scancode = code & ~SDLK_SCANCODE_MASK;
+		if (scancode < SDL_NUM_SCANCODES && m_keys[scancode].subscribed)
+		{
+			return scancode;
+		}
+	}
+	else if (code < CHAR_SLOT_COUNT)
+	{
+		return m_charSlots[code];
+	}
+
+	auto itSlot = m_otherSlots.find(code);
+	return itSlot != m_otherSlots.end() ? itSlot->second : NO_SLOT;
+}
+
 void geng::sdl::Input::AddCode(KeyCode code)
 {
-	if (m_state.count(code) == 0)
+	if (GetSlot(code) != NO_SLOT)
 	{
-		KeyData_ kdata;
-		kdata.state.keyCode = code;
-		kdata.state.finalState = KeySignal::KeyUp;
-		kdata.state.numChanges = 0;
+		return;
+	}
 
-		m_state.emplace(code, kdata);
+	size_t slot;
+	SDL_Scancode scancode = SDL_GetScancodeFromKey(code);
+	if (scancode > SDL_SCANCODE_UNKNOWN && scancode < SDL_NUM_SCANCODES)
+	{
+		slot = scancode;
+	}
+	else
+	{
+		slot = m_keys.size();
+		m_keys.emplace_back();
+	}
+
+	m_keys[slot].subscribed = true;
+	if (code < CHAR_SLOT_COUNT)
+	{
+		m_charSlots[code] = slot;
+	}
+	else if (!(code & SDLK_SCANCODE_MASK) || slot >= SDL_NUM_SCANCODES)
+	{
+		m_otherSlots.emplace(code, slot);
+	}
+
+	m_codes.emplace_back(code);
+	if (m_pEventPoller)
+	{
+		m_pEventPoller->WatchKey(code);
 	}
 }
 
@@ -50,13 +100,16 @@ bool geng::sdl::Input::QueryInput(MouseState* pMouseState,
 {
 	for (size_t i = 0; i < nKeyStates; ++i)
 	{
-		auto itCode = m_state.find(ppKeyStates[i]->keyCode);
-		if (itCode == m_state.end())
+		size_t slot = GetSlot(ppKeyStates[i]->keyCode);
+		if (slot == NO_SLOT)
 		{
 			return false;
 		}
 
-		*ppKeyStates[i] = itCode->second.state;
+		const KeyData_& rKey = m_keys[slot];
+		ppKeyStates[i]->finalState = rKey.finalState;
+		ppKeyStates[i]->numChanges = rKey.generation == m_generation ? rKey.numChanges : 0;
+		ppKeyStates[i]->changeTime = rKey.changeTime;
 	}
 
 	if (pkeyboardState)
@@ -69,64 +122,109 @@ bool geng::sdl::Input::QueryInput(MouseState* pMouseState,
 
 bool geng::sdl::Input::ForceState(const KeyState& keyState)
 {
-	auto itState = m_state.find(keyState.keyCode);
-	if (itState != m_state.end())
+	size_t slot = GetSlot(keyState.keyCode);
+	if (slot != NO_SLOT)
 	{
-		itState->second.state = keyState;
+		KeyData_& rKey = m_keys[slot];
+		rKey.finalState = keyState.finalState;
+		rKey.numChanges = keyState.numChanges;
+		rKey.changeTime = keyState.changeTime;
+		rKey.generation = m_generation;
 		return true;
 	}
 
 	return false;
 }
 
-void geng::sdl::Input::OnFrame(const SimState& simState, const SimContextState* pContextState)
+bool geng::sdl::Input::OnKeyEvent(const SDL_Event& rEvent, bool latched)
 {
-	// Reset the keystate
-	for (auto& rKeyPair : m_state)
+	if (rEvent.type != SDL_KEYDOWN && rEvent.type != SDL_KEYUP)
 	{
-		rKeyPair.second.state.numChanges = 0;
+		return false;
 	}
 
-	m_downKeys = 0;
+	SDL_Scancode scancode = rEvent.key.keysym.scancode;
+	if (scancode <= SDL_SCANCODE_UNKNOWN || scancode >= SDL_NUM_SCANCODES
+		|| !m_keys[scancode].subscribed)
+	{
+		return false;
+	}
+
+	KeyData_& rKey = m_keys[scancode];
 
 #ifndef NDEBUG
-	g_keyChangedThisFrame = false;
+	g_keyChangedThisFrame = true;
 #endif
 
-	auto evtHandler = [this](const SDL_Event& rEvent)
+	KeySignal newSignal = rEvent.type == SDL_KEYDOWN ? KeySignal::KeyDown : KeySignal::KeyUp;
+
+	if (rKey.generation != m_generation)
+	{
+		rKey.numChanges = 0;
+		rKey.generation = m_generation;
+	}
+
+	if (newSignal != rKey.finalState)
 	{
-		if (rEvent.type != SDL_KEYDOWN && rEvent.type != SDL_KEYUP)
+		if (rKey.numChanges == 0)
 		{
-			return false;
+			rKey.changeTime = rEvent.key.timestamp;
 		}
+		++rKey.numChanges;
+		rKey.finalState = newSignal;
 
-		KeyCode kcod = rEvent.key.keysym.sym;
-
-		auto itKey = m_state.find(kcod);
+		rEvent.type == SDL_KEYDOWN ? ++m_downKeys : --m_downKeys;
 
-		if (itKey == m_state.end())
+		if (latched)
 		{
-			return false;
+			if (rKey.latchedChanges == 0)
+			{
+				rKey.latchedChangeTime = rEvent.key.timestamp;
+				m_latchedSlots.emplace_back(scancode);
+			}
+			++rKey.latchedChanges;
 		}
+	}
 
-#ifndef NDEBUG
-		g_keyChangedThisFrame = true;
-#endif
+	return true;
+}
 
-		KeySignal newSignal = rEvent.type == SDL_KEYDOWN ? KeySignal::KeyDown : KeySignal::KeyUp;
+void geng::sdl::Input::LatchInput()
+{
+	m_pEventPoller->LatchEvents();
+	m_pEventPoller->IterateEvents([this](const SDL_Event& rEvent) { return OnKeyEvent(rEvent, true); },
+		m_eventsSeen);
+	m_eventsSeen = m_pEventPoller->GetEventCount();
+}
 
-		if (newSignal != itKey->second.state.finalState)
-		{
-			++itKey->second.state.numChanges;
-			itKey->second.state.finalState = newSignal;
-			
-			rEvent.type == SDL_KEYDOWN ? ++m_downKeys : --m_downKeys;
-		}
+unsigned long geng::sdl::Input::GetInputTime() const
+{
+	// The clock SDL stamps its events with
+	return SDL_GetTicks();
+}
 
-		return true;
-	};
+void geng::sdl::Input::OnFrame(const SimState& simState, const SimContextState* pContextState)
+{
+	// Every key's changes are from an older frame now
+	++m_generation;
+	m_downKeys = 0;
+
+	for (size_t slot : m_latchedSlots)
+	{
+		KeyData_& rKey = m_keys[slot];
+		rKey.numChanges = rKey.latchedChanges;
+		rKey.changeTime = rKey.latchedChangeTime;
+		rKey.generation = m_generation;
+		rKey.latchedChanges = 0;
+	}
+	m_latchedSlots.clear();
+
+#ifndef NDEBUG
+	g_keyChangedThisFrame = false;
+#endif
 
-	m_pEventPoller->IterateEvents(evtHandler);
+	m_pEventPoller->IterateEvents([this](const SDL_Event& rEvent) { return OnKeyEvent(rEvent, false); });
+	m_eventsSeen = m_pEventPoller->GetEventCount();
 	
 	/*
 #ifndef NDEBUG
@@ -134,11 +232,13 @@ void geng::sdl::Input::OnFrame(const SimState& simState, const SimContextState*
 	{
 		fprintf(stderr, ">>>>\n");
 
-		for (auto& rKeyPair : m_state)
+		for (size_t slot = 0; slot < m_keys.size(); ++slot)
 		{
-			fprintf(stderr, "key %d state %d numchanges %d\n",
-				rKeyPair.first, rKeyPair.second.state.finalState,
-				rKeyPair.second.state.numChanges);
+			if (m_keys[slot].subscribed)
+			{
+				fprintf(stderr, "key %zu state %d numchanges %d\n",
+					slot, m_keys[slot].finalState, m_keys[slot].numChanges);
+			}
 		}
 		fprintf(stderr, "<<<<\n");
 	}
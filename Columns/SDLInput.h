@@ -5,8 +5,10 @@
 #include "SDLEventPoller.h"
 #include "IGame.h"
 
+#include <array>
+#include <vector>
+#include <limits>
 #include <unordered_map>
-#include <unordered_set>
 
 namespace geng::sdl
 {
@@ -17,8 +19,20 @@ namespace geng::sdl
 	private:
 		struct KeyData_
 		{
-			KeyState state;
+			KeySignal finalState{ KeySignal::KeyUp };
+			// Counts for the current frame only when the generation is the current one,
+			// so starting a frame doesn't have to touch every key
+			unsigned int numChanges{ 0 };
+			unsigned long changeTime{ 0 };
+			unsigned long generation{ 0 };
+			bool subscribed{ false };
+			// Changes a latch took in, which count again in the next frame
+			unsigned int latchedChanges{ 0 };
+			unsigned long latchedChangeTime{ 0 };
 		};
+
+		static constexpr size_t NO_SLOT = std::numeric_limits<size_t>::max();
+		static constexpr size_t CHAR_SLOT_COUNT = 128;
 	public:
 
 		Input();
@@ -31,14 +45,34 @@ namespace geng::sdl
 			KeyboardState* pkeyboardState,
 			KeyState** ppKeyStates,
 			size_t nKeyStates) override;
+		void LatchInput() override;
+		unsigned long GetInputTime() const override;
 
 	private:
+		// The key's slot in m_keys, or NO_SLOT if it was never added
+		size_t GetSlot(KeyCode code) const;
+		bool OnKeyEvent(const SDL_Event& rEvent, bool latched);
+
 		// The event poller polls events for the frame
 		std::shared_ptr<EventPoller>   m_pEventPoller;
-		std::unordered_map<KeyCode, KeyData_>   m_state;
+		// Indexed by scancode, so events go straight to their key.  Keys with no scancode
+		// (which SDL never sends, but can still be queried and forced) come after
+		std::vector<KeyData_>   m_keys;
+		// Key code to slot.  Keys without a character carry their scancode already;
+		// characters are looked up once and kept here
+		std::array<size_t, CHAR_SLOT_COUNT>   m_charSlots;
+		std::unordered_map<KeyCode, size_t>   m_otherSlots;
+		// Every key added, for the poller once it's there
+		std::vector<KeyCode>   m_codes;
+		unsigned long m_generation{ 0 };
 		unsigned int m_downKeys{ 0 };
+		// How many of the poller's events have been taken in this frame
+		size_t m_eventsSeen{ 0 };
+		// Keys a latch changed in the last frame.  Whatever read them before the latch
+		// (the executive) would miss those changes, so they're carried into the next frame
+		std::vector<size_t> m_latchedSlots;
 
 	};
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,104 @@
+#include "SDLKeySampler.h"
+
+#include <SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+
+#pragma comment(lib, "winmm.lib")
+
+namespace
+{
+	class AsyncKeySampler : public geng::IInputEventSource
+	{
+	public:
+		AsyncKeySampler()
+		{
+			// Sleeps are otherwise rounded up to the 15.6ms system tick
+			timeBeginPeriod(1);
+		}
+
+		~AsyncKeySampler() override
+		{
+			timeEndPeriod(1);
+		}
+
+		bool CanSample(geng::KeyCode keyCode) const override
+		{
+			return GetVirtualKey(keyCode) != 0;
+		}
+
+		void Sample(const std::vector<geng::KeyCode>& keys, std::vector<geng::InputEvent>& rEvents) override
+		{
+			if (m_keyDown.size() < keys.size())
+			{
+				m_keyDown.resize(keys.size(), false);
+			}
+
+			unsigned long now = SDL_GetTicks();
+			for (size_t keyIndex = 0; keyIndex < keys.size(); ++keyIndex)
+			{
+				bool keyDown = (GetAsyncKeyState(GetVirtualKey(keys[keyIndex])) & 0x8000) != 0;
+				if (keyDown != m_keyDown[keyIndex])
+				{
+					m_keyDown[keyIndex] = keyDown;
+					rEvents.emplace_back(geng::InputEvent{ keys[keyIndex],
+						keyDown ? geng::KeySignal::KeyDown : geng::KeySignal::KeyUp,
+						now });
+				}
+			}
+		}
+
+	private:
+		// The Windows virtual key for an SDL key code, or 0 for keys this doesn't know
+		static int GetVirtualKey(geng::KeyCode keyCode)
+		{
+			if (keyCode >= SDLK_a && keyCode <= SDLK_z)
+			{
+				return 'A' + (keyCode - SDLK_a);
+			}
+			if (keyCode >= SDLK_0 && keyCode <= SDLK_9)
+			{
+				return '0' + (keyCode - SDLK_0);
+			}
+			if (keyCode >= SDLK_F1 && keyCode <= SDLK_F12)
+			{
+				return VK_F1 + (keyCode - SDLK_F1);
+			}
+
+			switch (keyCode)
+			{
+			case SDLK_SPACE: return VK_SPACE;
+			case SDLK_ESCAPE: return VK_ESCAPE;
+			case SDLK_RETURN: return VK_RETURN;
+			case SDLK_TAB: return VK_TAB;
+			case SDLK_BACKSPACE: return VK_BACK;
+			case SDLK_LEFT: return VK_LEFT;
+			case SDLK_RIGHT: return VK_RIGHT;
+			case SDLK_UP: return VK_UP;
+			case SDLK_DOWN: return VK_DOWN;
+			default: return 0;
+			}
+		}
+
+		// By the key's place in the list
+		std::vector<bool> m_keyDown;
+	};
+}
+
+std::unique_ptr<geng::IInputEventSource> geng::sdl::CreateKeySampler()
+{
+	return std::unique_ptr<IInputEventSource>(new AsyncKeySampler());
+}
+
+#else
+
+std::unique_ptr<geng::IInputEventSource> geng::sdl::CreateKeySampler()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "InputThread.h"
+
+#include <memory>
+
+namespace geng::sdl
+{
+	// An event source for the input thread that reads the keyboard from the system directly.
+	// SDL only hears about keys when the thread that owns the window pumps its events, so it
+	// can't be sampled any faster than the frames go by.  On Windows this polls GetAsyncKeyState;
+	// elsewhere there's no way to, and this returns null.
+	// Key codes are SDL's, and the times are on SDL's tick clock, as SDL's own key events are
+	std::unique_ptr<IInputEventSource> CreateKeySampler();
+}
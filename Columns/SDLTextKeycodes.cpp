@@ -49,7 +49,7 @@ char geng::sdl::GetTextFromKeyCode(KeyCode kcode)
 		std::make_pair(SDLK_x, 'x'),
 		std::make_pair(SDLK_y, 'y'),
 		std::make_pair(SDLK_z, 'z'),
-		std::make_pair(SDLK_0, '1'),
+		std::make_pair(SDLK_0, '0'),
 		std::make_pair(SDLK_1, '1'),
 		std::make_pair(SDLK_2, '2'),
 		std::make_pair(SDLK_3, '3'),
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace geng
+{
+	constexpr size_t CACHE_LINE_SIZE = 64;
+
+	// A bounded queue for exactly one thread pushing and one thread popping, with no locks.
+	// Each side keeps its own copy of the other's position and only reloads it when the queue
+	// looks full (or empty), so in the common case the two threads don't touch each other's lines
+	template<typename T>
+	class SPSCQueue
+	{
+	public:
+		// The capacity is rounded up to a power of two
+		explicit SPSCQueue(size_t capacity)
+		{
+			size_t slotCount = 1;
+			while (slotCount < capacity)
+			{
+				slotCount <<= 1;
+			}
+			m_slots.resize(slotCount);
+			m_mask = slotCount - 1;
+		}
+
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		// Producer only.  False if the queue is full
+		bool Push(const T& value)
+		{
+			size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_headCache == m_slots.size())
+			{
+				m_headCache = m_head.load(std::memory_order_acquire);
+				if (tail - m_headCache == m_slots.size())
+				{
+					return false;
+				}
+			}
+
+			m_slots[tail & m_mask] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only.  False if the queue is empty
+		bool Pop(T& rValue)
+		{
+			size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tailCache)
+			{
+				m_tailCache = m_tail.load(std::memory_order_acquire);
+				if (head == m_tailCache)
+				{
+					return false;
+				}
+			}
+
+			rValue = m_slots[head & m_mask];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		size_t GetCapacity() const { return m_slots.size(); }
+
+	private:
+		std::vector<T> m_slots;
+		size_t m_mask{ 0 };
+
+		// The consumer's side
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head{ 0 };
+		size_t m_tailCache{ 0 };
+
+		// The producer's side
+		alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail{ 0 };
+		size_t m_headCache{ 0 };
+	};
+}
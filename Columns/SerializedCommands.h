@@ -4,6 +4,7 @@
 #include "Packet.h"
 
 #include <memory>
+#include <vector>
 #include <cinttypes>
 
 namespace geng
@@ -38,6 +39,14 @@ namespace geng
 			virtual ICommandDelta*
 				AllocateDeltaObject() = 0;
 		};
+
+		// Where a recording of a game already in progress starts.  The game state is opaque
+		// to the command layer
+		struct CommandStartState
+		{
+			unsigned long frame{ 0 };
+			std::vector<uint8_t> gameState;
+		};
 	}
 
 }
\ No newline at end of file
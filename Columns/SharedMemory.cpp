@@ -0,0 +1,208 @@
+#include "SharedMemory.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	std::string SystemName(const char* pName)
+	{
+#ifdef _WIN32
+		std::string systemName = "Local\\geng_";
+#else
+		std::string systemName = "/geng_";
+#endif
+		systemName += pName;
+		return systemName;
+	}
+}
+
+geng::SharedMemoryRegion::~SharedMemoryRegion()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool geng::SharedMemoryRegion::Create(const char* pName, size_t size)
+{
+	Close();
+	m_systemName = SystemName(pName);
+
+	// New mappings backed by the paging file come zero-filled
+	HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		(DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xffffffff), m_systemName.c_str());
+	if (!hMapping)
+	{
+		m_error = "Could not create shared memory: " + m_systemName;
+		return false;
+	}
+	// The name lives as long as any process has it open, so it may still be held by a reader
+	bool alreadyExists = GetLastError() == ERROR_ALREADY_EXISTS;
+
+	m_pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!m_pData)
+	{
+		CloseHandle(hMapping);
+		m_error = "Could not map shared memory: " + m_systemName;
+		return false;
+	}
+	if (alreadyExists)
+	{
+		memset(m_pData, 0, size);
+	}
+
+	m_handle = (intptr_t)hMapping;
+	m_size = size;
+	m_isOwner = true;
+	return true;
+}
+
+bool geng::SharedMemoryRegion::Open(const char* pName)
+{
+	Close();
+	m_systemName = SystemName(pName);
+
+	HANDLE hMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, m_systemName.c_str());
+	if (!hMapping)
+	{
+		m_error = "No shared memory named " + m_systemName;
+		return false;
+	}
+
+	m_pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+	if (!m_pData)
+	{
+		CloseHandle(hMapping);
+		m_error = "Could not map shared memory: " + m_systemName;
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION memInfo;
+	VirtualQuery(m_pData, &memInfo, sizeof(memInfo));
+	m_handle = (intptr_t)hMapping;
+	m_size = memInfo.RegionSize;
+	return true;
+}
+
+void geng::SharedMemoryRegion::Close()
+{
+	if (m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+	if (m_handle != -1)
+	{
+		// The name goes away with the last handle
+		CloseHandle((HANDLE)m_handle);
+		m_handle = -1;
+	}
+	m_size = 0;
+	m_isOwner = false;
+}
+
+#else
+
+bool geng::SharedMemoryRegion::Create(const char* pName, size_t size)
+{
+	Close();
+	m_systemName = SystemName(pName);
+
+	// A region left behind by a process that died is simply replaced
+	shm_unlink(m_systemName.c_str());
+	int fd = shm_open(m_systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0)
+	{
+		m_error = "Could not create shared memory: " + m_systemName;
+		return false;
+	}
+
+	if (ftruncate(fd, (off_t)size) != 0)
+	{
+		close(fd);
+		shm_unlink(m_systemName.c_str());
+		m_error = "Could not size shared memory: " + m_systemName;
+		return false;
+	}
+
+	void* pData = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pData == MAP_FAILED)
+	{
+		close(fd);
+		shm_unlink(m_systemName.c_str());
+		m_error = "Could not map shared memory: " + m_systemName;
+		return false;
+	}
+
+	m_pData = pData;
+	m_handle = fd;
+	m_size = size;
+	m_isOwner = true;
+	return true;
+}
+
+bool geng::SharedMemoryRegion::Open(const char* pName)
+{
+	Close();
+	m_systemName = SystemName(pName);
+
+	int fd = shm_open(m_systemName.c_str(), O_RDWR, 0);
+	if (fd < 0)
+	{
+		m_error = "No shared memory named " + m_systemName;
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+	{
+		close(fd);
+		m_error = "Could not size shared memory: " + m_systemName;
+		return false;
+	}
+
+	void* pData = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pData == MAP_FAILED)
+	{
+		close(fd);
+		m_error = "Could not map shared memory: " + m_systemName;
+		return false;
+	}
+
+	m_pData = pData;
+	m_handle = fd;
+	m_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+void geng::SharedMemoryRegion::Close()
+{
+	if (m_pData)
+	{
+		munmap(m_pData, m_size);
+		m_pData = nullptr;
+	}
+	if (m_handle != -1)
+	{
+		close((int)m_handle);
+		m_handle = -1;
+	}
+	if (m_isOwner)
+	{
+		shm_unlink(m_systemName.c_str());
+	}
+	m_size = 0;
+	m_isOwner = false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace geng
+{
+	// A named block of memory shared between processes.  The creator owns the name:  when it
+	// closes the region, the name goes away, but processes that have it open keep their mapping
+	class SharedMemoryRegion
+	{
+	public:
+		SharedMemoryRegion() = default;
+		~SharedMemoryRegion();
+
+		SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+		SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+		// Create a zero-filled region.  A region left over under the same name is taken over
+		bool Create(const char* pName, size_t size);
+		// Map an existing region
+		bool Open(const char* pName);
+		void Close();
+
+		void* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_size; }
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		std::string m_systemName;
+		void* m_pData{ nullptr };
+		size_t m_size{ 0 };
+		bool m_isOwner{ false };
+		// File descriptor or mapping handle
+		intptr_t m_handle{ -1 };
+		std::string m_error;
+	};
+}
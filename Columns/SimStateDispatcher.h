@@ -2,6 +2,7 @@
 
 #include <variant>
 #include <functional>
+#include <utility>
 
 namespace geng
 {
@@ -68,7 +69,20 @@ namespace geng
 
 		}
 
+		// Put the dispatcher straight into the state with the given index, without the enter
+		// and exit callbacks.  For restoring a saved state
+		bool RestoreStateIndex(size_t stateIndex)
+		{
+			return RestoreStateIndex_(stateIndex, std::index_sequence_for<States...>());
+		}
+
 	private:
+		template<size_t ... StateIndices>
+		bool RestoreStateIndex_(size_t stateIndex, std::index_sequence<StateIndices...>)
+		{
+			return ((stateIndex == StateIndices ? (m_varStates.template emplace<StateIndices>(), true) : false) || ...);
+		}
+
 		std::variant<States...>  m_varStates;
 	};
 
@@ -0,0 +1,578 @@
+#include "SpectatorFeed.h"
+#include "Packet.h"
+
+#include <atomic>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+	constexpr char FEED_MAGIC[16] = "GengSpectator";
+	constexpr uint32_t FEED_LAYOUT_VERSION = 2;
+
+	constexpr size_t SESSION_CAPACITY = 16 * 1024;
+	constexpr size_t SNAPSHOT_CAPACITY = 16 * 1024;
+	// Must be a power of two
+	constexpr size_t RING_CAPACITY = 1024 * 1024;
+
+	// How many times a reader retries a snapshot that is being rewritten under it
+	constexpr unsigned int SNAPSHOT_RETRIES = 64;
+
+	struct FrameRecordHeader_
+	{
+		uint32_t recordSize;  // including the header
+		uint32_t frame;
+		uint64_t commandHash;
+		uint32_t changeCount;
+		// 0 if the game hadn't sent its state, in which case there's no state hash
+		uint32_t simStateSize;
+		uint64_t simStateHash;
+	};
+
+	constexpr uint64_t INITIAL_COMMAND_HASH = 0xcbf29ce484222325;
+	constexpr uint64_t FNV_PRIME = 0x100000001b3;
+
+	// FNV-1a, continued from the previous frame's hash
+	uint64_t HashFrame(uint64_t prevHash, uint32_t frame, const uint8_t* pPayload, size_t payloadSize)
+	{
+		uint64_t hash = prevHash;
+		for (size_t i = 0; i < sizeof(frame); ++i)
+		{
+			hash = (hash ^ ((frame >> (8 * i)) & 0xff)) * FNV_PRIME;
+		}
+		for (size_t i = 0; i < payloadSize; ++i)
+		{
+			hash = (hash ^ pPayload[i]) * FNV_PRIME;
+		}
+		return hash;
+	}
+}
+
+uint64_t geng::serial::HashSimState(const void* pState, size_t size)
+{
+	const uint8_t* pBytes = static_cast<const uint8_t*>(pState);
+	uint64_t hash = INITIAL_COMMAND_HASH;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ pBytes[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+// The writer fills in everything up to the session description, then sets "ready".
+// Frame records go into the ring at increasing positions; reservePos runs ahead of the bytes
+// being written and writePos follows once they are in place, so a reader that copied a
+// record and then finds reservePos less than a ring ahead of it knows the copy is intact.
+// The snapshot is guarded the same way by a sequence number that is odd while it's rewritten
+struct geng::serial::SpectatorFeedLayout
+{
+	char magic[16];
+	uint32_t layoutVersion;
+	std::atomic<uint32_t> ready;
+	std::atomic<uint32_t> ended;
+	std::atomic<uint64_t> sessionId;
+	std::atomic<uint64_t> reservePos;
+	std::atomic<uint64_t> writePos;
+	std::atomic<uint64_t> snapshotSeq;
+	std::atomic<uint32_t> snapshotSize;
+	uint32_t sessionSize;
+	uint8_t session[SESSION_CAPACITY];
+	uint8_t snapshot[SNAPSHOT_CAPACITY];
+	uint8_t ring[RING_CAPACITY];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Spectator feed needs lock-free 64-bit atomics");
+static_assert(std::is_standard_layout_v<geng::serial::SpectatorFeedLayout>, "Spectator feed layout must be plain");
+static_assert((RING_CAPACITY & (RING_CAPACITY - 1)) == 0, "Ring capacity must be a power of two");
+
+// SpectatorFeedWriter
+geng::serial::SpectatorFeedWriter::Command_::Command_(const std::shared_ptr<ISerializableCommand>& pCommand_)
+	:pCommand(pCommand_),
+	pDelta(pCommand_->AllocateDeltaObject())
+{ }
+
+geng::serial::SpectatorFeedWriter::SpectatorFeedWriter(const char* pFeedName,
+	const std::shared_ptr<IPacket>& pDescriptionPacket,
+	const std::vector<std::shared_ptr<ISerializableCommand> >& commandList)
+	:m_commandHash(INITIAL_COMMAND_HASH)
+{
+	// Session description:  the description packet, then the command keys
+	MemoryWriteStream sessionStream;
+	MemoryWriteStream descriptionStream;
+	pDescriptionPacket->Write(&descriptionStream);
+	EncodeData(&sessionStream, (uint32_t)descriptionStream.GetSize());
+	sessionStream.Write(descriptionStream.GetData(), descriptionStream.GetSize());
+
+	EncodeData(&sessionStream, (uint16_t)commandList.size());
+	for (const auto& pCommand : commandList)
+	{
+		std::string cmdKey{ pCommand->GetKey() };
+		EncodeData(&sessionStream, (uint16_t)cmdKey.size());
+		sessionStream.Write(cmdKey.c_str(), cmdKey.size());
+		m_commands.emplace_back(pCommand);
+	}
+
+	if (sessionStream.GetSize() > SESSION_CAPACITY)
+	{
+		m_error = "Spectator feed: session description is too large";
+		return;
+	}
+
+	if (!m_region.Create(pFeedName, sizeof(SpectatorFeedLayout)))
+	{
+		m_error = m_region.GetError();
+		return;
+	}
+
+	m_pLayout = static_cast<SpectatorFeedLayout*>(m_region.GetData());
+	memcpy(m_pLayout->magic, FEED_MAGIC, sizeof(FEED_MAGIC));
+	m_pLayout->layoutVersion = FEED_LAYOUT_VERSION;
+	m_pLayout->sessionSize = (uint32_t)sessionStream.GetSize();
+	memcpy(m_pLayout->session, sessionStream.GetData(), sessionStream.GetSize());
+
+	// Readers left over from a previous game can tell that this is a new one
+	std::random_device randomDevice;
+	uint64_t sessionId = ((uint64_t)randomDevice() << 32) | randomDevice() | 1;
+	m_pLayout->sessionId.store(sessionId, std::memory_order_relaxed);
+	m_pLayout->ready.store(1, std::memory_order_release);
+
+	m_valid = true;
+}
+
+geng::serial::SpectatorFeedWriter::~SpectatorFeedWriter()
+{
+	EndSession();
+}
+
+void geng::serial::SpectatorFeedWriter::BeginFrame(unsigned long curFrame)
+{
+	m_currentFrame = curFrame;
+}
+
+void geng::serial::SpectatorFeedWriter::SetSimState(const void* pState, size_t size)
+{
+	const uint8_t* pBytes = static_cast<const uint8_t*>(pState);
+	m_simState.assign(pBytes, pBytes + size);
+	m_simStateHash = HashSimState(pState, size);
+}
+
+bool geng::serial::SpectatorFeedWriter::WriteDelta(MemoryWriteStream& rStream, uint32_t commandIndex,
+	ICommandDelta& rDelta)
+{
+	// Deltas are prefixed with their size, so that readers can skip commands they don't know
+	m_deltaStream.Clear();
+	if (!rDelta.Write(&m_deltaStream) || m_deltaStream.GetSize() > std::numeric_limits<uint16_t>::max())
+	{
+		return false;
+	}
+
+	EncodeData(&rStream, commandIndex);
+	EncodeData(&rStream, (uint16_t)m_deltaStream.GetSize());
+	rStream.Write(m_deltaStream.GetData(), m_deltaStream.GetSize());
+	return true;
+}
+
+void geng::serial::SpectatorFeedWriter::EndFrame(const CommandChangeList& changes)
+{
+	if (!m_valid || m_sessionEnded)
+	{
+		return;
+	}
+
+	m_frameStream.Clear();
+	uint32_t changeCount = 0;
+	for (uint32_t cmdIdx : changes)
+	{
+		Command_& cmd = m_commands[cmdIdx];
+		cmd.pDelta->OnCommand(*cmd.pCommand);
+		if (cmd.pDelta->HasDelta() && WriteDelta(m_frameStream, cmdIdx, *cmd.pDelta))
+		{
+			++changeCount;
+		}
+	}
+
+	FrameRecordHeader_ recordHeader{};
+	recordHeader.recordSize = (uint32_t)(sizeof(recordHeader) + m_frameStream.GetSize());
+	if (recordHeader.recordSize > RING_CAPACITY / 2)
+	{
+		// Can't happen with any sane set of commands
+		return;
+	}
+	recordHeader.frame = (uint32_t)m_currentFrame;
+	recordHeader.changeCount = changeCount;
+	m_commandHash = HashFrame(m_commandHash, recordHeader.frame, m_frameStream.GetData(), m_frameStream.GetSize());
+	recordHeader.commandHash = m_commandHash;
+	recordHeader.simStateSize = (uint32_t)m_simState.size();
+	recordHeader.simStateHash = m_simStateHash;
+
+	// Claim the space first, so that readers can tell if their copy may have been overwritten
+	uint64_t writePos = m_pLayout->writePos.load(std::memory_order_relaxed);
+	uint64_t recordEnd = writePos + recordHeader.recordSize;
+	m_pLayout->reservePos.store(recordEnd, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	auto writeRing = [this](uint64_t ringPos, const void* pData, size_t size)
+	{
+		size_t offset = (size_t)(ringPos & (RING_CAPACITY - 1));
+		size_t firstPart = std::min(size, RING_CAPACITY - offset);
+		memcpy(m_pLayout->ring + offset, pData, firstPart);
+		memcpy(m_pLayout->ring, static_cast<const uint8_t*>(pData) + firstPart, size - firstPart);
+	};
+	writeRing(writePos, &recordHeader, sizeof(recordHeader));
+	if (m_frameStream.GetSize() > 0)
+	{
+		writeRing(writePos + sizeof(recordHeader), m_frameStream.GetData(), m_frameStream.GetSize());
+	}
+
+	m_pLayout->writePos.store(recordEnd, std::memory_order_release);
+
+	if (!m_hasSnapshot || m_currentFrame - m_lastSnapshotFrame >= SPECTATOR_SNAPSHOT_INTERVAL)
+	{
+		PublishSnapshot();
+	}
+}
+
+void geng::serial::SpectatorFeedWriter::PublishSnapshot()
+{
+	// Frame, hash, the ring position the snapshot is good for, the game state the frame started
+	// from, then a delta from the reset state for every command that isn't in it
+	m_snapshotStream.Clear();
+	EncodeData(&m_snapshotStream, (uint32_t)m_currentFrame);
+	EncodeData(&m_snapshotStream, m_commandHash);
+	EncodeData(&m_snapshotStream, m_pLayout->writePos.load(std::memory_order_relaxed));
+	EncodeData(&m_snapshotStream, (uint32_t)m_simState.size());
+	if (!m_simState.empty())
+	{
+		m_snapshotStream.Write(m_simState.data(), m_simState.size());
+	}
+
+	MemoryWriteStream deltaList;
+	uint32_t deltaCount = 0;
+	for (uint32_t cmdIdx = 0; cmdIdx < m_commands.size(); ++cmdIdx)
+	{
+		std::unique_ptr<ICommandDelta> pKeyDelta(m_commands[cmdIdx].pCommand->AllocateDeltaObject());
+		pKeyDelta->OnCommand(*m_commands[cmdIdx].pCommand);
+		if (pKeyDelta->HasDelta() && WriteDelta(deltaList, cmdIdx, *pKeyDelta))
+		{
+			++deltaCount;
+		}
+	}
+	EncodeData(&m_snapshotStream, deltaCount);
+	m_snapshotStream.Write(deltaList.GetData(), deltaList.GetSize());
+
+	if (m_snapshotStream.GetSize() > SNAPSHOT_CAPACITY)
+	{
+		return;
+	}
+
+	uint64_t snapshotSeq = m_pLayout->snapshotSeq.load(std::memory_order_relaxed);
+	m_pLayout->snapshotSeq.store(snapshotSeq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(m_pLayout->snapshot, m_snapshotStream.GetData(), m_snapshotStream.GetSize());
+	m_pLayout->snapshotSize.store((uint32_t)m_snapshotStream.GetSize(), std::memory_order_relaxed);
+
+	m_pLayout->snapshotSeq.store(snapshotSeq + 2, std::memory_order_release);
+
+	m_lastSnapshotFrame = m_currentFrame;
+	m_hasSnapshot = true;
+}
+
+void geng::serial::SpectatorFeedWriter::EndSession()
+{
+	if (m_valid && !m_sessionEnded)
+	{
+		m_pLayout->ended.store(1, std::memory_order_release);
+	}
+	m_sessionEnded = true;
+}
+
+// SpectatorFeedReader
+geng::serial::SpectatorFeedReader::SpectatorFeedReader(const char* pFeedName)
+{
+	if (!m_region.Open(pFeedName))
+	{
+		m_error = m_region.GetError();
+		return;
+	}
+
+	if (m_region.GetSize() < sizeof(SpectatorFeedLayout))
+	{
+		m_error = "Spectator feed: shared memory is too small";
+		return;
+	}
+
+	m_pLayout = static_cast<const SpectatorFeedLayout*>(m_region.GetData());
+	if (m_pLayout->ready.load(std::memory_order_acquire) == 0)
+	{
+		m_error = "Spectator feed: the game has not started publishing";
+		return;
+	}
+
+	if (memcmp(m_pLayout->magic, FEED_MAGIC, sizeof(FEED_MAGIC)) != 0
+		|| m_pLayout->layoutVersion != FEED_LAYOUT_VERSION
+		|| m_pLayout->sessionSize > SESSION_CAPACITY)
+	{
+		m_error = "Spectator feed: not a feed, or an incompatible version";
+		return;
+	}
+	m_sessionId = m_pLayout->sessionId.load(std::memory_order_relaxed);
+
+	MemoryReadStream sessionStream(m_pLayout->session, m_pLayout->sessionSize);
+	uint32_t descriptionSize{ 0 };
+	if (!DecodeData(&sessionStream, descriptionSize) || !sessionStream.CanRead(descriptionSize))
+	{
+		m_error = "Spectator feed: bad session description";
+		return;
+	}
+	m_description.resize(descriptionSize);
+	sessionStream.Read(m_description.data(), descriptionSize);
+
+	uint16_t commandCount{ 0 };
+	if (!DecodeData(&sessionStream, commandCount))
+	{
+		m_error = "Spectator feed: bad session description";
+		return;
+	}
+	for (uint16_t cmdIdx = 0; cmdIdx < commandCount; ++cmdIdx)
+	{
+		uint16_t keySize{ 0 };
+		if (!DecodeData(&sessionStream, keySize) || !sessionStream.CanRead(keySize))
+		{
+			m_error = "Spectator feed: bad session description";
+			return;
+		}
+		std::string cmdKey(keySize, '\0');
+		sessionStream.Read(&cmdKey[0], keySize);
+		m_commandKeys.emplace_back(std::move(cmdKey));
+	}
+	m_bindings.resize(m_commandKeys.size());
+
+	m_valid = true;
+}
+
+bool geng::serial::SpectatorFeedReader::BindCommands(const std::shared_ptr<IPacket>& pDescriptionPacket,
+	const std::vector<std::shared_ptr<ISerializableCommand> >& commandList)
+{
+	if (!m_valid)
+	{
+		return false;
+	}
+
+	if (pDescriptionPacket)
+	{
+		MemoryReadStream descriptionStream(m_description.data(), m_description.size());
+		if (!pDescriptionPacket->Read(&descriptionStream))
+		{
+			m_error = "Spectator feed: could not read the description packet";
+			return false;
+		}
+	}
+
+	for (const auto& pCommand : commandList)
+	{
+		for (size_t cmdIdx = 0; cmdIdx < m_commandKeys.size(); ++cmdIdx)
+		{
+			if (m_commandKeys[cmdIdx] == pCommand->GetKey())
+			{
+				m_bindings[cmdIdx].pCommand = pCommand;
+				m_bindings[cmdIdx].pDelta.reset(pCommand->AllocateDeltaObject());
+				break;
+			}
+		}
+	}
+
+	// The commands get their state at the next resync
+	m_synced = false;
+	return true;
+}
+
+bool geng::serial::SpectatorFeedReader::IsSameSession() const
+{
+	return m_pLayout->sessionId.load(std::memory_order_acquire) == m_sessionId;
+}
+
+void geng::serial::SpectatorFeedReader::ReadRing(uint64_t ringPos, void* pBuff, size_t size) const
+{
+	size_t offset = (size_t)(ringPos & (RING_CAPACITY - 1));
+	size_t firstPart = std::min(size, RING_CAPACITY - offset);
+	memcpy(pBuff, m_pLayout->ring + offset, firstPart);
+	memcpy(static_cast<uint8_t*>(pBuff) + firstPart, m_pLayout->ring, size - firstPart);
+}
+
+bool geng::serial::SpectatorFeedReader::ApplyDeltas(MemoryReadStream& rStream, uint32_t changeCount)
+{
+	for (uint32_t changeIdx = 0; changeIdx < changeCount; ++changeIdx)
+	{
+		uint32_t cmdIdx{ 0 };
+		uint16_t deltaSize{ 0 };
+		if (!DecodeData(&rStream, cmdIdx) || !DecodeData(&rStream, deltaSize)
+			|| !rStream.CanRead(deltaSize))
+		{
+			return false;
+		}
+
+		size_t deltaPos = rStream.GetPosition();
+		if (cmdIdx < m_bindings.size() && m_bindings[cmdIdx].pCommand)
+		{
+			Binding_& binding = m_bindings[cmdIdx];
+			if (!binding.pDelta->Read(&rStream))
+			{
+				return false;
+			}
+			binding.pDelta->ApplyTo(*binding.pCommand);
+		}
+
+		// Skip whatever wasn't read
+		std::vector<uint8_t> skipped(deltaSize - (rStream.GetPosition() - deltaPos));
+		if (!skipped.empty())
+		{
+			rStream.Read(skipped.data(), skipped.size());
+		}
+	}
+	return true;
+}
+
+bool geng::serial::SpectatorFeedReader::Resync()
+{
+	std::vector<uint8_t> snapshot;
+	for (unsigned int attempt = 0; attempt < SNAPSHOT_RETRIES; ++attempt)
+	{
+		uint64_t seqBefore = m_pLayout->snapshotSeq.load(std::memory_order_acquire);
+		if (seqBefore == 0 || (seqBefore & 1) != 0)
+		{
+			// None yet, or being written
+			continue;
+		}
+
+		uint32_t snapshotSize = m_pLayout->snapshotSize.load(std::memory_order_relaxed);
+		if (snapshotSize > SNAPSHOT_CAPACITY)
+		{
+			continue;
+		}
+		snapshot.assign(m_pLayout->snapshot, m_pLayout->snapshot + snapshotSize);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_pLayout->snapshotSeq.load(std::memory_order_relaxed) != seqBefore)
+		{
+			continue;
+		}
+
+		MemoryReadStream snapshotStream(snapshot.data(), snapshot.size());
+		uint32_t frame{ 0 };
+		uint64_t commandHash{ 0 };
+		uint64_t ringPos{ 0 };
+		uint32_t simStateSize{ 0 };
+		uint32_t deltaCount{ 0 };
+		if (!DecodeData(&snapshotStream, frame)
+			|| !DecodeData(&snapshotStream, commandHash)
+			|| !DecodeData(&snapshotStream, ringPos)
+			|| !DecodeData(&snapshotStream, simStateSize)
+			|| !snapshotStream.CanRead(simStateSize))
+		{
+			return false;
+		}
+		std::vector<uint8_t> simState(simStateSize);
+		if (simStateSize > 0)
+		{
+			snapshotStream.Read(simState.data(), simStateSize);
+		}
+		if (!DecodeData(&snapshotStream, deltaCount))
+		{
+			return false;
+		}
+
+		for (Binding_& binding : m_bindings)
+		{
+			if (binding.pCommand)
+			{
+				binding.pCommand->Reset();
+			}
+		}
+		if (!ApplyDeltas(snapshotStream, deltaCount))
+		{
+			return false;
+		}
+
+		m_frame = frame;
+		m_commandHash = commandHash;
+		m_simState = std::move(simState);
+		m_hasSimStateHash = !m_simState.empty();
+		m_simStateHash = m_hasSimStateHash ? HashSimState(m_simState.data(), m_simState.size()) : 0;
+		m_readPos = ringPos;
+		m_synced = true;
+		return true;
+	}
+
+	return false;
+}
+
+geng::serial::SpectatorPollResult geng::serial::SpectatorFeedReader::Poll()
+{
+	if (!m_valid)
+	{
+		return SpectatorPollResult::Error;
+	}
+
+	if (!IsSameSession())
+	{
+		return SpectatorPollResult::Ended;
+	}
+
+	if (!m_synced)
+	{
+		return Resync() ? SpectatorPollResult::Resynced : SpectatorPollResult::NoFrame;
+	}
+
+	uint64_t writePos = m_pLayout->writePos.load(std::memory_order_acquire);
+	if (writePos == m_readPos)
+	{
+		return m_pLayout->ended.load(std::memory_order_acquire) != 0 ?
+			SpectatorPollResult::Ended
+			: SpectatorPollResult::NoFrame;
+	}
+
+	if (writePos - m_readPos > RING_CAPACITY)
+	{
+		return Resync() ? SpectatorPollResult::Resynced : SpectatorPollResult::NoFrame;
+	}
+
+	FrameRecordHeader_ recordHeader;
+	ReadRing(m_readPos, &recordHeader, sizeof(recordHeader));
+	bool sizeOK = recordHeader.recordSize >= sizeof(recordHeader)
+		&& recordHeader.recordSize <= writePos - m_readPos;
+	if (sizeOK)
+	{
+		m_record.resize(recordHeader.recordSize - sizeof(recordHeader));
+		if (!m_record.empty())
+		{
+			ReadRing(m_readPos + sizeof(recordHeader), m_record.data(), m_record.size());
+		}
+	}
+
+	// If the writer got around to this part of the ring while it was being copied, start over
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (!sizeOK
+		|| m_pLayout->reservePos.load(std::memory_order_relaxed) - m_readPos > RING_CAPACITY
+		|| HashFrame(m_commandHash, recordHeader.frame, m_record.data(), m_record.size()) != recordHeader.commandHash)
+	{
+		return Resync() ? SpectatorPollResult::Resynced : SpectatorPollResult::NoFrame;
+	}
+
+	MemoryReadStream recordStream(m_record.data(), m_record.size());
+	if (!ApplyDeltas(recordStream, recordHeader.changeCount))
+	{
+		m_error = "Spectator feed: bad frame record";
+		return SpectatorPollResult::Error;
+	}
+
+	m_readPos += recordHeader.recordSize;
+	m_frame = recordHeader.frame;
+	m_commandHash = recordHeader.commandHash;
+	m_hasSimStateHash = recordHeader.simStateSize != 0;
+	m_simStateHash = recordHeader.simStateHash;
+	return SpectatorPollResult::Frame;
+}
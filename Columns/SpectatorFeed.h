@@ -0,0 +1,168 @@
+#pragma once
+
+#include "SerializedCommands.h"
+#include "SharedMemory.h"
+#include "MemoryStream.h"
+
+#include <vector>
+#include <memory>
+#include <string>
+
+namespace geng::serial
+{
+	// How the feed is laid out in shared memory; see SpectatorFeed.cpp
+	struct SpectatorFeedLayout;
+
+	// A full snapshot of the commands is published this often, for spectators who attach mid-game
+	// or fall too far behind
+	constexpr unsigned long SPECTATOR_SNAPSHOT_INTERVAL = 50;
+
+	// The hash of a saved game state that frame records carry
+	uint64_t HashSimState(const void* pState, size_t size);
+
+	// Publishes the commands of a game into a ring buffer in shared memory, one record per frame.
+	// A record carries the frame's command deltas and a running hash of the command history, which
+	// spectators use to check that they haven't lost track, along with a hash of the game state the
+	// frame starts from.  The snapshot carries that state itself, so spectators can start mid-game.
+	// There is a single producer and any number of consumers; the producer never waits on them, and
+	// consumers who fall a whole ring behind start over from the latest snapshot
+	class SpectatorFeedWriter
+	{
+	private:
+		struct Command_
+		{
+			std::shared_ptr<ISerializableCommand>  pCommand;
+			std::unique_ptr<ICommandDelta>  pDelta;
+
+			Command_(const std::shared_ptr<ISerializableCommand>& pCommand_);
+		};
+	public:
+		SpectatorFeedWriter(const char* pFeedName,
+			const std::shared_ptr<IPacket>& pDescriptionPacket,
+			const std::vector<std::shared_ptr<ISerializableCommand> >& commandList);
+		~SpectatorFeedWriter();
+
+		void BeginFrame(unsigned long curFrame);
+		// Publishes the frame.  The change list is indexed in the order of the constructor's command list
+		void EndFrame(const CommandChangeList& changes);
+		// Tells spectators that the game is over
+		void EndSession();
+
+		// The saved game state the next frame starts from; the simulation hands it over after each
+		// frame.  Until then, frames go out without a state hash
+		void SetSimState(const void* pState, size_t size);
+
+		bool IsValid() const {
+			return m_valid;
+		}
+
+		const std::string& GetError() const {
+			return m_error;
+		}
+
+	private:
+		bool WriteDelta(MemoryWriteStream& rStream, uint32_t commandIndex, ICommandDelta& rDelta);
+		void PublishSnapshot();
+
+		SharedMemoryRegion m_region;
+		SpectatorFeedLayout* m_pLayout{ nullptr };
+
+		std::vector<Command_>  m_commands;
+		unsigned long m_currentFrame{ 0 };
+		unsigned long m_lastSnapshotFrame{ 0 };
+		bool m_hasSnapshot{ false };
+		uint64_t m_commandHash;
+		bool m_sessionEnded{ false };
+
+		std::vector<uint8_t> m_simState;
+		uint64_t m_simStateHash{ 0 };
+
+		// Reused from frame to frame
+		MemoryWriteStream m_frameStream;
+		MemoryWriteStream m_deltaStream;
+		MemoryWriteStream m_snapshotStream;
+
+		bool m_valid{ false };
+		std::string m_error;
+	};
+
+	enum class SpectatorPollResult
+	{
+		NoFrame,
+		Frame,
+		// Fell behind (or attached for the first time); the commands were loaded from a snapshot
+		Resynced,
+		// The game is over, or a new one has taken over the feed
+		Ended,
+		Error
+	};
+
+	// Follows a feed.  Bound commands are updated as each frame is read, just as they
+	// would be on playback from a file
+	class SpectatorFeedReader
+	{
+	private:
+		struct Binding_
+		{
+			std::shared_ptr<ISerializableCommand>  pCommand;
+			std::unique_ptr<ICommandDelta>  pDelta;
+		};
+
+	public:
+		SpectatorFeedReader(const char* pFeedName);
+
+		// The keys of the commands in the feed, in feed order
+		const std::vector<std::string>& GetCommandKeys() const { return m_commandKeys; }
+
+		// Read the description packet and match commands to the feed by key.  Feed commands
+		// with no match are skipped
+		bool BindCommands(const std::shared_ptr<IPacket>& pDescriptionPacket,
+			const std::vector<std::shared_ptr<ISerializableCommand> >& commandList);
+
+		// Read the next frame, if there is one.  The first call always resyncs
+		SpectatorPollResult Poll();
+
+		unsigned long GetFrame() const { return m_frame; }
+		// The running hash of the command history read so far.  It shows that the stream arrived
+		// intact, not that a simulation fed from it agrees with the game's
+		uint64_t GetCommandHash() const { return m_commandHash; }
+
+		// The game state the current frame starts from, as of the last resync; a spectator that runs
+		// its own simulation loads it and carries on from there.  Empty if the game hadn't sent one
+		const std::vector<uint8_t>& GetSimState() const { return m_simState; }
+		// The hash of the game state the current frame starts from.  A spectator's simulation that
+		// gives a different HashSimState() has gone out of sync with the game
+		bool HasSimStateHash() const { return m_hasSimStateHash; }
+		uint64_t GetSimStateHash() const { return m_simStateHash; }
+
+		bool IsValid() const { return m_valid; }
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		bool IsSameSession() const;
+		// Load the latest snapshot; false if it couldn't be read
+		bool Resync();
+		void ReadRing(uint64_t ringPos, void* pBuff, size_t size) const;
+		bool ApplyDeltas(MemoryReadStream& rStream, uint32_t changeCount);
+
+		SharedMemoryRegion m_region;
+		const SpectatorFeedLayout* m_pLayout{ nullptr };
+		uint64_t m_sessionId{ 0 };
+
+		std::vector<uint8_t> m_description;
+		std::vector<std::string> m_commandKeys;
+		std::vector<Binding_> m_bindings;
+
+		bool m_synced{ false };
+		uint64_t m_readPos{ 0 };
+		unsigned long m_frame{ 0 };
+		uint64_t m_commandHash{ 0 };
+		std::vector<uint8_t> m_simState;
+		bool m_hasSimStateHash{ false };
+		uint64_t m_simStateHash{ 0 };
+		std::vector<uint8_t> m_record;
+
+		bool m_valid{ false };
+		std::string m_error;
+	};
+}
@@ -0,0 +1,142 @@
+#include "SyntheticCommands.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+
+bool geng::ActionScript::Load(const char* pFileName)
+{
+	std::ifstream scriptFile(pFileName);
+	if (!scriptFile)
+	{
+		m_error = "ActionScript: could not open ";
+		m_error += pFileName;
+		return false;
+	}
+
+	return Parse(scriptFile);
+}
+
+bool geng::ActionScript::Parse(std::istream& is)
+{
+	m_actionNames.clear();
+	m_steps.clear();
+	m_error.clear();
+
+	std::string line;
+	unsigned long lineNumber{ 0 };
+	while (std::getline(is, line))
+	{
+		++lineNumber;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream lineStream(line);
+		std::string token;
+		if (!(lineStream >> token))
+		{
+			continue;
+		}
+
+		char* pEnd{ nullptr };
+		unsigned long frame = std::strtoul(token.c_str(), &pEnd, 10);
+		if (token[0] == '-' || *pEnd != '\0')
+		{
+			m_error = "ActionScript: line " + std::to_string(lineNumber) + " does not start with a frame";
+			return false;
+		}
+
+		if (!m_steps.empty() && frame <= m_steps.back().frame)
+		{
+			m_error = "ActionScript: line " + std::to_string(lineNumber) + " goes back in time";
+			return false;
+		}
+
+		Step_ step{ frame, {} };
+		while (lineStream >> token)
+		{
+			auto itName = std::find(m_actionNames.begin(), m_actionNames.end(), token);
+			if (itName == m_actionNames.end())
+			{
+				itName = m_actionNames.insert(m_actionNames.end(), token);
+			}
+			step.actions.emplace_back(itName - m_actionNames.begin());
+		}
+		m_steps.emplace_back(std::move(step));
+	}
+
+	return true;
+}
+
+void geng::ActionScript::GetChangeFrames(const std::string& actionName, std::vector<unsigned long>& changeFrames) const
+{
+	changeFrames.clear();
+
+	auto itName = std::find(m_actionNames.begin(), m_actionNames.end(), actionName);
+	if (itName == m_actionNames.end())
+	{
+		return;
+	}
+
+	size_t actionIndex = itName - m_actionNames.begin();
+	bool state{ false };
+	for (const Step_& step : m_steps)
+	{
+		bool stepState = std::find(step.actions.begin(), step.actions.end(), actionIndex) != step.actions.end();
+		if (stepState != state)
+		{
+			changeFrames.emplace_back(step.frame);
+			state = stepState;
+		}
+	}
+}
+
+geng::ScriptedActionCommandStream::ScriptedActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand,
+	const std::shared_ptr<const ActionScript>& pScript,
+	const std::string& actionName)
+	:SyntheticActionCommandStream(pCommand)
+{
+	pScript->GetChangeFrames(actionName, m_changeFrames);
+}
+
+bool geng::ScriptedActionCommandStream::GetStateOnFrame(unsigned long gameFrame)
+{
+	while (m_nextChange < m_changeFrames.size() && m_changeFrames[m_nextChange] <= gameFrame)
+	{
+		m_state = !m_state;
+		++m_nextChange;
+	}
+
+	return m_state;
+}
+
+geng::RandomActionCommandStream::RandomActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand,
+	const RandomActionArgs& args,
+	unsigned int actionIndex)
+	:SyntheticActionCommandStream(pCommand),
+	m_args(args)
+{
+	// Each action gets a sequence of its own, so the streams can be updated in any order
+	std::seed_seq seedSequence{ (uint32_t)args.seed, (uint32_t)(args.seed >> 32), (uint32_t)actionIndex };
+	m_generator.seed(seedSequence);
+}
+
+bool geng::RandomActionCommandStream::GetStateOnFrame(unsigned long gameFrame)
+{
+	if (m_holdFrames > 0)
+	{
+		--m_holdFrames;
+		return true;
+	}
+
+	// The draws are made by hand, since the standard distributions may differ between libraries
+	constexpr double TWO_TO_64 = 18446744073709551616.0;
+	if ((double)m_generator() / TWO_TO_64 >= m_args.pressChance)
+	{
+		return false;
+	}
+
+	unsigned int maxHoldFrames = std::max(m_args.maxHoldFrames, 1u);
+	m_holdFrames = (unsigned int)(m_generator() % maxHoldFrames);
+	return true;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "ActionCommands.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <random>
+#include <functional>
+#include <iosfwd>
+
+namespace geng
+{
+	// Command streams that make up an action instead of reading it off the keyboard, so a game can
+	// run with nobody at the controls.  They set the command's state directly -- what the sim sees
+	// on the frame -- with no throttling in between.
+	// Frames are counted from the first one a stream is updated on, i.e. from the start of the game
+
+	class SyntheticActionCommandStream : public ICommandStream, public PooledObject
+	{
+	public:
+		bool UpdateOnFrame(unsigned long frameIndex) override
+		{
+			if (!m_started)
+			{
+				m_firstFrame = frameIndex;
+			}
+
+			bool curState = GetStateOnFrame(frameIndex - m_firstFrame);
+			if (!m_started || curState != m_prevState)
+			{
+				m_pCommand->SetState(curState);
+			}
+
+			m_started = true;
+			m_prevState = curState;
+			return true;
+		}
+
+	protected:
+		SyntheticActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand)
+			:m_pCommand(pCommand)
+		{ }
+
+		// Called once a frame, with the frames going up one at a time
+		virtual bool GetStateOnFrame(unsigned long gameFrame) = 0;
+
+	private:
+		std::shared_ptr<ActionCommand> m_pCommand;
+		unsigned long m_firstFrame{ 0 };
+		bool m_started{ false };
+		bool m_prevState{ false };
+	};
+
+	// A script is text, one step per line:  "<frame> [action ...]".  From that frame on, exactly the
+	// actions listed are on, until the next step.  Frames must go up from step to step; everything
+	// after a '#' is a comment
+	class ActionScript
+	{
+	public:
+		bool Load(const char* pFileName);
+		bool Parse(std::istream& is);
+
+		// Every action the script names
+		const std::vector<std::string>& GetActionNames() const { return m_actionNames; }
+		// The frames on which the action turns on or off, in order.  Every action starts off
+		void GetChangeFrames(const std::string& actionName, std::vector<unsigned long>& changeFrames) const;
+
+		const std::string& GetError() const { return m_error; }
+
+	private:
+		struct Step_
+		{
+			unsigned long frame;
+			// Indices into m_actionNames
+			std::vector<size_t> actions;
+		};
+
+		std::vector<std::string> m_actionNames;
+		std::vector<Step_> m_steps;
+		std::string m_error;
+	};
+
+	class ScriptedActionCommandStream : public SyntheticActionCommandStream
+	{
+	public:
+		ScriptedActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand,
+			const std::shared_ptr<const ActionScript>& pScript,
+			const std::string& actionName);
+
+	protected:
+		bool GetStateOnFrame(unsigned long gameFrame) override;
+
+	private:
+		std::vector<unsigned long> m_changeFrames;
+		size_t m_nextChange{ 0 };
+		bool m_state{ false };
+	};
+
+	struct RandomActionArgs
+	{
+		// Streams with the same seed and action index press the same way
+		unsigned long long seed{ 0 };
+		// Of a press starting on any frame the action is off
+		double pressChance{ 0.03 };
+		// A press lasts from one frame to this many
+		unsigned int maxHoldFrames{ 4 };
+	};
+
+	class RandomActionCommandStream : public SyntheticActionCommandStream
+	{
+	public:
+		RandomActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand,
+			const RandomActionArgs& args,
+			unsigned int actionIndex);
+
+	protected:
+		bool GetStateOnFrame(unsigned long gameFrame) override;
+
+	private:
+		RandomActionArgs m_args;
+		std::mt19937_64 m_generator;
+		// Frames left in the current press
+		unsigned int m_holdFrames{ 0 };
+	};
+
+	// Asked once a frame, with the frame counted from the start of the game, for a player's
+	// actions as bits
+	using ActionBotPolicy = std::function<uint32_t(unsigned long gameFrame)>;
+
+	// Shared by a player's streams, so the policy runs once a frame whichever stream asks first
+	class ActionBot
+	{
+	public:
+		ActionBot(const ActionBotPolicy& policy)
+			:m_policy(policy)
+		{ }
+
+		bool IsActionOn(unsigned long gameFrame, unsigned int actionBit)
+		{
+			if (!m_hasFrame || gameFrame != m_frame)
+			{
+				m_actionBits = m_policy(gameFrame);
+				m_frame = gameFrame;
+				m_hasFrame = true;
+			}
+
+			return (m_actionBits & (1u << actionBit)) != 0;
+		}
+
+	private:
+		ActionBotPolicy m_policy;
+		unsigned long m_frame{ 0 };
+		bool m_hasFrame{ false };
+		uint32_t m_actionBits{ 0 };
+	};
+
+	class BotActionCommandStream : public SyntheticActionCommandStream
+	{
+	public:
+		BotActionCommandStream(const std::shared_ptr<ActionCommand>& pCommand,
+			const std::shared_ptr<ActionBot>& pBot,
+			unsigned int actionBit)
+			:SyntheticActionCommandStream(pCommand),
+			m_pBot(pBot),
+			m_actionBit(actionBit)
+		{ }
+
+	protected:
+		bool GetStateOnFrame(unsigned long gameFrame) override
+		{
+			return m_pBot->IsActionOn(gameFrame, m_actionBit);
+		}
+
+	private:
+		std::shared_ptr<ActionBot> m_pBot;
+		unsigned int m_actionBit;
+	};
+}
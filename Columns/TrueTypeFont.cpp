@@ -4,7 +4,7 @@
 #include "DTUtils.h"
 #include "DTConstruct.h"
 #include "ResDescriptor.h"
-#include "DTSimple.h"
+#include "DTArena.h"
 #include "PathUtils.h"
 
 #include <sstream>
@@ -37,9 +37,8 @@ geng::sdl::TTFFactory::TTFFactory(const std::vector<std::string>& searchPaths)
 
 bool geng::sdl::TTFFactory::IsMyResource(const data::IDatum& resDescriptor) const
 {
-	std::string resType;
-	if (data::GetDictValue(resDescriptor, res_desc::RES_TYPE, resType)
-		!= data::AccessResult::OK)
+	std::string_view resType;
+	if (res_desc::ResTypePath().GetValue(resDescriptor, resType) != data::AccessResult::OK)
 	{
 		return false;
 	}
@@ -57,14 +56,14 @@ std::shared_ptr<geng::IResource> geng::sdl::TTFFactory
 
 	// get the font size and the source
 	int16_t fontSize{};
-	if (GetDictValue(resourceDesc, "size", fontSize) != AccessResult::OK)
+	if (res_desc::SizePath().GetValue(resourceDesc, fontSize) != AccessResult::OK)
 	{
 		rErr = "descriptor must have a \"size\" field";
 		return pFont;
 	}
 	
 	std::shared_ptr<data::IDatum> pTypeface;
-	if (GetDictChild(resourceDesc, "typeface", pTypeface) != AccessResult::OK)
+	if (res_desc::TypefacePath().GetChild(resourceDesc, pTypeface) != AccessResult::OK)
 	{
 		rErr = "descriptor must have a \"typeface\" field";
 		return pFont;
@@ -103,17 +102,18 @@ std::shared_ptr<geng::IResource> geng::sdl::TTFFactory
 		}
 
 		// Load the font as a raw file
+		arena::ArenaScope descriptorScope;
 		auto pFontDescriptor = 
-			DTDict<simple::Suite>
+			DTDict<arena::Suite>
 			({ 
 			   {res_desc::RES_TYPE,
-					DTElem<simple::Suite>(RawMemoryResource::GetTypeName())
+					DTElem<arena::Suite>(RawMemoryResource::GetTypeName())
 			   },
 			   {res_desc::SOURCE,
-				 DTDict<simple::Suite>
+				 DTDict<arena::Suite>
 					({{
 						res_desc::FILE_PATH,
-						DTElem<simple::Suite>(fontPath.string().c_str())
+						DTElem<arena::Suite>(fontPath.string().c_str())
 					 }}
 				    )
 			   }